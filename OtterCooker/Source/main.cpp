@@ -0,0 +1,64 @@
+#include <string>
+#include <cstdlib>
+#include <vector>
+#include <cctype>
+#include <algorithm>
+#include <filesystem>
+
+#include "Core/Logger.h"
+#include "Core/EngineCore.h"
+#include "Resources/MeshCooker.h"
+#include "Resources/TextureCooker.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+	bool IsTextureSource(const fs::path& path) {
+		std::string extension = path.extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(),
+			[](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return extension == ".png" || extension == ".jpg" || extension == ".jpeg" ||
+			extension == ".tga" || extension == ".bmp";
+	}
+}
+
+// Usage: OtterCooker <source asset> [cooked output] [texture options]
+// Texture options: --bc1 | --bc7 | --rgba8, --linear, --no-mips, --min-psnr <dB>
+int main(int argc, char** argv) {
+	OtterEngine::EngineCore::Start();
+
+	std::vector<std::string> positional;
+	OtterEngine::TextureCookSettings textureSettings;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string argument = argv[i];
+		if (argument == "--bc1") textureSettings.mCompression = OtterEngine::TextureCompression::BC1;
+		else if (argument == "--bc7") textureSettings.mCompression = OtterEngine::TextureCompression::BC7;
+		else if (argument == "--rgba8") textureSettings.mCompression = OtterEngine::TextureCompression::None;
+		else if (argument == "--linear") textureSettings.mIsSRGB = false;
+		else if (argument == "--no-mips") textureSettings.mGenerateMips = false;
+		else if (argument == "--min-psnr" && i + 1 < argc) textureSettings.mMinPSNR = std::strtod(argv[++i], nullptr);
+		else positional.push_back(argument);
+	}
+
+	if (positional.empty()) {
+		OTTER_CLIENT_ERROR("Usage: OtterCooker <source asset> [cooked output] [--bc1|--bc7|--rgba8] [--linear] [--no-mips] [--min-psnr <dB>]");
+		return EXIT_FAILURE;
+	}
+
+	fs::path source = positional[0];
+	fs::path destination = positional.size() > 1 ? fs::path(positional[1]) : fs::path();
+
+	bool cooked = false;
+	if (source.extension() == ".obj") {
+		cooked = OtterEngine::MeshCooker::Cook(source, destination);
+	}
+	else if (IsTextureSource(source)) {
+		cooked = OtterEngine::TextureCooker::Cook(source, destination, textureSettings);
+	}
+	else {
+		OTTER_CLIENT_ERROR("No cooker available for '{}'", source.string());
+	}
+
+	return cooked ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+namespace OtterEngine {
+
+	/// <summary>
+	/// Engine-wide pool of worker threads. Workers are spawned lazily on first use,
+	/// or explicitly via Init, and joined by Shutdown.
+	/// </summary>
+	class JobSystem final {
+	public:
+		using Job = std::function<void()>;
+
+		/// <summary>
+		/// Spawns the worker threads
+		/// </summary>
+		/// <param name="workerCount">Number of workers, 0 picks one less than the hardware threads</param>
+		static void Init(uint32_t workerCount = 0);
+
+		/// <summary>
+		/// Drains the queued jobs and joins every worker
+		/// </summary>
+		static void Shutdown();
+
+		static uint32_t GetWorkerCount();
+
+		/// <summary>
+		/// Queues a job to be run by the first free worker
+		/// </summary>
+		static void Submit(Job job);
+
+		/// <summary>
+		/// Runs body(i) for every i in [0, count) and returns once all of them completed.
+		/// The calling thread takes part in the work, so nesting inside a job is safe.
+		/// </summary>
+		/// <param name="maxThreads">Upper bound of threads used including the caller, 0 means no limit</param>
+		static void ParallelFor(size_t count, const std::function<void(size_t)>& body, uint32_t maxThreads = 0);
+	};
+}
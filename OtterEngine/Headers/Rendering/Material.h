@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Resources/Texture.h"
+#include "Resources/Resources.h"
+#include "Rendering/ShaderVariants.h"
+
+namespace OtterEngine {
+	/// <summary>
+	/// What a material is drawn with. Its features pick the shader variant, and with it the pipeline.
+	/// </summary>
+	struct MaterialDesc {
+		ResourceHandle<Texture> mTexture;
+		// Tangent-space normals, only sampled with SHADER_FEATURE_NORMAL_MAP
+		ResourceHandle<Texture> mNormalMap;
+		ShaderFeatureFlags mFeatures = 0;
+	};
+}
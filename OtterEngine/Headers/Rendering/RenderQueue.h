@@ -0,0 +1,96 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstdint>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "glm/glm.hpp"
+
+namespace OtterEngine {
+	using MaterialID = uint32_t;
+	using PipelineID = uint32_t;
+
+	/// <summary>
+	/// Instances of one mesh drawn together, their transforms being contiguous from mFirstInstance
+	/// </summary>
+	struct DrawCommand {
+		uint32_t mMesh = 0;
+		uint32_t mFirstInstance = 0;
+		uint32_t mInstanceCount = 0;
+	};
+
+	/// <summary>
+	/// Consecutive draw commands sharing a pipeline and a material, issued with a single indirect draw
+	/// </summary>
+	struct DrawGroup {
+		PipelineID mPipeline = 0;
+		MaterialID mMaterial = 0;
+		uint32_t mFirstCommand = 0;
+		uint32_t mCommandCount = 0;
+	};
+
+	struct RenderQueueStats {
+		uint32_t mInstanceCount = 0;
+		uint32_t mCommandCount = 0;
+		uint32_t mGroupCount = 0;
+		float mBuildMs = 0.0f;
+	};
+
+	/// <summary>
+	/// Collects the (mesh, material, transform) instances of a frame and sorts them into draw commands
+	/// grouped by pipeline then material, so that each group costs one state change and one draw call.
+	/// Only sort keys are moved around, transforms are copied once straight into the instance buffer.
+	/// Not thread safe, submissions are expected from the thread building the frame.
+	/// </summary>
+	class RenderQueue {
+	public:
+		static constexpr uint32_t PIPELINE_BITS = 8;
+		static constexpr uint32_t MATERIAL_BITS = 24;
+		static constexpr PipelineID MAX_PIPELINES = 1u << PIPELINE_BITS;
+		static constexpr MaterialID MAX_MATERIALS = 1u << MATERIAL_BITS;
+
+	private:
+		// Pipeline in the high bits, then material, then mesh
+		struct SortItem {
+			uint64_t mKey = 0;
+			uint32_t mTransform = 0;
+		};
+
+		std::vector<SortItem> mItems;
+		std::vector<glm::mat4> mTransforms;
+
+		std::vector<DrawCommand> mCommands;
+		std::vector<DrawGroup> mGroups;
+
+		RenderQueueStats mStats;
+
+	public:
+		void Reserve(size_t instanceCount);
+
+		/// <summary>
+		/// Queues one instance of a mesh. Meshes are identified by the handle their renderer gave them.
+		/// </summary>
+		void Submit(uint32_t mesh, MaterialID material, const glm::mat4& transform, PipelineID pipeline = 0);
+
+		/// <summary>
+		/// Sorts the queued instances into draw commands and groups, writing their transforms in draw order
+		/// </summary>
+		/// <param name="instances">Destination of the transforms, at least GetInstanceCount() long</param>
+		void Build(std::span<glm::mat4> instances);
+
+		/// <summary>
+		/// Drops every instance, keeping the memory for the next frame
+		/// </summary>
+		void Clear();
+
+		uint32_t GetInstanceCount() const noexcept { return static_cast<uint32_t>(mItems.size()); }
+
+		// Valid after Build
+		std::span<const DrawCommand> GetCommands() const noexcept { return mCommands; }
+		std::span<const DrawGroup> GetGroups() const noexcept { return mGroups; }
+		const RenderQueueStats& GetStats() const noexcept { return mStats; }
+	};
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+
+namespace OtterEngine {
+	enum class ShaderStage : uint8_t {
+		Vertex,
+		Fragment,
+		Compute
+	};
+
+	/// <summary>
+	/// Preprocessor definition passed to the compiler, as if "#define mName mValue" opened the source
+	/// </summary>
+	struct ShaderDefine {
+		std::string mName;
+		std::string mValue;
+
+		bool operator==(const ShaderDefine&) const = default;
+	};
+
+	/// <summary>
+	/// Everything that makes up one SPIR-V binary besides the files' content
+	/// </summary>
+	struct ShaderSourceDesc {
+		std::filesystem::path mPath;
+		ShaderStage mStage = ShaderStage::Vertex;
+		std::vector<ShaderDefine> mDefines;
+
+		bool operator==(const ShaderSourceDesc&) const = default;
+	};
+
+	/// <summary>
+	/// A file read to build a shader, with its write time at the moment it was read
+	/// </summary>
+	struct ShaderDependency {
+		std::filesystem::path mPath;
+		std::filesystem::file_time_type mWriteTime;
+	};
+
+	struct CompiledShader {
+		// Empty when the source is missing or does not compile
+		std::vector<uint32_t> mSpirv;
+		uint64_t mKey = 0;
+		// The source followed by every file it includes
+		std::vector<ShaderDependency> mDependencies;
+		bool mFromCache = false;
+	};
+
+	/// <summary>
+	/// Compiles GLSL to SPIR-V at runtime through shaderc. Binaries are cached on disk under a key hashing the
+	/// content of the source and of every file it includes, the defines, the stage and the compiler's version,
+	/// so an unchanged permutation is read back instead of compiled again, whatever its file's timestamp.
+	/// "#include" lines resolve relative to the including file, then to the directory of the source.
+	/// </summary>
+	class ShaderCompiler final {
+	public:
+		// Bump when the compile options change, it invalidates every cached binary
+		static constexpr uint32_t CACHE_VERSION = 1;
+		static constexpr const char* CACHE_DIRECTORY = "Cache/Shaders";
+
+		/// <summary>
+		/// Reads desc from the cache or compiles it, blocking. Safe to call from any thread.
+		/// </summary>
+		static CompiledShader Compile(const ShaderSourceDesc& desc);
+
+		/// <summary>
+		/// Reads the source and every file it includes and returns the key its binary is cached under, without compiling
+		/// </summary>
+		/// <param name="dependencies">Receives the files read, the source first, if not null</param>
+		/// <returns>0 if the source cannot be read</returns>
+		static uint64_t ComputeKey(const ShaderSourceDesc& desc, std::vector<ShaderDependency>* dependencies = nullptr);
+
+		/// <summary>
+		/// Versions of the compiler libraries, part of every cache key so that a compiler update recompiles everything
+		/// </summary>
+		static const std::string& GetCompilerIdentity();
+	};
+}
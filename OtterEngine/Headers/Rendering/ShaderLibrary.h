@@ -0,0 +1,70 @@
+#pragma once
+
+#include <span>
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include "Rendering/ShaderCompiler.h"
+
+namespace OtterEngine {
+	using ShaderHandle = uint32_t;
+
+	/// <summary>
+	/// Shaders the renderer builds pipelines from. Each one is compiled once when loaded, then watched:
+	/// when the source or one of its includes is written to, it is recompiled on a JobSystem worker
+	/// and swapped in by Update. A recompile that fails keeps the previous binary.
+	/// Not thread safe, owned by the render thread.
+	/// </summary>
+	class ShaderLibrary {
+	public:
+		static constexpr float DEFAULT_WATCH_INTERVAL_MS = 500.0f;
+
+	private:
+		struct Entry {
+			ShaderSourceDesc mDesc;
+			CompiledShader mShader;
+			bool mIsCompiling = false;
+		};
+
+		struct Recompile {
+			ShaderHandle mHandle = 0;
+			CompiledShader mShader;
+		};
+
+		// Shared with the workers, a recompile finishing after the library is gone drops its result
+		struct Completions {
+			std::mutex mMutex;
+			std::vector<Recompile> mRecompiles;
+		};
+
+		std::vector<Entry> mEntries;
+		std::shared_ptr<Completions> mCompletions = std::make_shared<Completions>();
+
+		float mWatchIntervalMs = DEFAULT_WATCH_INTERVAL_MS;
+		std::chrono::steady_clock::time_point mLastWatch = std::chrono::steady_clock::now();
+
+		bool HasChanged(const Entry& entry) const;
+
+	public:
+		/// <summary>
+		/// Compiles the shader, or reads it from the cache, blocking. Loading the same source, stage and defines again
+		/// returns the same handle.
+		/// </summary>
+		ShaderHandle Load(const ShaderSourceDesc& desc);
+
+		/// <returns>Empty when the shader never compiled</returns>
+		std::span<const uint32_t> GetSpirv(ShaderHandle handle) const;
+
+		/// <summary>
+		/// Swaps in the recompiles that finished and, at most once per watch interval, starts recompiling
+		/// the shaders whose files changed. To be called once per frame.
+		/// </summary>
+		/// <returns>True when the binary of a shader changed, the pipelines built from it are outdated</returns>
+		bool Update();
+
+		void SetWatchInterval(float intervalMs) noexcept { mWatchIntervalMs = intervalMs; }
+	};
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+#include <unordered_map>
+
+#include "Rendering/ShaderLibrary.h"
+
+namespace OtterEngine {
+	/// <summary>
+	/// Optional work of the shaders, a material only pays for the features it enables.
+	/// Each feature is a define of the same name prefixed with OTTER_, see Shaders/triangle.*
+	/// </summary>
+	enum ShaderFeatureBits : uint32_t {
+		SHADER_FEATURE_LIT = 1 << 0,
+		SHADER_FEATURE_NORMAL_MAP = 1 << 1,
+		SHADER_FEATURE_VERTEX_COLOR = 1 << 2,
+		SHADER_FEATURE_ALPHA_TEST = 1 << 3,
+		// Set by the renderer from the vertex format of the mesh, not by materials
+		SHADER_FEATURE_OCTAHEDRAL_NORMAL = 1 << 4,
+	};
+	using ShaderFeatureFlags = uint32_t;
+
+	inline constexpr uint32_t SHADER_FEATURE_COUNT = 5;
+
+	using ShaderVariantID = uint32_t;
+
+	/// <summary>
+	/// Vertex and fragment shaders compiled with the defines of one feature set
+	/// </summary>
+	struct ShaderVariant {
+		ShaderFeatureFlags mFeatures = 0;
+		uint64_t mKey = 0;
+		ShaderHandle mVertex = 0;
+		ShaderHandle mFragment = 0;
+	};
+
+	/// <summary>
+	/// Permutations of a vertex and fragment shader pair, compiled the first time a feature set asks for them.
+	/// Feature sets are normalized first, so sets that would compile to the same code share a variant,
+	/// and variants are deduplicated by a key hashing the sources' paths with the normalized features.
+	/// IDs are dense and stable, the renderer keys its pipelines with them.
+	/// </summary>
+	class ShaderVariantCache {
+	private:
+		ShaderLibrary& mLibrary;
+		std::filesystem::path mVertexPath;
+		std::filesystem::path mFragmentPath;
+		uint64_t mProgramKey = 0;
+
+		std::vector<ShaderVariant> mVariants;
+		std::unordered_map<uint64_t, ShaderVariantID> mVariantsByKey;
+
+	public:
+		ShaderVariantCache(ShaderLibrary& library, std::filesystem::path vertexPath, std::filesystem::path fragmentPath);
+
+		/// <summary>
+		/// Drops the features that do nothing on their own, normal mapping and normal decoding only affect lit shaders
+		/// </summary>
+		static ShaderFeatureFlags Normalize(ShaderFeatureFlags features);
+
+		/// <summary>
+		/// Defines selecting the features, in bit order
+		/// </summary>
+		static std::vector<ShaderDefine> GetDefines(ShaderFeatureFlags features);
+
+		/// <summary>
+		/// Returns the variant of the features, compiling it on first request
+		/// </summary>
+		ShaderVariantID GetVariantID(ShaderFeatureFlags features);
+
+		const ShaderVariant& GetVariant(ShaderVariantID id) const { return mVariants[id]; }
+		uint32_t GetCount() const noexcept { return static_cast<uint32_t>(mVariants.size()); }
+	};
+}
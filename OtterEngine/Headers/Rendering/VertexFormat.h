@@ -0,0 +1,119 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "Rendering/Vertex.h"
+
+namespace OtterEngine {
+	// 4 x fp16, the last half is 1.0 so the attribute stays 4-byte aligned
+	enum class PositionEncoding : uint8_t {
+		Float32,
+		Float16
+	};
+
+	enum class NormalEncoding : uint8_t {
+		None,
+		Float32,
+		// 2 x snorm16 on the octahedron, decoded by the vertex shader
+		Octahedral16
+	};
+
+	// Unorm16 only covers UVs inside [0, 1]
+	enum class TexCoordEncoding : uint8_t {
+		Float32,
+		Unorm16
+	};
+
+	// Meshes without colors are drawn white
+	enum class ColorEncoding : uint8_t {
+		None,
+		Unorm8
+	};
+
+	/// <summary>
+	/// Attributes interleaved in one stream in the order position, normal, texcoord, color; absent ones take no space
+	/// </summary>
+	struct VertexAttributeOffsets {
+		uint32_t mPosition = 0;
+		uint32_t mNormal = 0;
+		uint32_t mTexCoord = 0;
+		uint32_t mColor = 0;
+		uint32_t mStride = 0;
+	};
+
+	/// <summary>
+	/// Error bounds of the vertex quantization, an attribute keeps its full precision encoding when its
+	/// round-trip error over the mesh exceeds its bound
+	/// </summary>
+	struct VertexQuantizationSettings {
+		bool mEnabled = true;
+		// In model units
+		float mMaxPositionError = 1e-3f;
+		// Angle in radians
+		float mMaxNormalError = 1e-3f;
+		float mMaxTexCoordError = 1.0f / 8192.0f;
+	};
+
+	/// <summary>
+	/// Largest round-trip error of each attribute, in the units of VertexQuantizationSettings
+	/// </summary>
+	struct VertexQuantizationError {
+		float mPosition = 0.0f;
+		float mNormal = 0.0f;
+		float mTexCoord = 0.0f;
+		float mColor = 0.0f;
+	};
+
+	/// <summary>
+	/// Which attributes a mesh stores and how they are encoded. Vertex is the full precision form used while
+	/// importing, meshes keep their vertices packed in their format and are uploaded as is.
+	/// </summary>
+	struct VertexFormat {
+		PositionEncoding mPosition = PositionEncoding::Float32;
+		NormalEncoding mNormal = NormalEncoding::Float32;
+		TexCoordEncoding mTexCoord = TexCoordEncoding::Float32;
+		ColorEncoding mColor = ColorEncoding::Unorm8;
+
+		bool operator==(const VertexFormat&) const = default;
+
+		bool HasNormals() const noexcept { return mNormal != NormalEncoding::None; }
+		bool HasColors()  const noexcept { return mColor != ColorEncoding::None; }
+
+		VertexAttributeOffsets GetOffsets() const noexcept;
+		uint32_t GetStride() const noexcept { return GetOffsets().mStride; }
+
+		/// <summary>
+		/// One byte per attribute, stored in cooked meshes and used to key pipelines
+		/// </summary>
+		uint32_t GetKey() const noexcept;
+
+		/// <summary>
+		/// Reads a key written by GetKey, false if one of its encodings is unknown
+		/// </summary>
+		static bool FromKey(uint32_t key, VertexFormat& format) noexcept;
+
+		/// <summary>
+		/// Picks the most compact format whose error stays within the bounds. Normals and colors are left out
+		/// when every vertex has a zero normal or a white color.
+		/// </summary>
+		static VertexFormat Choose(std::span<const Vertex> vertices, const VertexQuantizationSettings& settings);
+	};
+
+	/// <summary>
+	/// Packs the vertices in the given format, in order
+	/// </summary>
+	std::vector<std::byte> EncodeVertices(std::span<const Vertex> vertices, const VertexFormat& format);
+
+	/// <summary>
+	/// Unpacks the vertices of a stream in the given format. Absent normals decode to zero and absent colors to white.
+	/// </summary>
+	std::vector<Vertex> DecodeVertices(std::span<const std::byte> data, const VertexFormat& format);
+
+	/// <summary>
+	/// Largest difference between the vertices and their round trip through the given format
+	/// </summary>
+	VertexQuantizationError MeasureQuantizationError(std::span<const Vertex> vertices, const VertexFormat& format);
+}
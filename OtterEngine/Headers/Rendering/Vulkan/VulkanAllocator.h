@@ -0,0 +1,132 @@
+#pragma once
+
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <vulkan/vulkan.h>
+
+#include "Utils/RangeAllocator.h"
+
+namespace OtterEngine {
+	/// <summary>
+	/// Device memory bound to one buffer or image, either a range of a shared block or a dedicated allocation
+	/// </summary>
+	struct VulkanAllocation {
+		VkDeviceMemory mMemory = VK_NULL_HANDLE;
+		VkDeviceSize mOffset = 0;
+		VkDeviceSize mSize = 0;
+
+		// Persistent mapping of the range, null unless the memory is host visible
+		void* pMapped = nullptr;
+
+		uint32_t mMemoryType = UINT32_MAX;
+		// Owning block, or UINT32_MAX for dedicated allocations
+		uint32_t mBlockIndex = UINT32_MAX;
+		uint32_t mBlockID = 0;
+
+		bool IsDedicated() const noexcept { return mBlockIndex == UINT32_MAX; }
+		explicit operator bool() const noexcept { return mMemory != VK_NULL_HANDLE; }
+	};
+
+	struct VulkanAllocatorStats {
+		uint32_t mBlockCount = 0;
+		uint32_t mDedicatedCount = 0;
+		uint32_t mAllocationCount = 0;
+
+		// Device memory obtained from the driver, and the part of it handed out to resources
+		VkDeviceSize mReservedBytes = 0;
+		VkDeviceSize mUsedBytes = 0;
+		VkDeviceSize mPeakReservedBytes = 0;
+	};
+
+	/// <summary>
+	/// Engine-owned device memory allocator. Memory is taken from the driver in large blocks per
+	/// memory type and sub-allocated to buffers and images, honoring their alignment. Linear and
+	/// optimal-tiling resources never share a block when the device has a bufferImageGranularity,
+	/// and resources bigger than half a block get a dedicated allocation.
+	/// Host-visible memory is mapped once for its whole lifetime. All methods are thread safe.
+	/// </summary>
+	class VulkanAllocator {
+	public:
+		static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+		enum class ResourceKind : uint32_t {
+			Linear,		// Buffers and linear images
+			Optimal		// Optimal-tiling images
+		};
+
+	private:
+		struct Block {
+			VkDeviceMemory mMemory = VK_NULL_HANDLE;
+			RangeAllocator mRanges;
+			uint8_t* pMapped = nullptr;
+			ResourceKind mKind = ResourceKind::Linear;
+			// Tells a freed allocation apart from one of an older block that lived in the same slot
+			uint32_t mID = 0;
+		};
+
+		struct MemoryTypePool {
+			std::vector<std::unique_ptr<Block>> mBlocks;
+		};
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+		VkPhysicalDevice mPhysicalDevice = VK_NULL_HANDLE;
+		VkPhysicalDeviceMemoryProperties mMemoryProperties{};
+		VkDeviceSize mBufferImageGranularity = 1;
+		uint32_t mMaxAllocationCount = 0;
+		VkDeviceSize mBlockSize = DEFAULT_BLOCK_SIZE;
+
+		mutable std::mutex mLock;
+		std::vector<MemoryTypePool> mPools;
+		uint32_t mNextBlockID = 1;
+		uint32_t mDriverAllocationCount = 0;
+		VulkanAllocatorStats mStats;
+
+		uint32_t FindMemoryType(uint32_t filter, VkMemoryPropertyFlags properties) const;
+		VkDeviceSize GetBlockSize(uint32_t memoryType) const;
+		VkDeviceMemory AllocateDeviceMemory(VkDeviceSize size, uint32_t memoryType, uint8_t** mapped);
+		void FreeDeviceMemory(VkDeviceMemory memory, VkDeviceSize size);
+
+	public:
+		VulkanAllocator(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize blockSize = DEFAULT_BLOCK_SIZE);
+		~VulkanAllocator();
+
+		VulkanAllocator(const VulkanAllocator&) = delete;
+		VulkanAllocator& operator=(const VulkanAllocator&) = delete;
+
+		/// <summary>
+		/// Reserves memory matching the requirements of a resource
+		/// </summary>
+		/// <returns>The allocation, empty if the device is out of memory</returns>
+		VulkanAllocation Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, ResourceKind kind);
+
+		/// <summary>
+		/// Releases an allocation and resets it. Empty blocks are given back to the driver,
+		/// except one per memory type that is kept around for the next allocations.
+		/// </summary>
+		void Free(VulkanAllocation& allocation);
+
+		/// <summary>
+		/// Creates a buffer and binds it to freshly allocated memory
+		/// </summary>
+		VkResult CreateBuffer(const VkBufferCreateInfo& createInfo, VkMemoryPropertyFlags properties, VkBuffer& buffer, VulkanAllocation& allocation);
+
+		/// <summary>
+		/// Creates an image and binds it to freshly allocated memory
+		/// </summary>
+		VkResult CreateImage(const VkImageCreateInfo& createInfo, VkMemoryPropertyFlags properties, VkImage& image, VulkanAllocation& allocation);
+
+		/// <summary>
+		/// Destroys a buffer created by CreateBuffer and frees its memory, both are reset
+		/// </summary>
+		void DestroyBuffer(VkBuffer& buffer, VulkanAllocation& allocation);
+		void DestroyImage(VkImage& image, VulkanAllocation& allocation);
+
+		VulkanAllocatorStats GetStats() const;
+		void LogStats() const;
+
+		VkDevice GetDevice() const noexcept { return mDevice; }
+		VkPhysicalDevice GetPhysicalDevice() const noexcept { return mPhysicalDevice; }
+	};
+}
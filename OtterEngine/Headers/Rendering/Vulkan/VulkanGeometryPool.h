@@ -0,0 +1,163 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstdint>
+#include <vulkan/vulkan.h>
+
+#include "Utils/RangeAllocator.h"
+#include "Rendering/Vulkan/VulkanAllocator.h"
+#include "Rendering/Vulkan/VulkanUploadQueue.h"
+
+namespace OtterEngine {
+	using GeometryHandle = uint32_t;
+	inline constexpr GeometryHandle INVALID_GEOMETRY = UINT32_MAX;
+
+	/// <summary>
+	/// Where a mesh lives in the shared buffers, in vertices of its own stride and indices of its own type.
+	/// Indices are relative to mVertexOffset.
+	/// </summary>
+	struct GeometryRange {
+		uint32_t mFirstIndex = 0;
+		uint32_t mIndexCount = 0;
+		int32_t mVertexOffset = 0;
+		uint32_t mVertexCount = 0;
+		uint32_t mVertexStride = 0;
+		VkIndexType mIndexType = VK_INDEX_TYPE_UINT32;
+	};
+
+	struct GeometryPoolStats {
+		uint32_t mMeshCount = 0;
+		// Counted in bytes, vertex strides and index types depend on the mesh
+		uint32_t mVertexBufferSize = 0;
+		uint32_t mIndexBufferSize = 0;
+		uint32_t mLiveVertexBytes = 0;
+		uint32_t mLiveIndexBytes = 0;
+		uint32_t mReallocationCount = 0;
+	};
+
+	/// <summary>
+	/// Packs many meshes into one device-local vertex buffer and one index buffer, so that every mesh
+	/// is drawn after a single bind through its firstIndex and vertexOffset.
+	/// Ranges are sub-allocated per mesh; freed ranges are only reused once the frames that could still
+	/// read them are done. When no range fits, the live meshes are copied packed into new buffers, grown
+	/// if needed, which also undoes fragmentation. Meant to be driven from the render thread only.
+	/// Meshes of any vertex format share the vertex buffer: each one starts at a multiple of its stride, so that
+	/// its vertexOffset counts its own vertices and the buffer stays bound at offset 0. The same goes for 16 and
+	/// 32-bit indices in the index buffer, which is bound again with the index type of the mesh drawn.
+	/// </summary>
+	class VulkanGeometryPool {
+	public:
+		static constexpr uint32_t DEFAULT_VERTEX_BUFFER_SIZE = 8 * 1024 * 1024;
+		static constexpr uint32_t DEFAULT_INDEX_BUFFER_SIZE = 4 * 1024 * 1024;
+
+	private:
+		struct Slot {
+			GeometryRange mRange;
+			bool mIsLive = false;
+		};
+
+		// Ranges released by Remove, reusable from mReleaseFrame on
+		struct PendingFree {
+			GeometryRange mRange;
+			uint64_t mReleaseFrame = 0;
+		};
+
+		struct RetiredBuffer {
+			VkBuffer mBuffer = VK_NULL_HANDLE;
+			VulkanAllocation mAllocation;
+			uint64_t mReleaseFrame = 0;
+		};
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+		VulkanAllocator& mAllocator;
+		VulkanUploadQueue& mUploadQueue;
+		VkCommandPool mCommandPool = VK_NULL_HANDLE;
+		VkQueue mGraphicsQueue = VK_NULL_HANDLE;
+
+		VkBuffer mVertexBuffer = VK_NULL_HANDLE;
+		VulkanAllocation mVertexAllocation;
+		VkBuffer mIndexBuffer = VK_NULL_HANDLE;
+		VulkanAllocation mIndexAllocation;
+
+		// In bytes
+		RangeAllocator mVertexRanges;
+		RangeAllocator mIndexRanges;
+
+		std::vector<Slot> mSlots;
+		std::vector<GeometryHandle> mFreeSlots;
+		std::vector<PendingFree> mPendingFrees;
+		std::vector<RetiredBuffer> mRetiredBuffers;
+
+		uint32_t mFramesInFlight = 1;
+		uint64_t mFrame = 0;
+		UploadTicket mLastUpload = VulkanUploadQueue::INVALID_TICKET;
+		GeometryPoolStats mStats;
+
+		void CreateBuffers(uint32_t vertexBufferSize, uint32_t indexBufferSize, VkBuffer& vertexBuffer, VulkanAllocation& vertexAllocation,
+			VkBuffer& indexBuffer, VulkanAllocation& indexAllocation);
+		// False if the live meshes do not fit packed in the given sizes, the pool is then left untouched
+		bool Reallocate(uint32_t vertexBufferSize, uint32_t indexBufferSize);
+		void Retire(VkBuffer& buffer, VulkanAllocation& allocation);
+		void ReleaseRange(const GeometryRange& range);
+
+	public:
+		VulkanGeometryPool(VulkanAllocator& allocator, VulkanUploadQueue& uploadQueue, VkCommandPool commandPool, VkQueue graphicsQueue,
+			uint32_t framesInFlight, uint32_t vertexBufferSize = DEFAULT_VERTEX_BUFFER_SIZE, uint32_t indexBufferSize = DEFAULT_INDEX_BUFFER_SIZE);
+		~VulkanGeometryPool();
+
+		VulkanGeometryPool(const VulkanGeometryPool&) = delete;
+		VulkanGeometryPool& operator=(const VulkanGeometryPool&) = delete;
+
+		/// <summary>
+		/// Records the upload of a mesh into the shared buffers, the copy goes out with the next upload batch
+		/// </summary>
+		/// <param name="vertexData">Packed vertices, drawn with a pipeline whose binding has the same stride</param>
+		/// <param name="indexData">Indices of indexType, relative to the first vertex</param>
+		/// <returns>The handle of the mesh, INVALID_GEOMETRY for empty meshes or if the pool cannot grow enough to hold it</returns>
+		GeometryHandle Add(std::span<const std::byte> vertexData, uint32_t vertexStride, std::span<const std::byte> indexData,
+			VkIndexType indexType);
+
+		/// <summary>
+		/// Releases a mesh. Its ranges are reused once the frames in flight are done with them.
+		/// </summary>
+		void Remove(GeometryHandle handle);
+
+		/// <summary>
+		/// Copies the live meshes to the front of new buffers of the same capacity, merging every free range.
+		/// Blocks until the copy has executed, meant for load screens and level transitions.
+		/// Alignment may keep the packed meshes from fitting, the pool is then left as it is.
+		/// </summary>
+		void Compact();
+
+		/// <summary>
+		/// Advances the pool by one frame, to be called once the oldest frame in flight has completed
+		/// </summary>
+		void Update();
+
+		/// <summary>
+		/// Binds the shared vertex buffer, once for every mesh of the pool
+		/// </summary>
+		void Bind(VkCommandBuffer commandBuffer) const;
+
+		/// <summary>
+		/// Binds the shared index buffer, again whenever the index type of the meshes drawn changes
+		/// </summary>
+		void BindIndexBuffer(VkCommandBuffer commandBuffer, VkIndexType indexType) const;
+
+		/// <summary>
+		/// Binds the index buffer with the mesh's index type and draws it
+		/// </summary>
+		void Draw(VkCommandBuffer commandBuffer, GeometryHandle handle, uint32_t instanceCount = 1, uint32_t firstInstance = 0) const;
+
+		/// <summary>
+		/// Current placement of a mesh, it changes whenever the pool reallocates
+		/// </summary>
+		const GeometryRange& GetRange(GeometryHandle handle) const;
+		bool IsValid(GeometryHandle handle) const { return handle < mSlots.size() && mSlots[handle].mIsLive; }
+
+		VkBuffer GetVertexBuffer() const noexcept { return mVertexBuffer; }
+		VkBuffer GetIndexBuffer()  const noexcept { return mIndexBuffer; }
+		const GeometryPoolStats& GetStats() const noexcept { return mStats; }
+	};
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <vulkan/vulkan.h>
+
+#include "Rendering/RenderQueue.h"
+#include "Rendering/Vulkan/VulkanAllocator.h"
+#include "Rendering/Vulkan/VulkanGeometryPool.h"
+
+namespace OtterEngine {
+	/// <summary>
+	/// Turns a RenderQueue into per-instance transforms in a storage buffer, read by the vertex shader
+	/// through gl_InstanceIndex, and into indexed indirect commands drawn one DrawGroup at a time.
+	/// Buffers are host visible, one pair per frame in flight, and grow as the instance count does.
+	/// Devices without multiDrawIndirect issue one indirect draw per command, and devices without
+	/// drawIndirectFirstInstance fall back to direct draws of the same commands.
+	/// Meshes with 16 and 32-bit indices can share a group, its commands are then drawn in runs of one index type.
+	/// </summary>
+	class VulkanIndirectDrawer {
+	public:
+		static constexpr uint32_t DEFAULT_INSTANCE_CAPACITY = 1024;
+
+	private:
+		struct FrameBuffers {
+			VkBuffer mInstanceBuffer = VK_NULL_HANDLE;
+			VulkanAllocation mInstanceAllocation;
+			uint32_t mInstanceCapacity = 0;
+
+			VkBuffer mIndirectBuffer = VK_NULL_HANDLE;
+			VulkanAllocation mIndirectAllocation;
+			uint32_t mCommandCapacity = 0;
+		};
+
+		VulkanAllocator& mAllocator;
+		std::vector<FrameBuffers> mFrames;
+
+		// Commands of the last prepared frame, kept on the CPU for direct draws
+		std::vector<VkDrawIndexedIndirectCommand> mCommands;
+		// Index type of the mesh of each command
+		std::vector<VkIndexType> mIndexTypes;
+
+		bool mSupportsMultiDraw = false;
+		bool mSupportsFirstInstance = false;
+		uint32_t mMaxDrawIndirectCount = 1;
+
+		void CreateInstanceBuffer(FrameBuffers& frame, uint32_t capacity);
+		void CreateIndirectBuffer(FrameBuffers& frame, uint32_t capacity);
+
+	public:
+		VulkanIndirectDrawer(VulkanAllocator& allocator, VkPhysicalDevice physicalDevice, uint32_t framesInFlight,
+			uint32_t instanceCapacity = DEFAULT_INSTANCE_CAPACITY);
+		~VulkanIndirectDrawer();
+
+		VulkanIndirectDrawer(const VulkanIndirectDrawer&) = delete;
+		VulkanIndirectDrawer& operator=(const VulkanIndirectDrawer&) = delete;
+
+		/// <summary>
+		/// Builds the queue into the frame's buffers, to be called once the frame's previous submission completed
+		/// </summary>
+		/// <returns>True when the frame's instance buffer was recreated and has to be written to its descriptor again</returns>
+		bool Prepare(uint32_t frameIndex, RenderQueue& queue, const VulkanGeometryPool& geometryPool);
+
+		/// <summary>
+		/// Records the draws of one group, with the geometry pool's vertex buffer and the group's pipeline and material bound
+		/// </summary>
+		/// <param name="boundIndexType">Index type the pool's index buffer is bound with, updated when it is bound again</param>
+		void Draw(VkCommandBuffer commandBuffer, uint32_t frameIndex, const DrawGroup& group, const VulkanGeometryPool& geometryPool,
+			VkIndexType& boundIndexType) const;
+
+		VkBuffer GetInstanceBuffer(uint32_t frameIndex) const { return mFrames[frameIndex].mInstanceBuffer; }
+		VkDeviceSize GetInstanceBufferSize(uint32_t frameIndex) const { return mFrames[frameIndex].mInstanceCapacity * sizeof(glm::mat4); }
+	};
+}
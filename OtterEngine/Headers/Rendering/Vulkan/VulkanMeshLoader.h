@@ -1,55 +1,61 @@
 #pragma once
 
+#include <span>
 #include <vector>
 #include <filesystem>
+#include <unordered_map>
 #include <vulkan/vulkan.h>
 #include <cstdint>
-#include <optional>
 #include "Core/Logger.h"
 
 #include "Resources/Mesh.h"
-#include "Rendering/Vertex.h"
 #include "Resources/Resources.h"
 
 #include "Utils/IMeshLoader.h"
+#include "Rendering/Vulkan/VulkanGeometryPool.h"
 
 namespace OtterEngine {
-	class VulkanMeshLoader final : public IMeshLoader {
-	private:
-		VkDevice mDevice;
-		VkPhysicalDevice mPhysicalDevice;
-		VkCommandPool mCommandPool;
-		VkQueue mGraphicsQueue;
-
+	struct LoadedMesh {
 		ResourceHandle<Mesh> mMeshHandle;
+		// One per chunk of the mesh, see MeshChunk
+		std::vector<GeometryHandle> mGeometry;
+		// Chunks of each level of detail, picked per draw from their error on screen
+		std::vector<MeshLod> mLods;
+		MeshBounds mBounds;
+		// Pipelines drawing the mesh read its vertices in this format
+		VertexFormat mVertexFormat;
+	};
 
-		VkBuffer mVertexBuffer = VK_NULL_HANDLE;
-		VkDeviceMemory mVertexBufferMemory = VK_NULL_HANDLE;
+	/// <summary>
+	/// Keeps every loaded mesh resident in the shared geometry pool, loading the same asset twice returns the first upload
+	/// </summary>
+	class VulkanMeshLoader final : public IMeshLoader {
+	private:
+		VulkanGeometryPool* pGeometryPool = nullptr;
 
-		VkBuffer mIndexBuffer = VK_NULL_HANDLE;
-		VkDeviceMemory mIndexBufferMemory = VK_NULL_HANDLE;
+		std::unordered_map<AssetID, LoadedMesh> mMeshes;
 
 	public:
 		VulkanMeshLoader() = default;
 
-		VulkanMeshLoader(VkDevice device, VkPhysicalDevice physicalDevice,
-			VkCommandPool commandPool, VkQueue graphicsQueue);
+		explicit VulkanMeshLoader(VulkanGeometryPool* geometryPool);
 
 		~VulkanMeshLoader() override;
 
 		ResourceHandle<Mesh> LoadMesh(const std::filesystem::path& path) override;
 
-		VkBuffer GetVertexBuffer() const { return mVertexBuffer; }
-		VkBuffer GetIndexBuffer()  const { return mIndexBuffer; }
-		uint32_t GetIndexCount()   const { return mMeshHandle ? mMeshHandle->GetIndexCount() : 0; }
+		/// <summary>
+		/// Releases the GPU copy of a mesh, the CPU resource stays cached
+		/// </summary>
+		void UnloadMesh(const ResourceHandle<Mesh>& mesh);
 
-		const ResourceHandle<Mesh>& GetMeshHandle() const { return mMeshHandle; }
+		/// <summary>
+		/// Geometry of each chunk of a mesh, every level of detail included, empty when it is not loaded
+		/// </summary>
+		std::span<const GeometryHandle> GetGeometry(const ResourceHandle<Mesh>& mesh) const;
 
-		void ClearResources();
+		const std::unordered_map<AssetID, LoadedMesh>& GetMeshes() const { return mMeshes; }
 
-	private:
-		void UploadMeshToGPU	(const Mesh& mesh);
-		void CreateVertexBuffer (const std::vector<Vertex>& vertices);
-		void CreateIndexBuffer  (const std::vector<uint32_t>& indices);
+		void ClearResources();
 	};
-}
\ No newline at end of file
+}
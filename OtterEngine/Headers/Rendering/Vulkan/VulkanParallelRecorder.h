@@ -0,0 +1,58 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <vulkan/vulkan.h>
+
+namespace OtterEngine {
+	/// <summary>
+	/// Records slices of a draw list into secondary command buffers concurrently, through the JobSystem.
+	/// Every slice has its own command pool per frame in flight, so no pool is ever touched by two threads
+	/// at once and a frame's pools are reset as a whole once its fence signaled.
+	/// The secondaries continue a render pass, the primary runs them with vkCmdExecuteCommands.
+	/// </summary>
+	class VulkanParallelRecorder {
+	public:
+		// Fewer items than this are not worth a thread of their own
+		static constexpr size_t DEFAULT_MIN_ITEMS_PER_SLICE = 64;
+
+		/// <summary>
+		/// Records items [begin, end) into a secondary command buffer. Nothing is inherited from the primary,
+		/// pipeline, descriptor sets, buffers and dynamic state have to be bound again.
+		/// </summary>
+		using SliceRecorder = std::function<void(VkCommandBuffer commandBuffer, size_t begin, size_t end)>;
+
+	private:
+		struct Slice {
+			VkCommandPool mPool = VK_NULL_HANDLE;
+			VkCommandBuffer mCommandBuffer = VK_NULL_HANDLE;
+		};
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+		uint32_t mSliceCount = 1;
+
+		// Indexed by frame in flight, then slice
+		std::vector<std::vector<Slice>> mFrames;
+		std::vector<VkCommandBuffer> mRecorded;
+
+	public:
+		/// <param name="sliceCount">Slices recorded concurrently at most, 0 picks one per JobSystem worker plus the caller</param>
+		VulkanParallelRecorder(VkDevice device, uint32_t graphicsFamily, uint32_t framesInFlight, uint32_t sliceCount = 0);
+		~VulkanParallelRecorder();
+
+		VulkanParallelRecorder(const VulkanParallelRecorder&) = delete;
+		VulkanParallelRecorder& operator=(const VulkanParallelRecorder&) = delete;
+
+		/// <summary>
+		/// Splits itemCount items in contiguous slices and records them concurrently, blocking until all are recorded.
+		/// To be called once the frame's previous submission completed.
+		/// </summary>
+		/// <returns>The recorded secondaries in item order, valid until the next call for the same frame</returns>
+		std::span<const VkCommandBuffer> Record(uint32_t frameIndex, VkRenderPass renderPass, uint32_t subpass, VkFramebuffer framebuffer,
+			size_t itemCount, const SliceRecorder& recordSlice, size_t minItemsPerSlice = DEFAULT_MIN_ITEMS_PER_SLICE);
+
+		uint32_t GetSliceCount() const noexcept { return mSliceCount; }
+	};
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <vulkan/vulkan.h>
+
+namespace OtterEngine {
+	/// <summary>
+	/// VkPipelineCache persisted to disk, so drivers skip shader compilation on later launches.
+	/// The file is tagged with the device and driver it was built on, and with a hash of its data;
+	/// a cache from another device or driver, or a damaged one, is ignored and rebuilt.
+	/// </summary>
+	class VulkanPipelineCache {
+	public:
+		static constexpr uint32_t FILE_MAGIC = 0x4850544F; // "OTPH"
+		static constexpr uint32_t FILE_VERSION = 1;
+
+	private:
+		// Written in front of the driver's data
+		struct FileHeader {
+			uint32_t mMagic = FILE_MAGIC;
+			uint32_t mVersion = FILE_VERSION;
+			uint32_t mVendorID = 0;
+			uint32_t mDeviceID = 0;
+			uint32_t mDriverVersion = 0;
+			uint8_t mPipelineCacheUUID[VK_UUID_SIZE] = {};
+			uint32_t mPadding = 0;
+			uint64_t mDataSize = 0;
+			uint64_t mDataHash = 0;
+		};
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+		VkPipelineCache mCache = VK_NULL_HANDLE;
+		std::filesystem::path mPath;
+
+		FileHeader mExpectedHeader;
+		bool mWasLoaded = false;
+
+	public:
+		VulkanPipelineCache(VkDevice device, VkPhysicalDevice physicalDevice, std::filesystem::path path);
+		~VulkanPipelineCache();
+
+		VulkanPipelineCache(const VulkanPipelineCache&) = delete;
+		VulkanPipelineCache& operator=(const VulkanPipelineCache&) = delete;
+
+		/// <summary>
+		/// Writes the cache back to its file, replacing it atomically
+		/// </summary>
+		bool Save() const;
+
+		VkPipelineCache Get() const noexcept { return mCache; }
+
+		/// <summary>
+		/// Tells whether the cache started from a valid file rather than empty
+		/// </summary>
+		bool WasLoaded() const noexcept { return mWasLoaded; }
+	};
+}
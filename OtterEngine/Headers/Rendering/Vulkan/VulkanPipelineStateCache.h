@@ -0,0 +1,159 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+#include <unordered_map>
+#include <vulkan/vulkan.h>
+
+#include "Rendering/ShaderLibrary.h"
+
+namespace OtterEngine {
+	using PipelineStateHandle = uint32_t;
+
+	enum class BlendMode : uint8_t {
+		Opaque,
+		Alpha,
+		Additive
+	};
+
+	/// <summary>
+	/// Everything a graphics pipeline is built from, laid out without padding so that it hashes and compares as bytes.
+	/// Viewport and scissor are dynamic and left out.
+	/// </summary>
+	struct PipelineStateDesc {
+		static constexpr uint32_t MAX_VERTEX_ATTRIBUTES = 4;
+		static constexpr uint32_t MAX_SPECIALIZATION_CONSTANTS = 4;
+
+		struct VertexAttribute {
+			VkFormat mFormat = VK_FORMAT_UNDEFINED;
+			uint16_t mOffset = 0;
+			uint8_t mLocation = 0;
+			uint8_t mPadding = 0;
+		};
+
+		ShaderHandle mVertexShader = 0;
+		ShaderHandle mFragmentShader = 0;
+		VkPipelineLayout mLayout = VK_NULL_HANDLE;
+		// Formats and samples of the render pass, see MakeRenderPassKey
+		uint64_t mRenderPassKey = 0;
+		uint16_t mSubpass = 0;
+		uint8_t mSampleCount = VK_SAMPLE_COUNT_1_BIT;
+		uint8_t mPadding = 0;
+
+		// Single interleaved binding
+		uint16_t mVertexStride = 0;
+		uint8_t mVertexAttributeCount = 0;
+		uint8_t mSpecializationCount = 0;
+		VertexAttribute mVertexAttributes[MAX_VERTEX_ATTRIBUTES] = {};
+		// Values of the constant IDs 0 to mSpecializationCount - 1, given to every stage
+		uint32_t mSpecialization[MAX_SPECIALIZATION_CONSTANTS] = {};
+
+		uint8_t mTopology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		uint8_t mPolygonMode = VK_POLYGON_MODE_FILL;
+		uint8_t mCullMode = VK_CULL_MODE_BACK_BIT;
+		uint8_t mFrontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+		uint8_t mDepthCompareOp = VK_COMPARE_OP_LESS;
+		uint8_t mDepthTest = 1;
+		uint8_t mDepthWrite = 1;
+		BlendMode mBlendMode = BlendMode::Opaque;
+	};
+	static_assert(std::has_unique_object_representations_v<PipelineStateDesc>, "PipelineStateDesc must not have padding, it is hashed as bytes");
+
+	/// <summary>
+	/// Graphics pipelines deduplicated by a hash of their PipelineStateDesc. Registering a state is cheap and hands back
+	/// a stable handle; the pipeline itself is only created the first time it is acquired, on the calling thread or on
+	/// a JobSystem worker. Created pipelines go through the VkPipelineCache, so they are persisted with it.
+	/// Pipelines only depend on the render pass through its compatibility key, they outlive swapchain recreation.
+	/// Not thread safe apart from Get, owned by the render thread.
+	/// </summary>
+	class VulkanPipelineStateCache {
+	private:
+		struct Entry {
+			PipelineStateDesc mDesc;
+			VkPipeline mPipeline = VK_NULL_HANDLE;
+			bool mIsPending = false;
+			bool mHasFailed = false;
+		};
+
+		struct Creation {
+			PipelineStateHandle mHandle = 0;
+			uint32_t mGeneration = 0;
+			VkPipeline mPipeline = VK_NULL_HANDLE;
+		};
+
+		// Shared with the workers creating pipelines
+		struct Completions {
+			std::mutex mMutex;
+			std::vector<Creation> mCreations;
+			std::atomic<uint32_t> mPendingCount = 0;
+		};
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+		VkPipelineCache mPipelineCache = VK_NULL_HANDLE;
+		const ShaderLibrary& mShaders;
+
+		// Pipelines are created against this pass, it has to match the key of their state
+		VkRenderPass mRenderPass = VK_NULL_HANDLE;
+		uint64_t mRenderPassKey = 0;
+
+		std::vector<Entry> mEntries;
+		std::unordered_map<uint64_t, PipelineStateHandle> mHandlesByKey;
+
+		std::shared_ptr<Completions> mCompletions = std::make_shared<Completions>();
+		// Bumped by InvalidateAll, creations started before are dropped
+		uint32_t mGeneration = 0;
+
+	public:
+		VulkanPipelineStateCache(VkDevice device, VkPipelineCache pipelineCache, const ShaderLibrary& shaders);
+		~VulkanPipelineStateCache();
+
+		VulkanPipelineStateCache(const VulkanPipelineStateCache&) = delete;
+		VulkanPipelineStateCache& operator=(const VulkanPipelineStateCache&) = delete;
+
+		static uint64_t MakeRenderPassKey(VkFormat colorFormat, VkFormat depthFormat, VkSampleCountFlagBits samples);
+
+		/// <summary>
+		/// Returns the handle of the state, registering it if it is new. Does not create the pipeline.
+		/// </summary>
+		PipelineStateHandle GetHandle(const PipelineStateDesc& desc);
+
+		/// <summary>
+		/// Returns the pipeline of the state, creating it on first use
+		/// </summary>
+		/// <param name="async">Creates the pipeline on a worker and returns null until Update picks it up</param>
+		VkPipeline Acquire(PipelineStateHandle handle, bool async);
+
+		/// <summary>
+		/// Returns the pipeline of the state if it was created, null otherwise. Safe to call from recording threads.
+		/// </summary>
+		VkPipeline Get(PipelineStateHandle handle) const noexcept;
+
+		/// <summary>
+		/// Picks up the pipelines created by workers. To be called once per frame.
+		/// </summary>
+		void Update();
+
+		/// <summary>
+		/// Sets the pass new pipelines are created against
+		/// </summary>
+		void SetRenderPass(VkRenderPass renderPass, uint64_t renderPassKey);
+
+		/// <summary>
+		/// Blocks until no worker is creating a pipeline, to be called before destroying the render pass
+		/// </summary>
+		void WaitForPending() const;
+
+		/// <summary>
+		/// Destroys every pipeline, they are created again on their next Acquire. Handles stay valid.
+		/// To be called once the device is idle, when shaders changed.
+		/// </summary>
+		void InvalidateAll();
+
+		uint64_t GetRenderPassKey() const noexcept { return mRenderPassKey; }
+		uint32_t GetCount() const noexcept { return static_cast<uint32_t>(mEntries.size()); }
+	};
+}
@@ -5,27 +5,55 @@
 #include <vulkan/vulkan.h>
 
 #include <optional>
+#include <unordered_map>
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include "glm/glm.hpp"
 
-#include "Rendering/Vertex.h"
+#include "Resources/Texture.h"
+#include "Resources/Resources.h"
+#include "Rendering/VertexFormat.h"
+#include "Rendering/Material.h"
+#include "Rendering/RenderQueue.h"
+#include "Rendering/ShaderLibrary.h"
+#include "Rendering/ShaderVariants.h"
 #include "Rendering/Vulkan/VulkanDebugger.h"
+#include "Rendering/Vulkan/VulkanAllocator.h"
+#include "Rendering/Vulkan/VulkanPipelineStateCache.h"
 
 #include "Rendering/IRenderer.h"
 
+// Set by CMake to the engine's shader sources, so that edits are picked up without a rebuild
+#ifndef OTTER_SHADER_DIR
+#define OTTER_SHADER_DIR "../Shaders"
+#endif
+
 namespace OtterEngine {
+	struct LoadedMesh;
+
 	class VulkanRenderer : public IRenderer { 
 	public:
+		// Model matrices are per instance, see RenderQueue
 		struct UniformBufferObject {
-			alignas(16) glm::mat4 model;
 			alignas(16) glm::mat4 view;
 			alignas(16) glm::mat4 proj;
 		};
 
 	private:
+		struct Material {
+			MaterialDesc mDesc;
+		};
+
+		// Pushed for the fragment shader once per material
+		struct DrawConstants {
+			uint32_t mTextureIndex = 0;
+			uint32_t mNormalMapIndex = 0;
+
+			bool operator==(const DrawConstants&) const = default;
+		};
+
 		GLFWwindow* pWindow;
 		VkInstance mInstance = VK_NULL_HANDLE;
 
@@ -33,8 +61,19 @@ namespace OtterEngine {
 		VkDevice mDevice = VK_NULL_HANDLE;
 		
 		VkSurfaceKHR mSurface = VK_NULL_HANDLE;
+		// Textures are bound as one array updated after bind, see VulkanTextureLoader
+		bool mHasDescriptorIndexing = false;
 
 		static constexpr uint32_t MAX_ONGOING_FRAMES = 2;
+		// Indirect draws are split at this many commands so that large groups spread across recording threads
+		static constexpr uint32_t MAX_COMMANDS_PER_DRAW = 256;
+		static constexpr size_t MIN_DRAWS_PER_SLICE = 16;
+		// Materials drawn for the first time show up once their pipeline is ready instead of stalling the frame
+		static constexpr bool ASYNC_PIPELINE_CREATION = true;
+		// Meshes are drawn with their coarsest level of detail whose error covers at most this many pixels
+		static constexpr float LOD_PIXEL_ERROR = 1.0f;
+		static constexpr const char* PIPELINE_CACHE_PATH = "Cache/pipeline_cache.bin";
+		static constexpr const char* SHADER_DIRECTORY = OTTER_SHADER_DIR;
 
 #ifdef NDEBUG
 		const bool mEnableValidationLayers = false;
@@ -48,6 +87,8 @@ namespace OtterEngine {
 
 		VkQueue mGraphicsQueue = VK_NULL_HANDLE;
 		VkQueue mPresentQueue = VK_NULL_HANDLE;
+		// Same as mGraphicsQueue when the device has no transfer-only family
+		VkQueue mTransferQueue = VK_NULL_HANDLE;
 
 		VkSwapchainKHR mSwapchain = VK_NULL_HANDLE;
 		std::vector<VkImage> mSwapchainImages;
@@ -58,14 +99,16 @@ namespace OtterEngine {
 
 		VkRenderPass mRenderPass;
 		VkDescriptorSetLayout mDescriptorSetLayout = VK_NULL_HANDLE;
+		// Shared by every pipeline, variants only differ in their shaders
 		VkPipelineLayout mPipelineLayout;
-		VkPipeline mGraphicsPipeline;
 
 		VkCommandPool mCommandPool = VK_NULL_HANDLE;
 
 		std::vector<VkBuffer> mUniformBuffers;
-		std::vector<VkDeviceMemory> mUniformBuffersMemory;
+		std::vector<VulkanAllocation> mUniformBuffersAllocations;
 		std::vector<void*> mUniformBuffersMapped;
+		// Camera of the frame being recorded, levels of detail are picked from it
+		UniformBufferObject mCamera{};
 
 		VkDescriptorPool mDescriptorPool = VK_NULL_HANDLE;
 		std::vector<VkDescriptorSet> mDescriptorSets;
@@ -79,11 +122,36 @@ namespace OtterEngine {
 
 		bool mIsCleared = false;
 
+		std::unique_ptr<VulkanAllocator> mAllocator;
+		std::unique_ptr<class VulkanPipelineCache> mPipelineCache;
+		std::unique_ptr<class VulkanStagingRing> mStagingRing;
+		std::unique_ptr<class VulkanUploadQueue> mUploadQueue;
+		std::unique_ptr<class VulkanGeometryPool> mGeometryPool;
 		std::unique_ptr<class VulkanTextureLoader> mTextureLoader;
 		std::unique_ptr<class VulkanMeshLoader> mMeshLoader;
+		std::unique_ptr<class VulkanIndirectDrawer> mIndirectDrawer;
+		std::unique_ptr<class VulkanParallelRecorder> mParallelRecorder;
+
+		std::unique_ptr<ShaderLibrary> mShaderLibrary;
+		std::unique_ptr<ShaderVariantCache> mShaderVariants;
+		// PipelineIDs are handles of this cache
+		std::unique_ptr<VulkanPipelineStateCache> mPipelineStates;
+
+		RenderQueue mRenderQueue;
+		// Indexed by MaterialID
+		std::vector<Material> mMaterials;
+		// Pipeline of each material and vertex format drawn together, keyed by MaterialID then VertexFormat::GetKey
+		std::unordered_map<uint64_t, PipelineID> mMaterialPipelines;
+
+		ResourceHandle<Texture> mSceneTexture;
+		MaterialID mSceneMaterial = 0;
+
+		// Draws of the frame being recorded, with the texture slots of each material they use
+		std::vector<DrawGroup> mDrawList;
+		std::vector<DrawConstants> mMaterialConstants;
 
 		VkImage mDepthImage;
-		VkDeviceMemory mDepthImageMemory;
+		VulkanAllocation mDepthImageAllocation;
 		VkImageView mDepthImageView;
 
 		std::unique_ptr<VulkanDebugger> mVkDebugger;
@@ -99,26 +167,45 @@ namespace OtterEngine {
 		void CreateCommandPool();
 		void CreateDepthResources();
 
+		void CreateAllocator();
+		void CreatePipelineCache();
+		void LoadShaders();
+		void CreateStagingRing();
+		void CreateUploadQueue();
+		void CreateGeometryPool();
 		void CreateTextureLoader();
 		void CreateMeshLoader();
+		void CreateIndirectDrawer();
+		void CreateParallelRecorder();
 		
 		void CreateUniformBuffers();
 		void CreateDescriptorPool();
 		void CreateDescriptorSets();
+		void WriteInstanceDescriptor(uint32_t frameIndex);
 		void CreateCommandBuffers();
 		void RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+		void BuildDrawList();
+		// Called from several threads at once, only reads renderer state
+		void RecordDrawSlice(VkCommandBuffer commandBuffer, size_t begin, size_t end) const;
 		void CreateSyncObjects();
 
 		void CleanupSwapchainResources();
 		void RecreateSwapchain();
 
-		VkShaderModule CreateShaderModule(const std::vector<char>& shader) const;
-
-		void CreateGraphicsPipeline();
+		void CreatePipelineLayout();
+		void CreatePipelineStates();
+		uint64_t GetRenderPassKey() const;
+		PipelineStateDesc MakePipelineState(ShaderVariantID variantID, const VertexFormat& vertexFormat) const;
+		// Rebuilds every pipeline from shaders recompiled while running
+		void ReloadPipelines();
 
 		void CreateDescriptorSetLayout();
 
 		void UpdateUniformBuffer(uint32_t currentImage);
+		void SubmitScene();
+		uint32_t SelectLod(const LoadedMesh& mesh, const glm::mat4& model) const;
+
+		VkPipeline GetPipeline(PipelineID pipeline) const;
 
 		// Debugging and utilities
 		void SetupDebugMessenger();
@@ -129,5 +216,21 @@ namespace OtterEngine {
 		void Init() override; 
 		void Clear() override;
 		void DrawFrame() override;
+
+		/// <summary>
+		/// Instances submitted here are drawn by the next DrawFrame, the queue is emptied once it is recorded
+		/// </summary>
+		RenderQueue& GetRenderQueue() noexcept { return mRenderQueue; }
+
+		/// <summary>
+		/// Registers a material. Its shader variants are compiled as meshes of new vertex formats are drawn with it.
+		/// </summary>
+		MaterialID CreateMaterial(const MaterialDesc& desc);
+
+		/// <summary>
+		/// Pipeline to submit the material's instances of meshes in the given vertex format with.
+		/// Features needing a stream the format lacks are dropped, vertex colors or lighting without normals.
+		/// </summary>
+		PipelineID GetMaterialPipeline(MaterialID material, const VertexFormat& vertexFormat);
 	};
 }
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vulkan/vulkan.h>
+
+namespace OtterEngine {
+	/// <summary>
+	/// Parameters a sampler is shared by. Every field is 4 bytes wide, so the struct hashes without padding.
+	/// </summary>
+	struct SamplerDesc {
+		VkFilter mMagFilter = VK_FILTER_LINEAR;
+		VkFilter mMinFilter = VK_FILTER_LINEAR;
+		VkSamplerMipmapMode mMipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		VkSamplerAddressMode mAddressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		VkSamplerAddressMode mAddressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		VkSamplerAddressMode mAddressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		// Clamped to the device limit, 1 or less disables anisotropic filtering
+		float mMaxAnisotropy = 16.0f;
+
+		bool operator==(const SamplerDesc& other) const = default;
+	};
+
+	struct SamplerDescHash {
+		size_t operator()(const SamplerDesc& desc) const noexcept;
+	};
+
+	/// <summary>
+	/// Creates each distinct sampler once and hands out the same VkSampler to every texture using it.
+	/// Samplers never clamp the LOD range, one sampler serves textures of any mip count.
+	/// </summary>
+	class VulkanSamplerCache {
+	private:
+		VkDevice mDevice = VK_NULL_HANDLE;
+		float mMaxSupportedAnisotropy = 1.0f;
+
+		std::unordered_map<SamplerDesc, VkSampler, SamplerDescHash> mSamplers;
+
+	public:
+		VulkanSamplerCache() = default;
+		VulkanSamplerCache(VkDevice device, VkPhysicalDevice physicalDevice);
+		~VulkanSamplerCache();
+
+		VulkanSamplerCache(const VulkanSamplerCache&) = delete;
+		VulkanSamplerCache& operator=(const VulkanSamplerCache&) = delete;
+
+		/// <summary>
+		/// Returns the sampler matching desc, creating it on first use
+		/// </summary>
+		VkSampler Get(const SamplerDesc& desc);
+
+		/// <summary>
+		/// Destroys every sampler, none of them may still be in use
+		/// </summary>
+		void Clear();
+
+		size_t GetCount() const noexcept { return mSamplers.size(); }
+	};
+}
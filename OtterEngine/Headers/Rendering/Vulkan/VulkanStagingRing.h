@@ -0,0 +1,100 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <cstdint>
+#include <vulkan/vulkan.h>
+
+#include "Rendering/Vulkan/VulkanAllocator.h"
+
+namespace OtterEngine {
+	/// <summary>
+	/// Slice of staging memory handed out by VulkanStagingRing, written through pMapped
+	/// and read by the GPU at mOffset in mBuffer
+	/// </summary>
+	struct StagingAllocation {
+		VkBuffer mBuffer = VK_NULL_HANDLE;
+		VkDeviceSize mOffset = 0;
+		VkDeviceSize mSize = 0;
+		uint8_t* pMapped = nullptr;
+
+		explicit operator bool() const noexcept { return pMapped != nullptr; }
+	};
+
+	/// <summary>
+	/// Persistently mapped, host-coherent staging buffer used as a ring for CPU to GPU uploads.
+	/// Allocations are grouped by Commit() and recycled once the fence of their group signals,
+	/// uploads that do not fit in the ring get a dedicated buffer released the same way.
+	/// Meant to be driven from the render thread only.
+	/// </summary>
+	class VulkanStagingRing {
+	public:
+		static constexpr VkDeviceSize DEFAULT_CAPACITY = 32ull * 1024 * 1024;
+		static constexpr VkDeviceSize DEFAULT_ALIGNMENT = 16;
+
+	private:
+		struct DedicatedBuffer {
+			VkBuffer mBuffer = VK_NULL_HANDLE;
+			VulkanAllocation mAllocation;
+		};
+
+		// Allocations committed together, alive until mFence signals
+		struct Segment {
+			VkFence mFence = VK_NULL_HANDLE;
+			VkDeviceSize mByteCount = 0;
+			std::vector<DedicatedBuffer> mDedicatedBuffers;
+		};
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+		VulkanAllocator& mAllocator;
+
+		VkBuffer mBuffer = VK_NULL_HANDLE;
+		VulkanAllocation mAllocation;
+		uint8_t* pMapped = nullptr;
+		VkDeviceSize mCapacity = 0;
+
+		// Next free byte, and bytes reserved from the oldest live segment up to it
+		VkDeviceSize mHead = 0;
+		VkDeviceSize mUsedBytes = 0;
+
+		Segment mPending;
+		std::deque<Segment> mInFlight;
+
+		StagingAllocation AllocateDedicated(VkDeviceSize size);
+		bool TryAllocate(VkDeviceSize size, VkDeviceSize alignment, StagingAllocation& allocation);
+		void ReleaseSegment(Segment& segment);
+
+	public:
+		VulkanStagingRing(VulkanAllocator& allocator, VkDeviceSize capacity = DEFAULT_CAPACITY);
+		~VulkanStagingRing();
+
+		VulkanStagingRing(const VulkanStagingRing&) = delete;
+		VulkanStagingRing& operator=(const VulkanStagingRing&) = delete;
+
+		/// <summary>
+		/// Reserves size bytes of staging memory. When the ring is full, the oldest uploads are
+		/// waited for; anything that still does not fit falls back to a dedicated buffer.
+		/// </summary>
+		StagingAllocation Allocate(VkDeviceSize size, VkDeviceSize alignment = DEFAULT_ALIGNMENT);
+
+		/// <summary>
+		/// Ties every allocation made since the previous commit to the GPU work signaling fence.
+		/// The fence must not be reset before Reclaim() or Allocate() saw it signaled.
+		/// Pass VK_NULL_HANDLE when that work is already known to be complete.
+		/// </summary>
+		void Commit(VkFence fence);
+
+		/// <summary>
+		/// Recycles the committed allocations whose fence has signaled, without blocking
+		/// </summary>
+		void Reclaim();
+
+		/// <summary>
+		/// Blocks until every committed allocation can be recycled
+		/// </summary>
+		void WaitIdle();
+
+		VkDeviceSize GetCapacity()	const noexcept { return mCapacity; }
+		VkDeviceSize GetUsedBytes() const noexcept { return mUsedBytes; }
+	};
+}
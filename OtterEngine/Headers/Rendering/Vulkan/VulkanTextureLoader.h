@@ -1,45 +1,145 @@
 #pragma once
 
+#include <vector>
+#include <cstdint>
 #include <filesystem>
+#include <unordered_map>
 #include <vulkan/vulkan.h>
 
 #include "Resources/Texture.h"
 #include "Resources/Resources.h"
 #include "Utils/ITextureLoader.h"
+#include "Rendering/Vulkan/VulkanAllocator.h"
+#include "Rendering/Vulkan/VulkanUploadQueue.h"
+#include "Rendering/Vulkan/VulkanSamplerCache.h"
 
 namespace OtterEngine {
+	struct TextureResidencyStats {
+		uint32_t mResidentCount = 0;
+		VkDeviceSize mResidentBytes = 0;
+		VkDeviceSize mBudgetBytes = 0;
+		uint64_t mEvictionCount = 0;
+		uint32_t mCapacity = 0;
+	};
+
+	/// <summary>
+	/// Keeps many textures resident at once behind a single array of combined image samplers,
+	/// which shaders index with the value returned by GetTextureIndex.
+	/// With descriptor indexing the array is one update-after-bind set, partially bound, written as
+	/// textures become ready. Without it there is one fully written set per frame in flight, empty slots
+	/// pointing at a 1x1 white texture, each set being rewritten when its frame begins.
+	/// Textures not used for a few frames are evicted, least recently used first, to stay within the budget.
+	/// Samplers are shared through a cache. Meant to be driven from the render thread only.
+	/// </summary>
 	class VulkanTextureLoader final : public ITextureLoader {
+	public:
+		static constexpr uint32_t MAX_TEXTURES = 4096;
+		// Slot of the white texture, returned for anything not resident yet
+		static constexpr uint32_t DEFAULT_TEXTURE_INDEX = 0;
+		static constexpr VkDeviceSize DEFAULT_BUDGET = 512ull * 1024 * 1024;
+
 	private:
-		VkDevice mDevice;
-		VkPhysicalDevice mPhysicalDevice;
-		VkCommandPool mCommandPool;
-		VkQueue mGraphicsQueue;
+		struct ResidentTexture {
+			ResourceHandle<Texture> mHandle;
+			VkImage mImage = VK_NULL_HANDLE;
+			VulkanAllocation mAllocation;
+			VkImageView mImageView = VK_NULL_HANDLE;
+			VkSampler mSampler = VK_NULL_HANDLE;
+			VkDeviceSize mByteSize = 0;
+			uint64_t mLastUsedFrame = 0;
+			// Batch the image was uploaded in, the slot is only handed out once it completed
+			UploadTicket mUploadTicket = VulkanUploadQueue::INVALID_TICKET;
+			bool mIsReady = false;
+			bool mIsLive = false;
+		};
+
+		// Images released while frames in flight may still sample them, destroyed from mReleaseFrame on
+		struct RetiredTexture {
+			uint32_t mIndex = DEFAULT_TEXTURE_INDEX;
+			VkImage mImage = VK_NULL_HANDLE;
+			VulkanAllocation mAllocation;
+			VkImageView mImageView = VK_NULL_HANDLE;
+			UploadTicket mUploadTicket = VulkanUploadQueue::INVALID_TICKET;
+			uint64_t mReleaseFrame = 0;
+		};
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+		VkPhysicalDevice mPhysicalDevice = VK_NULL_HANDLE;
+		VulkanAllocator* pAllocator = nullptr;
+		VulkanUploadQueue* pUploadQueue = nullptr;
+		VulkanSamplerCache mSamplerCache;
+
+		bool mUseDescriptorIndexing = false;
+		uint32_t mCapacity = 1;
+		VkDescriptorSetLayout mSetLayout = VK_NULL_HANDLE;
+		VkDescriptorPool mDescriptorPool = VK_NULL_HANDLE;
+		std::vector<VkDescriptorSet> mDescriptorSets;
+		// Slots to rewrite, per descriptor set
+		std::vector<std::vector<uint32_t>> mDirtySlots;
+
+		// Indexed by descriptor slot
+		std::vector<ResidentTexture> mSlots;
+		std::vector<uint32_t> mFreeSlots;
+		std::unordered_map<AssetID, uint32_t> mSlotByAsset;
+		std::vector<RetiredTexture> mRetired;
 
-		ResourceHandle<Texture> mTextureHandle;
-		VkImage mTexture;
-		VkImageView mImageView;
-		VkDeviceMemory mTextureImageMemory;
-		VkSampler mTextureSampler;
+		uint32_t mFramesInFlight = 1;
+		uint64_t mFrame = 0;
+		VkDeviceSize mBudget = DEFAULT_BUDGET;
+		TextureResidencyStats mStats;
+
+		void CreateDescriptors();
+		void CreateDefaultTexture();
+
+		bool UploadTextureToGPU(const Texture& tex, ResidentTexture& slot);
+		uint32_t AcquireSlot(VkDeviceSize byteSize);
+		bool EvictLeastRecentlyUsed();
+		void Release(uint32_t index);
+		void MarkDirty(uint32_t index);
+		void FlushDescriptorWrites(uint32_t setIndex);
 
 	public:
 		VulkanTextureLoader() = default;
-		VulkanTextureLoader(VkDevice device, VkPhysicalDevice physicalDevice,
-			VkCommandPool commandPool, VkQueue graphicsQueue);
+		VulkanTextureLoader(VkDevice device, VkPhysicalDevice physicalDevice, VulkanAllocator* allocator,
+			VulkanUploadQueue* uploadQueue, uint32_t framesInFlight, bool useDescriptorIndexing, VkDeviceSize budget = DEFAULT_BUDGET);
 		~VulkanTextureLoader() override;
 
+		VulkanTextureLoader(const VulkanTextureLoader&) = delete;
+		VulkanTextureLoader& operator=(const VulkanTextureLoader&) = delete;
+
+		/// <summary>
+		/// Makes a texture resident, loading the same asset twice returns the first upload.
+		/// The image goes out with the next upload batch, its slot is handed out once that batch completed.
+		/// </summary>
 		ResourceHandle<Texture> LoadTexture(const std::filesystem::path& path) override;
-		void CreateTextureImageView();
-		void CreateTextureSampler();
 
-		void ClearResources();
+		/// <summary>
+		/// Releases the GPU copy of a texture, the CPU resource stays cached
+		/// </summary>
+		void UnloadTexture(const ResourceHandle<Texture>& texture);
 
-		const ResourceHandle<Texture>& GetTextureHandle() const { return mTextureHandle; }
+		/// <summary>
+		/// Slot of a texture in the descriptor array, marking it as used this frame
+		/// </summary>
+		/// <returns>DEFAULT_TEXTURE_INDEX while the texture is not resident or still uploading</returns>
+		uint32_t GetTextureIndex(const ResourceHandle<Texture>& texture);
 
-		VkImage GetCurrentImage() const { return mTexture; }
-		VkImageView GetCurrentImageView() const { return mImageView; }
-		VkSampler GetCurrentSampler() const { return mTextureSampler; }
+		/// <summary>
+		/// Advances residency by one frame and writes the pending descriptors of the frame's set,
+		/// to be called once the frame's previous submission has completed
+		/// </summary>
+		void BeginFrame(uint32_t frameIndex);
 
-	private:
-		void UploadTextureToGPU(const Texture& tex);
+		VkDescriptorSet GetDescriptorSet(uint32_t frameIndex) const { return mDescriptorSets[frameIndex % mDescriptorSets.size()]; }
+		VkDescriptorSetLayout GetDescriptorSetLayout() const noexcept { return mSetLayout; }
+
+		/// <summary>
+		/// Length of the descriptor array, shaders size their texture array with it
+		/// </summary>
+		uint32_t GetCapacity() const noexcept { return mCapacity; }
+		const TextureResidencyStats& GetStats() const noexcept { return mStats; }
+		void LogStats() const;
+
+		void ClearResources();
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <span>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <vulkan/vulkan.h>
+
+#include "Rendering/Vulkan/VulkanStagingRing.h"
+
+namespace OtterEngine {
+	/// <summary>
+	/// Identifies the batch an upload was recorded in, 0 means "nothing to wait for"
+	/// </summary>
+	using UploadTicket = uint64_t;
+
+	/// <summary>
+	/// Records CPU to GPU copies and their barriers into one command buffer per batch and submits
+	/// the batch with a fence, on a dedicated transfer queue when the device has one.
+	/// Resources uploaded through a transfer queue are handed over to the graphics queue with a
+	/// release/acquire barrier pair, the acquire being submitted on the graphics queue right after
+	/// the transfer, so later frames never need to wait on uploads explicitly.
+	/// Meant to be driven from the render thread only.
+	/// </summary>
+	class VulkanUploadQueue {
+	public:
+		static constexpr UploadTicket INVALID_TICKET = 0;
+
+	private:
+		struct Batch {
+			UploadTicket mTicket = INVALID_TICKET;
+			VkCommandBuffer mTransferCommands = VK_NULL_HANDLE;
+			// Acquire barriers, only used with a dedicated transfer queue
+			VkCommandBuffer mAcquireCommands = VK_NULL_HANDLE;
+			VkSemaphore mTransferDone = VK_NULL_HANDLE;
+			VkFence mFence = VK_NULL_HANDLE;
+
+			// Barriers making the copied data visible to the graphics queue, emitted on submit
+			std::vector<VkBufferMemoryBarrier> mBufferBarriers;
+			std::vector<VkImageMemoryBarrier> mImageBarriers;
+			VkPipelineStageFlags mDstStages = 0;
+		};
+
+		VkDevice mDevice = VK_NULL_HANDLE;
+		VulkanStagingRing& mStagingRing;
+
+		VkQueue mTransferQueue = VK_NULL_HANDLE;
+		uint32_t mTransferFamily = 0;
+		VkQueue mGraphicsQueue = VK_NULL_HANDLE;
+		uint32_t mGraphicsFamily = 0;
+
+		VkCommandPool mTransferPool = VK_NULL_HANDLE;
+		VkCommandPool mAcquirePool = VK_NULL_HANDLE;
+
+		std::vector<std::unique_ptr<Batch>> mBatches;
+		std::vector<Batch*> mFreeBatches;
+		std::deque<Batch*> mInFlight;
+		Batch* pRecording = nullptr;
+
+		UploadTicket mNextTicket = 1;
+		UploadTicket mCompletedTicket = INVALID_TICKET;
+
+		bool HasDedicatedTransferQueue() const noexcept { return mTransferFamily != mGraphicsFamily; }
+
+		Batch& GetRecordingBatch();
+		Batch* CreateBatch();
+		void RetireOldest();
+
+	public:
+		VulkanUploadQueue(VkDevice device, VulkanStagingRing& stagingRing,
+			VkQueue transferQueue, uint32_t transferFamily,
+			VkQueue graphicsQueue, uint32_t graphicsFamily);
+		~VulkanUploadQueue();
+
+		VulkanUploadQueue(const VulkanUploadQueue&) = delete;
+		VulkanUploadQueue& operator=(const VulkanUploadQueue&) = delete;
+
+		/// <summary>
+		/// Reserves staging memory, released once the batch it is copied from completes
+		/// </summary>
+		StagingAllocation AllocateStaging(VkDeviceSize size, VkDeviceSize alignment = VulkanStagingRing::DEFAULT_ALIGNMENT);
+
+		/// <summary>
+		/// Records a copy into an exclusive buffer owned by the graphics queue, made visible to
+		/// dstAccess at dstStage once the batch is submitted
+		/// </summary>
+		UploadTicket CopyBuffer(VkBuffer src, VkDeviceSize srcOffset, VkBuffer dst, VkDeviceSize dstOffset, VkDeviceSize size,
+			VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+
+		/// <summary>
+		/// Records the upload of every region of a freshly created image. The image goes from
+		/// UNDEFINED to finalLayout, readable by dstAccess at dstStage once the batch is submitted.
+		/// </summary>
+		UploadTicket UploadImage(VkBuffer src, VkImage image, uint32_t mipLevels, std::span<const VkBufferImageCopy> regions,
+			VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			VkAccessFlags dstAccess = VK_ACCESS_SHADER_READ_BIT);
+
+		/// <summary>
+		/// Submits everything recorded so far as one batch
+		/// </summary>
+		/// <returns>The ticket of the submitted batch, INVALID_TICKET if nothing was recorded</returns>
+		UploadTicket Submit();
+
+		/// <summary>
+		/// Retires the batches that completed, without blocking
+		/// </summary>
+		void Poll();
+
+		/// <summary>
+		/// Tells whether the batch of the ticket completed, without blocking
+		/// </summary>
+		bool IsComplete(UploadTicket ticket);
+
+		/// <summary>
+		/// Blocks until the batch of the ticket completed, submitting it first if needed
+		/// </summary>
+		void Wait(UploadTicket ticket);
+
+		void WaitIdle();
+
+		uint32_t GetTransferFamily() const noexcept { return mTransferFamily; }
+	};
+}
@@ -3,18 +3,22 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
+#include <span>
 #include <array>
 #include <string>
 #include <vector>
 #include <optional>
 #include <vulkan/vulkan.h>
 
-#include "Rendering/Vertex.h"
+#include "Rendering/VertexFormat.h"
+#include "Rendering/Vulkan/VulkanAllocator.h"
 
 namespace OtterEngine {
 	struct QueueFamilyIndices {
 		std::optional<uint32_t> mGraphicsFamily = UINT32_MAX;
 		std::optional<uint32_t> mPresentFamily = UINT32_MAX;
+		// Transfer-only family for asynchronous uploads, empty when the device has none
+		std::optional<uint32_t> mTransferFamily;
 		bool IsComplete() const {
 			return mGraphicsFamily != UINT32_MAX && mPresentFamily != UINT32_MAX;
 		}
@@ -30,22 +34,37 @@ namespace OtterEngine {
 	public:
 		static uint32_t FindMemoryType(VkPhysicalDevice device, uint32_t filter, VkMemoryPropertyFlags properties);
 
-		static void CreateNewBuffer(VkDevice device, VkPhysicalDevice physDevice, VkDeviceSize size, VkBufferUsageFlags usages, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+		/// <summary>
+		/// Creates a buffer backed by memory sub-allocated from the given allocator
+		/// </summary>
+		static void CreateNewBuffer(VulkanAllocator& allocator, VkDeviceSize size, VkBufferUsageFlags usages, VkMemoryPropertyFlags properties, VkBuffer& buffer, VulkanAllocation& bufferAllocation);
 
-		static void CreateVkImage(VkDevice device, VkPhysicalDevice physDevice, VkImage& img, VkDeviceMemory& imgMem, uint32_t w, uint32_t h, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties);
+		/// <summary>
+		/// Creates a 2D image backed by memory sub-allocated from the given allocator
+		/// </summary>
+		static void CreateVkImage(VulkanAllocator& allocator, VkImage& img, VulkanAllocation& imgAllocation, uint32_t w, uint32_t h, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, uint32_t mipLevels = 1);
 
-		static VkImageView CreateImageView(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
+		static VkImageView CreateImageView(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels = 1);
 
 		static VkCommandBuffer BeginSingleTimeCommandBuffer(VkDevice device, VkCommandPool commandPool);
 
+		/// <summary>
+		/// Submits a command buffer from BeginSingleTimeCommandBuffer and blocks until it has executed.
+		/// Only meant for one-off work, uploads go through VulkanUploadQueue.
+		/// </summary>
 		static void EndSingleTimeCommandBuffer(VkDevice device, VkCommandBuffer buffer, VkCommandPool pool, VkQueue grQueue);
 
-		static void CopyBuffer(VkDevice device, VkQueue queue, VkCommandPool cmdPool, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+		static void CopyBuffer(VkDevice device, VkQueue queue, VkCommandPool cmdPool, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset = 0, VkDeviceSize dstOffset = 0);
 
-		static void TransitionImageLayout(VkDevice device, VkCommandPool cmdPool, VkImage image, VkQueue grQueue, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
+		static void TransitionImageLayout(VkDevice device, VkCommandPool cmdPool, VkImage image, VkQueue grQueue, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels = 1);
 
 		static void CopyBufferToImage(VkDevice device, VkCommandPool commandPool, VkQueue grQueue, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
 
+		/// <summary>
+		/// Copies several regions of a buffer, such as every mip level of an image, with a single command
+		/// </summary>
+		static void CopyBufferToImage(VkDevice device, VkCommandPool commandPool, VkQueue grQueue, VkBuffer buffer, VkImage image, std::span<const VkBufferImageCopy> regions);
+
 		static bool HasStencilComponent(VkFormat format) {
 			return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
 		}
@@ -108,6 +127,11 @@ namespace OtterEngine {
 
 		static bool IsDeviceSuitable(VkPhysicalDevice device, VkSurfaceKHR surface, std::vector<const char*> deviceExtensions);
 
+		/// <summary>
+		/// Tells whether the device can keep a partially bound sampled image array updated after bind (Vulkan 1.2 descriptor indexing)
+		/// </summary>
+		static bool SupportsDescriptorIndexing(VkPhysicalDevice device);
+
 		static bool CheckDeviceExtensionSupport(VkPhysicalDevice device, std::vector<const char*> deviceExtensions);
 
 		static SwapchainSupportDetails QuerySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface);
@@ -121,36 +145,59 @@ namespace OtterEngine {
 		static bool CheckValidationLayerSupport(const std::vector<const char*>& validationLayers);
 	};
 
+	/// <summary>
+	/// Vertex input of a packed vertex format, one interleaved binding with an attribute per stored stream.
+	/// Locations are fixed per attribute, see Shaders/triangle.vert.
+	/// </summary>
 	struct VertexLayout {
-		static VkVertexInputBindingDescription GetBindingDescription() {
+		static constexpr uint32_t POSITION_LOCATION = 0;
+		static constexpr uint32_t NORMAL_LOCATION = 1;
+		static constexpr uint32_t TEXCOORD_LOCATION = 2;
+		static constexpr uint32_t COLOR_LOCATION = 3;
+
+		static VkVertexInputBindingDescription GetBindingDescription(const VertexFormat& format) {
 			VkVertexInputBindingDescription bindingDescription{};
 			bindingDescription.binding = 0;
-			bindingDescription.stride = sizeof(Vertex);
+			bindingDescription.stride = format.GetStride();
 			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 			return bindingDescription;
 		}
 
-		static std::array<VkVertexInputAttributeDescription, 4> GetAttributeDescriptions() {
-			std::array<VkVertexInputAttributeDescription, 4> attributeDescriptions{};
-			attributeDescriptions[0].binding = 0;
-			attributeDescriptions[0].location = 0;
-			attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT; // vec3
-			attributeDescriptions[0].offset = offsetof(Vertex, mPosition);
-
-			attributeDescriptions[1].binding = 0;
-			attributeDescriptions[1].location = 1;
-			attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT; // vec3
-			attributeDescriptions[1].offset = offsetof(Vertex, mNormal);
-
-			attributeDescriptions[2].binding = 0;
-			attributeDescriptions[2].location = 2;
-			attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT; // vec2
-			attributeDescriptions[2].offset = offsetof(Vertex, mTexCoord);
-
-			attributeDescriptions[3].binding = 0;
-			attributeDescriptions[3].location = 3;
-			attributeDescriptions[3].format = VK_FORMAT_R32G32B32_SFLOAT; // vec3
-			attributeDescriptions[3].offset = offsetof(Vertex, mColor);
+		static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions(const VertexFormat& format) {
+			const VertexAttributeOffsets offsets = format.GetOffsets();
+			std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+
+			VkVertexInputAttributeDescription& position = attributeDescriptions.emplace_back();
+			position.binding = 0;
+			position.location = POSITION_LOCATION;
+			position.format = format.mPosition == PositionEncoding::Float16
+				? VK_FORMAT_R16G16B16A16_SFLOAT // w is 1
+				: VK_FORMAT_R32G32B32_SFLOAT;
+			position.offset = offsets.mPosition;
+
+			if (format.HasNormals()) {
+				VkVertexInputAttributeDescription& normal = attributeDescriptions.emplace_back();
+				normal.binding = 0;
+				normal.location = NORMAL_LOCATION;
+				normal.format = format.mNormal == NormalEncoding::Octahedral16
+					? VK_FORMAT_R16G16_SNORM // Decoded by the vertex shader
+					: VK_FORMAT_R32G32B32_SFLOAT;
+				normal.offset = offsets.mNormal;
+			}
+
+			VkVertexInputAttributeDescription& texCoord = attributeDescriptions.emplace_back();
+			texCoord.binding = 0;
+			texCoord.location = TEXCOORD_LOCATION;
+			texCoord.format = format.mTexCoord == TexCoordEncoding::Unorm16 ? VK_FORMAT_R16G16_UNORM : VK_FORMAT_R32G32_SFLOAT;
+			texCoord.offset = offsets.mTexCoord;
+
+			if (format.HasColors()) {
+				VkVertexInputAttributeDescription& color = attributeDescriptions.emplace_back();
+				color.binding = 0;
+				color.location = COLOR_LOCATION;
+				color.format = VK_FORMAT_R8G8B8A8_UNORM;
+				color.offset = offsets.mColor;
+			}
 
 			return attributeDescriptions;
 		}
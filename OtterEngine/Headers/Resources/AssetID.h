@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+namespace OtterEngine {
+
+	// Stable identifier of an asset, derived from its path relative to the resources folder
+	using AssetID = uint64_t;
+
+	inline constexpr AssetID INVALID_ASSET_ID = 0;
+
+	/// <summary>
+	/// Interns asset paths into 64-bit IDs. The ID of a path is the FNV-1a hash of its
+	/// normalized generic form, so it is the same across runs and platforms.
+	/// Safe to use from any thread.
+	/// </summary>
+	class AssetRegistry final {
+	public:
+		/// <summary>
+		/// Hashes a path into its ID without registering it
+		/// </summary>
+		static AssetID MakeID(const std::filesystem::path& path);
+
+		/// <summary>
+		/// Returns the ID of a path and remembers the path it was made from
+		/// </summary>
+		/// <returns>The ID, or INVALID_ASSET_ID if another path already has it</returns>
+		static AssetID Intern(const std::filesystem::path& path);
+
+		/// <summary>
+		/// Registers a path under an ID made beforehand, such as one stored in cooked data
+		/// </summary>
+		/// <returns>The ID, or INVALID_ASSET_ID if another path already has it</returns>
+		static AssetID Intern(const std::filesystem::path& path, AssetID id);
+
+		/// <summary>
+		/// Returns the path an ID was interned from
+		/// </summary>
+		/// <returns>A reference valid for the whole program, to an empty path if the ID is unknown</returns>
+		static const std::filesystem::path& GetPath(AssetID id);
+	};
+}
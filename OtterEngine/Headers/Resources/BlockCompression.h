@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "Resources/TextureFormat.h"
+
+namespace OtterEngine {
+
+	/// <summary>
+	/// CPU encoder and decoder of the GPU block-compressed texture formats.
+	/// Blocks cover 4x4 pixels, passed around as 16 RGBA8 pixels in row-major order.
+	/// </summary>
+	class BlockCompression final {
+	public:
+		static constexpr uint32_t BLOCK_DIMENSION = 4;
+		static constexpr uint32_t BLOCK_PIXEL_COUNT = BLOCK_DIMENSION * BLOCK_DIMENSION;
+
+		/// <summary>
+		/// Returns the bytes taken by one block, or by one pixel for uncompressed textures
+		/// </summary>
+		static size_t GetBlockByteSize(TextureCompression compression);
+
+		/// <summary>
+		/// Returns the bytes taken by an image of the given size
+		/// </summary>
+		static size_t GetImageByteSize(TextureCompression compression, uint32_t width, uint32_t height);
+
+		/// <summary>
+		/// Compresses a whole RGBA8 image, rows of blocks are encoded in parallel on the job system.
+		/// Blocks crossing the right or bottom edge are padded by repeating the edge pixels.
+		/// </summary>
+		static std::vector<uint8_t> Compress(TextureCompression compression, const uint8_t* pixels, uint32_t width, uint32_t height);
+
+		/// <summary>
+		/// Expands a compressed image back to RGBA8
+		/// </summary>
+		static std::vector<uint8_t> Decompress(TextureCompression compression, const uint8_t* blocks, uint32_t width, uint32_t height);
+
+		/// <summary>
+		/// Encodes a BC1 block, using the 3-color mode with transparency if any pixel has alpha below 128
+		/// </summary>
+		static void EncodeBC1Block(const uint8_t* pixels, uint8_t* output);
+		static void DecodeBC1Block(const uint8_t* input, uint8_t* pixels);
+
+		/// <summary>
+		/// Encodes a BC7 block in mode 6: a single RGBA subset with 7-bit endpoints, p-bits and 4-bit indices
+		/// </summary>
+		static void EncodeBC7Block(const uint8_t* pixels, uint8_t* output);
+
+		/// <summary>
+		/// Decodes a BC7 block. Only mode 6, the one written by EncodeBC7Block, is supported.
+		/// </summary>
+		/// <returns>False if the block uses another mode, its pixels are then filled with opaque magenta</returns>
+		static bool DecodeBC7Block(const uint8_t* input, uint8_t* pixels);
+	};
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <span>
 #include <memory>
 #include <vector>
 #include <cstdint>
@@ -7,29 +8,178 @@
 
 #include "Core/Logger.h"
 #include "Rendering/Vertex.h"
+#include "Rendering/VertexFormat.h"
+#include "Utils/MappedFile.h"
+#include "Resources/MeshOptimizer.h"
+#include "Resources/MeshSimplifier.h"
+#include "Resources/MeshletBuilder.h"
 #include "Resources/Resources.h"
 
 namespace OtterEngine {
+	struct MeshBounds {
+		glm::vec3 mMin{ 0.0f };
+		glm::vec3 mMax{ 0.0f };
+	};
+
+	enum class IndexType : uint8_t {
+		UInt16,
+		UInt32
+	};
+
+	/// <summary>
+	/// Triangles drawn with one indexed draw: indices are relative to mFirstVertex, so that 16-bit indices can
+	/// address meshes of any size one chunk at a time. Counts are in vertices and indices of the mesh.
+	/// </summary>
+	struct MeshChunk {
+		uint32_t mFirstIndex = 0;
+		uint32_t mIndexCount = 0;
+		uint32_t mFirstVertex = 0;
+		uint32_t mVertexCount = 0;
+		// Meshlets partitioning the chunk's triangles, their vertices are relative to mFirstVertex as well
+		uint32_t mFirstMeshlet = 0;
+		uint32_t mMeshletCount = 0;
+	};
+
+	/// <summary>
+	/// One level of detail, drawn with its own chunks and vertices. Level 0 is the imported mesh.
+	/// </summary>
+	struct MeshLod {
+		uint32_t mFirstChunk = 0;
+		uint32_t mChunkCount = 0;
+		// Largest distance to the base mesh in model units, grows with the level
+		float mError = 0.0f;
+	};
+
+	struct MeshImportSettings {
+		// Threads assembling OBJ shapes in parallel, 0 uses every job system worker and 1 imports serially.
+		// The imported vertex and index order does not depend on this value.
+		uint32_t mImportThreads = 0;
+
+		// Reorders the deduplicated triangles and vertices for the GPU caches, see MeshOptimizer
+		bool mOptimize = true;
+		MeshOptimizationSettings mOptimization;
+
+		// Imported vertices are packed in the most compact format these bounds allow
+		VertexQuantizationSettings mQuantization;
+
+		// Coarser levels of detail are simplified from the imported mesh and stored along with it
+		bool mGenerateLods = true;
+		MeshSimplificationSettings mSimplification;
+
+		// Meshes over 65536 vertices are cut in chunks with 16-bit indices when the vertices duplicated along the
+		// cuts take less memory than the index bytes saved, they keep 32-bit indices otherwise
+		bool mSplitLargeMeshes = true;
+
+		// Every chunk is partitioned in meshlets with bounds and normal cones, for cluster culling
+		bool mBuildMeshlets = true;
+		MeshletSettings mMeshlets;
+	};
+
 	class Mesh {
 	private:
-		std::vector<Vertex> mVertices;
-		std::vector<uint32_t> mIndices;
+		static inline MeshImportSettings sImportSettings;
+
+		VertexFormat mVertexFormat;
+		IndexType mIndexType = IndexType::UInt32;
+		std::vector<std::byte> mVertexData;
+		std::vector<std::byte> mIndexData;
+		std::vector<MeshChunk> mChunks;
+		std::vector<MeshLod> mLods;
+		MeshletGeometry mMeshletGeometry;
+
+		// Cooked meshes keep their file mapped and read every block in place
+		std::unique_ptr<MappedFile> mMappedFile;
+
+		// Vertices packed in mVertexFormat, indices of mIndexType
+		std::span<const std::byte> mVertexView;
+		std::span<const std::byte> mIndexView;
+		std::span<const MeshChunk> mChunkView;
+		std::span<const MeshLod> mLodView;
+		std::span<const Meshlet> mMeshletView;
+		std::span<const uint32_t> mMeshletVertexView;
+		std::span<const uint8_t> mMeshletTriangleView;
+
+		MeshBounds mBounds;
+		uint64_t mImportSettingsHash = 0;
+
+		/// <summary>
+		/// Maps a cooked mesh file
+		/// </summary>
+		/// <param name="requireCurrentSettings">Rejects a file cooked with other import settings than the current ones</param>
+		static std::shared_ptr<Mesh> LoadCooked(const std::filesystem::path& path, bool requireCurrentSettings);
+
 	public:
 		Mesh() = default;
-		Mesh(std::vector<Vertex> vertices, std::vector<uint32_t> indices)
-			: mVertices(std::move(vertices)), mIndices(std::move(indices)) {
-		}
+		/// <summary>
+		/// Packs the vertices in the format the import settings choose for them, and the indices in 16 bits when possible
+		/// </summary>
+		Mesh(std::span<const Vertex> vertices, std::span<const uint32_t> indices);
+		/// <summary>
+		/// Packs every level of detail one after the other, the first one being the base mesh
+		/// </summary>
+		explicit Mesh(std::span<const MeshLodGeometry> lods);
+		Mesh(std::unique_ptr<MappedFile> mappedFile, const VertexFormat& vertexFormat, std::span<const std::byte> vertexData,
+			IndexType indexType, std::span<const std::byte> indexData, std::span<const MeshChunk> chunks, std::span<const MeshLod> lods,
+			std::span<const Meshlet> meshlets, std::span<const uint32_t> meshletVertices, std::span<const uint8_t> meshletTriangles,
+			const MeshBounds& bounds);
+
+		// Views may point into the owned vectors, copying would leave them dangling
+		Mesh(const Mesh&) = delete;
+		Mesh& operator=(const Mesh&) = delete;
 
 		// Resource concept requires static LoadFromFile and IsValid methods
 		static std::shared_ptr<Mesh> LoadFromFile(const std::filesystem::path& path);
-		bool IsValid() const { return !mVertices.empty() && !mIndices.empty(); }
+		bool IsValid() const { return !mVertexView.empty() && !mIndexView.empty() && !mChunkView.empty() && !mLodView.empty(); }
+
+		/// <summary>
+		/// Parses and triangulates a Wavefront .obj file, ignoring any cooked copy of it
+		/// </summary>
+		static std::shared_ptr<Mesh> ImportObj(const std::filesystem::path& path);
+
+		// Import settings are meant to be configured once at startup, before any load
+		static void SetImportSettings(const MeshImportSettings& settings) { sImportSettings = settings; }
+		static const MeshImportSettings& GetImportSettings() { return sImportSettings; }
+
+		/// <summary>
+		/// Hashes every setting changing the imported mesh, the import thread count does not
+		/// </summary>
+		static uint64_t HashImportSettings(const MeshImportSettings& settings);
+
+		/// <summary>
+		/// Unpacks the vertices to full precision, for CPU processing
+		/// </summary>
+		std::vector<Vertex> DecodeVertices() const { return OtterEngine::DecodeVertices(mVertexView, mVertexFormat); }
+
+		/// <summary>
+		/// Widens the indices of a level to 32 bits and rebases them on the first vertex of the mesh, for CPU processing
+		/// </summary>
+		std::vector<uint32_t> DecodeIndices(uint32_t lod = 0) const;
+
+		std::span<const std::byte> GetVertexData()   const { return mVertexView; }
+		std::span<const std::byte> GetIndexData()	 const { return mIndexView; }
+		std::span<const MeshChunk> GetChunks()	     const { return mChunkView; }
+		std::span<const MeshLod>   GetLods()		 const { return mLodView; }
+		std::span<const Meshlet>   GetMeshlets()	 const { return mMeshletView; }
+		std::span<const Meshlet>   GetMeshlets(const MeshChunk& chunk) const { return mMeshletView.subspan(chunk.mFirstMeshlet, chunk.mMeshletCount); }
+		// Indices of meshlet vertices relative to the first vertex of their chunk, see Meshlet
+		std::span<const uint32_t>  GetMeshletVertices()  const { return mMeshletVertexView; }
+		// Three 8-bit corners per meshlet triangle, into the meshlet's own vertices
+		std::span<const uint8_t>   GetMeshletTriangles() const { return mMeshletTriangleView; }
+		const VertexFormat&		   GetVertexFormat() const { return mVertexFormat; }
+		IndexType				   GetIndexType()	 const { return mIndexType; }
+		const MeshBounds&		   GetBounds()	     const { return mBounds; }
+		// Hash of the import settings the mesh was built with, see HashImportSettings
+		uint64_t				   GetImportSettingsHash() const { return mImportSettingsHash; }
 
-		const std::vector<Vertex>& GetVertices()  const { return mVertices; }
-		const std::vector<uint32_t>& GetIndices() const { return mIndices; }
+		bool IsMemoryMapped() const { return mMappedFile != nullptr; }
 
-		size_t GetVertexCount()		 const { return mVertices.size(); }
-		size_t GetIndexCount()		 const { return mIndices.size(); }
-		size_t GetVertexBufferSize() const { return mVertices.size() * sizeof(Vertex); }
-		size_t GetIndexBufferSize()  const { return mIndices.size() * sizeof(uint32_t); }
+		uint32_t GetVertexStride()	 const { return mVertexFormat.GetStride(); }
+		uint32_t GetIndexStride()	 const { return mIndexType == IndexType::UInt16 ? sizeof(uint16_t) : sizeof(uint32_t); }
+		size_t GetVertexCount()		 const { return mVertexView.size() / GetVertexStride(); }
+		size_t GetIndexCount()		 const { return mIndexView.size() / GetIndexStride(); }
+		size_t GetVertexBufferSize() const { return mVertexView.size_bytes(); }
+		size_t GetIndexBufferSize()  const { return mIndexView.size_bytes(); }
+		size_t GetMeshletDataSize()	 const { return mMeshletView.size_bytes() + mMeshletVertexView.size_bytes() + mMeshletTriangleView.size_bytes(); }
+		size_t GetByteSize()		 const { return GetVertexBufferSize() + GetIndexBufferSize() + mChunkView.size_bytes() + mLodView.size_bytes() + GetMeshletDataSize(); }
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <filesystem>
+
+#include "Resources/Mesh.h"
+
+namespace OtterEngine {
+
+	/// <summary>
+	/// Offline conversion of source meshes into the binary cooked format,
+	/// which Mesh::LoadFromFile memory-maps instead of parsing
+	/// </summary>
+	class MeshCooker {
+	public:
+		/// <summary>
+		/// Imports a source mesh and writes its cooked version
+		/// </summary>
+		/// <param name="source">Path to the source mesh (.obj)</param>
+		/// <param name="destination">Output path, defaults to the source path with the cooked extension</param>
+		/// <returns>True if the cooked file has been written</returns>
+		static bool Cook(const std::filesystem::path& source, std::filesystem::path destination = {});
+
+		/// <summary>
+		/// Serializes an already loaded mesh in the cooked format
+		/// </summary>
+		/// <returns>True if the cooked file has been written</returns>
+		static bool Write(const Mesh& mesh, const std::filesystem::path& destination);
+	};
+}
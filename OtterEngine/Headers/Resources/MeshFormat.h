@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace OtterEngine {
+
+	// Binary layout of a cooked mesh file (.omesh):
+	// [CookedMeshHeader][vertex block][index block][chunk block][LOD block]
+	// [meshlet block][meshlet vertex block][meshlet triangle block]
+	// Every block starts at an offset aligned to COOKED_MESH_BLOCK_ALIGNMENT,
+	// so a memory-mapped file can be read in place without copies.
+	inline constexpr uint32_t COOKED_MESH_MAGIC = 0x48534D4F; // "OMSH"
+	inline constexpr uint32_t COOKED_MESH_VERSION = 6;
+	inline constexpr uint64_t COOKED_MESH_BLOCK_ALIGNMENT = 16;
+	inline constexpr const char* COOKED_MESH_EXTENSION = ".omesh";
+
+	struct CookedMeshHeader {
+		uint32_t mMagic = COOKED_MESH_MAGIC;
+		uint32_t mVersion = COOKED_MESH_VERSION;
+		uint32_t mVertexStride = 0;
+		// 2 or 4 bytes, 16-bit indices are relative to the first vertex of their chunk
+		uint32_t mIndexStride = 0;
+		// VertexFormat::GetKey of the packed vertices
+		uint32_t mVertexFormat = 0;
+		uint32_t mReserved = 0;
+
+		uint64_t mVertexCount = 0;
+		uint64_t mIndexCount = 0;
+
+		// Mesh::HashImportSettings of the settings the mesh was imported with, a cooked file
+		// imported differently than the current settings would is stale
+		uint64_t mImportSettingsHash = 0;
+
+		// Byte offsets from the beginning of the file
+		uint64_t mVertexOffset = 0;
+		uint64_t mIndexOffset = 0;
+
+		// Array of MeshChunk
+		uint64_t mChunkCount = 0;
+		uint64_t mChunkOffset = 0;
+
+		// Array of MeshLod, the first one is the base mesh
+		uint64_t mLodCount = 0;
+		uint64_t mLodOffset = 0;
+
+		// Arrays of Meshlet, of uint32_t vertices relative to their chunk and of uint8_t triangle corners,
+		// empty when the mesh was cooked without meshlets
+		uint64_t mMeshletCount = 0;
+		uint64_t mMeshletOffset = 0;
+		uint64_t mMeshletVertexCount = 0;
+		uint64_t mMeshletVertexOffset = 0;
+		uint64_t mMeshletTriangleCount = 0;
+		uint64_t mMeshletTriangleOffset = 0;
+
+		float mBoundsMin[3] = { 0.0f, 0.0f, 0.0f };
+		float mBoundsMax[3] = { 0.0f, 0.0f, 0.0f };
+	};
+
+	constexpr uint64_t AlignCookedOffset(uint64_t offset) noexcept {
+		return (offset + COOKED_MESH_BLOCK_ALIGNMENT - 1) & ~(COOKED_MESH_BLOCK_ALIGNMENT - 1);
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstdint>
+
+#include "Rendering/Vertex.h"
+
+namespace OtterEngine {
+	/// <summary>
+	/// Transformed vertices of an index buffer on a simulated FIFO post-transform cache
+	/// </summary>
+	struct VertexCacheStats {
+		uint32_t mTransformedVertices = 0;
+		// Average cache miss ratio, transformed vertices per triangle: 0.5 at best on regular grids, 3 at worst
+		float mAcmr = 0.0f;
+		// Average transform to vertex ratio, transformed vertices per vertex: 1 at best
+		float mAtvr = 0.0f;
+	};
+
+	struct MeshOptimizationSettings {
+		// Entries of the simulated post-transform cache, small enough for every GPU
+		uint32_t mCacheSize = 16;
+		// How much worse the ACMR may get to cut the triangle order in more clusters for the overdraw pass, 1 disables it
+		float mOverdrawThreshold = 1.05f;
+	};
+
+	/// <summary>
+	/// Import-time reordering of triangles and vertices for the GPU. Triangles are ordered for the post-transform cache
+	/// with Tipsify, then its clusters are sorted outside-in so that front faces tend to be drawn first, then vertices
+	/// are renumbered in order of first use for fetch locality. Only orders change, the mesh draws the same.
+	/// </summary>
+	class MeshOptimizer {
+	public:
+		/// <summary>
+		/// Runs every pass in order and logs the cache stats before and after
+		/// </summary>
+		static void Optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const MeshOptimizationSettings& settings);
+
+		/// <summary>
+		/// Simulates a FIFO cache of the given size over the triangle list
+		/// </summary>
+		static VertexCacheStats AnalyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize);
+
+		/// <summary>
+		/// Reorders triangles with Tipsify (Sander, Nehab and Barczak 2007)
+		/// </summary>
+		/// <param name="clusters">Receives the first triangle of every run ended by a dead end, where the cache starts over</param>
+		static std::vector<uint32_t> OptimizeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize,
+			std::vector<uint32_t>* clusters = nullptr);
+
+		/// <summary>
+		/// Splits the clusters further where the cache is warm enough to stay within threshold times the ACMR of the
+		/// whole mesh, then sorts them by how much they face away from the mesh center
+		/// </summary>
+		/// <param name="clusters">First triangle of each cluster of the index order, as given by OptimizeVertexCache</param>
+		static void OptimizeOverdraw(std::span<uint32_t> indices, std::span<const Vertex> vertices, std::span<const uint32_t> clusters,
+			uint32_t cacheSize, float threshold);
+
+		/// <summary>
+		/// Renumbers vertices in order of first use and drops unused ones
+		/// </summary>
+		static void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::span<uint32_t> indices);
+	};
+}
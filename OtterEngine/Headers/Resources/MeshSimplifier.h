@@ -0,0 +1,61 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstdint>
+
+#include "Rendering/Vertex.h"
+
+namespace OtterEngine {
+	struct MeshSimplificationSettings {
+		// Triangle count of each level after the base one, relative to the base mesh, from finest to coarsest
+		std::vector<float> mTriangleRatios = { 0.5f, 0.25f, 0.125f };
+		// Largest error a level may reach, relative to the radius of the mesh bounds
+		float mMaxError = 0.02f;
+		// How much normals and texture coordinates count in the error next to positions, 0 ignores them
+		float mNormalWeight = 0.5f;
+		float mTexCoordWeight = 0.5f;
+		// The chain stops at a level keeping more than this ratio of the previous level's triangles
+		float mMinReduction = 0.85f;
+	};
+
+	/// <summary>
+	/// Vertices and indices of one level of detail while importing
+	/// </summary>
+	struct MeshLodGeometry {
+		std::vector<Vertex> mVertices;
+		std::vector<uint32_t> mIndices;
+		// Largest distance from positions to the base mesh in model units, normals and texture coordinates left out
+		float mError = 0.0f;
+	};
+
+	/// <summary>
+	/// Edge collapse simplification driven by quadric error metrics over positions, normals and texture coordinates
+	/// (Garland and Heckbert 1998). Vertices only collapse onto one of their neighbours, so levels reuse the base
+	/// vertices and keep their exact attributes. Vertices on open borders only slide along them, and the two vertices
+	/// of an attribute seam only slide along it together. Positions shared by more than two vertices and non-manifold
+	/// edges never move, so flat shaded meshes do not simplify.
+	/// </summary>
+	class MeshSimplifier {
+	public:
+		// Changes whenever the same input and settings give other levels, cooked meshes are stale across it
+		static constexpr uint32_t VERSION = 2;
+
+		/// <summary>
+		/// Simplifies the mesh once per triangle ratio, each level continuing from the previous one
+		/// </summary>
+		/// <returns>The levels after the base mesh, each with only the vertices it uses. Fewer than asked when
+		/// the error bound is reached or the mesh cannot be reduced further.</returns>
+		static std::vector<MeshLodGeometry> BuildLodChain(std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+			const MeshSimplificationSettings& settings);
+
+		/// <summary>
+		/// Collapses edges by increasing error until the target index count or the error bound is reached
+		/// </summary>
+		/// <param name="maxError">Largest error allowed, normals and texture coordinates counted in, in model units</param>
+		/// <param name="resultError">Receives the largest distance reached by positions, in model units</param>
+		/// <returns>Indices of the simplified mesh into the given vertices</returns>
+		static std::vector<uint32_t> Simplify(std::span<const Vertex> vertices, std::span<const uint32_t> indices, size_t targetIndexCount,
+			float maxError, const MeshSimplificationSettings& settings, float* resultError = nullptr);
+	};
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstdint>
+
+#include "Rendering/Vertex.h"
+
+namespace OtterEngine {
+	/// <summary>
+	/// Cluster of triangles small enough for one mesh shader workgroup, culled as a whole. Its vertices are indices
+	/// relative to the first vertex of its chunk, its triangles index those vertices with 8-bit corners.
+	/// Bounds are in model space, plain floats so that the layout is the same in a cooked file.
+	/// </summary>
+	struct Meshlet {
+		// Offsets in the meshlet vertex array and in the meshlet triangle array, counted in corners
+		uint32_t mVertexOffset = 0;
+		uint32_t mTriangleOffset = 0;
+		uint32_t mVertexCount = 0;
+		uint32_t mTriangleCount = 0;
+
+		// Sphere around every vertex of the meshlet
+		float mCenter[3] = { 0.0f, 0.0f, 0.0f };
+		float mRadius = 0.0f;
+
+		// Every triangle faces away from a viewer standing where dot(normalize(center - viewer), axis) >= cutoff
+		// once the sphere is accounted for, see IsBackFacing. A cutoff of 1 never culls.
+		float mConeAxis[3] = { 0.0f, 0.0f, 0.0f };
+		float mConeCutoff = 1.0f;
+
+		/// <summary>
+		/// True when no triangle of the meshlet can face a viewer at this model space position
+		/// </summary>
+		bool IsBackFacing(const glm::vec3& viewer) const {
+			const glm::vec3 center(mCenter[0], mCenter[1], mCenter[2]);
+			const glm::vec3 axis(mConeAxis[0], mConeAxis[1], mConeAxis[2]);
+			const glm::vec3 toCenter = center - viewer;
+			return glm::dot(toCenter, axis) >= mConeCutoff * glm::length(toCenter) + mRadius;
+		}
+	};
+
+	struct MeshletSettings {
+		// Sizes meant for mesh shaders: 64 vertices and 124 triangles fill the 128 bytes of primitive indices
+		// NVIDIA hardware fetches at once and keep the per-meshlet output within the limits of every vendor
+		uint32_t mMaxVertices = 64;
+		uint32_t mMaxTriangles = 124;
+	};
+
+	/// <summary>
+	/// Meshlets of one or more chunks, appended one after the other
+	/// </summary>
+	struct MeshletGeometry {
+		std::vector<Meshlet> mMeshlets;
+		std::vector<uint32_t> mVertices;
+		std::vector<uint8_t> mTriangles;
+	};
+
+	/// <summary>
+	/// Greedy partition of a triangle list in meshlets. Each meshlet grows from a seed triangle by adding, among
+	/// the unassigned triangles sharing a vertex with it, the one bringing the fewest new vertices and then the
+	/// one closest to its center, so that meshlets stay compact and their bounds tight.
+	/// </summary>
+	class MeshletBuilder {
+	public:
+		/// <summary>
+		/// Partitions the triangles and appends the meshlets, every triangle ending up in exactly one of them
+		/// </summary>
+		/// <returns>Number of meshlets appended</returns>
+		static uint32_t Build(std::span<const Vertex> vertices, std::span<const uint32_t> indices, const MeshletSettings& settings,
+			MeshletGeometry& result);
+
+		/// <summary>
+		/// Checks that the meshlets reference each triangle of the index list exactly once
+		/// </summary>
+		static bool CoversTriangles(const MeshletGeometry& geometry, std::span<const Meshlet> meshlets, std::span<const uint32_t> indices);
+	};
+}
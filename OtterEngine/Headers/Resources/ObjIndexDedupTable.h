@@ -0,0 +1,72 @@
+#pragma once
+
+#include <bit>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+namespace OtterEngine {
+
+	/// <summary>
+	/// Flat table deduplicating the (position, normal, texcoord) index triples of an OBJ
+	/// face list. Vertices are bucketed by position index: face lists walk positions mostly
+	/// in order, so consecutive corners land in neighbouring buckets instead of being
+	/// scattered over the table by a hash, and a bucket only chains the few vertices
+	/// sharing a position. The triples themselves live once in the unique keys array.
+	/// Corners are merged on their indices only: identical values stored under
+	/// distinct indices stay distinct vertices.
+	/// Key is rapidobj::Index, or any type with the same three index members.
+	/// </summary>
+	template<typename Key>
+	class ObjIndexDedupTable {
+	private:
+		static constexpr uint32_t END_OF_CHAIN = UINT32_MAX;
+
+		// First vertex of each bucket, then for each vertex the next one of its bucket
+		std::vector<uint32_t> mFirstVertex;
+		std::vector<uint32_t> mNextVertex;
+		std::vector<Key> mUniqueKeys;
+		uint32_t mPositionBegin = 0;
+		uint32_t mMask = 0;
+
+	public:
+		/// <summary>
+		/// Gives one bucket to each position of the [positionBegin, positionEnd) range the keys
+		/// index, but never more buckets than keys: wider ranges wrap around. Keys outside of
+		/// the range are still found, they only make longer chains.
+		/// </summary>
+		ObjIndexDedupTable(uint32_t positionBegin, uint32_t positionEnd, size_t maxKeys) {
+			const size_t positionCount = positionEnd > positionBegin ? positionEnd - positionBegin : 1;
+			const size_t bucketCount = std::bit_ceil(std::max<size_t>(std::min(positionCount, maxKeys), 1));
+			mFirstVertex.assign(bucketCount, END_OF_CHAIN);
+			mPositionBegin = positionBegin;
+			mMask = static_cast<uint32_t>(bucketCount - 1);
+		}
+
+		/// <summary>
+		/// Returns the vertex id of the given key, assigning the next free id on first sight
+		/// </summary>
+		uint32_t FindOrInsert(const Key& key) {
+			uint32_t& first = mFirstVertex[(static_cast<uint32_t>(key.position_index) - mPositionBegin) & mMask];
+
+			for (uint32_t vertex = first; vertex != END_OF_CHAIN; vertex = mNextVertex[vertex]) {
+				const Key& other = mUniqueKeys[vertex];
+				if (other.position_index == key.position_index &&
+					other.normal_index == key.normal_index &&
+					other.texcoord_index == key.texcoord_index) {
+					return vertex;
+				}
+			}
+
+			const uint32_t vertex = static_cast<uint32_t>(mUniqueKeys.size());
+			mNextVertex.push_back(first);
+			mUniqueKeys.push_back(key);
+			first = vertex;
+			return vertex;
+		}
+
+		size_t GetBucketCount() const { return mFirstVertex.size(); }
+		const std::vector<Key>& GetUniqueKeys() const { return mUniqueKeys; }
+		std::vector<Key> TakeUniqueKeys() { return std::move(mUniqueKeys); }
+	};
+}
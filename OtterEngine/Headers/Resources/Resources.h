@@ -1,15 +1,25 @@
 #pragma once
 
+#include <array>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
 #include <string>
 #include <memory>
+#include <vector>
+#include <shared_mutex>
 #include <cassert>
 #include <concepts>
 #include <filesystem>
 #include <functional>
 #include <unordered_map>
+#include <condition_variable>
 
 #include "Core/Logger.h"
+#include "Core/JobSystem.h"
 #include "Utils/TypeID.h"
+#include "Utils/PathFormat.h"
+#include "Resources/AssetID.h"
 
 namespace OtterEngine {
 
@@ -25,21 +35,18 @@ namespace OtterEngine {
 	};
 
 	/// <summary>
-	/// Wrapper around a pointer to a resource and its path
+	/// Wrapper around a pointer to a resource and the ID of the asset it was loaded from
 	/// </summary>
 	/// <typeparam name="T">The Resource the handle points to</typeparam>
 	template<typename T>
 	class ResourceHandle {
 	private:
 		std::shared_ptr<T> mRes;
-		fs::path mPath;
+		AssetID mID = INVALID_ASSET_ID;
 	public:
 		ResourceHandle() = default;
-		ResourceHandle(std::shared_ptr<T> resource, const fs::path& path)
-			: mRes(std::move(resource)), mPath(path) {
-		}
-		ResourceHandle(std::shared_ptr<T>&& resource, const fs::path& path)
-			: mRes(std::move(resource)), mPath(path) {
+		ResourceHandle(std::shared_ptr<T> resource, AssetID id)
+			: mRes(std::move(resource)), mID(id) {
 		}
 
 		/// <summary>
@@ -62,11 +69,13 @@ namespace OtterEngine {
 
 		explicit operator bool() const { return mRes && mRes->IsValid(); }
 
+		AssetID GetID() const { return mID; }
+
 		/// <summary>
-		/// Returns the stored path as a string
+		/// Returns the path the resource was loaded from, relative to the resources folder
 		/// </summary>
-		/// <returns>A constant reference to the stored path string</returns>
-		const fs::path& GetPath() const { return mPath; }
+		/// <returns>A constant reference to the interned path</returns>
+		const fs::path& GetPath() const { return AssetRegistry::GetPath(mID); }
 
 		/// <summary>
 		/// Returns the pointer to the managed resource
@@ -82,31 +91,323 @@ namespace OtterEngine {
 		virtual void Clear() = 0;
 	};
 
+	// Resources reporting their memory footprint, only those can be retained by a cache budget
+	template<typename T>
+	concept SizedResource = requires(const T& t) {
+		{ t.GetByteSize() } -> std::convertible_to<std::size_t>;
+	};
+
+	struct ResourceRetentionPolicy {
+		// Bytes of unreferenced resources kept alive, least recently used first out.
+		// 0 keeps weak references only, freeing a resource as soon as its last handle drops.
+		std::size_t mByteBudget = 0;
+	};
+
+	struct ResourceCacheStats {
+		uint64_t mHits = 0;
+		uint64_t mMisses = 0;
+		uint64_t mEvictions = 0;
+		std::size_t mRetainedBytes = 0;
+		std::size_t mByteBudget = 0;
+		std::size_t mEntryCount = 0;
+	};
+
+	// Number of independently locked partitions of every typed cache
+	inline constexpr std::size_t RESOURCE_CACHE_SHARD_COUNT = 16;
+
+	/// <summary>
+	/// References to the loaded resources of one type, safe to use from any thread.
+	/// Entries are split across shards by asset ID, lookups only take a shared lock on their shard.
+	/// The pointers handed out release into the cache: once the last one drops, the resource is kept
+	/// within the retention budget so it survives without handles, or forgotten along with its entry.
+	/// </summary>
 	template<Resource T>
 	class TypedResourceCache final : public IResourceCache {
 	private:
-		std::unordered_map<fs::path, std::weak_ptr<T>> mCache;
+		struct Entry {
+			// Pointer handed out while the resource is referenced, mRetained while it is not
+			std::weak_ptr<T> mRef;
+			std::shared_ptr<T> mRetained;
+			std::size_t mByteSize = 0;
+			// Tick at which the current pointers were handed out, older ones no longer release into the entry
+			uint64_t mGeneration = 0;
+			// Tick of the last access, updated under the shared lock
+			std::atomic<uint64_t> mLastUse{ 0 };
+		};
+
+		struct alignas(64) Shard {
+			mutable std::shared_mutex mLock;
+			std::unordered_map<AssetID, Entry> mEntries;
+		};
 
-	public:
-		std::shared_ptr<T> Get(const fs::path& path) {
-			if (auto iter = mCache.find(path); iter != mCache.end()) {
-				if (auto res = iter->second.lock()) {
-					return res;
+		/// <summary>
+		/// Deleter of the handed out pointers, owning the resource until the last of them drops
+		/// </summary>
+		struct Releaser {
+			TypedResourceCache* mCache = nullptr;
+			AssetID mID = INVALID_ASSET_ID;
+			uint64_t mGeneration = 0;
+			std::shared_ptr<T> mResource;
+
+			void operator()(T*) {
+				mCache->OnUnreferenced(mID, mGeneration, std::move(mResource));
+			}
+		};
+
+		std::array<Shard, RESOURCE_CACHE_SHARD_COUNT> mShards;
+
+		std::atomic<std::size_t> mByteBudget{ 0 };
+		std::atomic<std::size_t> mRetainedBytes{ 0 };
+		std::atomic<std::size_t> mEntryCount{ 0 };
+		std::atomic<uint64_t> mClock{ 0 };
+
+		std::atomic<uint64_t> mHits{ 0 };
+		std::atomic<uint64_t> mMisses{ 0 };
+		std::atomic<uint64_t> mEvictions{ 0 };
+
+		// Serializes evictions, lookups never take it
+		std::mutex mEvictionLock;
+
+		Shard& GetShard(AssetID id) {
+			// Asset IDs are already hashes, their top bits pick the shard
+			return mShards[(id >> 60) % RESOURCE_CACHE_SHARD_COUNT];
+		}
+
+		uint64_t Tick() { return mClock.fetch_add(1, std::memory_order_relaxed) + 1; }
+
+		static std::size_t GetByteSize(const T& res) {
+			if constexpr (SizedResource<T>) {
+				return static_cast<std::size_t>(res.GetByteSize());
+			}
+			else {
+				return 0;
+			}
+		}
+
+		// Caller holds the unique lock of the shard owning the entry
+		std::shared_ptr<T> HandOut(AssetID id, Entry& entry, std::shared_ptr<T> res) {
+			T* pointer = res.get();
+			entry.mGeneration = Tick();
+			std::shared_ptr<T> handedOut(pointer, Releaser{ this, id, entry.mGeneration, std::move(res) });
+			entry.mRef = handedOut;
+			return handedOut;
+		}
+
+		// Caller holds the unique lock of the shard owning the entry, the returned resource is to be dropped after unlocking
+		std::shared_ptr<T> Release(Entry& entry) {
+			if (entry.mRetained) {
+				mRetainedBytes.fetch_sub(entry.mByteSize, std::memory_order_relaxed);
+			}
+			return std::move(entry.mRetained);
+		}
+
+		/// <summary>
+		/// Called once the last pointer of a generation drops: keeps the resource if it fits the budget, forgets it otherwise
+		/// </summary>
+		void OnUnreferenced(AssetID id, uint64_t generation, std::shared_ptr<T> res) {
+			bool isRetained = false;
+			{
+				Shard& shard = GetShard(id);
+				std::unique_lock lock(shard.mLock);
+				auto iter = shard.mEntries.find(id);
+				if (iter == shard.mEntries.end() || iter->second.mGeneration != generation) {
+					// Removed, or stored again since, the resource is dropped below
+					return;
+				}
+
+				Entry& entry = iter->second;
+				std::size_t budget = mByteBudget.load(std::memory_order_relaxed);
+				if (entry.mByteSize > 0 && entry.mByteSize <= budget) {
+					entry.mRetained = std::move(res);
+					mRetainedBytes.fetch_add(entry.mByteSize, std::memory_order_relaxed);
+					isRetained = true;
+				}
+				else {
+					shard.mEntries.erase(iter);
+					mEntryCount.fetch_sub(1, std::memory_order_relaxed);
+				}
+			}
+
+			if (isRetained) {
+				EnforceBudget();
+			}
+		}
+
+		std::shared_ptr<T> Find(AssetID id, bool isAccess) {
+			Shard& shard = GetShard(id);
+			bool isRetained = false;
+			{
+				std::shared_lock lock(shard.mLock);
+				if (auto iter = shard.mEntries.find(id); iter != shard.mEntries.end()) {
+					if (auto res = iter->second.mRef.lock()) {
+						if (isAccess) {
+							iter->second.mLastUse.store(Tick(), std::memory_order_relaxed);
+							mHits.fetch_add(1, std::memory_order_relaxed);
+						}
+						return res;
+					}
+					isRetained = iter->second.mRetained != nullptr;
+				}
+			}
+
+			// Kept without handles: hand it out again, which takes it out of the retained bytes
+			if (isRetained) {
+				std::unique_lock lock(shard.mLock);
+				if (auto iter = shard.mEntries.find(id); iter != shard.mEntries.end()) {
+					Entry& entry = iter->second;
+					std::shared_ptr<T> res = entry.mRef.lock();
+					if (!res && entry.mRetained) {
+						mRetainedBytes.fetch_sub(entry.mByteSize, std::memory_order_relaxed);
+						res = HandOut(id, entry, std::move(entry.mRetained));
+					}
+
+					if (res) {
+						if (isAccess) {
+							entry.mLastUse.store(Tick(), std::memory_order_relaxed);
+							mHits.fetch_add(1, std::memory_order_relaxed);
+						}
+						return res;
+					}
 				}
 			}
+
+			if (isAccess) {
+				mMisses.fetch_add(1, std::memory_order_relaxed);
+			}
 			return nullptr;
 		}
 
-		void Store(const fs::path& path, std::shared_ptr<T> res) {
-			mCache[path] = std::move(res);
+		/// <summary>
+		/// Forgets the least recently used unreferenced resources until the retained bytes fit the budget
+		/// </summary>
+		void EnforceBudget() {
+			// Resources are destroyed once every lock is released, declared first to outlive them
+			std::vector<std::shared_ptr<T>> evicted;
+			std::scoped_lock evictionLock(mEvictionLock);
+
+			std::size_t budget = mByteBudget.load(std::memory_order_relaxed);
+			if (mRetainedBytes.load(std::memory_order_relaxed) <= budget) return;
+
+			struct Candidate {
+				uint64_t mLastUse;
+				AssetID mID;
+			};
+
+			std::vector<Candidate> candidates;
+			for (Shard& shard : mShards) {
+				std::shared_lock lock(shard.mLock);
+				for (const auto& [id, entry] : shard.mEntries) {
+					if (entry.mRetained) {
+						candidates.push_back({ entry.mLastUse.load(std::memory_order_relaxed), id });
+					}
+				}
+			}
+
+			std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+				return a.mLastUse < b.mLastUse;
+			});
+
+			for (const Candidate& candidate : candidates) {
+				if (mRetainedBytes.load(std::memory_order_relaxed) <= budget) break;
+
+				Shard& shard = GetShard(candidate.mID);
+				std::unique_lock lock(shard.mLock);
+				if (auto iter = shard.mEntries.find(candidate.mID); iter != shard.mEntries.end() && iter->second.mRetained) {
+					evicted.push_back(Release(iter->second));
+					shard.mEntries.erase(iter);
+					mEntryCount.fetch_sub(1, std::memory_order_relaxed);
+					mEvictions.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
 		}
 
-		void Remove(const fs::path& path) {
-			mCache.erase(path);
+	public:
+		/// <summary>
+		/// Looks a resource up, counting a hit or a miss and marking it as recently used
+		/// </summary>
+		std::shared_ptr<T> Get(AssetID id) { return Find(id, true); }
+
+		/// <summary>
+		/// Looks a resource up without touching the statistics or the usage order
+		/// </summary>
+		std::shared_ptr<T> Peek(AssetID id) { return Find(id, false); }
+
+		/// <summary>
+		/// Caches a loaded resource
+		/// </summary>
+		/// <returns>The pointer to hand out in place of the given one, so that the cache knows when it is no longer referenced</returns>
+		std::shared_ptr<T> Store(AssetID id, std::shared_ptr<T> res) {
+			if (!res) return nullptr;
+
+			std::size_t byteSize = GetByteSize(*res);
+			std::shared_ptr<T> replaced;
+
+			Shard& shard = GetShard(id);
+			std::unique_lock lock(shard.mLock);
+			auto [iter, isInserted] = shard.mEntries.try_emplace(id);
+			if (isInserted) {
+				mEntryCount.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			Entry& entry = iter->second;
+			replaced = Release(entry);
+			entry.mByteSize = byteSize;
+			entry.mLastUse.store(Tick(), std::memory_order_relaxed);
+			return HandOut(id, entry, std::move(res));
+		}
+
+		void Remove(AssetID id) {
+			std::shared_ptr<T> removed;
+
+			Shard& shard = GetShard(id);
+			std::unique_lock lock(shard.mLock);
+			if (auto iter = shard.mEntries.find(id); iter != shard.mEntries.end()) {
+				removed = Release(iter->second);
+				shard.mEntries.erase(iter);
+				mEntryCount.fetch_sub(1, std::memory_order_relaxed);
+			}
 		}
 
 		void Clear() override {
-			mCache.clear();
+			for (Shard& shard : mShards) {
+				std::vector<std::shared_ptr<T>> removed;
+
+				std::unique_lock lock(shard.mLock);
+				for (auto& [id, entry] : shard.mEntries) {
+					removed.push_back(Release(entry));
+				}
+				mEntryCount.fetch_sub(shard.mEntries.size(), std::memory_order_relaxed);
+				shard.mEntries.clear();
+			}
+		}
+
+		/// <summary>
+		/// Changes the byte budget, evicting right away if the retained resources exceed it
+		/// </summary>
+		void SetRetentionPolicy(const ResourceRetentionPolicy& policy) {
+			mByteBudget.store(policy.mByteBudget, std::memory_order_relaxed);
+			EnforceBudget();
+		}
+
+		ResourceRetentionPolicy GetRetentionPolicy() const {
+			return { mByteBudget.load(std::memory_order_relaxed) };
+		}
+
+		ResourceCacheStats GetStats() const {
+			return {
+				mHits.load(std::memory_order_relaxed),
+				mMisses.load(std::memory_order_relaxed),
+				mEvictions.load(std::memory_order_relaxed),
+				mRetainedBytes.load(std::memory_order_relaxed),
+				mByteBudget.load(std::memory_order_relaxed),
+				mEntryCount.load(std::memory_order_relaxed)
+			};
+		}
+
+		void ResetStats() {
+			mHits.store(0, std::memory_order_relaxed);
+			mMisses.store(0, std::memory_order_relaxed);
+			mEvictions.store(0, std::memory_order_relaxed);
 		}
 	};
 
@@ -114,42 +415,205 @@ namespace OtterEngine {
 	// behind IResourceCache interface via polimorphism
 	class ResourceCache final {
 	private:
-		static inline std::unordered_map<std::size_t, std::unique_ptr<IResourceCache>> mInternalCaches;
+		// Typed caches are created once and never destroyed, so references to them stay valid.
+		// Handles dropped during static destruction still release into their cache.
+		static inline std::shared_mutex mCachesLock;
+		static inline std::unordered_map<std::size_t, IResourceCache*> mInternalCaches;
 
 		template<Resource T>
 		static TypedResourceCache<T>& GetCache() {
+			// Every type resolves its cache once, later calls skip the registry entirely
+			static TypedResourceCache<T>& sCache = FindOrCreateCache<T>();
+			return sCache;
+		}
+
+		template<Resource T>
+		static TypedResourceCache<T>& FindOrCreateCache() {
 			std::size_t typeID = GetTypeID<T>();
 
+			std::unique_lock lock(mCachesLock);
 			if (auto iter = mInternalCaches.find(typeID); iter != mInternalCaches.end()) {
-				return *static_cast<TypedResourceCache<T>*>(iter->second.get());
+				return *static_cast<TypedResourceCache<T>*>(iter->second);
 			}
 
 			// Create new cache for this type
-			auto newCache = std::make_unique<TypedResourceCache<T>>();
-			auto& cacheRef = *newCache;
-			mInternalCaches[typeID] = std::move(newCache);
-			return cacheRef;
+			auto* newCache = new TypedResourceCache<T>();
+			mInternalCaches[typeID] = newCache;
+			return *newCache;
 		}
 
 	public:
 		template<Resource T>
-		static std::shared_ptr<T> Get(const fs::path& path) {
-			return GetCache<T>().Get(path);
+		static std::shared_ptr<T> Get(AssetID id) {
+			return GetCache<T>().Get(id);
 		}
 
 		template<Resource T>
-		static void Store(const fs::path& path, std::shared_ptr<T> res) {
-			GetCache<T>().Store(path, std::move(res));
+		static std::shared_ptr<T> Peek(AssetID id) {
+			return GetCache<T>().Peek(id);
 		}
 
 		template<Resource T>
-		static void Remove(const fs::path& path) {
-			GetCache<T>().Remove(path);
+		static std::shared_ptr<T> Store(AssetID id, std::shared_ptr<T> res) {
+			return GetCache<T>().Store(id, std::move(res));
+		}
+
+		template<Resource T>
+		static void Remove(AssetID id) {
+			GetCache<T>().Remove(id);
+		}
+
+		/// <summary>
+		/// Sets how much memory the cache of a resource type may keep alive without any handle
+		/// </summary>
+		template<Resource T>
+		static void SetRetentionPolicy(const ResourceRetentionPolicy& policy) {
+			GetCache<T>().SetRetentionPolicy(policy);
+		}
+
+		template<Resource T>
+		static ResourceRetentionPolicy GetRetentionPolicy() {
+			return GetCache<T>().GetRetentionPolicy();
+		}
+
+		template<Resource T>
+		static ResourceCacheStats GetStats() {
+			return GetCache<T>().GetStats();
+		}
+
+		template<Resource T>
+		static void ResetStats() {
+			GetCache<T>().ResetStats();
 		}
 
 		static void Clear() {
-			mInternalCaches.clear();
+			std::shared_lock lock(mCachesLock);
+			for (auto& [typeID, cache] : mInternalCaches) {
+				cache->Clear();
+			}
+		}
+	};
+
+	enum class ResourceLoadState : uint8_t {
+		Pending,
+		Ready,
+		Failed
+	};
+
+	template<typename T>
+	class ResourceRequest;
+
+	/// <summary>
+	/// State of a load, shared by every request made for the same resource while it is in flight
+	/// </summary>
+	/// <typeparam name="T">The Resource being loaded</typeparam>
+	template<typename T>
+	class ResourceLoadOperation {
+	public:
+		using Callback = std::function<void(const ResourceHandle<T>&)>;
+
+	private:
+		std::atomic<ResourceLoadState> mState = ResourceLoadState::Pending;
+		std::shared_ptr<T> mRes;
+		AssetID mID;
+		fs::path mFullPath;
+
+		mutable std::mutex mLock;
+		mutable std::condition_variable mCompleted;
+		std::vector<Callback> mCallbacks;
+		bool mCallbacksDispatched = false;
+
+		// Set by the one thread performing the load, LoadAsync's job or a blocking Load joining before it ran
+		std::atomic<bool> mIsClaimed = false;
+
+		/// <summary>
+		/// Grants the right to perform the load once, and only while it is pending
+		/// </summary>
+		bool TryClaim() {
+			return GetState() == ResourceLoadState::Pending && !mIsClaimed.exchange(true, std::memory_order_acq_rel);
+		}
+
+		friend class Resources;
+		friend class ResourceRequest<T>;
+
+	public:
+		ResourceLoadOperation(AssetID id, fs::path fullPath)
+			: mID(id), mFullPath(std::move(fullPath)) {
+		}
+
+		ResourceLoadState GetState() const { return mState.load(std::memory_order_acquire); }
+
+		/// <summary>
+		/// Publishes the loaded resource, or its absence, and wakes up the waiting threads
+		/// </summary>
+		void Complete(std::shared_ptr<T> resource) {
+			{
+				std::scoped_lock lock(mLock);
+				mRes = std::move(resource);
+				mState.store(mRes ? ResourceLoadState::Ready : ResourceLoadState::Failed, std::memory_order_release);
+			}
+			mCompleted.notify_all();
+		}
+
+		void Wait() const {
+			std::unique_lock lock(mLock);
+			mCompleted.wait(lock, [this]() { return GetState() != ResourceLoadState::Pending; });
+		}
+
+		ResourceHandle<T> GetHandle() const {
+			if (GetState() != ResourceLoadState::Ready) return ResourceHandle<T>();
+			return ResourceHandle<T>(mRes, mID);
+		}
+	};
+
+	/// <summary>
+	/// Handle to a resource being loaded in the background by Resources::LoadAsync
+	/// </summary>
+	/// <typeparam name="T">The Resource being loaded</typeparam>
+	template<typename T>
+	class ResourceRequest {
+	private:
+		std::shared_ptr<ResourceLoadOperation<T>> mOperation;
+
+	public:
+		ResourceRequest() = default;
+		explicit ResourceRequest(std::shared_ptr<ResourceLoadOperation<T>> operation)
+			: mOperation(std::move(operation)) {
+		}
+
+		/// <summary>
+		/// Whether the load is over, successfully or not
+		/// </summary>
+		bool IsReady() const { return mOperation && mOperation->GetState() != ResourceLoadState::Pending; }
+		bool HasFailed() const { return !mOperation || mOperation->GetState() == ResourceLoadState::Failed; }
+
+		ResourceLoadState GetState() const {
+			return mOperation ? mOperation->GetState() : ResourceLoadState::Failed;
 		}
+
+		/// <summary>
+		/// Returns the loaded resource without blocking
+		/// </summary>
+		/// <returns>The resource handle, empty while pending or if the load failed</returns>
+		ResourceHandle<T> Get() const { return mOperation ? mOperation->GetHandle() : ResourceHandle<T>(); }
+
+		/// <summary>
+		/// Blocks the calling thread until the load is over
+		/// </summary>
+		/// <returns>The resource handle, empty if the load failed</returns>
+		ResourceHandle<T> Wait() const {
+			if (!mOperation) return ResourceHandle<T>();
+			mOperation->Wait();
+			return mOperation->GetHandle();
+		}
+
+		/// <summary>
+		/// Registers a callback run by Resources::Update once the load is over.
+		/// The handle passed to it is empty if the load failed.
+		/// </summary>
+		void OnComplete(typename ResourceLoadOperation<T>::Callback callback) const;
+
+		explicit operator bool() const { return mOperation != nullptr; }
 	};
 
 	class IResourceLoader {
@@ -176,71 +640,279 @@ namespace OtterEngine {
 	private:
 		// Default starting point
 		static inline fs::path mResPath = "../Resources/";
-		static inline std::unordered_map<std::size_t, std::unique_ptr<IResourceLoader>> mResLoaders;
+
+		// Loaders are shared so a load in progress keeps its loader alive if it gets replaced
+		static inline std::shared_mutex mLoadersLock;
+		static inline std::unordered_map<std::size_t, std::shared_ptr<IResourceLoader>> mResLoaders;
+
+		// Completion callbacks are handed over to the thread calling Update
+		static inline std::mutex mCompletionLock;
+		static inline std::vector<std::function<void()>> mCompletions;
+
+		// Loads currently in flight for each resource type
+		template<Resource T>
+		struct InFlightLoads {
+			static inline std::mutex sLock;
+			static inline std::unordered_map<AssetID, std::shared_ptr<ResourceLoadOperation<T>>> sLoads;
+		};
+
+		template<typename T>
+		friend class ResourceRequest;
 
 		template<Resource T>
-		static TypedResourceLoader<T>* GetLoader() {
+		static std::shared_ptr<TypedResourceLoader<T>> GetLoader() {
 			std::size_t typeID = GetTypeID<T>();
+			std::shared_lock lock(mLoadersLock);
 			if (auto iter = mResLoaders.find(typeID); iter != mResLoaders.end()) {
-				return static_cast<TypedResourceLoader<T>*>(iter->second.get());
+				return std::static_pointer_cast<TypedResourceLoader<T>>(iter->second);
 			}
 			return nullptr;
 		}
 
+		static void QueueCompletion(std::function<void()> completion) {
+			std::scoped_lock lock(mCompletionLock);
+			mCompletions.push_back(std::move(completion));
+		}
+
+		/// <summary>
+		/// Returns the load in flight for the given asset, registering a new one if there is none.
+		/// The cache is checked again under the in-flight lock: a finishing load stores its
+		/// resource before retiring, so a resource is never missed by both lookups.
+		/// </summary>
+		/// <param name="isOwner">Set when the caller registered the load and has to see it performed</param>
+		/// <returns>The in-flight operation, or an already completed one on cache hit</returns>
+		template<Resource T>
+		static std::shared_ptr<ResourceLoadOperation<T>> BeginLoad(AssetID id, bool& isOwner) {
+			isOwner = false;
+			auto operation = std::make_shared<ResourceLoadOperation<T>>(id, mResPath / AssetRegistry::GetPath(id));
+
+			std::scoped_lock lock(InFlightLoads<T>::sLock);
+			if (auto cached = ResourceCache::Peek<T>(id)) {
+				operation->Complete(std::move(cached));
+				operation->mCallbacksDispatched = true;
+				return operation;
+			}
+
+			auto& inFlight = InFlightLoads<T>::sLoads[id];
+			if (inFlight) {
+				return inFlight;
+			}
+
+			inFlight = operation;
+			isOwner = true;
+			return operation;
+		}
+
+		/// <summary>
+		/// Runs the loader for an operation registered by BeginLoad and publishes the result.
+		/// The resource is cached before waiters wake up and callbacks are queued for Update.
+		/// </summary>
+		template<Resource T>
+		static void PerformLoad(const std::shared_ptr<ResourceLoadOperation<T>>& operation,
+			const std::shared_ptr<TypedResourceLoader<T>>& loader) {
+			std::shared_ptr<T> resource;
+			if (!loader) {
+				OTTER_CORE_ERROR("[RESOURCES] No loader registered for type id: {}", GetTypeID<T>());
+			}
+			else {
+				resource = loader->Load(operation->mFullPath);
+				if (!resource || !resource->IsValid()) {
+					OTTER_CORE_ERROR("[RESOURCES] Failed to load: {}", operation->mFullPath);
+					resource = nullptr;
+				}
+			}
+
+			// Everyone gets the cache's pointer, which tells it when the resource is no longer referenced
+			if (resource) {
+				resource = ResourceCache::Store<T>(operation->mID, std::move(resource));
+			}
+			operation->Complete(std::move(resource));
+
+			{
+				std::scoped_lock lock(InFlightLoads<T>::sLock);
+				InFlightLoads<T>::sLoads.erase(operation->mID);
+			}
+
+			std::vector<typename ResourceLoadOperation<T>::Callback> callbacks;
+			{
+				std::scoped_lock lock(operation->mLock);
+				operation->mCallbacksDispatched = true;
+				callbacks.swap(operation->mCallbacks);
+			}
+
+			if (!callbacks.empty()) {
+				QueueCompletion([operation, callbacks = std::move(callbacks)]() {
+					ResourceHandle<T> handle = operation->GetHandle();
+					for (auto& callback : callbacks) {
+						callback(handle);
+					}
+				});
+			}
+		}
+
 	public:
+		/// <summary>
+		/// Sets the directory relative paths are resolved against, to be called before any load
+		/// </summary>
 		static void SetResourcesPath(const fs::path& newPath) { mResPath = newPath; }
 
+		/// <summary>
+		/// Interns a path relative to the resources folder, the returned ID can be stored
+		/// and passed to Load and LoadAsync to skip hashing the path on every call.
+		/// Paths whose ID is taken by another path get INVALID_ASSET_ID, which every load refuses.
+		/// </summary>
+		static AssetID GetAssetID(const fs::path& relativePath) { return AssetRegistry::Intern(relativePath); }
+
+		/// <summary>
+		/// Loads a resource on the calling thread, or returns it from the cache.
+		/// Safe to call from any thread, concurrent loads of the same resource are performed once.
+		/// Job system workers included: a load still queued by LoadAsync is run here rather than waited for.
+		/// </summary>
 		template<Resource T>
 		static ResourceHandle<T> Load(const fs::path& relativePath) {
+			return Load<T>(AssetRegistry::Intern(relativePath));
+		}
 
-			fs::path fullPath = mResPath / relativePath;
+		/// <summary>
+		/// Loads a previously interned asset. Cache hits neither allocate nor hash strings.
+		/// </summary>
+		template<Resource T>
+		static ResourceHandle<T> Load(AssetID id) {
+			// Already reported by the registry
+			if (id == INVALID_ASSET_ID) {
+				return ResourceHandle<T>();
+			}
 
 			// Check cache first
-			if (auto cached = ResourceCache::Get<T>(fullPath)) {
-				return ResourceHandle<T>(cached, relativePath);
+			if (auto cached = ResourceCache::Get<T>(id)) {
+				return ResourceHandle<T>(std::move(cached), id);
 			}
 
-			// Load new resource
-			auto* loader = GetLoader<T>();
-			if (!loader) {
-				OTTER_CORE_ERROR("[RESOURCES] No loader registered for type id: {}", GetTypeID<T>());
+			if (AssetRegistry::GetPath(id).empty()) {
+				OTTER_CORE_ERROR("[RESOURCES] Unknown asset id: {:#018x}", id);
 				return ResourceHandle<T>();
 			}
 
-			auto resource = loader->Load(fullPath);
-			if (!resource || !resource->IsValid()) {
-				OTTER_CORE_ERROR("[RESOURCES] Failed to load: {}", fullPath);
-				return ResourceHandle<T>();
+			// Load new resource, or join the thread already loading it. A load LoadAsync queued but no worker
+			// started yet is taken over, waiting for it from a worker could wait on a job queued behind this one.
+			bool isOwner = false;
+			auto operation = BeginLoad<T>(id, isOwner);
+			if (operation->TryClaim()) {
+				PerformLoad<T>(operation, GetLoader<T>());
+			}
+			else {
+				operation->Wait();
 			}
 
-			// Cache new resource and return it
-			ResourceCache::Store<T>(fullPath, resource);
-			return ResourceHandle<T>(resource, relativePath);
+			return operation->GetHandle();
+		}
+
+		/// <summary>
+		/// Starts loading a resource on the job system and returns straight away.
+		/// Requests for a resource which is already being loaded share the same load.
+		/// </summary>
+		/// <returns>A request to poll, wait on or attach completion callbacks to</returns>
+		template<Resource T>
+		static ResourceRequest<T> LoadAsync(const fs::path& relativePath) {
+			return LoadAsync<T>(AssetRegistry::Intern(relativePath));
+		}
+
+		template<Resource T>
+		static ResourceRequest<T> LoadAsync(AssetID id) {
+			// Requests over before they start, failed ones included, still run their callbacks on the next Update
+			auto completedRequest = [id](std::shared_ptr<T> resource) {
+				auto operation = std::make_shared<ResourceLoadOperation<T>>(id, fs::path());
+				operation->Complete(std::move(resource));
+				operation->mCallbacksDispatched = true;
+				return ResourceRequest<T>(operation);
+			};
+
+			// Already reported by the registry
+			if (id == INVALID_ASSET_ID) {
+				return completedRequest(nullptr);
+			}
+
+			if (auto cached = ResourceCache::Get<T>(id)) {
+				return completedRequest(std::move(cached));
+			}
+
+			if (AssetRegistry::GetPath(id).empty()) {
+				OTTER_CORE_ERROR("[RESOURCES] Unknown asset id: {:#018x}", id);
+				return completedRequest(nullptr);
+			}
+
+			bool isOwner = false;
+			auto operation = BeginLoad<T>(id, isOwner);
+			if (isOwner) {
+				JobSystem::Submit([operation, loader = GetLoader<T>()]() {
+					// Unless a blocking Load took it over in the meantime
+					if (operation->TryClaim()) {
+						PerformLoad<T>(operation, loader);
+					}
+				});
+			}
+
+			return ResourceRequest<T>(operation);
+		}
+
+		/// <summary>
+		/// Runs the completion callbacks of the loads finished since the last call.
+		/// Meant to be called once per frame by the thread owning the callbacks.
+		/// </summary>
+		static void Update() {
+			std::vector<std::function<void()>> completions;
+			{
+				std::scoped_lock lock(mCompletionLock);
+				completions.swap(mCompletions);
+			}
+
+			for (auto& completion : completions) {
+				completion();
+			}
 		}
 
 		template<Resource T>
 		static void AddLoader() {
-			std::size_t typeID = GetTypeID<T>();
-			mResLoaders[typeID] = std::make_unique<TypedResourceLoader<T>>(
-				[](const fs::path& path) -> std::shared_ptr<T> {
-					return T::LoadFromFile(path);
-				}
-			);
+			AddCustomLoader<T>([](const fs::path& path) -> std::shared_ptr<T> {
+				return T::LoadFromFile(path);
+			});
 		}
 
 		template<Resource T>
 		static void AddCustomLoader(std::function<std::shared_ptr<T>(const fs::path&)> loader) {
-			mResLoaders[GetTypeID<T>()] = std::make_unique<TypedResourceLoader<T>>(std::move(loader));
+			auto typedLoader = std::make_shared<TypedResourceLoader<T>>(std::move(loader));
+			std::unique_lock lock(mLoadersLock);
+			mResLoaders[GetTypeID<T>()] = std::move(typedLoader);
 		}
 
 		template<Resource T>
 		static void RemoveLoader() {
+			std::unique_lock lock(mLoadersLock);
 			mResLoaders.erase(GetTypeID<T>());
 		}
 
 		static void ClearAll() {
 			ResourceCache::Clear();
+			std::unique_lock lock(mLoadersLock);
 			mResLoaders.clear();
 		}
 	};
+
+	template<typename T>
+	void ResourceRequest<T>::OnComplete(typename ResourceLoadOperation<T>::Callback callback) const {
+		if (!mOperation || !callback) return;
+
+		{
+			std::scoped_lock lock(mOperation->mLock);
+			if (!mOperation->mCallbacksDispatched) {
+				mOperation->mCallbacks.push_back(std::move(callback));
+				return;
+			}
+		}
+
+		// Already over, deliver it on the next Update like any other completion
+		Resources::QueueCompletion([operation = mOperation, callback = std::move(callback)]() {
+			callback(operation->GetHandle());
+		});
+	}
 }
\ No newline at end of file
@@ -1,39 +1,90 @@
 #pragma once
 
+#include <span>
 #include <memory>
 #include <vector>
 #include <cstdint>
 #include <filesystem>
 
 #include "Resources/Resources.h"
+#include "Resources/TextureFormat.h"
 
 namespace OtterEngine {
+	struct TextureMip {
+		uint32_t mWidth = 0;
+		uint32_t mHeight = 0;
+
+		// Location of the level in the pixel buffer
+		size_t mOffset = 0;
+		size_t mSize = 0;
+	};
+
 	class Texture {
+	public:
+		// Pixel storage shared with whoever allocated it, released through its own deleter
+		using PixelBuffer = std::shared_ptr<const uint8_t[]>;
+
 	private:
 		int mWidth = 0;
 		int mHeight = 0;
 		int mChannels = 0;
-		std::vector<uint8_t> mPixels;
+		PixelBuffer mPixels;
+		size_t mByteSize = 0;
+
+		TextureCompression mCompression = TextureCompression::None;
+		bool mIsSRGB = true;
+		std::vector<TextureMip> mMips;
+
+		static std::shared_ptr<Texture> LoadCooked(const std::filesystem::path& path);
 
 	public:
 		Texture() = default;
 
 		Texture(int width, int height, int channels, std::vector<uint8_t> pixels);
 
+		/// <summary>
+		/// Adopts an already filled pixel buffer without copying it
+		/// </summary>
+		Texture(int width, int height, int channels, PixelBuffer pixels, size_t byteSize);
+
+		/// <summary>
+		/// Adopts a buffer holding a whole mip chain, largest level first
+		/// </summary>
+		Texture(TextureCompression compression, std::vector<TextureMip> mips, PixelBuffer pixels, size_t byteSize, bool isSRGB = true);
+
 		// Resource concept requires static LoadFromFile and IsValid methods
 
 		static std::shared_ptr<Texture> LoadFromFile(const std::filesystem::path& path);
-		bool IsValid() const { return mWidth > 0 && mHeight > 0 && !mPixels.empty(); }
-		
+		bool IsValid() const { return mWidth > 0 && mHeight > 0 && mPixels && mByteSize > 0 && !mMips.empty(); }
+
+		/// <summary>
+		/// Decodes a source image (.png, .jpg, ...) to RGBA8, ignoring any cooked copy of it
+		/// </summary>
+		static std::shared_ptr<Texture> ImportImage(const std::filesystem::path& path);
+
+		/// <summary>
+		/// Expands a block-compressed texture to RGBA8, keeping its mip chain
+		/// </summary>
+		/// <returns>The uncompressed copy, or nullptr if the texture is not compressed</returns>
+		std::shared_ptr<Texture> Decompress() const;
+
 		constexpr int	 GetWidth()	   const noexcept { return mWidth; }
 		constexpr int	 GetHeight()   const noexcept { return mHeight; }
 		constexpr int	 GetChannels() const noexcept { return mChannels; }
-		constexpr size_t GetByteSize() const noexcept { return mPixels.size(); }
+		constexpr size_t GetByteSize() const noexcept { return mByteSize; }
+
+		TextureCompression GetCompression() const noexcept { return mCompression; }
+		bool IsCompressed() const noexcept { return mCompression != TextureCompression::None; }
+		bool IsSRGB()		const noexcept { return mIsSRGB; }
 
-		const std::vector<uint8_t>& GetPixels() const& noexcept { return mPixels; }
-		std::vector<uint8_t>		GetPixels()&&	   noexcept { return std::move(mPixels); }
+		uint32_t GetMipCount() const noexcept { return static_cast<uint32_t>(mMips.size()); }
+		std::span<const TextureMip> GetMips() const noexcept { return mMips; }
+		std::span<const uint8_t> GetMipData(uint32_t level) const noexcept {
+			return { mPixels.get() + mMips[level].mOffset, mMips[level].mSize };
+		}
 
-		const uint8_t* GetData() const noexcept { return mPixels.data(); }
-		uint8_t*	   GetData()				{ return mPixels.data(); }
+		// Every level of the chain, as stored
+		std::span<const uint8_t> GetPixels() const noexcept { return { mPixels.get(), mByteSize }; }
+		const uint8_t* GetData() const noexcept { return mPixels.get(); }
 	};
-}
\ No newline at end of file
+}
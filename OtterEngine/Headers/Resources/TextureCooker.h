@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+#include "Resources/Texture.h"
+#include "Resources/TextureFormat.h"
+
+namespace OtterEngine {
+
+	struct TextureCookSettings {
+		TextureCompression mCompression = TextureCompression::BC7;
+		bool mGenerateMips = true;
+		// Color textures are filtered in linear space and sampled through sRGB formats
+		bool mIsSRGB = true;
+		// Lowest PSNR, in dB, accepted for any level once decoded back. 0 skips the validation.
+		double mMinPSNR = 30.0;
+	};
+
+	/// <summary>
+	/// Offline conversion of source images into the cooked texture format: a precomputed
+	/// mip chain, block-compressed on the CPU, which Texture::LoadFromFile memory-maps
+	/// </summary>
+	class TextureCooker {
+	public:
+		/// <summary>
+		/// Imports a source image, builds and compresses its mip chain, validates it and writes the cooked version
+		/// </summary>
+		/// <param name="source">Path to the source image (.png, .jpg, ...)</param>
+		/// <param name="destination">Output path, defaults to the source path with the cooked extension</param>
+		/// <returns>True if the cooked file has been written</returns>
+		static bool Cook(const std::filesystem::path& source, std::filesystem::path destination = {},
+			const TextureCookSettings& settings = {});
+
+		/// <summary>
+		/// Serializes an already built texture in the cooked format
+		/// </summary>
+		/// <returns>True if the cooked file has been written</returns>
+		static bool Write(const Texture& texture, const std::filesystem::path& destination);
+
+		/// <summary>
+		/// Peak signal-to-noise ratio between two RGBA8 images of the same size, over all four channels
+		/// </summary>
+		/// <returns>The PSNR in dB, infinity if the images are identical</returns>
+		static double ComputePSNR(const uint8_t* reference, const uint8_t* test, size_t pixelCount);
+	};
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace OtterEngine {
+
+	// Encoding of the pixels of every mip level of a texture
+	enum class TextureCompression : uint32_t {
+		None = 0, // RGBA8
+		BC1 = 1,  // 4x4 blocks of 8 bytes, RGB with 1-bit alpha
+		BC7 = 2	  // 4x4 blocks of 16 bytes, RGBA
+	};
+
+	// Binary layout of a cooked texture file (.otex):
+	// [CookedTextureHeader][CookedTextureMip * mMipCount][mip 0 data][mip 1 data]...
+	// Every mip starts at an offset aligned to COOKED_TEXTURE_BLOCK_ALIGNMENT and the levels
+	// are stored largest first, back to back, so they can be staged with a single copy.
+	inline constexpr uint32_t COOKED_TEXTURE_MAGIC = 0x5845544F; // "OTEX"
+	inline constexpr uint32_t COOKED_TEXTURE_VERSION = 1;
+	inline constexpr uint64_t COOKED_TEXTURE_BLOCK_ALIGNMENT = 16;
+	inline constexpr const char* COOKED_TEXTURE_EXTENSION = ".otex";
+
+	// Header flags
+	inline constexpr uint32_t COOKED_TEXTURE_FLAG_SRGB = 1u << 0;
+
+	struct CookedTextureHeader {
+		uint32_t mMagic = COOKED_TEXTURE_MAGIC;
+		uint32_t mVersion = COOKED_TEXTURE_VERSION;
+		uint32_t mCompression = static_cast<uint32_t>(TextureCompression::None);
+		uint32_t mFlags = 0;
+
+		uint32_t mWidth = 0;
+		uint32_t mHeight = 0;
+		uint32_t mMipCount = 0;
+		uint32_t mReserved = 0;
+
+		// Byte offset and size of all the mip data, from the beginning of the file
+		uint64_t mDataOffset = 0;
+		uint64_t mDataSize = 0;
+	};
+
+	struct CookedTextureMip {
+		uint32_t mWidth = 0;
+		uint32_t mHeight = 0;
+
+		// Relative to CookedTextureHeader::mDataOffset
+		uint64_t mOffset = 0;
+		uint64_t mSize = 0;
+	};
+
+	constexpr uint64_t AlignCookedTextureOffset(uint64_t offset) noexcept {
+		return (offset + COOKED_TEXTURE_BLOCK_ALIGNMENT - 1) & ~(COOKED_TEXTURE_BLOCK_ALIGNMENT - 1);
+	}
+}
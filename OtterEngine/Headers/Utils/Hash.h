@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+namespace OtterEngine {
+
+	inline constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+	inline constexpr uint64_t FNV_PRIME = 0x00000100000001b3ull;
+
+	/// <summary>
+	/// 64-bit FNV-1a hash of a byte range, chainable through the seed
+	/// </summary>
+	inline uint64_t HashBytes(const void* data, std::size_t size, uint64_t seed = FNV_OFFSET_BASIS) noexcept {
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		uint64_t hash = seed;
+		for (std::size_t i = 0; i < size; ++i) {
+			hash ^= bytes[i];
+			hash *= FNV_PRIME;
+		}
+		return hash;
+	}
+
+	inline uint64_t HashString(std::string_view text, uint64_t seed = FNV_OFFSET_BASIS) noexcept {
+		return HashBytes(text.data(), text.size(), seed);
+	}
+
+	/// <summary>
+	/// Folds the bytes of a trivially copyable value into the hash. Padding bytes are hashed too,
+	/// so values must be zero-initialized before their fields are set.
+	/// </summary>
+	template<typename T>
+	uint64_t HashValue(const T& value, uint64_t seed = FNV_OFFSET_BASIS) noexcept {
+		static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be hashed by their bytes");
+		return HashBytes(&value, sizeof(T), seed);
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <memory>
+#include <cstddef>
+#include <filesystem>
+
+namespace OtterEngine {
+
+	/// <summary>
+	/// Read-only memory mapping of a whole file. The mapped bytes stay valid
+	/// for as long as the MappedFile instance is alive.
+	/// </summary>
+	class MappedFile {
+	private:
+		const std::byte* pData = nullptr;
+		size_t mSize = 0;
+
+#ifdef _WIN32
+		void* mFileHandle = nullptr;
+		void* mMappingHandle = nullptr;
+#else
+		int mFileDescriptor = -1;
+#endif
+
+		MappedFile() = default;
+
+	public:
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		/// <summary>
+		/// Maps the given file in memory
+		/// </summary>
+		/// <returns>The mapped file, or nullptr if the file could not be opened or mapped</returns>
+		static std::unique_ptr<MappedFile> Open(const std::filesystem::path& path);
+
+		const std::byte* GetData() const noexcept { return pData; }
+		size_t GetSize() const noexcept { return mSize; }
+	};
+}
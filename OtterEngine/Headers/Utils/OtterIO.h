@@ -1,7 +1,10 @@
 #pragma once
 
+#include <span>
 #include <string>
 #include <vector>
+#include <optional>
+#include <filesystem>
 
 namespace OtterEngine {
 
@@ -9,5 +12,17 @@ namespace OtterEngine {
 
 	public:
 		static std::vector<char> ReadFile(const std::string& fileName);
+
+		/// <summary>
+		/// Reads a whole file that may legitimately be missing, such as a cache
+		/// </summary>
+		/// <returns>Empty when the file does not exist or cannot be read</returns>
+		static std::optional<std::vector<char>> TryReadFile(const std::filesystem::path& path);
+
+		/// <summary>
+		/// Writes a file next to its destination then renames it over, so readers never see it half written.
+		/// Missing parent directories are created.
+		/// </summary>
+		static bool WriteFileAtomic(const std::filesystem::path& path, std::span<const char> data);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <utility>
+#include <cstdint>
+
+namespace OtterEngine {
+
+	/// <summary>
+	/// Hands out aligned ranges of an abstract address space [0, size), such as a block of device
+	/// memory or a shared buffer. Free ranges are coalesced on release and picked best-fit.
+	/// The allocator never touches the memory it manages.
+	/// </summary>
+	class RangeAllocator {
+	public:
+		static constexpr uint64_t INVALID_OFFSET = UINT64_MAX;
+
+	private:
+		uint64_t mSize = 0;
+		uint64_t mUsedBytes = 0;
+		uint32_t mAllocationCount = 0;
+
+		// The same free ranges, indexed by offset for coalescing and by size for best-fit
+		std::map<uint64_t, uint64_t> mFreeByOffset;
+		std::set<std::pair<uint64_t, uint64_t>> mFreeBySize;
+
+		void InsertFreeRange(uint64_t offset, uint64_t size);
+		void EraseFreeRange(std::map<uint64_t, uint64_t>::iterator range);
+
+	public:
+		RangeAllocator() = default;
+		explicit RangeAllocator(uint64_t size);
+
+		/// <summary>
+		/// Forgets every allocation and manages a fresh space of the given size
+		/// </summary>
+		void Reset(uint64_t size);
+
+		/// <summary>
+		/// Reserves size bytes starting at a multiple of alignment
+		/// </summary>
+		/// <returns>The offset of the range, or INVALID_OFFSET if no free range is large enough</returns>
+		uint64_t Allocate(uint64_t size, uint64_t alignment = 1);
+
+		/// <summary>
+		/// Releases a range previously returned by Allocate, with the size it was requested with
+		/// </summary>
+		void Free(uint64_t offset, uint64_t size);
+
+		/// <summary>
+		/// Grows the managed space, the new bytes are appended as free
+		/// </summary>
+		void Grow(uint64_t newSize);
+
+		uint64_t GetSize()			  const noexcept { return mSize; }
+		uint64_t GetUsedBytes()		  const noexcept { return mUsedBytes; }
+		uint64_t GetFreeBytes()		  const noexcept { return mSize - mUsedBytes; }
+		uint32_t GetAllocationCount() const noexcept { return mAllocationCount; }
+		uint64_t GetLargestFreeRange() const noexcept { return mFreeBySize.empty() ? 0 : mFreeBySize.rbegin()->first; }
+		bool IsEmpty() const noexcept { return mAllocationCount == 0; }
+	};
+}
@@ -1,11 +1,74 @@
 #version 450
 
-layout(location = 0) in vec3 fragColor;
-layout(location = 1) in vec2 fragTexCoord;
+// Features are defined by the renderer per material, see ShaderVariants.h
+
+// Length of the texture array, set by the renderer from the device limits
+layout(constant_id = 0) const uint TEXTURE_CAPACITY = 1;
+
+const vec3 LIGHT_DIRECTION = normalize(vec3(0.4, 0.3, 1.0));
+const float AMBIENT = 0.2;
+const float ALPHA_CUTOFF = 0.5;
+
+layout(location = 0) in vec2 fragTexCoord;
+#ifdef OTTER_VERTEX_COLOR
+layout(location = 1) in vec3 fragColor;
+#endif
+#ifdef OTTER_LIT
+layout(location = 2) in vec3 fragNormal;
+#endif
+#ifdef OTTER_NORMAL_MAP
+layout(location = 3) in vec3 fragPosition;
+#endif
 
 layout(location = 0) out vec4 outColor;
-layout(binding = 1) uniform sampler2D texSampler;
+layout(set = 1, binding = 0) uniform sampler2D textures[TEXTURE_CAPACITY];
+
+// Same for the whole draw, so the indices are dynamically uniform
+layout(push_constant) uniform DrawConstants {
+    uint textureIndex;
+    uint normalMapIndex;
+} draw;
+
+#ifdef OTTER_NORMAL_MAP
+// The vertex format has no tangents, the tangent frame is rebuilt from screen-space derivatives
+vec3 PerturbNormal(vec3 normal, vec3 tangentNormal) {
+    vec3 dp1 = dFdx(fragPosition);
+    vec3 dp2 = dFdy(fragPosition);
+    vec2 duv1 = dFdx(fragTexCoord);
+    vec2 duv2 = dFdy(fragTexCoord);
+
+    vec3 dp2perp = cross(dp2, normal);
+    vec3 dp1perp = cross(normal, dp1);
+    vec3 tangent = dp2perp * duv1.x + dp1perp * duv2.x;
+    vec3 bitangent = dp2perp * duv1.y + dp1perp * duv2.y;
+
+    float invScale = inversesqrt(max(dot(tangent, tangent), dot(bitangent, bitangent)));
+    return normalize(mat3(tangent * invScale, bitangent * invScale, normal) * tangentNormal);
+}
+#endif
 
 void main() {
-    outColor = texture(texSampler, fragTexCoord);
-}
\ No newline at end of file
+    vec4 color = texture(textures[draw.textureIndex], fragTexCoord);
+
+#ifdef OTTER_ALPHA_TEST
+    if (color.a < ALPHA_CUTOFF) {
+        discard;
+    }
+#endif
+
+#ifdef OTTER_VERTEX_COLOR
+    color.rgb *= fragColor;
+#endif
+
+#ifdef OTTER_LIT
+    vec3 normal = normalize(fragNormal);
+#ifdef OTTER_NORMAL_MAP
+    vec3 tangentNormal = texture(textures[draw.normalMapIndex], fragTexCoord).xyz * 2.0 - 1.0;
+    normal = PerturbNormal(normal, tangentNormal);
+#endif
+    float diffuse = max(dot(normal, LIGHT_DIRECTION), 0.0);
+    color.rgb *= AMBIENT + (1.0 - AMBIENT) * diffuse;
+#endif
+
+    outColor = color;
+}
@@ -1,21 +1,70 @@
 #version 450
 
+// Features are defined by the renderer per material, see ShaderVariants.h
+
 layout(binding = 0) uniform UniformBufferObject {
-    mat4 model;
     mat4 view;
     mat4 proj;
 } ubo;
 
+// One model matrix per instance, in draw order
+layout(std430, binding = 1) readonly buffer InstanceBuffer {
+    mat4 models[];
+} instances;
+
+// Streams absent from the mesh's vertex format are never declared, see VertexLayout
 layout(location = 0) in vec3 inPosition;
+#ifdef OTTER_LIT
+#ifdef OTTER_OCTAHEDRAL_NORMAL
+layout(location = 1) in vec2 inNormal;
+#else
 layout(location = 1) in vec3 inNormal;
+#endif
+#endif
 layout(location = 2) in vec2 inTexCoord;
+#ifdef OTTER_VERTEX_COLOR
 layout(location = 3) in vec3 inColor;
+#endif
+
+layout(location = 0) out vec2 fragTexCoord;
+#ifdef OTTER_VERTEX_COLOR
+layout(location = 1) out vec3 fragColor;
+#endif
+#ifdef OTTER_LIT
+layout(location = 2) out vec3 fragNormal;
+#endif
+#ifdef OTTER_NORMAL_MAP
+layout(location = 3) out vec3 fragPosition;
+#endif
 
-layout(location = 0) out vec3 fragColor;
-layout(location = 1) out vec2 fragTexCoord;
+#ifdef OTTER_OCTAHEDRAL_NORMAL
+// Unfolds the octahedron encoding of EncodeOctahedral in VertexFormat.cpp
+vec3 DecodeOctahedral(vec2 encoded) {
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-normal.z, 0.0);
+    normal.xy += mix(vec2(fold), vec2(-fold), greaterThanEqual(normal.xy, vec2(0.0)));
+    return normalize(normal);
+}
+#endif
 
 void main() {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
-    fragColor = inColor;
+    mat4 model = instances.models[gl_InstanceIndex];
+    vec4 worldPosition = model * vec4(inPosition, 1.0);
+
+    gl_Position = ubo.proj * ubo.view * worldPosition;
     fragTexCoord = inTexCoord;
-}
\ No newline at end of file
+#ifdef OTTER_VERTEX_COLOR
+    fragColor = inColor;
+#endif
+#ifdef OTTER_LIT
+    // Models are scaled uniformly, the normal matrix is the model's rotation
+#ifdef OTTER_OCTAHEDRAL_NORMAL
+    fragNormal = mat3(model) * DecodeOctahedral(inNormal);
+#else
+    fragNormal = mat3(model) * inNormal;
+#endif
+#endif
+#ifdef OTTER_NORMAL_MAP
+    fragPosition = worldPosition.xyz;
+#endif
+}
@@ -1,7 +1,9 @@
 #include "OtterPCH.h"
 
+#include "Core/JobSystem.h"
 #include "Core/EngineCore.h"
 #include "Core/Application.h"
+#include "Resources/Resources.h"
 #include <Events/EventDispatcher.h>
 #include <Events/WindowCloseEvent.h>
 #include <Rendering/Vulkan/VulkanRenderer.h>
@@ -22,6 +24,7 @@ namespace OtterEngine {
 
 	Application::~Application() {
 		mRenderer->Clear();
+		JobSystem::Shutdown();
 	}
 
 	void Application::Run() {
@@ -37,6 +40,7 @@ namespace OtterEngine {
 			}
 
 			mWindow->OnUpdate();
+			Resources::Update();
 			mRenderer->DrawFrame();
 			frameCount++;
 		}
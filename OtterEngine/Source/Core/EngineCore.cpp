@@ -4,6 +4,7 @@
 #include "Resources/Texture.h"
 #include "Resources/Resources.h"
 
+#include "Core/JobSystem.h"
 #include "Core/EngineCore.h"
 
 namespace OtterEngine {
@@ -17,6 +18,8 @@ namespace OtterEngine {
 			OtterCrashReporter::Report(cond, msg, file, line);
 		});
 
+		JobSystem::Init();
+
 		Resources::AddLoader<Mesh>();
 		Resources::AddLoader<Texture>();
 
@@ -0,0 +1,183 @@
+#include "OtterPCH.h"
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+
+#include "Core/JobSystem.h"
+
+namespace OtterEngine {
+	namespace {
+		struct JobQueue {
+			std::mutex mLock;
+			std::condition_variable mWakeUp;
+			std::deque<JobSystem::Job> mJobs;
+			std::vector<std::thread> mWorkers;
+			bool mStarted = false;
+			bool mStopping = false;
+
+			~JobQueue() { Stop(); }
+
+			void Start(uint32_t workerCount) {
+				mStarted = true;
+				mStopping = false;
+				mWorkers.reserve(workerCount);
+				for (uint32_t i = 0; i < workerCount; ++i) {
+					mWorkers.emplace_back([this]() { WorkerLoop(); });
+				}
+			}
+
+			void Stop() {
+				{
+					std::scoped_lock lock(mLock);
+					mStopping = true;
+				}
+				mWakeUp.notify_all();
+
+				for (std::thread& worker : mWorkers) {
+					if (worker.joinable()) worker.join();
+				}
+				mWorkers.clear();
+			}
+
+			void WorkerLoop() {
+				while (true) {
+					JobSystem::Job job;
+					{
+						std::unique_lock lock(mLock);
+						mWakeUp.wait(lock, [this]() { return mStopping || !mJobs.empty(); });
+
+						// Keep draining on shutdown so nobody waits on a dropped job
+						if (mJobs.empty()) return;
+
+						job = std::move(mJobs.front());
+						mJobs.pop_front();
+					}
+					job();
+				}
+			}
+		};
+
+		JobQueue& GetQueue() {
+			static JobQueue sQueue;
+			return sQueue;
+		}
+
+		void EnsureStarted() {
+			JobQueue& queue = GetQueue();
+			{
+				std::scoped_lock lock(queue.mLock);
+				if (queue.mStarted) return;
+			}
+			JobSystem::Init();
+		}
+
+		// Shared between the threads taking part in a ParallelFor, it outlives
+		// the call if a helper job gets scheduled after the work is over
+		struct ParallelForState {
+			std::function<void(size_t)> mBody;
+			size_t mCount = 0;
+			std::atomic<size_t> mNext{ 0 };
+			std::atomic<size_t> mDone{ 0 };
+			std::mutex mLock;
+			std::condition_variable mFinished;
+
+			void Work() {
+				size_t completed = 0;
+				for (size_t i = mNext.fetch_add(1); i < mCount; i = mNext.fetch_add(1)) {
+					mBody(i);
+					++completed;
+				}
+
+				if (completed > 0 && mDone.fetch_add(completed) + completed == mCount) {
+					std::scoped_lock lock(mLock);
+					mFinished.notify_all();
+				}
+			}
+		};
+	}
+
+	void JobSystem::Init(uint32_t workerCount)
+	{
+		JobQueue& queue = GetQueue();
+
+		std::scoped_lock lock(queue.mLock);
+		if (!queue.mWorkers.empty()) {
+			return;
+		}
+
+		if (workerCount == 0) {
+			uint32_t hardwareThreads = std::thread::hardware_concurrency();
+			workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+		}
+
+		queue.Start(workerCount);
+		OTTER_CORE_LOG("[JOB SYSTEM] Started {} worker threads", workerCount);
+	}
+
+	void JobSystem::Shutdown()
+	{
+		GetQueue().Stop();
+	}
+
+	uint32_t JobSystem::GetWorkerCount()
+	{
+		EnsureStarted();
+		JobQueue& queue = GetQueue();
+		std::scoped_lock lock(queue.mLock);
+		return static_cast<uint32_t>(queue.mWorkers.size());
+	}
+
+	void JobSystem::Submit(Job job)
+	{
+		EnsureStarted();
+		JobQueue& queue = GetQueue();
+		{
+			std::scoped_lock lock(queue.mLock);
+			if (queue.mStopping) {
+				OTTER_CORE_WARNING("[JOB SYSTEM] Job submitted after shutdown, running it inline");
+			}
+			else {
+				queue.mJobs.push_back(std::move(job));
+				job = nullptr;
+			}
+		}
+
+		if (job) {
+			job();
+		}
+		else {
+			queue.mWakeUp.notify_one();
+		}
+	}
+
+	void JobSystem::ParallelFor(size_t count, const std::function<void(size_t)>& body, uint32_t maxThreads)
+	{
+		if (count == 0) return;
+
+		size_t helperCount = std::min<size_t>(GetWorkerCount(), count - 1);
+		if (maxThreads > 0) {
+			helperCount = std::min<size_t>(helperCount, maxThreads - 1);
+		}
+
+		if (helperCount == 0) {
+			for (size_t i = 0; i < count; ++i) body(i);
+			return;
+		}
+
+		auto state = std::make_shared<ParallelForState>();
+		state->mBody = body;
+		state->mCount = count;
+
+		for (size_t i = 0; i < helperCount; ++i) {
+			Submit([state]() { state->Work(); });
+		}
+
+		state->Work();
+
+		std::unique_lock lock(state->mLock);
+		state->mFinished.wait(lock, [&state]() { return state->mDone.load() == state->mCount; });
+	}
+}
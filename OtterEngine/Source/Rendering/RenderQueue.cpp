@@ -0,0 +1,85 @@
+#include "OtterPCH.h"
+
+#include "Rendering/RenderQueue.h"
+
+namespace OtterEngine {
+	namespace {
+		constexpr uint32_t MESH_BITS = 64 - RenderQueue::PIPELINE_BITS - RenderQueue::MATERIAL_BITS;
+
+		// Pipeline and material of a key, the part shared by a whole group
+		constexpr uint64_t GroupOf(uint64_t key) { return key >> MESH_BITS; }
+	}
+
+	void RenderQueue::Reserve(size_t instanceCount)
+	{
+		mItems.reserve(instanceCount);
+		mTransforms.reserve(instanceCount);
+	}
+
+	void RenderQueue::Submit(uint32_t mesh, MaterialID material, const glm::mat4& transform, PipelineID pipeline)
+	{
+		OTTER_ASSERT(pipeline < MAX_PIPELINES, "[RENDER QUEUE] Pipeline ID {} out of range!", pipeline);
+		OTTER_ASSERT(material < MAX_MATERIALS, "[RENDER QUEUE] Material ID {} out of range!", material);
+
+		const uint64_t key = (static_cast<uint64_t>(pipeline) << (64 - PIPELINE_BITS))
+			| (static_cast<uint64_t>(material) << MESH_BITS)
+			| mesh;
+
+		mItems.push_back({ key, static_cast<uint32_t>(mTransforms.size()) });
+		mTransforms.push_back(transform);
+	}
+
+	void RenderQueue::Build(std::span<glm::mat4> instances)
+	{
+		OTTER_ASSERT(instances.size() >= mItems.size(), "[RENDER QUEUE] Instance destination too small: {} for {} instances",
+			instances.size(), mItems.size());
+
+		auto startTime = std::chrono::high_resolution_clock::now();
+
+		auto byKey = [](const SortItem& a, const SortItem& b) { return a.mKey < b.mKey; };
+		// Scenes submitted in order skip the sort
+		if (!std::is_sorted(mItems.begin(), mItems.end(), byKey)) {
+			std::sort(mItems.begin(), mItems.end(), byKey);
+		}
+
+		mCommands.clear();
+		mGroups.clear();
+
+		for (uint32_t i = 0; i < mItems.size(); ++i) {
+			const SortItem& item = mItems[i];
+			instances[i] = mTransforms[item.mTransform];
+
+			const bool isNewCommand = i == 0 || item.mKey != mItems[i - 1].mKey;
+			if (!isNewCommand) {
+				++mCommands.back().mInstanceCount;
+				continue;
+			}
+
+			if (i == 0 || GroupOf(item.mKey) != GroupOf(mItems[i - 1].mKey)) {
+				DrawGroup& group = mGroups.emplace_back();
+				group.mPipeline = static_cast<PipelineID>(item.mKey >> (64 - PIPELINE_BITS));
+				group.mMaterial = static_cast<MaterialID>(GroupOf(item.mKey) & (MAX_MATERIALS - 1));
+				group.mFirstCommand = static_cast<uint32_t>(mCommands.size());
+			}
+
+			DrawCommand& command = mCommands.emplace_back();
+			command.mMesh = static_cast<uint32_t>(item.mKey);
+			command.mFirstInstance = i;
+			command.mInstanceCount = 1;
+			++mGroups.back().mCommandCount;
+		}
+
+		mStats.mInstanceCount = static_cast<uint32_t>(mItems.size());
+		mStats.mCommandCount = static_cast<uint32_t>(mCommands.size());
+		mStats.mGroupCount = static_cast<uint32_t>(mGroups.size());
+		mStats.mBuildMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+	}
+
+	void RenderQueue::Clear()
+	{
+		mItems.clear();
+		mTransforms.clear();
+		mCommands.clear();
+		mGroups.clear();
+	}
+}
@@ -0,0 +1,281 @@
+#include "OtterPCH.h"
+
+#include <shaderc/shaderc.hpp>
+#if __has_include(<glslang/build_info.h>)
+#include <glslang/build_info.h>
+#endif
+
+#include "Utils/Hash.h"
+#include "Utils/OtterIO.h"
+#include "Utils/PathFormat.h"
+
+#include "Rendering/ShaderCompiler.h"
+
+namespace OtterEngine {
+	namespace {
+		constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+
+		struct SourceFile {
+			std::filesystem::path mPath;
+			std::string mContent;
+		};
+
+		// Files of a shader in the order they were found, the root source first
+		using SourceSet = std::vector<SourceFile>;
+
+		shaderc_shader_kind ToShadercKind(ShaderStage stage) {
+			switch (stage) {
+			case ShaderStage::Vertex: return shaderc_vertex_shader;
+			case ShaderStage::Fragment: return shaderc_fragment_shader;
+			case ShaderStage::Compute: return shaderc_compute_shader;
+			}
+			return shaderc_vertex_shader;
+		}
+
+		std::filesystem::path ResolveInclude(std::string_view requested, const std::filesystem::path& includer,
+			const std::filesystem::path& root)
+		{
+			std::error_code error;
+			std::filesystem::path candidate = (includer.parent_path() / requested).lexically_normal();
+			if (std::filesystem::exists(candidate, error)) return candidate;
+
+			return (root.parent_path() / requested).lexically_normal();
+		}
+
+		// Name between the quotes or brackets of an #include line, empty for any other line
+		std::string_view ParseInclude(std::string_view line) {
+			size_t pos = line.find_first_not_of(" \t");
+			if (pos == std::string_view::npos || line[pos] != '#') return {};
+
+			pos = line.find_first_not_of(" \t", pos + 1);
+			if (pos == std::string_view::npos || line.compare(pos, 7, "include") != 0) return {};
+
+			pos = line.find_first_of("\"<", pos + 7);
+			if (pos == std::string_view::npos) return {};
+
+			const size_t end = line.find(line[pos] == '"' ? '"' : '>', pos + 1);
+			if (end == std::string_view::npos) return {};
+
+			return line.substr(pos + 1, end - pos - 1);
+		}
+
+		bool ReadSource(const std::filesystem::path& path, SourceSet& sources, std::vector<ShaderDependency>& dependencies) {
+			std::error_code error;
+			// Taken before reading, an edit racing the read is seen as a change next time
+			const auto writeTime = std::filesystem::last_write_time(path, error);
+			if (error) return false;
+
+			auto content = OtterIO::TryReadFile(path);
+			if (!content) return false;
+
+			sources.push_back({ path, std::string(content->begin(), content->end()) });
+			dependencies.push_back({ path, writeTime });
+			return true;
+		}
+
+		// Follows includes from every line, inactive preprocessor branches included, so the set is never missing a file
+		void GatherIncludes(size_t fileIndex, const std::filesystem::path& root, SourceSet& sources,
+			std::vector<ShaderDependency>& dependencies)
+		{
+			std::vector<std::filesystem::path> includes;
+			{
+				std::string_view content = sources[fileIndex].mContent;
+				while (!content.empty()) {
+					const size_t lineEnd = std::min(content.find('\n'), content.size());
+					std::string_view name = ParseInclude(content.substr(0, lineEnd));
+					if (!name.empty()) {
+						includes.push_back(ResolveInclude(name, sources[fileIndex].mPath, root));
+					}
+					content.remove_prefix(std::min(lineEnd + 1, content.size()));
+				}
+			}
+
+			for (const std::filesystem::path& include : includes) {
+				auto isKnown = [&](const SourceFile& source) { return source.mPath == include; };
+				if (std::any_of(sources.begin(), sources.end(), isKnown)) continue;
+
+				// Missing files are left to the compiler to report
+				if (!ReadSource(include, sources, dependencies)) continue;
+				GatherIncludes(sources.size() - 1, root, sources, dependencies);
+			}
+		}
+
+		// The source then every file it includes, false if the source itself cannot be read
+		bool GatherSources(const ShaderSourceDesc& desc, SourceSet& sources, std::vector<ShaderDependency>& dependencies) {
+			if (!ReadSource(desc.mPath, sources, dependencies)) return false;
+			GatherIncludes(0, desc.mPath, sources, dependencies);
+			return true;
+		}
+
+		uint64_t HashSources(const ShaderSourceDesc& desc, const SourceSet& sources) {
+			const std::string& compiler = ShaderCompiler::GetCompilerIdentity();
+
+			uint64_t key = HashValue(ShaderCompiler::CACHE_VERSION);
+			key = HashValue(compiler.size(), key);
+			key = HashString(compiler, key);
+			key = HashValue(desc.mStage, key);
+
+			// Lengths go in front of strings so that no two different lists hash the same bytes
+			for (const ShaderDefine& define : desc.mDefines) {
+				key = HashValue(define.mName.size(), key);
+				key = HashString(define.mName, key);
+				key = HashValue(define.mValue.size(), key);
+				key = HashString(define.mValue, key);
+			}
+
+			for (const SourceFile& source : sources) {
+				key = HashValue(source.mContent.size(), key);
+				key = HashString(source.mContent, key);
+			}
+			return key;
+		}
+
+		/// <summary>
+		/// Serves includes from the files read to compute the key, so the binary always matches the key it is cached under
+		/// </summary>
+		class SourceIncluder final : public shaderc::CompileOptions::IncluderInterface {
+			struct Include {
+				shaderc_include_result mResult{};
+				std::string mName;
+				std::string mError;
+			};
+
+			const SourceSet& mSources;
+			std::filesystem::path mRoot;
+
+		public:
+			SourceIncluder(const SourceSet& sources, std::filesystem::path root) :
+				mSources(sources),
+				mRoot(std::move(root))
+			{
+			}
+
+			shaderc_include_result* GetInclude(const char* requestedSource, shaderc_include_type /*type*/,
+				const char* requestingSource, size_t /*includeDepth*/) override
+			{
+				auto* include = new Include();
+				const std::filesystem::path resolved = ResolveInclude(requestedSource, requestingSource, mRoot);
+
+				auto it = std::find_if(mSources.begin(), mSources.end(),
+					[&](const SourceFile& source) { return source.mPath == resolved; });
+
+				if (it != mSources.end()) {
+					include->mName = resolved.string();
+					include->mResult.content = it->mContent.data();
+					include->mResult.content_length = it->mContent.size();
+				}
+				else {
+					// An empty name tells shaderc the include failed, the content is the message
+					include->mError = fmt::format("Cannot find '{}'", requestedSource);
+					include->mResult.content = include->mError.data();
+					include->mResult.content_length = include->mError.size();
+				}
+
+				include->mResult.source_name = include->mName.data();
+				include->mResult.source_name_length = include->mName.size();
+				include->mResult.user_data = include;
+				return &include->mResult;
+			}
+
+			void ReleaseInclude(shaderc_include_result* result) override {
+				delete static_cast<Include*>(result->user_data);
+			}
+		};
+
+		bool IsValidSpirv(const std::vector<char>& data) {
+			if (data.size() < 5 * sizeof(uint32_t) || data.size() % sizeof(uint32_t) != 0) return false;
+
+			uint32_t magic = 0;
+			memcpy(&magic, data.data(), sizeof(magic));
+			return magic == SPIRV_MAGIC;
+		}
+	}
+
+	const std::string& ShaderCompiler::GetCompilerIdentity()
+	{
+		// The SPIR-V version alone stays the same across compiler releases whose output differs
+		static const std::string sIdentity = []() {
+			unsigned int spirvVersion = 0;
+			unsigned int spirvRevision = 0;
+			shaderc_get_spv_version(&spirvVersion, &spirvRevision);
+
+#ifdef GLSLANG_VERSION_MAJOR
+			std::string identity = fmt::format("glslang {}.{}.{}{} SPIR-V {:#x} rev {}", GLSLANG_VERSION_MAJOR, GLSLANG_VERSION_MINOR,
+				GLSLANG_VERSION_PATCH, GLSLANG_VERSION_FLAVOR, spirvVersion, spirvRevision);
+#else
+			std::string identity = fmt::format("shaderc SPIR-V {:#x} rev {}", spirvVersion, spirvRevision);
+#endif
+			OTTER_CORE_LOG("[SHADER COMPILER] Shader cache keyed on {}", identity);
+			return identity;
+		}();
+		return sIdentity;
+	}
+
+	uint64_t ShaderCompiler::ComputeKey(const ShaderSourceDesc& desc, std::vector<ShaderDependency>* dependencies)
+	{
+		SourceSet sources;
+		std::vector<ShaderDependency> readFiles;
+		if (!GatherSources(desc, sources, readFiles)) {
+			return 0;
+		}
+
+		if (dependencies) {
+			*dependencies = std::move(readFiles);
+		}
+		return HashSources(desc, sources);
+	}
+
+	CompiledShader ShaderCompiler::Compile(const ShaderSourceDesc& desc)
+	{
+		CompiledShader shader;
+
+		SourceSet sources;
+		if (!GatherSources(desc, sources, shader.mDependencies)) {
+			OTTER_CORE_ERROR("[SHADER COMPILER] Cannot read shader source '{}'", desc.mPath);
+			return shader;
+		}
+
+		shader.mKey = HashSources(desc, sources);
+		const std::filesystem::path cachePath = std::filesystem::path(CACHE_DIRECTORY) / fmt::format("{:016x}.spv", shader.mKey);
+
+		if (auto cached = OtterIO::TryReadFile(cachePath); cached && IsValidSpirv(*cached)) {
+			shader.mSpirv.resize(cached->size() / sizeof(uint32_t));
+			memcpy(shader.mSpirv.data(), cached->data(), cached->size());
+			shader.mFromCache = true;
+			return shader;
+		}
+
+		auto startTime = std::chrono::high_resolution_clock::now();
+
+		shaderc::CompileOptions options;
+		// SPIR-V 1.0, as glslc emits by default, so devices below Vulkan 1.3 keep loading it
+		options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_0);
+		options.SetOptimizationLevel(shaderc_optimization_level_performance);
+		options.SetIncluder(std::make_unique<SourceIncluder>(sources, desc.mPath));
+		for (const ShaderDefine& define : desc.mDefines) {
+			options.AddMacroDefinition(define.mName, define.mValue);
+		}
+
+		// A compiler per call, they are cheap to create next to a compile and never shared between threads
+		shaderc::Compiler compiler;
+		const std::string sourceName = desc.mPath.string();
+		const std::string& source = sources.front().mContent;
+
+		shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(source.data(), source.size(),
+			ToShadercKind(desc.mStage), sourceName.c_str(), "main", options);
+
+		if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
+			OTTER_CORE_ERROR("[SHADER COMPILER] Failed to compile '{}':\n{}", desc.mPath, result.GetErrorMessage());
+			return shader;
+		}
+
+		shader.mSpirv.assign(result.cbegin(), result.cend());
+
+		float compileMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+		OTTER_CORE_LOG("[SHADER COMPILER] Compiled '{}' ({} defines) in {:.2f} ms", desc.mPath, desc.mDefines.size(), compileMs);
+
+		OtterIO::WriteFileAtomic(cachePath, { reinterpret_cast<const char*>(shader.mSpirv.data()),
+			shader.mSpirv.size() * sizeof(uint32_t) });
+		return shader;
+	}
+}
@@ -0,0 +1,88 @@
+#include "OtterPCH.h"
+
+#include "Core/JobSystem.h"
+#include "Utils/PathFormat.h"
+
+#include "Rendering/ShaderLibrary.h"
+
+namespace OtterEngine {
+	ShaderHandle ShaderLibrary::Load(const ShaderSourceDesc& desc)
+	{
+		auto it = std::find_if(mEntries.begin(), mEntries.end(), [&](const Entry& entry) { return entry.mDesc == desc; });
+		if (it != mEntries.end()) {
+			return static_cast<ShaderHandle>(it - mEntries.begin());
+		}
+
+		Entry& entry = mEntries.emplace_back();
+		entry.mDesc = desc;
+		entry.mShader = ShaderCompiler::Compile(desc);
+
+		if (entry.mShader.mFromCache) {
+			OTTER_CORE_LOG("[SHADER LIBRARY] Loaded '{}' from the cache", desc.mPath);
+		}
+		return static_cast<ShaderHandle>(mEntries.size() - 1);
+	}
+
+	std::span<const uint32_t> ShaderLibrary::GetSpirv(ShaderHandle handle) const
+	{
+		OTTER_ASSERT(handle < mEntries.size(), "[SHADER LIBRARY] Invalid shader handle {}", handle);
+		return mEntries[handle].mShader.mSpirv;
+	}
+
+	bool ShaderLibrary::HasChanged(const Entry& entry) const
+	{
+		for (const ShaderDependency& dependency : entry.mShader.mDependencies) {
+			std::error_code error;
+			const auto writeTime = std::filesystem::last_write_time(dependency.mPath, error);
+			// A file being replaced may briefly be missing, it is looked at again next interval
+			if (!error && writeTime != dependency.mWriteTime) return true;
+		}
+		return false;
+	}
+
+	bool ShaderLibrary::Update()
+	{
+		std::vector<Recompile> recompiles;
+		{
+			std::scoped_lock lock(mCompletions->mMutex);
+			recompiles.swap(mCompletions->mRecompiles);
+		}
+
+		bool changed = false;
+		for (Recompile& recompile : recompiles) {
+			Entry& entry = mEntries[recompile.mHandle];
+			entry.mIsCompiling = false;
+
+			if (recompile.mShader.mSpirv.empty()) {
+				OTTER_CORE_WARNING("[SHADER LIBRARY] Keeping the previous binary of '{}'", entry.mDesc.mPath);
+				// Its files are not watched again until they are written to once more
+				entry.mShader.mDependencies = std::move(recompile.mShader.mDependencies);
+				continue;
+			}
+
+			// Touching a file without changing it hashes to the same key
+			changed |= recompile.mShader.mKey != entry.mShader.mKey;
+			entry.mShader = std::move(recompile.mShader);
+		}
+
+		const auto now = std::chrono::steady_clock::now();
+		if (std::chrono::duration<float, std::milli>(now - mLastWatch).count() < mWatchIntervalMs) return changed;
+		mLastWatch = now;
+
+		for (ShaderHandle handle = 0; handle < mEntries.size(); ++handle) {
+			Entry& entry = mEntries[handle];
+			if (entry.mIsCompiling || !HasChanged(entry)) continue;
+
+			OTTER_CORE_LOG("[SHADER LIBRARY] '{}' changed, recompiling", entry.mDesc.mPath);
+			entry.mIsCompiling = true;
+
+			JobSystem::Submit([handle, desc = entry.mDesc, completions = mCompletions]() {
+				CompiledShader shader = ShaderCompiler::Compile(desc);
+
+				std::scoped_lock lock(completions->mMutex);
+				completions->mRecompiles.push_back({ handle, std::move(shader) });
+			});
+		}
+		return changed;
+	}
+}
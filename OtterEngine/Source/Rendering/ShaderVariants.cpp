@@ -0,0 +1,73 @@
+#include "OtterPCH.h"
+
+#include "Utils/Hash.h"
+#include "Utils/PathFormat.h"
+
+#include "Rendering/ShaderVariants.h"
+
+namespace OtterEngine {
+	namespace {
+		// Indexed by feature bit
+		constexpr const char* FEATURE_DEFINES[SHADER_FEATURE_COUNT] = {
+			"OTTER_LIT",
+			"OTTER_NORMAL_MAP",
+			"OTTER_VERTEX_COLOR",
+			"OTTER_ALPHA_TEST",
+			"OTTER_OCTAHEDRAL_NORMAL",
+		};
+	}
+
+	ShaderVariantCache::ShaderVariantCache(ShaderLibrary& library, std::filesystem::path vertexPath, std::filesystem::path fragmentPath) :
+		mLibrary(library),
+		mVertexPath(std::move(vertexPath)),
+		mFragmentPath(std::move(fragmentPath))
+	{
+		mProgramKey = HashString(mVertexPath.generic_string());
+		mProgramKey = HashString(mFragmentPath.generic_string(), mProgramKey);
+	}
+
+	ShaderFeatureFlags ShaderVariantCache::Normalize(ShaderFeatureFlags features)
+	{
+		features &= (1u << SHADER_FEATURE_COUNT) - 1;
+
+		if (!(features & SHADER_FEATURE_LIT)) {
+			features &= ~(SHADER_FEATURE_NORMAL_MAP | SHADER_FEATURE_OCTAHEDRAL_NORMAL);
+		}
+		return features;
+	}
+
+	std::vector<ShaderDefine> ShaderVariantCache::GetDefines(ShaderFeatureFlags features)
+	{
+		std::vector<ShaderDefine> defines;
+		for (uint32_t bit = 0; bit < SHADER_FEATURE_COUNT; ++bit) {
+			if (features & (1u << bit)) {
+				defines.push_back({ FEATURE_DEFINES[bit], "1" });
+			}
+		}
+		return defines;
+	}
+
+	ShaderVariantID ShaderVariantCache::GetVariantID(ShaderFeatureFlags features)
+	{
+		features = Normalize(features);
+
+		const uint64_t key = HashValue(features, mProgramKey);
+		if (auto it = mVariantsByKey.find(key); it != mVariantsByKey.end()) {
+			return it->second;
+		}
+
+		std::vector<ShaderDefine> defines = GetDefines(features);
+
+		ShaderVariant& variant = mVariants.emplace_back();
+		variant.mFeatures = features;
+		variant.mKey = key;
+		variant.mVertex = mLibrary.Load({ mVertexPath, ShaderStage::Vertex, defines });
+		variant.mFragment = mLibrary.Load({ mFragmentPath, ShaderStage::Fragment, std::move(defines) });
+
+		const ShaderVariantID id = static_cast<ShaderVariantID>(mVariants.size() - 1);
+		mVariantsByKey.emplace(key, id);
+
+		OTTER_CORE_LOG("[SHADER VARIANTS] Built variant {} of '{}' with features {:#x}", id, mFragmentPath.filename(), features);
+		return id;
+	}
+}
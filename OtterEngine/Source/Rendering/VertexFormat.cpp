@@ -0,0 +1,356 @@
+#include "OtterPCH.h"
+
+#include <bit>
+#include <cmath>
+
+#include "Rendering/VertexFormat.h"
+
+namespace OtterEngine {
+	namespace {
+		constexpr uint32_t MAX_VERTEX_STRIDE = 64;
+
+		uint16_t FloatToHalf(float value) {
+			const uint32_t bits = std::bit_cast<uint32_t>(value);
+			const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+			const uint32_t magnitude = bits & 0x7FFFFFFF;
+
+			// NaN stays NaN, infinities and values rounding past 65504 become infinities
+			if (magnitude > 0x7F800000) {
+				return sign | 0x7E00;
+			}
+			if (magnitude >= 0x477FF000) {
+				return sign | 0x7C00;
+			}
+
+			// Below the smallest normal half, the value is a multiple of 2^-24
+			if (magnitude < 0x38800000) {
+				const float scaled = std::bit_cast<float>(magnitude) * 16777216.0f;
+				return sign | static_cast<uint16_t>(std::nearbyint(scaled));
+			}
+
+			// Rebias the exponent and round the mantissa to nearest even
+			uint32_t half = magnitude - 0x38000000;
+			half += 0xFFF + ((half >> 13) & 1);
+			return sign | static_cast<uint16_t>(half >> 13);
+		}
+
+		float HalfToFloat(uint16_t half) {
+			const uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+			const uint32_t exponent = (half >> 10) & 0x1F;
+			const uint32_t mantissa = half & 0x3FF;
+
+			if (exponent == 0) {
+				const float value = static_cast<float>(mantissa) / 16777216.0f;
+				return sign ? -value : value;
+			}
+			if (exponent == 31) {
+				return std::bit_cast<float>(sign | 0x7F800000 | (mantissa << 13));
+			}
+			return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+		}
+
+		int16_t FloatToSnorm16(float value) {
+			return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+		}
+
+		float Snorm16ToFloat(int16_t value) {
+			return std::max(static_cast<float>(value) / 32767.0f, -1.0f);
+		}
+
+		uint16_t FloatToUnorm16(float value) {
+			return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+		}
+
+		uint8_t FloatToUnorm8(float value) {
+			return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+		}
+
+		float SignNotZero(float value) {
+			return value >= 0.0f ? 1.0f : -1.0f;
+		}
+
+		// Projects the direction on the octahedron |x| + |y| + |z| = 1 and unfolds the lower half over the corners
+		glm::vec2 EncodeOctahedral(const glm::vec3& normal) {
+			const float length = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+			if (length == 0.0f) {
+				return { 0.0f, 0.0f };
+			}
+
+			float x = normal.x / length;
+			float y = normal.y / length;
+			if (normal.z < 0.0f) {
+				const float foldedX = (1.0f - std::fabs(y)) * SignNotZero(x);
+				const float foldedY = (1.0f - std::fabs(x)) * SignNotZero(y);
+				x = foldedX;
+				y = foldedY;
+			}
+			return { x, y };
+		}
+
+		// Same as DecodeOctahedral in Shaders/triangle.vert
+		glm::vec3 DecodeOctahedral(float x, float y) {
+			glm::vec3 normal(x, y, 1.0f - std::fabs(x) - std::fabs(y));
+			const float fold = std::max(-normal.z, 0.0f);
+			normal.x += normal.x >= 0.0f ? -fold : fold;
+			normal.y += normal.y >= 0.0f ? -fold : fold;
+			return glm::normalize(normal);
+		}
+
+		template<typename T>
+		void Store(std::byte* destination, const T& value) {
+			memcpy(destination, &value, sizeof(T));
+		}
+
+		template<typename T>
+		T Load(const std::byte* source) {
+			T value;
+			memcpy(&value, source, sizeof(T));
+			return value;
+		}
+
+		void EncodeVertex(const Vertex& vertex, const VertexFormat& format, const VertexAttributeOffsets& offsets, std::byte* destination) {
+			std::byte* position = destination + offsets.mPosition;
+			if (format.mPosition == PositionEncoding::Float16) {
+				const uint16_t halves[4] = {
+					FloatToHalf(vertex.mPosition.x), FloatToHalf(vertex.mPosition.y), FloatToHalf(vertex.mPosition.z), FloatToHalf(1.0f)
+				};
+				Store(position, halves);
+			}
+			else {
+				const float floats[3] = { vertex.mPosition.x, vertex.mPosition.y, vertex.mPosition.z };
+				Store(position, floats);
+			}
+
+			std::byte* normal = destination + offsets.mNormal;
+			if (format.mNormal == NormalEncoding::Octahedral16) {
+				const glm::vec2 octahedral = EncodeOctahedral(vertex.mNormal);
+				const int16_t snorms[2] = { FloatToSnorm16(octahedral.x), FloatToSnorm16(octahedral.y) };
+				Store(normal, snorms);
+			}
+			else if (format.mNormal == NormalEncoding::Float32) {
+				const float floats[3] = { vertex.mNormal.x, vertex.mNormal.y, vertex.mNormal.z };
+				Store(normal, floats);
+			}
+
+			std::byte* texCoord = destination + offsets.mTexCoord;
+			if (format.mTexCoord == TexCoordEncoding::Unorm16) {
+				const uint16_t unorms[2] = { FloatToUnorm16(vertex.mTexCoord.x), FloatToUnorm16(vertex.mTexCoord.y) };
+				Store(texCoord, unorms);
+			}
+			else {
+				const float floats[2] = { vertex.mTexCoord.x, vertex.mTexCoord.y };
+				Store(texCoord, floats);
+			}
+
+			if (format.mColor == ColorEncoding::Unorm8) {
+				const uint8_t unorms[4] = {
+					FloatToUnorm8(vertex.mColor.x), FloatToUnorm8(vertex.mColor.y), FloatToUnorm8(vertex.mColor.z), 255
+				};
+				Store(destination + offsets.mColor, unorms);
+			}
+		}
+
+		Vertex DecodeVertex(const std::byte* source, const VertexFormat& format, const VertexAttributeOffsets& offsets) {
+			Vertex vertex{};
+
+			const std::byte* position = source + offsets.mPosition;
+			if (format.mPosition == PositionEncoding::Float16) {
+				const auto halves = Load<std::array<uint16_t, 4>>(position);
+				vertex.mPosition = { HalfToFloat(halves[0]), HalfToFloat(halves[1]), HalfToFloat(halves[2]) };
+			}
+			else {
+				const auto floats = Load<std::array<float, 3>>(position);
+				vertex.mPosition = { floats[0], floats[1], floats[2] };
+			}
+
+			const std::byte* normal = source + offsets.mNormal;
+			if (format.mNormal == NormalEncoding::Octahedral16) {
+				const auto snorms = Load<std::array<int16_t, 2>>(normal);
+				vertex.mNormal = DecodeOctahedral(Snorm16ToFloat(snorms[0]), Snorm16ToFloat(snorms[1]));
+			}
+			else if (format.mNormal == NormalEncoding::Float32) {
+				const auto floats = Load<std::array<float, 3>>(normal);
+				vertex.mNormal = { floats[0], floats[1], floats[2] };
+			}
+			else {
+				vertex.mNormal = { 0.0f, 0.0f, 0.0f };
+			}
+
+			const std::byte* texCoord = source + offsets.mTexCoord;
+			if (format.mTexCoord == TexCoordEncoding::Unorm16) {
+				const auto unorms = Load<std::array<uint16_t, 2>>(texCoord);
+				vertex.mTexCoord = { unorms[0] / 65535.0f, unorms[1] / 65535.0f };
+			}
+			else {
+				const auto floats = Load<std::array<float, 2>>(texCoord);
+				vertex.mTexCoord = { floats[0], floats[1] };
+			}
+
+			if (format.mColor == ColorEncoding::Unorm8) {
+				const auto unorms = Load<std::array<uint8_t, 4>>(source + offsets.mColor);
+				vertex.mColor = { unorms[0] / 255.0f, unorms[1] / 255.0f, unorms[2] / 255.0f };
+			}
+			else {
+				vertex.mColor = { 1.0f, 1.0f, 1.0f };
+			}
+
+			return vertex;
+		}
+
+		float MaxComponentDifference(const glm::vec3& a, const glm::vec3& b) {
+			return std::max({ std::fabs(a.x - b.x), std::fabs(a.y - b.y), std::fabs(a.z - b.z) });
+		}
+	}
+
+	VertexAttributeOffsets VertexFormat::GetOffsets() const noexcept
+	{
+		VertexAttributeOffsets offsets;
+		uint32_t offset = 0;
+
+		offsets.mPosition = offset;
+		offset += mPosition == PositionEncoding::Float16 ? 4 * sizeof(uint16_t) : 3 * sizeof(float);
+
+		offsets.mNormal = offset;
+		if (mNormal == NormalEncoding::Octahedral16) {
+			offset += 2 * sizeof(int16_t);
+		}
+		else if (mNormal == NormalEncoding::Float32) {
+			offset += 3 * sizeof(float);
+		}
+
+		offsets.mTexCoord = offset;
+		offset += mTexCoord == TexCoordEncoding::Unorm16 ? 2 * sizeof(uint16_t) : 2 * sizeof(float);
+
+		offsets.mColor = offset;
+		if (mColor == ColorEncoding::Unorm8) {
+			offset += 4 * sizeof(uint8_t);
+		}
+
+		offsets.mStride = offset;
+		return offsets;
+	}
+
+	uint32_t VertexFormat::GetKey() const noexcept
+	{
+		return static_cast<uint32_t>(mPosition) |
+			(static_cast<uint32_t>(mNormal) << 8) |
+			(static_cast<uint32_t>(mTexCoord) << 16) |
+			(static_cast<uint32_t>(mColor) << 24);
+	}
+
+	bool VertexFormat::FromKey(uint32_t key, VertexFormat& format) noexcept
+	{
+		const uint32_t position = key & 0xFF;
+		const uint32_t normal = (key >> 8) & 0xFF;
+		const uint32_t texCoord = (key >> 16) & 0xFF;
+		const uint32_t color = key >> 24;
+
+		if (position > static_cast<uint32_t>(PositionEncoding::Float16) ||
+			normal > static_cast<uint32_t>(NormalEncoding::Octahedral16) ||
+			texCoord > static_cast<uint32_t>(TexCoordEncoding::Unorm16) ||
+			color > static_cast<uint32_t>(ColorEncoding::Unorm8)) {
+			return false;
+		}
+
+		format.mPosition = static_cast<PositionEncoding>(position);
+		format.mNormal = static_cast<NormalEncoding>(normal);
+		format.mTexCoord = static_cast<TexCoordEncoding>(texCoord);
+		format.mColor = static_cast<ColorEncoding>(color);
+		return true;
+	}
+
+	VertexFormat VertexFormat::Choose(std::span<const Vertex> vertices, const VertexQuantizationSettings& settings)
+	{
+		bool hasNormals = false;
+		bool hasColors = false;
+		bool areTexCoordsNormalized = true;
+		for (const Vertex& vertex : vertices) {
+			hasNormals |= vertex.mNormal != glm::vec3(0.0f);
+			hasColors |= vertex.mColor != glm::vec3(1.0f);
+			areTexCoordsNormalized &= vertex.mTexCoord.x >= 0.0f && vertex.mTexCoord.x <= 1.0f &&
+				vertex.mTexCoord.y >= 0.0f && vertex.mTexCoord.y <= 1.0f;
+		}
+
+		VertexFormat format;
+		format.mNormal = hasNormals ? NormalEncoding::Float32 : NormalEncoding::None;
+		format.mColor = hasColors ? ColorEncoding::Unorm8 : ColorEncoding::None;
+		if (!settings.mEnabled) {
+			return format;
+		}
+
+		// Try every compact encoding at once, then fall back per attribute
+		VertexFormat quantized = format;
+		quantized.mPosition = PositionEncoding::Float16;
+		if (hasNormals) {
+			quantized.mNormal = NormalEncoding::Octahedral16;
+		}
+		if (areTexCoordsNormalized) {
+			quantized.mTexCoord = TexCoordEncoding::Unorm16;
+		}
+
+		// Written so that a NaN error rejects the encoding
+		const VertexQuantizationError error = MeasureQuantizationError(vertices, quantized);
+		if (!(error.mPosition <= settings.mMaxPositionError)) {
+			quantized.mPosition = PositionEncoding::Float32;
+		}
+		if (!(error.mNormal <= settings.mMaxNormalError)) {
+			quantized.mNormal = format.mNormal;
+		}
+		if (!(error.mTexCoord <= settings.mMaxTexCoordError)) {
+			quantized.mTexCoord = TexCoordEncoding::Float32;
+		}
+		return quantized;
+	}
+
+	std::vector<std::byte> EncodeVertices(std::span<const Vertex> vertices, const VertexFormat& format)
+	{
+		const VertexAttributeOffsets offsets = format.GetOffsets();
+
+		std::vector<std::byte> data(vertices.size() * offsets.mStride);
+		for (size_t i = 0; i < vertices.size(); ++i) {
+			EncodeVertex(vertices[i], format, offsets, data.data() + i * offsets.mStride);
+		}
+		return data;
+	}
+
+	std::vector<Vertex> DecodeVertices(std::span<const std::byte> data, const VertexFormat& format)
+	{
+		const VertexAttributeOffsets offsets = format.GetOffsets();
+
+		std::vector<Vertex> vertices(data.size() / offsets.mStride);
+		for (size_t i = 0; i < vertices.size(); ++i) {
+			vertices[i] = DecodeVertex(data.data() + i * offsets.mStride, format, offsets);
+		}
+		return vertices;
+	}
+
+	VertexQuantizationError MeasureQuantizationError(std::span<const Vertex> vertices, const VertexFormat& format)
+	{
+		const VertexAttributeOffsets offsets = format.GetOffsets();
+		OTTER_ASSERT(offsets.mStride <= MAX_VERTEX_STRIDE, "[VERTEX FORMAT] Vertex stride {} is too large!", offsets.mStride);
+
+		VertexQuantizationError error;
+		std::byte packed[MAX_VERTEX_STRIDE];
+		for (const Vertex& vertex : vertices) {
+			EncodeVertex(vertex, format, offsets, packed);
+			const Vertex decoded = DecodeVertex(packed, format, offsets);
+
+			error.mPosition = std::max(error.mPosition, glm::length(decoded.mPosition - vertex.mPosition));
+			error.mTexCoord = std::max({ error.mTexCoord,
+				std::fabs(decoded.mTexCoord.x - vertex.mTexCoord.x), std::fabs(decoded.mTexCoord.y - vertex.mTexCoord.y) });
+			if (format.HasColors()) {
+				error.mColor = std::max(error.mColor, MaxComponentDifference(decoded.mColor, vertex.mColor));
+			}
+
+			// Only directions are stored, zero normals have none to compare
+			const float normalLength = glm::length(vertex.mNormal);
+			if (format.HasNormals() && normalLength > 0.0f) {
+				// atan2 keeps its precision for small angles, where acos of the dot product does not
+				const glm::vec3 original = vertex.mNormal / normalLength;
+				const float angle = std::atan2(glm::length(glm::cross(original, decoded.mNormal)), glm::dot(original, decoded.mNormal));
+				error.mNormal = std::max(error.mNormal, angle);
+			}
+		}
+		return error;
+	}
+}
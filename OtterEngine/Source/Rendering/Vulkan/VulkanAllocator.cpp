@@ -0,0 +1,294 @@
+#include "OtterPCH.h"
+
+#include "Rendering/Vulkan/VulkanUtility.h"
+
+#include "Rendering/Vulkan/VulkanAllocator.h"
+
+namespace OtterEngine {
+	namespace {
+		constexpr double BYTES_PER_MB = 1024.0 * 1024.0;
+	}
+
+	VulkanAllocator::VulkanAllocator(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize blockSize) :
+		mDevice(device), mPhysicalDevice(physicalDevice), mBlockSize(blockSize) {
+		vkGetPhysicalDeviceMemoryProperties(mPhysicalDevice, &mMemoryProperties);
+
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(mPhysicalDevice, &properties);
+		mBufferImageGranularity = std::max<VkDeviceSize>(properties.limits.bufferImageGranularity, 1);
+		mMaxAllocationCount = properties.limits.maxMemoryAllocationCount;
+
+		mPools.resize(mMemoryProperties.memoryTypeCount);
+
+		OTTER_CORE_LOG("[VULKAN ALLOCATOR] {} memory types, {} MB blocks, buffer-image granularity {}, at most {} driver allocations",
+			mMemoryProperties.memoryTypeCount, mBlockSize / (1024 * 1024), mBufferImageGranularity, mMaxAllocationCount);
+	}
+
+	VulkanAllocator::~VulkanAllocator()
+	{
+		LogStats();
+
+		if (mStats.mAllocationCount > 0) {
+			OTTER_CORE_WARNING("[VULKAN ALLOCATOR] {} allocations were never freed", mStats.mAllocationCount);
+		}
+
+		for (MemoryTypePool& pool : mPools) {
+			for (std::unique_ptr<Block>& block : pool.mBlocks) {
+				if (block) {
+					vkFreeMemory(mDevice, block->mMemory, nullptr);
+				}
+			}
+			pool.mBlocks.clear();
+		}
+	}
+
+	VulkanAllocation VulkanAllocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, ResourceKind kind)
+	{
+		std::lock_guard<std::mutex> lock(mLock);
+
+		const uint32_t memoryType = FindMemoryType(requirements.memoryTypeBits, properties);
+		if (memoryType == UINT32_MAX) {
+			OTTER_CORE_ERROR("[VULKAN ALLOCATOR] No memory type matches filter 0x{:x} with properties 0x{:x}", requirements.memoryTypeBits, properties);
+			return VulkanAllocation();
+		}
+
+		// Without a granularity to respect, buffers and images can share the same blocks
+		if (mBufferImageGranularity <= 1) {
+			kind = ResourceKind::Linear;
+		}
+
+		VulkanAllocation allocation;
+		allocation.mMemoryType = memoryType;
+		allocation.mSize = requirements.size;
+
+		const VkDeviceSize blockSize = GetBlockSize(memoryType);
+		if (requirements.size > blockSize / 2) {
+			uint8_t* mapped = nullptr;
+			allocation.mMemory = AllocateDeviceMemory(requirements.size, memoryType, &mapped);
+			if (allocation.mMemory == VK_NULL_HANDLE) {
+				return VulkanAllocation();
+			}
+
+			allocation.pMapped = mapped;
+			++mStats.mDedicatedCount;
+		}
+		else {
+			std::vector<std::unique_ptr<Block>>& blocks = mPools[memoryType].mBlocks;
+			uint32_t blockIndex = UINT32_MAX;
+			uint64_t offset = RangeAllocator::INVALID_OFFSET;
+
+			for (uint32_t i = 0; i < blocks.size() && offset == RangeAllocator::INVALID_OFFSET; ++i) {
+				if (blocks[i] && blocks[i]->mKind == kind) {
+					offset = blocks[i]->mRanges.Allocate(requirements.size, requirements.alignment);
+					blockIndex = i;
+				}
+			}
+
+			if (offset == RangeAllocator::INVALID_OFFSET) {
+				auto block = std::make_unique<Block>();
+				block->mMemory = AllocateDeviceMemory(blockSize, memoryType, &block->pMapped);
+				if (block->mMemory == VK_NULL_HANDLE) {
+					return VulkanAllocation();
+				}
+				block->mRanges.Reset(blockSize);
+				block->mKind = kind;
+				block->mID = mNextBlockID++;
+
+				// Reuse the slot of a released block so indices held by live allocations stay valid
+				auto freeSlot = std::find(blocks.begin(), blocks.end(), nullptr);
+				blockIndex = static_cast<uint32_t>(freeSlot - blocks.begin());
+				if (freeSlot == blocks.end()) {
+					blocks.push_back(std::move(block));
+				}
+				else {
+					*freeSlot = std::move(block);
+				}
+				++mStats.mBlockCount;
+
+				offset = blocks[blockIndex]->mRanges.Allocate(requirements.size, requirements.alignment);
+			}
+
+			const Block& block = *blocks[blockIndex];
+			allocation.mMemory = block.mMemory;
+			allocation.mOffset = offset;
+			allocation.pMapped = block.pMapped ? block.pMapped + offset : nullptr;
+			allocation.mBlockIndex = blockIndex;
+			allocation.mBlockID = block.mID;
+		}
+
+		++mStats.mAllocationCount;
+		mStats.mUsedBytes += allocation.mSize;
+		return allocation;
+	}
+
+	void VulkanAllocator::Free(VulkanAllocation& allocation)
+	{
+		if (!allocation) {
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(mLock);
+
+		if (allocation.IsDedicated()) {
+			FreeDeviceMemory(allocation.mMemory, allocation.mSize);
+			--mStats.mDedicatedCount;
+		}
+		else {
+			std::vector<std::unique_ptr<Block>>& blocks = mPools[allocation.mMemoryType].mBlocks;
+			OTTER_ASSERT(allocation.mBlockIndex < blocks.size() && blocks[allocation.mBlockIndex] &&
+				blocks[allocation.mBlockIndex]->mID == allocation.mBlockID, "[VULKAN ALLOCATOR] Freeing an allocation of a released block!");
+
+			Block& block = *blocks[allocation.mBlockIndex];
+			block.mRanges.Free(allocation.mOffset, allocation.mSize);
+
+			// Keep one empty block per memory type, so allocating and freeing in a loop does not hit the driver
+			if (block.mRanges.IsEmpty()) {
+				const bool hasOtherEmptyBlock = std::any_of(blocks.begin(), blocks.end(), [&block](const std::unique_ptr<Block>& other) {
+					return other && other.get() != &block && other->mRanges.IsEmpty();
+				});
+				if (hasOtherEmptyBlock) {
+					FreeDeviceMemory(block.mMemory, block.mRanges.GetSize());
+					blocks[allocation.mBlockIndex].reset();
+					--mStats.mBlockCount;
+				}
+			}
+		}
+
+		--mStats.mAllocationCount;
+		mStats.mUsedBytes -= allocation.mSize;
+		allocation = VulkanAllocation();
+	}
+
+	VkResult VulkanAllocator::CreateBuffer(const VkBufferCreateInfo& createInfo, VkMemoryPropertyFlags properties, VkBuffer& buffer, VulkanAllocation& allocation)
+	{
+		VkResult result = vkCreateBuffer(mDevice, &createInfo, nullptr, &buffer);
+		if (result != VK_SUCCESS) {
+			return result;
+		}
+
+		VkMemoryRequirements requirements;
+		vkGetBufferMemoryRequirements(mDevice, buffer, &requirements);
+
+		allocation = Allocate(requirements, properties, ResourceKind::Linear);
+		if (!allocation) {
+			vkDestroyBuffer(mDevice, buffer, nullptr);
+			buffer = VK_NULL_HANDLE;
+			return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+		}
+
+		return vkBindBufferMemory(mDevice, buffer, allocation.mMemory, allocation.mOffset);
+	}
+
+	VkResult VulkanAllocator::CreateImage(const VkImageCreateInfo& createInfo, VkMemoryPropertyFlags properties, VkImage& image, VulkanAllocation& allocation)
+	{
+		VkResult result = vkCreateImage(mDevice, &createInfo, nullptr, &image);
+		if (result != VK_SUCCESS) {
+			return result;
+		}
+
+		VkMemoryRequirements requirements;
+		vkGetImageMemoryRequirements(mDevice, image, &requirements);
+
+		const ResourceKind kind = createInfo.tiling == VK_IMAGE_TILING_LINEAR ? ResourceKind::Linear : ResourceKind::Optimal;
+		allocation = Allocate(requirements, properties, kind);
+		if (!allocation) {
+			vkDestroyImage(mDevice, image, nullptr);
+			image = VK_NULL_HANDLE;
+			return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+		}
+
+		return vkBindImageMemory(mDevice, image, allocation.mMemory, allocation.mOffset);
+	}
+
+	void VulkanAllocator::DestroyBuffer(VkBuffer& buffer, VulkanAllocation& allocation)
+	{
+		if (buffer != VK_NULL_HANDLE) {
+			vkDestroyBuffer(mDevice, buffer, nullptr);
+			buffer = VK_NULL_HANDLE;
+		}
+		Free(allocation);
+	}
+
+	void VulkanAllocator::DestroyImage(VkImage& image, VulkanAllocation& allocation)
+	{
+		if (image != VK_NULL_HANDLE) {
+			vkDestroyImage(mDevice, image, nullptr);
+			image = VK_NULL_HANDLE;
+		}
+		Free(allocation);
+	}
+
+	VulkanAllocatorStats VulkanAllocator::GetStats() const
+	{
+		std::lock_guard<std::mutex> lock(mLock);
+		return mStats;
+	}
+
+	void VulkanAllocator::LogStats() const
+	{
+		VulkanAllocatorStats stats = GetStats();
+		OTTER_CORE_LOG("[VULKAN ALLOCATOR] {} allocations in {} blocks + {} dedicated, {:.1f} / {:.1f} MB used, peak {:.1f} MB",
+			stats.mAllocationCount, stats.mBlockCount, stats.mDedicatedCount,
+			stats.mUsedBytes / BYTES_PER_MB, stats.mReservedBytes / BYTES_PER_MB, stats.mPeakReservedBytes / BYTES_PER_MB);
+	}
+
+	uint32_t VulkanAllocator::FindMemoryType(uint32_t filter, VkMemoryPropertyFlags properties) const
+	{
+		for (uint32_t i = 0; i < mMemoryProperties.memoryTypeCount; ++i) {
+			if ((filter & (1u << i)) && (mMemoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+				return i;
+			}
+		}
+		return UINT32_MAX;
+	}
+
+	VkDeviceSize VulkanAllocator::GetBlockSize(uint32_t memoryType) const
+	{
+		// Small heaps, like the host-visible window of some GPUs, get proportionally smaller blocks
+		const VkDeviceSize heapSize = mMemoryProperties.memoryHeaps[mMemoryProperties.memoryTypes[memoryType].heapIndex].size;
+		return std::min(mBlockSize, std::max<VkDeviceSize>(heapSize / 8, 1024 * 1024));
+	}
+
+	VkDeviceMemory VulkanAllocator::AllocateDeviceMemory(VkDeviceSize size, uint32_t memoryType, uint8_t** mapped)
+	{
+		if (mMaxAllocationCount > 0 && mDriverAllocationCount >= mMaxAllocationCount) {
+			OTTER_CORE_ERROR("[VULKAN ALLOCATOR] Reached the device limit of {} memory allocations", mMaxAllocationCount);
+			return VK_NULL_HANDLE;
+		}
+
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = size;
+		allocInfo.memoryTypeIndex = memoryType;
+
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkResult result = vkAllocateMemory(mDevice, &allocInfo, nullptr, &memory);
+		if (result != VK_SUCCESS) {
+			OTTER_CORE_ERROR("[VULKAN ALLOCATOR] Failed to allocate {} bytes of memory type {}: {}", size, memoryType, VulkanUtility::VkResultToString(result));
+			return VK_NULL_HANDLE;
+		}
+
+		*mapped = nullptr;
+		if (mMemoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+			void* data = nullptr;
+			if (vkMapMemory(mDevice, memory, 0, VK_WHOLE_SIZE, 0, &data) != VK_SUCCESS) {
+				OTTER_CORE_ERROR("[VULKAN ALLOCATOR] Failed to map host-visible memory of type {}", memoryType);
+			}
+			*mapped = static_cast<uint8_t*>(data);
+		}
+
+		++mDriverAllocationCount;
+		mStats.mReservedBytes += size;
+		mStats.mPeakReservedBytes = std::max(mStats.mPeakReservedBytes, mStats.mReservedBytes);
+		return memory;
+	}
+
+	void VulkanAllocator::FreeDeviceMemory(VkDeviceMemory memory, VkDeviceSize size)
+	{
+		// Freeing the memory also releases its mapping
+		vkFreeMemory(mDevice, memory, nullptr);
+
+		--mDriverAllocationCount;
+		mStats.mReservedBytes -= size;
+	}
+}
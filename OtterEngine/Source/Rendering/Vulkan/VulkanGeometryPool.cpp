@@ -0,0 +1,372 @@
+#include "OtterPCH.h"
+
+#include "Rendering/Vulkan/VulkanUtility.h"
+
+#include "Rendering/Vulkan/VulkanGeometryPool.h"
+
+namespace OtterEngine {
+	namespace {
+		/// <summary>
+		/// Doubles a capacity until it holds the required bytes
+		/// </summary>
+		/// <returns>The new capacity, or 0 if it would not fit in the signed 32-bit vertex offsets of draw calls</returns>
+		uint32_t GrowCapacity(uint32_t capacity, uint64_t required) {
+			uint64_t grown = std::max<uint64_t>(capacity, 1);
+			while (grown < required) {
+				grown *= 2;
+			}
+			return grown <= static_cast<uint64_t>(INT32_MAX) ? static_cast<uint32_t>(grown) : 0;
+		}
+
+		uint32_t GetIndexSize(VkIndexType indexType) {
+			return indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+		}
+	}
+
+	VulkanGeometryPool::VulkanGeometryPool(VulkanAllocator& allocator, VulkanUploadQueue& uploadQueue, VkCommandPool commandPool, VkQueue graphicsQueue,
+		uint32_t framesInFlight, uint32_t vertexBufferSize, uint32_t indexBufferSize) :
+		mDevice(allocator.GetDevice()), mAllocator(allocator), mUploadQueue(uploadQueue),
+		mCommandPool(commandPool), mGraphicsQueue(graphicsQueue), mFramesInFlight(std::max(framesInFlight, 1u)) {
+		CreateBuffers(vertexBufferSize, indexBufferSize, mVertexBuffer, mVertexAllocation, mIndexBuffer, mIndexAllocation);
+		mVertexRanges.Reset(vertexBufferSize);
+		mIndexRanges.Reset(indexBufferSize);
+
+		mStats.mVertexBufferSize = vertexBufferSize;
+		mStats.mIndexBufferSize = indexBufferSize;
+
+		OTTER_CORE_LOG("[VULKAN GEOMETRY POOL] Created a pool of {} vertex bytes and {} index bytes", vertexBufferSize, indexBufferSize);
+	}
+
+	VulkanGeometryPool::~VulkanGeometryPool()
+	{
+		mUploadQueue.Wait(mLastUpload);
+
+		for (RetiredBuffer& retired : mRetiredBuffers) {
+			mAllocator.DestroyBuffer(retired.mBuffer, retired.mAllocation);
+		}
+		mRetiredBuffers.clear();
+
+		mAllocator.DestroyBuffer(mVertexBuffer, mVertexAllocation);
+		mAllocator.DestroyBuffer(mIndexBuffer, mIndexAllocation);
+	}
+
+	GeometryHandle VulkanGeometryPool::Add(std::span<const std::byte> vertexData, uint32_t vertexStride, std::span<const std::byte> indexData,
+		VkIndexType indexType)
+	{
+		if (vertexData.empty() || indexData.empty()) {
+			OTTER_CORE_WARNING("[VULKAN GEOMETRY POOL] Skipping a mesh without vertices or indices");
+			return INVALID_GEOMETRY;
+		}
+		OTTER_ASSERT(vertexStride >= 4 && vertexData.size() % vertexStride == 0,
+			"[VULKAN GEOMETRY POOL] Vertex data of {} bytes does not hold vertices of {} bytes!", vertexData.size(), vertexStride);
+
+		const uint32_t indexSize = GetIndexSize(indexType);
+		OTTER_ASSERT(indexData.size() % indexSize == 0,
+			"[VULKAN GEOMETRY POOL] Index data of {} bytes does not hold indices of {} bytes!", indexData.size(), indexSize);
+
+		const uint32_t vertexBytes = static_cast<uint32_t>(vertexData.size());
+		const uint32_t vertexCount = vertexBytes / vertexStride;
+		const uint32_t indexBytes = static_cast<uint32_t>(indexData.size());
+		const uint32_t indexCount = indexBytes / indexSize;
+
+		uint64_t vertexOffset = mVertexRanges.Allocate(vertexBytes, vertexStride);
+		uint64_t indexOffset = mIndexRanges.Allocate(indexBytes, indexSize);
+
+		if (vertexOffset == RangeAllocator::INVALID_OFFSET || indexOffset == RangeAllocator::INVALID_OFFSET) {
+			if (vertexOffset != RangeAllocator::INVALID_OFFSET) {
+				mVertexRanges.Free(vertexOffset, vertexBytes);
+			}
+			if (indexOffset != RangeAllocator::INVALID_OFFSET) {
+				mIndexRanges.Free(indexOffset, indexBytes);
+			}
+
+			// Packing the live meshes may be enough, otherwise grow the buffers along the way.
+			// Each mesh may lose up to one stride and one index to alignment.
+			const uint64_t vertexSlack = uint64_t(mStats.mMeshCount + 1) * vertexStride;
+			const uint64_t indexSlack = uint64_t(mStats.mMeshCount + 1) * sizeof(uint32_t);
+			uint32_t vertexBufferSize = GrowCapacity(mStats.mVertexBufferSize, uint64_t(mStats.mLiveVertexBytes) + vertexBytes + vertexSlack);
+			uint32_t indexBufferSize = GrowCapacity(mStats.mIndexBufferSize, uint64_t(mStats.mLiveIndexBytes) + indexBytes + indexSlack);
+
+			// Meshes of larger strides may lose more to alignment than the slack, keep doubling until everything fits
+			while (vertexOffset == RangeAllocator::INVALID_OFFSET || indexOffset == RangeAllocator::INVALID_OFFSET) {
+				if (vertexBufferSize == 0 || indexBufferSize == 0) {
+					OTTER_CORE_ERROR("[VULKAN GEOMETRY POOL] No room for a mesh of {} vertex bytes and {} index bytes, the pool cannot grow past {} bytes",
+						vertexBytes, indexBytes, INT32_MAX);
+					return INVALID_GEOMETRY;
+				}
+
+				if (Reallocate(vertexBufferSize, indexBufferSize)) {
+					vertexOffset = mVertexRanges.Allocate(vertexBytes, vertexStride);
+					indexOffset = mIndexRanges.Allocate(indexBytes, indexSize);
+					if (vertexOffset != RangeAllocator::INVALID_OFFSET && indexOffset != RangeAllocator::INVALID_OFFSET) {
+						break;
+					}
+					if (vertexOffset != RangeAllocator::INVALID_OFFSET) {
+						mVertexRanges.Free(vertexOffset, vertexBytes);
+						vertexOffset = RangeAllocator::INVALID_OFFSET;
+					}
+					if (indexOffset != RangeAllocator::INVALID_OFFSET) {
+						mIndexRanges.Free(indexOffset, indexBytes);
+						indexOffset = RangeAllocator::INVALID_OFFSET;
+					}
+				}
+
+				vertexBufferSize = GrowCapacity(vertexBufferSize, uint64_t(vertexBufferSize) + 1);
+				indexBufferSize = GrowCapacity(indexBufferSize, uint64_t(indexBufferSize) + 1);
+			}
+		}
+
+		StagingAllocation vertexStaging = mUploadQueue.AllocateStaging(vertexBytes);
+		memcpy(vertexStaging.pMapped, vertexData.data(), vertexBytes);
+		mUploadQueue.CopyBuffer(vertexStaging.mBuffer, vertexStaging.mOffset,
+			mVertexBuffer, vertexOffset, vertexBytes,
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+
+		StagingAllocation indexStaging = mUploadQueue.AllocateStaging(indexBytes);
+		memcpy(indexStaging.pMapped, indexData.data(), indexBytes);
+		mLastUpload = mUploadQueue.CopyBuffer(indexStaging.mBuffer, indexStaging.mOffset,
+			mIndexBuffer, indexOffset, indexBytes,
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
+
+		GeometryHandle handle;
+		if (!mFreeSlots.empty()) {
+			handle = mFreeSlots.back();
+			mFreeSlots.pop_back();
+		}
+		else {
+			handle = static_cast<GeometryHandle>(mSlots.size());
+			mSlots.emplace_back();
+		}
+
+		Slot& slot = mSlots[handle];
+		slot.mRange.mFirstIndex = static_cast<uint32_t>(indexOffset / indexSize);
+		slot.mRange.mIndexCount = indexCount;
+		slot.mRange.mVertexOffset = static_cast<int32_t>(vertexOffset / vertexStride);
+		slot.mRange.mVertexCount = vertexCount;
+		slot.mRange.mVertexStride = vertexStride;
+		slot.mRange.mIndexType = indexType;
+		slot.mIsLive = true;
+
+		++mStats.mMeshCount;
+		mStats.mLiveVertexBytes += vertexBytes;
+		mStats.mLiveIndexBytes += indexBytes;
+		return handle;
+	}
+
+	void VulkanGeometryPool::Remove(GeometryHandle handle)
+	{
+		if (!IsValid(handle)) {
+			OTTER_CORE_WARNING("[VULKAN GEOMETRY POOL] Removing unknown geometry {}", handle);
+			return;
+		}
+
+		Slot& slot = mSlots[handle];
+		slot.mIsLive = false;
+		mFreeSlots.push_back(handle);
+
+		// Frames recorded up to now may still draw the mesh
+		mPendingFrees.push_back({ slot.mRange, mFrame + mFramesInFlight });
+
+		--mStats.mMeshCount;
+		mStats.mLiveVertexBytes -= slot.mRange.mVertexCount * slot.mRange.mVertexStride;
+		mStats.mLiveIndexBytes -= slot.mRange.mIndexCount * GetIndexSize(slot.mRange.mIndexType);
+	}
+
+	void VulkanGeometryPool::Compact()
+	{
+		if (!Reallocate(mStats.mVertexBufferSize, mStats.mIndexBufferSize)) {
+			OTTER_CORE_WARNING("[VULKAN GEOMETRY POOL] Live meshes do not fit packed in the current capacity, the pool was left as is");
+		}
+	}
+
+	void VulkanGeometryPool::Update()
+	{
+		++mFrame;
+
+		std::erase_if(mPendingFrees, [this](const PendingFree& pending) {
+			if (pending.mReleaseFrame > mFrame) {
+				return false;
+			}
+			ReleaseRange(pending.mRange);
+			return true;
+		});
+
+		std::erase_if(mRetiredBuffers, [this](RetiredBuffer& retired) {
+			if (retired.mReleaseFrame > mFrame) {
+				return false;
+			}
+			mAllocator.DestroyBuffer(retired.mBuffer, retired.mAllocation);
+			return true;
+		});
+	}
+
+	void VulkanGeometryPool::Bind(VkCommandBuffer commandBuffer) const
+	{
+		VkBuffer vertexBuffers[] = { mVertexBuffer };
+		VkDeviceSize offsets[] = { 0 };
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+	}
+
+	void VulkanGeometryPool::BindIndexBuffer(VkCommandBuffer commandBuffer, VkIndexType indexType) const
+	{
+		vkCmdBindIndexBuffer(commandBuffer, mIndexBuffer, 0, indexType);
+	}
+
+	void VulkanGeometryPool::Draw(VkCommandBuffer commandBuffer, GeometryHandle handle, uint32_t instanceCount, uint32_t firstInstance) const
+	{
+		const GeometryRange& range = GetRange(handle);
+		BindIndexBuffer(commandBuffer, range.mIndexType);
+		vkCmdDrawIndexed(commandBuffer, range.mIndexCount, instanceCount, range.mFirstIndex, range.mVertexOffset, firstInstance);
+	}
+
+	const GeometryRange& VulkanGeometryPool::GetRange(GeometryHandle handle) const
+	{
+		OTTER_ASSERT(IsValid(handle), "[VULKAN GEOMETRY POOL] Invalid geometry handle {}!", handle);
+		return mSlots[handle].mRange;
+	}
+
+	void VulkanGeometryPool::CreateBuffers(uint32_t vertexBufferSize, uint32_t indexBufferSize, VkBuffer& vertexBuffer, VulkanAllocation& vertexAllocation,
+		VkBuffer& indexBuffer, VulkanAllocation& indexAllocation)
+	{
+		// Transfer source too, reallocations copy the live meshes out of the old buffers
+		VulkanUtility::CreateNewBuffer(mAllocator, VkDeviceSize(vertexBufferSize),
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			vertexBuffer, vertexAllocation);
+
+		VulkanUtility::CreateNewBuffer(mAllocator, VkDeviceSize(indexBufferSize),
+			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			indexBuffer, indexAllocation);
+	}
+
+	bool VulkanGeometryPool::Reallocate(uint32_t vertexBufferSize, uint32_t indexBufferSize)
+	{
+		// Place the live meshes first, nothing changes if one of them does not fit
+		RangeAllocator vertexRanges(vertexBufferSize);
+		RangeAllocator indexRanges(indexBufferSize);
+
+		std::vector<VkBufferCopy> vertexCopies;
+		std::vector<VkBufferCopy> indexCopies;
+		vertexCopies.reserve(mStats.mMeshCount);
+		indexCopies.reserve(mStats.mMeshCount);
+
+		for (const Slot& slot : mSlots) {
+			if (!slot.mIsLive) {
+				continue;
+			}
+
+			const GeometryRange& range = slot.mRange;
+			const uint64_t vertexBytes = uint64_t(range.mVertexCount) * range.mVertexStride;
+			const uint64_t vertexOffset = vertexRanges.Allocate(vertexBytes, range.mVertexStride);
+			const uint32_t indexSize = GetIndexSize(range.mIndexType);
+			const uint64_t indexBytes = uint64_t(range.mIndexCount) * indexSize;
+			const uint64_t indexOffset = indexRanges.Allocate(indexBytes, indexSize);
+
+			if (vertexOffset == RangeAllocator::INVALID_OFFSET || indexOffset == RangeAllocator::INVALID_OFFSET) {
+				OTTER_CORE_LOG("[VULKAN GEOMETRY POOL] {} meshes do not fit packed into {} vertex bytes and {} index bytes",
+					mStats.mMeshCount, vertexBufferSize, indexBufferSize);
+				return false;
+			}
+
+			VkBufferCopy vertexCopy{};
+			vertexCopy.srcOffset = VkDeviceSize(range.mVertexOffset) * range.mVertexStride;
+			vertexCopy.dstOffset = vertexOffset;
+			vertexCopy.size = vertexBytes;
+			vertexCopies.push_back(vertexCopy);
+
+			VkBufferCopy indexCopy{};
+			indexCopy.srcOffset = VkDeviceSize(range.mFirstIndex) * indexSize;
+			indexCopy.dstOffset = indexOffset;
+			indexCopy.size = indexBytes;
+			indexCopies.push_back(indexCopy);
+		}
+
+		OTTER_CORE_LOG("[VULKAN GEOMETRY POOL] Packing {} meshes into {} vertex bytes and {} index bytes (was {} and {})",
+			mStats.mMeshCount, vertexBufferSize, indexBufferSize, mStats.mVertexBufferSize, mStats.mIndexBufferSize);
+
+		// Copies still recorded against the old buffers must execute before they are read
+		mUploadQueue.Submit();
+
+		VkBuffer vertexBuffer = VK_NULL_HANDLE;
+		VulkanAllocation vertexAllocation;
+		VkBuffer indexBuffer = VK_NULL_HANDLE;
+		VulkanAllocation indexAllocation;
+		CreateBuffers(vertexBufferSize, indexBufferSize, vertexBuffer, vertexAllocation, indexBuffer, indexAllocation);
+
+		// Ranges waiting for in-flight frames belong to the old buffers, they simply are not carried over
+		mPendingFrees.clear();
+		mVertexRanges = std::move(vertexRanges);
+		mIndexRanges = std::move(indexRanges);
+
+		size_t copyIndex = 0;
+		for (Slot& slot : mSlots) {
+			if (!slot.mIsLive) {
+				continue;
+			}
+
+			GeometryRange& range = slot.mRange;
+			range.mVertexOffset = static_cast<int32_t>(vertexCopies[copyIndex].dstOffset / range.mVertexStride);
+			range.mFirstIndex = static_cast<uint32_t>(indexCopies[copyIndex].dstOffset / GetIndexSize(range.mIndexType));
+			++copyIndex;
+		}
+
+		if (!vertexCopies.empty()) {
+			VkCommandBuffer commandBuffer = VulkanUtility::BeginSingleTimeCommandBuffer(mDevice, mCommandPool);
+
+			// Earlier uploads and draws on the queue are done with the old buffers before they are read
+			VkMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+				0,
+				1, &barrier,
+				0, nullptr,
+				0, nullptr);
+
+			vkCmdCopyBuffer(commandBuffer, mVertexBuffer, vertexBuffer, static_cast<uint32_t>(vertexCopies.size()), vertexCopies.data());
+			vkCmdCopyBuffer(commandBuffer, mIndexBuffer, indexBuffer, static_cast<uint32_t>(indexCopies.size()), indexCopies.data());
+
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+				0,
+				1, &barrier,
+				0, nullptr,
+				0, nullptr);
+
+			VulkanUtility::EndSingleTimeCommandBuffer(mDevice, commandBuffer, mCommandPool, mGraphicsQueue);
+		}
+
+		// Frames in flight may still read the old buffers
+		Retire(mVertexBuffer, mVertexAllocation);
+		Retire(mIndexBuffer, mIndexAllocation);
+
+		mVertexBuffer = vertexBuffer;
+		mVertexAllocation = vertexAllocation;
+		mIndexBuffer = indexBuffer;
+		mIndexAllocation = indexAllocation;
+
+		mStats.mVertexBufferSize = vertexBufferSize;
+		mStats.mIndexBufferSize = indexBufferSize;
+		++mStats.mReallocationCount;
+		return true;
+	}
+
+	void VulkanGeometryPool::Retire(VkBuffer& buffer, VulkanAllocation& allocation)
+	{
+		mRetiredBuffers.push_back({ buffer, allocation, mFrame + mFramesInFlight });
+		buffer = VK_NULL_HANDLE;
+		allocation = VulkanAllocation();
+	}
+
+	void VulkanGeometryPool::ReleaseRange(const GeometryRange& range)
+	{
+		mVertexRanges.Free(uint64_t(range.mVertexOffset) * range.mVertexStride, uint64_t(range.mVertexCount) * range.mVertexStride);
+		const uint32_t indexSize = GetIndexSize(range.mIndexType);
+		mIndexRanges.Free(uint64_t(range.mFirstIndex) * indexSize, uint64_t(range.mIndexCount) * indexSize);
+	}
+}
@@ -0,0 +1,154 @@
+#include "OtterPCH.h"
+
+#include <bit>
+
+#include "Rendering/Vulkan/VulkanUtility.h"
+
+#include "Rendering/Vulkan/VulkanIndirectDrawer.h"
+
+namespace OtterEngine {
+	VulkanIndirectDrawer::VulkanIndirectDrawer(VulkanAllocator& allocator, VkPhysicalDevice physicalDevice, uint32_t framesInFlight,
+		uint32_t instanceCapacity) :
+		mAllocator(allocator),
+		mFrames(framesInFlight)
+	{
+		VkPhysicalDeviceFeatures supportedFeatures{};
+		vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+		mSupportsMultiDraw = supportedFeatures.multiDrawIndirect;
+		mSupportsFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		mMaxDrawIndirectCount = mSupportsMultiDraw ? std::max(properties.limits.maxDrawIndirectCount, 1u) : 1u;
+
+		// The vertex shader reads the instance buffer even when nothing is queued, it has to exist from the start
+		for (FrameBuffers& frame : mFrames) {
+			CreateInstanceBuffer(frame, std::max(instanceCapacity, 1u));
+			CreateIndirectBuffer(frame, std::max(instanceCapacity, 1u));
+		}
+
+		if (!mSupportsFirstInstance) {
+			OTTER_CORE_WARNING("[VULKAN INDIRECT DRAWER] drawIndirectFirstInstance not supported, falling back to direct draws");
+		}
+	}
+
+	VulkanIndirectDrawer::~VulkanIndirectDrawer()
+	{
+		for (FrameBuffers& frame : mFrames) {
+			mAllocator.DestroyBuffer(frame.mInstanceBuffer, frame.mInstanceAllocation);
+			mAllocator.DestroyBuffer(frame.mIndirectBuffer, frame.mIndirectAllocation);
+		}
+	}
+
+	void VulkanIndirectDrawer::CreateInstanceBuffer(FrameBuffers& frame, uint32_t capacity)
+	{
+		mAllocator.DestroyBuffer(frame.mInstanceBuffer, frame.mInstanceAllocation);
+
+		VulkanUtility::CreateNewBuffer(mAllocator, capacity * sizeof(glm::mat4),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			frame.mInstanceBuffer, frame.mInstanceAllocation);
+		frame.mInstanceCapacity = capacity;
+	}
+
+	void VulkanIndirectDrawer::CreateIndirectBuffer(FrameBuffers& frame, uint32_t capacity)
+	{
+		mAllocator.DestroyBuffer(frame.mIndirectBuffer, frame.mIndirectAllocation);
+
+		VulkanUtility::CreateNewBuffer(mAllocator, capacity * sizeof(VkDrawIndexedIndirectCommand),
+			VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			frame.mIndirectBuffer, frame.mIndirectAllocation);
+		frame.mCommandCapacity = capacity;
+	}
+
+	bool VulkanIndirectDrawer::Prepare(uint32_t frameIndex, RenderQueue& queue, const VulkanGeometryPool& geometryPool)
+	{
+		FrameBuffers& frame = mFrames[frameIndex];
+
+		// The previous submission of this frame is done, its buffers can be replaced right away
+		bool recreated = false;
+		const uint32_t instanceCount = queue.GetInstanceCount();
+		if (instanceCount > frame.mInstanceCapacity) {
+			CreateInstanceBuffer(frame, std::bit_ceil(instanceCount));
+			recreated = true;
+		}
+
+		auto* instances = static_cast<glm::mat4*>(frame.mInstanceAllocation.pMapped);
+		queue.Build({ instances, frame.mInstanceCapacity });
+
+		std::span<const DrawCommand> commands = queue.GetCommands();
+		if (commands.size() > frame.mCommandCapacity) {
+			CreateIndirectBuffer(frame, std::bit_ceil(static_cast<uint32_t>(commands.size())));
+		}
+
+		mCommands.resize(commands.size());
+		mIndexTypes.resize(commands.size());
+		for (size_t i = 0; i < commands.size(); ++i) {
+			const DrawCommand& command = commands[i];
+			VkDrawIndexedIndirectCommand& indirect = mCommands[i];
+
+			// Meshes removed since they were queued draw nothing, the command keeps its place in the group
+			if (!geometryPool.IsValid(command.mMesh)) {
+				indirect = VkDrawIndexedIndirectCommand{};
+				mIndexTypes[i] = i > 0 ? mIndexTypes[i - 1] : VK_INDEX_TYPE_UINT16;
+				continue;
+			}
+
+			const GeometryRange& range = geometryPool.GetRange(command.mMesh);
+			indirect.indexCount = range.mIndexCount;
+			indirect.instanceCount = command.mInstanceCount;
+			indirect.firstIndex = range.mFirstIndex;
+			indirect.vertexOffset = range.mVertexOffset;
+			indirect.firstInstance = command.mFirstInstance;
+			mIndexTypes[i] = range.mIndexType;
+		}
+
+		if (!mCommands.empty()) {
+			memcpy(frame.mIndirectAllocation.pMapped, mCommands.data(), mCommands.size() * sizeof(VkDrawIndexedIndirectCommand));
+		}
+
+		return recreated;
+	}
+
+	void VulkanIndirectDrawer::Draw(VkCommandBuffer commandBuffer, uint32_t frameIndex, const DrawGroup& group,
+		const VulkanGeometryPool& geometryPool, VkIndexType& boundIndexType) const
+	{
+		const FrameBuffers& frame = mFrames[frameIndex];
+		constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+		const uint32_t groupEnd = group.mFirstCommand + group.mCommandCount;
+		for (uint32_t runBegin = group.mFirstCommand; runBegin < groupEnd;) {
+			const VkIndexType indexType = mIndexTypes[runBegin];
+			uint32_t runEnd = runBegin + 1;
+			while (runEnd < groupEnd && mIndexTypes[runEnd] == indexType) {
+				++runEnd;
+			}
+
+			if (indexType != boundIndexType) {
+				geometryPool.BindIndexBuffer(commandBuffer, indexType);
+				boundIndexType = indexType;
+			}
+
+			if (!mSupportsFirstInstance) {
+				for (uint32_t i = runBegin; i < runEnd; ++i) {
+					const VkDrawIndexedIndirectCommand& command = mCommands[i];
+					if (command.instanceCount == 0) continue;
+
+					vkCmdDrawIndexed(commandBuffer, command.indexCount, command.instanceCount, command.firstIndex,
+						command.vertexOffset, command.firstInstance);
+				}
+			}
+			else {
+				// A single draw per run unless the device caps the draw count
+				for (uint32_t first = runBegin; first < runEnd; first += mMaxDrawIndirectCount) {
+					const uint32_t drawCount = std::min(mMaxDrawIndirectCount, runEnd - first);
+					const VkDeviceSize offset = static_cast<VkDeviceSize>(first) * stride;
+					vkCmdDrawIndexedIndirect(commandBuffer, frame.mIndirectBuffer, offset, drawCount, stride);
+				}
+			}
+
+			runBegin = runEnd;
+		}
+	}
+}
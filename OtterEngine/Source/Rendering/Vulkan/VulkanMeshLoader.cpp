@@ -2,15 +2,19 @@
 
 #include "Utils/PathFormat.h"
 #include "Resources/Mesh.h"
-#include "Rendering/Vertex.h"
 #include "Resources/Resources.h"
-#include "Rendering/Vulkan/VulkanUtility.h"
 
 #include "Rendering/Vulkan/VulkanMeshLoader.h"
 
 namespace OtterEngine {
-	VulkanMeshLoader::VulkanMeshLoader(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue) :
-		mDevice(device), mPhysicalDevice(physicalDevice), mCommandPool(commandPool), mGraphicsQueue(graphicsQueue) {
+	namespace {
+		VkIndexType ToVkIndexType(IndexType indexType) {
+			return indexType == IndexType::UInt16 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+		}
+	}
+
+	VulkanMeshLoader::VulkanMeshLoader(VulkanGeometryPool* geometryPool) :
+		pGeometryPool(geometryPool) {
 	}
 
 	VulkanMeshLoader::~VulkanMeshLoader()
@@ -20,108 +24,81 @@ namespace OtterEngine {
 
 	ResourceHandle<Mesh> VulkanMeshLoader::LoadMesh(const std::filesystem::path& path)
 	{
-		ClearResources();
-
-		mMeshHandle = Resources::Load<Mesh>(path);
+		ResourceHandle<Mesh> meshHandle = Resources::Load<Mesh>(path);
 
-		if (!mMeshHandle || !mMeshHandle->IsValid()) {
+		if (!meshHandle || !meshHandle->IsValid()) {
 			OTTER_CORE_ERROR("[VULKAN MESH LOADER] Failed to load mesh: {}", path);
 			return ResourceHandle<Mesh>();
 		}
 
-		UploadMeshToGPU(*mMeshHandle);
+		auto loaded = mMeshes.find(meshHandle.GetID());
+		if (loaded != mMeshes.end()) {
+			return loaded->second.mMeshHandle;
+		}
 
-		OTTER_CORE_LOG("[VULKAN MESH LOADER] Mesh loaded and uploaded to GPU: {} ({} vertices, {} indices)",
-			mMeshHandle.GetPath(),
-			mMeshHandle->GetVertexCount(),
-			mMeshHandle->GetIndexCount());
+		LoadedMesh mesh;
+		mesh.mMeshHandle = meshHandle;
+		mesh.mVertexFormat = meshHandle->GetVertexFormat();
+		mesh.mLods.assign(meshHandle->GetLods().begin(), meshHandle->GetLods().end());
+		mesh.mBounds = meshHandle->GetBounds();
+
+		// Each chunk is its own geometry, its indices only address its own vertices
+		const uint32_t vertexStride = meshHandle->GetVertexStride();
+		const uint32_t indexStride = meshHandle->GetIndexStride();
+		const VkIndexType indexType = ToVkIndexType(meshHandle->GetIndexType());
+		for (const MeshChunk& chunk : meshHandle->GetChunks()) {
+			GeometryHandle geometry = pGeometryPool->Add(
+				meshHandle->GetVertexData().subspan(size_t(chunk.mFirstVertex) * vertexStride, size_t(chunk.mVertexCount) * vertexStride),
+				vertexStride,
+				meshHandle->GetIndexData().subspan(size_t(chunk.mFirstIndex) * indexStride, size_t(chunk.mIndexCount) * indexStride),
+				indexType);
+			if (geometry == INVALID_GEOMETRY) {
+				OTTER_CORE_ERROR("[VULKAN MESH LOADER] Failed to upload mesh: {}", path);
+				for (GeometryHandle uploaded : mesh.mGeometry) {
+					pGeometryPool->Remove(uploaded);
+				}
+				return ResourceHandle<Mesh>();
+			}
+			mesh.mGeometry.push_back(geometry);
+		}
 
-		return mMeshHandle;
-	}
+		OTTER_CORE_LOG("[VULKAN MESH LOADER] Mesh loaded and uploaded to GPU: {} ({} vertices of {} bytes, {} {}-bit indices in {} chunks, {} levels of detail)",
+			meshHandle.GetPath(),
+			meshHandle->GetVertexCount(), vertexStride,
+			meshHandle->GetIndexCount(), indexStride * 8, mesh.mGeometry.size(), mesh.mLods.size());
 
-	void VulkanMeshLoader::UploadMeshToGPU(const Mesh& mesh)
-	{
-		CreateVertexBuffer(mesh.GetVertices());
-		CreateIndexBuffer(mesh.GetIndices());
+		mMeshes.emplace(meshHandle.GetID(), std::move(mesh));
+		return meshHandle;
 	}
 
-	void VulkanMeshLoader::CreateVertexBuffer(const std::vector<Vertex>& vertices)
+	void VulkanMeshLoader::UnloadMesh(const ResourceHandle<Mesh>& mesh)
 	{
-		VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
-
-		OTTER_CORE_LOG("[VULKAN MESH LOADER] [VERT BUF CREATION] Vertices: {} Buffer size: {} Data ptr: {}", vertices.size(), bufferSize, (void*)vertices.data());
-
-		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingBufferMemory;
-		VulkanUtility::CreateNewBuffer(mDevice, mPhysicalDevice, bufferSize,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			stagingBuffer, stagingBufferMemory);
-
-		void* data;
-		vkMapMemory(mDevice, stagingBufferMemory, 0, bufferSize, 0, &data);
-		memcpy(data, vertices.data(), (size_t)bufferSize);
-		vkUnmapMemory(mDevice, stagingBufferMemory);
-
-		VulkanUtility::CreateNewBuffer(mDevice, mPhysicalDevice, bufferSize,
-			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-			mVertexBuffer, mVertexBufferMemory);
-
-		VulkanUtility::CopyBuffer(mDevice, mGraphicsQueue, mCommandPool,
-			stagingBuffer, mVertexBuffer, bufferSize);
+		auto loaded = mMeshes.find(mesh.GetID());
+		if (loaded == mMeshes.end()) {
+			return;
+		}
 
-		vkDestroyBuffer(mDevice, stagingBuffer, nullptr);
-		vkFreeMemory(mDevice, stagingBufferMemory, nullptr);
+		for (GeometryHandle geometry : loaded->second.mGeometry) {
+			pGeometryPool->Remove(geometry);
+		}
+		mMeshes.erase(loaded);
 	}
 
-	void VulkanMeshLoader::CreateIndexBuffer(const std::vector<uint32_t>& indices)
+	std::span<const GeometryHandle> VulkanMeshLoader::GetGeometry(const ResourceHandle<Mesh>& mesh) const
 	{
-		VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
-
-		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingBufferMemory;
-		VulkanUtility::CreateNewBuffer(mDevice, mPhysicalDevice, bufferSize,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			stagingBuffer, stagingBufferMemory);
-
-		void* data;
-		vkMapMemory(mDevice, stagingBufferMemory, 0, bufferSize, 0, &data);
-		memcpy(data, indices.data(), (size_t)bufferSize);
-		vkUnmapMemory(mDevice, stagingBufferMemory);
-
-		VulkanUtility::CreateNewBuffer(mDevice, mPhysicalDevice, bufferSize,
-			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-			mIndexBuffer, mIndexBufferMemory);
-
-		VulkanUtility::CopyBuffer(mDevice, mGraphicsQueue, mCommandPool,
-			stagingBuffer, mIndexBuffer, bufferSize);
-
-		vkDestroyBuffer(mDevice, stagingBuffer, nullptr);
-		vkFreeMemory(mDevice, stagingBufferMemory, nullptr);
+		auto loaded = mMeshes.find(mesh.GetID());
+		return loaded != mMeshes.end() ? std::span<const GeometryHandle>(loaded->second.mGeometry) : std::span<const GeometryHandle>();
 	}
 
 	void VulkanMeshLoader::ClearResources()
 	{
-		if (mVertexBuffer != VK_NULL_HANDLE) {
-			vkDestroyBuffer(mDevice, mVertexBuffer, nullptr);
-			mVertexBuffer = VK_NULL_HANDLE;
-		}
-		if (mVertexBufferMemory != VK_NULL_HANDLE) {
-			vkFreeMemory(mDevice, mVertexBufferMemory, nullptr);
-			mVertexBufferMemory = VK_NULL_HANDLE;
-		}
-		if (mIndexBuffer != VK_NULL_HANDLE) {
-			vkDestroyBuffer(mDevice, mIndexBuffer, nullptr);
-			mIndexBuffer = VK_NULL_HANDLE;
+		if (pGeometryPool) {
+			for (auto& [id, mesh] : mMeshes) {
+				for (GeometryHandle geometry : mesh.mGeometry) {
+					pGeometryPool->Remove(geometry);
+				}
+			}
 		}
-		if (mIndexBufferMemory != VK_NULL_HANDLE) {
-			vkFreeMemory(mDevice, mIndexBufferMemory, nullptr);
-			mIndexBufferMemory = VK_NULL_HANDLE;
-		}
-
-		mMeshHandle = ResourceHandle<Mesh>();
+		mMeshes.clear();
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,108 @@
+#include "OtterPCH.h"
+
+#include "Core/JobSystem.h"
+
+#include "Rendering/Vulkan/VulkanParallelRecorder.h"
+
+namespace OtterEngine {
+	VulkanParallelRecorder::VulkanParallelRecorder(VkDevice device, uint32_t graphicsFamily, uint32_t framesInFlight, uint32_t sliceCount) :
+		mDevice(device),
+		mSliceCount(sliceCount != 0 ? sliceCount : JobSystem::GetWorkerCount() + 1)
+	{
+		mFrames.resize(framesInFlight);
+
+		for (auto& slices : mFrames) {
+			slices.resize(mSliceCount);
+
+			for (Slice& slice : slices) {
+				VkCommandPoolCreateInfo poolInfo{};
+				poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+				// Reset as a whole every frame, never per command buffer
+				poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+				poolInfo.queueFamilyIndex = graphicsFamily;
+
+				if (vkCreateCommandPool(mDevice, &poolInfo, nullptr, &slice.mPool) != VK_SUCCESS) {
+					OTTER_CORE_CRITICAL("[VULKAN PARALLEL RECORDER] Failed to create slice command pool!");
+					return;
+				}
+
+				VkCommandBufferAllocateInfo allocInfo{};
+				allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+				allocInfo.commandPool = slice.mPool;
+				allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+				allocInfo.commandBufferCount = 1;
+
+				if (vkAllocateCommandBuffers(mDevice, &allocInfo, &slice.mCommandBuffer) != VK_SUCCESS) {
+					OTTER_CORE_CRITICAL("[VULKAN PARALLEL RECORDER] Failed to allocate secondary command buffer!");
+					return;
+				}
+			}
+		}
+
+		mRecorded.reserve(mSliceCount);
+
+		OTTER_CORE_LOG("[VULKAN PARALLEL RECORDER] Recording up to {} slices concurrently", mSliceCount);
+	}
+
+	VulkanParallelRecorder::~VulkanParallelRecorder()
+	{
+		for (auto& slices : mFrames) {
+			for (Slice& slice : slices) {
+				// Destroying the pool frees its command buffer
+				if (slice.mPool != VK_NULL_HANDLE) {
+					vkDestroyCommandPool(mDevice, slice.mPool, nullptr);
+				}
+			}
+		}
+	}
+
+	std::span<const VkCommandBuffer> VulkanParallelRecorder::Record(uint32_t frameIndex, VkRenderPass renderPass, uint32_t subpass,
+		VkFramebuffer framebuffer, size_t itemCount, const SliceRecorder& recordSlice, size_t minItemsPerSlice)
+	{
+		mRecorded.clear();
+		if (itemCount == 0) return mRecorded;
+
+		std::vector<Slice>& slices = mFrames[frameIndex];
+
+		const size_t itemsPerSliceFloor = std::max<size_t>(minItemsPerSlice, 1);
+		const size_t maxSlices = std::min<size_t>(mSliceCount, (itemCount + itemsPerSliceFloor - 1) / itemsPerSliceFloor);
+		const size_t itemsPerSlice = (itemCount + maxSlices - 1) / maxSlices;
+		// Rounding up may leave the last slices empty, they are not recorded
+		const size_t sliceCount = (itemCount + itemsPerSlice - 1) / itemsPerSlice;
+
+		JobSystem::ParallelFor(sliceCount, [&](size_t sliceIndex) {
+			const Slice& slice = slices[sliceIndex];
+			const size_t begin = sliceIndex * itemsPerSlice;
+			const size_t end = std::min(itemCount, begin + itemsPerSlice);
+
+			vkResetCommandPool(mDevice, slice.mPool, 0);
+
+			VkCommandBufferInheritanceInfo inheritanceInfo{};
+			inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+			inheritanceInfo.renderPass = renderPass;
+			inheritanceInfo.subpass = subpass;
+			inheritanceInfo.framebuffer = framebuffer;
+
+			VkCommandBufferBeginInfo beginInfo{};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+			if (vkBeginCommandBuffer(slice.mCommandBuffer, &beginInfo) != VK_SUCCESS) {
+				OTTER_CORE_CRITICAL("[VULKAN PARALLEL RECORDER] Failed to begin secondary command buffer!");
+				return;
+			}
+
+			recordSlice(slice.mCommandBuffer, begin, end);
+
+			if (vkEndCommandBuffer(slice.mCommandBuffer) != VK_SUCCESS) {
+				OTTER_CORE_CRITICAL("[VULKAN PARALLEL RECORDER] Failed to record secondary command buffer!");
+			}
+		}, mSliceCount);
+
+		for (size_t i = 0; i < sliceCount; ++i) {
+			mRecorded.push_back(slices[i].mCommandBuffer);
+		}
+		return mRecorded;
+	}
+}
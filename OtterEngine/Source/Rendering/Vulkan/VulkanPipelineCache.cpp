@@ -0,0 +1,112 @@
+#include "OtterPCH.h"
+
+#include "Utils/Hash.h"
+#include "Utils/OtterIO.h"
+#include "Utils/PathFormat.h"
+
+#include "Rendering/Vulkan/VulkanPipelineCache.h"
+
+namespace OtterEngine {
+	VulkanPipelineCache::VulkanPipelineCache(VkDevice device, VkPhysicalDevice physicalDevice, std::filesystem::path path) :
+		mDevice(device),
+		mPath(std::move(path))
+	{
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+		mExpectedHeader.mVendorID = properties.vendorID;
+		mExpectedHeader.mDeviceID = properties.deviceID;
+		mExpectedHeader.mDriverVersion = properties.driverVersion;
+		memcpy(mExpectedHeader.mPipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+		const char* initialData = nullptr;
+		size_t initialDataSize = 0;
+
+		auto file = OtterIO::TryReadFile(mPath);
+		if (file && file->size() >= sizeof(FileHeader)) {
+			FileHeader header;
+			memcpy(&header, file->data(), sizeof(FileHeader));
+
+			const char* data = file->data() + sizeof(FileHeader);
+			const size_t dataSize = file->size() - sizeof(FileHeader);
+
+			if (header.mMagic != FILE_MAGIC || header.mVersion != FILE_VERSION) {
+				OTTER_CORE_WARNING("[VULKAN PIPELINE CACHE] '{}' is not a pipeline cache of this version, rebuilding it", mPath);
+			}
+			else if (header.mVendorID != mExpectedHeader.mVendorID || header.mDeviceID != mExpectedHeader.mDeviceID
+				|| header.mDriverVersion != mExpectedHeader.mDriverVersion
+				|| memcmp(header.mPipelineCacheUUID, mExpectedHeader.mPipelineCacheUUID, VK_UUID_SIZE) != 0) {
+				OTTER_CORE_WARNING("[VULKAN PIPELINE CACHE] '{}' was built for another device or driver, rebuilding it", mPath);
+			}
+			else if (header.mDataSize != dataSize || header.mDataHash != HashBytes(data, dataSize)) {
+				OTTER_CORE_WARNING("[VULKAN PIPELINE CACHE] '{}' is corrupted, rebuilding it", mPath);
+			}
+			else {
+				initialData = data;
+				initialDataSize = dataSize;
+			}
+		}
+
+		VkPipelineCacheCreateInfo cacheInfo{};
+		cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		cacheInfo.initialDataSize = initialDataSize;
+		cacheInfo.pInitialData = initialData;
+
+		VkResult result = vkCreatePipelineCache(mDevice, &cacheInfo, nullptr, &mCache);
+		if (result != VK_SUCCESS && initialData) {
+			// The driver may still refuse data that passed our checks, start over then
+			OTTER_CORE_WARNING("[VULKAN PIPELINE CACHE] Driver rejected '{}', rebuilding it", mPath);
+			cacheInfo.initialDataSize = 0;
+			cacheInfo.pInitialData = nullptr;
+			initialData = nullptr;
+			result = vkCreatePipelineCache(mDevice, &cacheInfo, nullptr, &mCache);
+		}
+
+		if (result != VK_SUCCESS) {
+			OTTER_CORE_ERROR("[VULKAN PIPELINE CACHE] Failed to create pipeline cache, pipelines will be built uncached");
+			mCache = VK_NULL_HANDLE;
+			return;
+		}
+
+		mWasLoaded = initialData != nullptr;
+		if (mWasLoaded) {
+			OTTER_CORE_LOG("[VULKAN PIPELINE CACHE] Loaded {} bytes from '{}'", initialDataSize, mPath);
+		}
+	}
+
+	VulkanPipelineCache::~VulkanPipelineCache()
+	{
+		if (mCache != VK_NULL_HANDLE) {
+			vkDestroyPipelineCache(mDevice, mCache, nullptr);
+		}
+	}
+
+	bool VulkanPipelineCache::Save() const
+	{
+		if (mCache == VK_NULL_HANDLE) return false;
+
+		size_t dataSize = 0;
+		if (vkGetPipelineCacheData(mDevice, mCache, &dataSize, nullptr) != VK_SUCCESS) {
+			OTTER_CORE_ERROR("[VULKAN PIPELINE CACHE] Failed to query pipeline cache size");
+			return false;
+		}
+
+		std::vector<char> file(sizeof(FileHeader) + dataSize);
+		char* data = file.data() + sizeof(FileHeader);
+		if (vkGetPipelineCacheData(mDevice, mCache, &dataSize, data) != VK_SUCCESS) {
+			OTTER_CORE_ERROR("[VULKAN PIPELINE CACHE] Failed to read pipeline cache data");
+			return false;
+		}
+		file.resize(sizeof(FileHeader) + dataSize);
+
+		FileHeader header = mExpectedHeader;
+		header.mDataSize = dataSize;
+		header.mDataHash = HashBytes(data, dataSize);
+		memcpy(file.data(), &header, sizeof(FileHeader));
+
+		if (!OtterIO::WriteFileAtomic(mPath, file)) return false;
+
+		OTTER_CORE_LOG("[VULKAN PIPELINE CACHE] Saved {} bytes to '{}'", dataSize, mPath);
+		return true;
+	}
+}
@@ -0,0 +1,374 @@
+#include "OtterPCH.h"
+
+#include <thread>
+
+#include "Core/JobSystem.h"
+#include "Utils/Hash.h"
+#include "Rendering/Vulkan/VulkanUtility.h"
+
+#include "Rendering/Vulkan/VulkanPipelineStateCache.h"
+
+namespace OtterEngine {
+	namespace {
+		VkShaderModule CreateShaderModule(VkDevice device, std::span<const uint32_t> spirv) {
+			VkShaderModuleCreateInfo createInfo{};
+			createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+			createInfo.codeSize = spirv.size_bytes();
+			createInfo.pCode = spirv.data();
+
+			VkShaderModule shaderModule = VK_NULL_HANDLE;
+			VkResult res = vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule);
+			if (res != VK_SUCCESS) {
+				OTTER_CORE_ERROR("[VULKAN PIPELINE STATES] Failed to create shader module! VkResult = {}",
+					std::string(VulkanUtility::VkResultToString(res)));
+				return VK_NULL_HANDLE;
+			}
+			return shaderModule;
+		}
+
+		VkPipelineColorBlendAttachmentState MakeBlendState(BlendMode mode) {
+			VkPipelineColorBlendAttachmentState blend{};
+			blend.colorWriteMask =
+				VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+				VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+			switch (mode) {
+			case BlendMode::Opaque:
+				blend.blendEnable = VK_FALSE;
+				break;
+			case BlendMode::Alpha:
+				blend.blendEnable = VK_TRUE;
+				blend.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+				blend.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+				blend.colorBlendOp = VK_BLEND_OP_ADD;
+				blend.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+				blend.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+				blend.alphaBlendOp = VK_BLEND_OP_ADD;
+				break;
+			case BlendMode::Additive:
+				blend.blendEnable = VK_TRUE;
+				blend.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+				blend.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+				blend.colorBlendOp = VK_BLEND_OP_ADD;
+				blend.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+				blend.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+				blend.alphaBlendOp = VK_BLEND_OP_ADD;
+				break;
+			}
+			return blend;
+		}
+
+		// Runs on the render thread or on a worker, reads nothing but its arguments
+		VkPipeline CreatePipeline(VkDevice device, VkPipelineCache pipelineCache, VkRenderPass renderPass, const PipelineStateDesc& desc,
+			std::span<const uint32_t> vertexCode, std::span<const uint32_t> fragmentCode)
+		{
+			if (vertexCode.empty() || fragmentCode.empty()) {
+				OTTER_CORE_ERROR("[VULKAN PIPELINE STATES] Pipeline shaders did not compile");
+				return VK_NULL_HANDLE;
+			}
+
+			VkShaderModule vertexModule = CreateShaderModule(device, vertexCode);
+			VkShaderModule fragmentModule = CreateShaderModule(device, fragmentCode);
+
+			// Constants are 4 bytes each, laid out back to back
+			std::array<VkSpecializationMapEntry, PipelineStateDesc::MAX_SPECIALIZATION_CONSTANTS> specializationEntries{};
+			for (uint32_t i = 0; i < desc.mSpecializationCount; ++i) {
+				specializationEntries[i].constantID = i;
+				specializationEntries[i].offset = i * sizeof(uint32_t);
+				specializationEntries[i].size = sizeof(uint32_t);
+			}
+
+			VkSpecializationInfo specialization{};
+			specialization.mapEntryCount = desc.mSpecializationCount;
+			specialization.pMapEntries = specializationEntries.data();
+			specialization.dataSize = desc.mSpecializationCount * sizeof(uint32_t);
+			specialization.pData = desc.mSpecialization;
+
+			std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages{};
+			shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+			shaderStages[0].module = vertexModule;
+			shaderStages[0].pName = "main";
+			shaderStages[0].pSpecializationInfo = &specialization;
+
+			shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+			shaderStages[1].module = fragmentModule;
+			shaderStages[1].pName = "main";
+			shaderStages[1].pSpecializationInfo = &specialization;
+
+			// Vertex input
+			VkVertexInputBindingDescription bindingDescription{};
+			bindingDescription.binding = 0;
+			bindingDescription.stride = desc.mVertexStride;
+			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+			std::array<VkVertexInputAttributeDescription, PipelineStateDesc::MAX_VERTEX_ATTRIBUTES> attributeDescriptions{};
+			for (uint32_t i = 0; i < desc.mVertexAttributeCount; ++i) {
+				attributeDescriptions[i].binding = 0;
+				attributeDescriptions[i].location = desc.mVertexAttributes[i].mLocation;
+				attributeDescriptions[i].format = desc.mVertexAttributes[i].mFormat;
+				attributeDescriptions[i].offset = desc.mVertexAttributes[i].mOffset;
+			}
+
+			VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+			vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+			vertexInputInfo.vertexBindingDescriptionCount = 1;
+			vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+			vertexInputInfo.vertexAttributeDescriptionCount = desc.mVertexAttributeCount;
+			vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+			// Input Assembly
+			VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+			inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+			inputAssembly.topology = static_cast<VkPrimitiveTopology>(desc.mTopology);
+			inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+			VkPipelineViewportStateCreateInfo viewportState{};
+			viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+			viewportState.viewportCount = 1;
+			viewportState.scissorCount = 1;
+
+			// Rasterizer
+			VkPipelineRasterizationStateCreateInfo rasterizer{};
+			rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+			rasterizer.depthClampEnable = VK_FALSE;
+			rasterizer.rasterizerDiscardEnable = VK_FALSE;
+			rasterizer.polygonMode = static_cast<VkPolygonMode>(desc.mPolygonMode);
+			rasterizer.lineWidth = 1.0f;
+			rasterizer.cullMode = desc.mCullMode;
+			rasterizer.frontFace = static_cast<VkFrontFace>(desc.mFrontFace);
+			rasterizer.depthBiasEnable = VK_FALSE;
+
+			// Multisampling
+			VkPipelineMultisampleStateCreateInfo multisampling{};
+			multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+			multisampling.sampleShadingEnable = VK_FALSE;
+			multisampling.rasterizationSamples = static_cast<VkSampleCountFlagBits>(desc.mSampleCount);
+
+			// Color blending
+			VkPipelineColorBlendAttachmentState colorBlendAttachment = MakeBlendState(desc.mBlendMode);
+
+			VkPipelineColorBlendStateCreateInfo colorBlending{};
+			colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+			colorBlending.logicOpEnable = VK_FALSE;
+			colorBlending.logicOp = VK_LOGIC_OP_COPY;
+			colorBlending.attachmentCount = 1;
+			colorBlending.pAttachments = &colorBlendAttachment;
+
+			// Depth Stencil
+			VkPipelineDepthStencilStateCreateInfo depthStencil{};
+			depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+			depthStencil.depthTestEnable = desc.mDepthTest ? VK_TRUE : VK_FALSE;
+			depthStencil.depthWriteEnable = desc.mDepthWrite ? VK_TRUE : VK_FALSE;
+			depthStencil.depthCompareOp = static_cast<VkCompareOp>(desc.mDepthCompareOp);
+			depthStencil.depthBoundsTestEnable = VK_FALSE;
+			depthStencil.minDepthBounds = 0.0f;
+			depthStencil.maxDepthBounds = 1.0f;
+			depthStencil.stencilTestEnable = VK_FALSE;
+
+			// Dynamic viewport and scissor
+			std::array<VkDynamicState, 2> dynamicStates = {
+				VK_DYNAMIC_STATE_VIEWPORT,
+				VK_DYNAMIC_STATE_SCISSOR
+			};
+
+			VkPipelineDynamicStateCreateInfo dynamicState{};
+			dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+			dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+			dynamicState.pDynamicStates = dynamicStates.data();
+
+			// Pipeline
+			VkGraphicsPipelineCreateInfo pipelineInfo{};
+			pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+			pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
+			pipelineInfo.pStages = shaderStages.data();
+			pipelineInfo.pVertexInputState = &vertexInputInfo;
+			pipelineInfo.pInputAssemblyState = &inputAssembly;
+			pipelineInfo.pViewportState = &viewportState;
+			pipelineInfo.pRasterizationState = &rasterizer;
+			pipelineInfo.pMultisampleState = &multisampling;
+			pipelineInfo.pColorBlendState = &colorBlending;
+			pipelineInfo.pDynamicState = &dynamicState;
+			pipelineInfo.pDepthStencilState = &depthStencil;
+			pipelineInfo.layout = desc.mLayout;
+			pipelineInfo.renderPass = renderPass;
+			pipelineInfo.subpass = desc.mSubpass;
+			pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+			VkPipeline pipeline = VK_NULL_HANDLE;
+			if (vertexModule != VK_NULL_HANDLE && fragmentModule != VK_NULL_HANDLE) {
+				// VkPipelineCache is internally synchronized, workers share it
+				VkResult res = vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+				if (res != VK_SUCCESS) {
+					OTTER_CORE_ERROR("[VULKAN PIPELINE STATES] Failed to create graphics pipeline! VkResult = {}",
+						std::string(VulkanUtility::VkResultToString(res)));
+					pipeline = VK_NULL_HANDLE;
+				}
+			}
+
+			// Clean up shader modules
+			if (fragmentModule != VK_NULL_HANDLE) vkDestroyShaderModule(device, fragmentModule, nullptr);
+			if (vertexModule != VK_NULL_HANDLE) vkDestroyShaderModule(device, vertexModule, nullptr);
+
+			return pipeline;
+		}
+	}
+
+	VulkanPipelineStateCache::VulkanPipelineStateCache(VkDevice device, VkPipelineCache pipelineCache, const ShaderLibrary& shaders) :
+		mDevice(device),
+		mPipelineCache(pipelineCache),
+		mShaders(shaders)
+	{
+	}
+
+	VulkanPipelineStateCache::~VulkanPipelineStateCache()
+	{
+		WaitForPending();
+
+		// Creations that finished since the last Update, the last worker may still hold the lock
+		std::scoped_lock lock(mCompletions->mMutex);
+		for (const Creation& creation : mCompletions->mCreations) {
+			if (creation.mPipeline != VK_NULL_HANDLE) vkDestroyPipeline(mDevice, creation.mPipeline, nullptr);
+		}
+
+		for (const Entry& entry : mEntries) {
+			if (entry.mPipeline != VK_NULL_HANDLE) vkDestroyPipeline(mDevice, entry.mPipeline, nullptr);
+		}
+	}
+
+	uint64_t VulkanPipelineStateCache::MakeRenderPassKey(VkFormat colorFormat, VkFormat depthFormat, VkSampleCountFlagBits samples)
+	{
+		uint64_t key = HashValue(colorFormat);
+		key = HashValue(depthFormat, key);
+		return HashValue(samples, key);
+	}
+
+	PipelineStateHandle VulkanPipelineStateCache::GetHandle(const PipelineStateDesc& desc)
+	{
+		const uint64_t key = HashValue(desc);
+		if (auto it = mHandlesByKey.find(key); it != mHandlesByKey.end()) {
+			OTTER_ASSERT(memcmp(&mEntries[it->second].mDesc, &desc, sizeof(desc)) == 0,
+				"[VULKAN PIPELINE STATES] Two pipeline states hash to {:016x}", key);
+			return it->second;
+		}
+
+		Entry& entry = mEntries.emplace_back();
+		entry.mDesc = desc;
+
+		const PipelineStateHandle handle = static_cast<PipelineStateHandle>(mEntries.size() - 1);
+		mHandlesByKey.emplace(key, handle);
+		return handle;
+	}
+
+	VkPipeline VulkanPipelineStateCache::Acquire(PipelineStateHandle handle, bool async)
+	{
+		OTTER_ASSERT(handle < mEntries.size(), "[VULKAN PIPELINE STATES] Invalid pipeline state handle {}", handle);
+
+		Entry& entry = mEntries[handle];
+		if (entry.mPipeline != VK_NULL_HANDLE || entry.mIsPending || entry.mHasFailed) {
+			return entry.mPipeline;
+		}
+
+		if (entry.mDesc.mRenderPassKey != mRenderPassKey) {
+			OTTER_CORE_ERROR("[VULKAN PIPELINE STATES] Pipeline state {} targets a render pass that is not the current one", handle);
+			entry.mHasFailed = true;
+			return VK_NULL_HANDLE;
+		}
+
+		std::span<const uint32_t> vertexCode = mShaders.GetSpirv(entry.mDesc.mVertexShader);
+		std::span<const uint32_t> fragmentCode = mShaders.GetSpirv(entry.mDesc.mFragmentShader);
+
+		if (!async) {
+			auto startTime = std::chrono::high_resolution_clock::now();
+
+			entry.mPipeline = CreatePipeline(mDevice, mPipelineCache, mRenderPass, entry.mDesc, vertexCode, fragmentCode);
+			entry.mHasFailed = entry.mPipeline == VK_NULL_HANDLE;
+
+			float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+			OTTER_CORE_LOG("[VULKAN PIPELINE STATES] Pipeline {} created in {:.2f} ms", handle, elapsedMs);
+			return entry.mPipeline;
+		}
+
+		entry.mIsPending = true;
+		++mCompletions->mPendingCount;
+
+		// The worker gets its own copy of everything, shaders may be swapped while it runs
+		JobSystem::Submit([device = mDevice, pipelineCache = mPipelineCache, renderPass = mRenderPass, desc = entry.mDesc,
+			vertex = std::vector<uint32_t>(vertexCode.begin(), vertexCode.end()),
+			fragment = std::vector<uint32_t>(fragmentCode.begin(), fragmentCode.end()),
+			handle, generation = mGeneration, completions = mCompletions]() {
+			auto startTime = std::chrono::high_resolution_clock::now();
+
+			VkPipeline pipeline = CreatePipeline(device, pipelineCache, renderPass, desc, vertex, fragment);
+
+			float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+			OTTER_CORE_LOG("[VULKAN PIPELINE STATES] Pipeline {} created on a worker in {:.2f} ms", handle, elapsedMs);
+
+			std::scoped_lock lock(completions->mMutex);
+			completions->mCreations.push_back({ handle, generation, pipeline });
+			--completions->mPendingCount;
+		});
+
+		return VK_NULL_HANDLE;
+	}
+
+	VkPipeline VulkanPipelineStateCache::Get(PipelineStateHandle handle) const noexcept
+	{
+		return handle < mEntries.size() ? mEntries[handle].mPipeline : VK_NULL_HANDLE;
+	}
+
+	void VulkanPipelineStateCache::Update()
+	{
+		std::vector<Creation> creations;
+		{
+			std::scoped_lock lock(mCompletions->mMutex);
+			creations.swap(mCompletions->mCreations);
+		}
+
+		for (const Creation& creation : creations) {
+			// Started before an invalidation, its shaders are outdated
+			if (creation.mGeneration != mGeneration) {
+				if (creation.mPipeline != VK_NULL_HANDLE) vkDestroyPipeline(mDevice, creation.mPipeline, nullptr);
+				continue;
+			}
+
+			Entry& entry = mEntries[creation.mHandle];
+			entry.mPipeline = creation.mPipeline;
+			entry.mIsPending = false;
+			entry.mHasFailed = creation.mPipeline == VK_NULL_HANDLE;
+		}
+	}
+
+	void VulkanPipelineStateCache::SetRenderPass(VkRenderPass renderPass, uint64_t renderPassKey)
+	{
+		mRenderPass = renderPass;
+
+		if (renderPassKey != mRenderPassKey) {
+			mRenderPassKey = renderPassKey;
+			// States that failed against the previous pass may match this one
+			for (Entry& entry : mEntries) entry.mHasFailed = false;
+		}
+	}
+
+	void VulkanPipelineStateCache::WaitForPending() const
+	{
+		while (mCompletions->mPendingCount.load() != 0) {
+			std::this_thread::yield();
+		}
+	}
+
+	void VulkanPipelineStateCache::InvalidateAll()
+	{
+		++mGeneration;
+
+		for (Entry& entry : mEntries) {
+			if (entry.mPipeline != VK_NULL_HANDLE) {
+				vkDestroyPipeline(mDevice, entry.mPipeline, nullptr);
+			}
+			entry.mPipeline = VK_NULL_HANDLE;
+			entry.mIsPending = false;
+			entry.mHasFailed = false;
+		}
+	}
+}
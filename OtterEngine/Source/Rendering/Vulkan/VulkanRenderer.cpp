@@ -7,9 +7,14 @@
 
 #include <span>
 
-#include "Utils/OtterIO.h"
 #include "Rendering/Vulkan/VulkanUtility.h"
 #include "Rendering/Vulkan/VulkanMeshLoader.h" 
+#include "Rendering/Vulkan/VulkanStagingRing.h"
+#include "Rendering/Vulkan/VulkanUploadQueue.h"
+#include "Rendering/Vulkan/VulkanGeometryPool.h"
+#include "Rendering/Vulkan/VulkanIndirectDrawer.h"
+#include "Rendering/Vulkan/VulkanPipelineCache.h"
+#include "Rendering/Vulkan/VulkanParallelRecorder.h"
 #include "Rendering/Vulkan/VulkanTextureLoader.h"
 
 #include "Rendering/Vulkan/VulkanRenderer.h"
@@ -28,8 +33,6 @@ namespace OtterEngine {
 		mPhysicalDevice(VK_NULL_HANDLE),
 		mPipelineLayout(VK_NULL_HANDLE),
 		mDepthImageView(VK_NULL_HANDLE),
-		mDepthImageMemory(VK_NULL_HANDLE),
-		mGraphicsPipeline(VK_NULL_HANDLE),
 		mDescriptorSetLayout(VK_NULL_HANDLE),
 		mSwapchainImageFormat(VK_FORMAT_UNDEFINED),
 		mSwapchainExtent{} {
@@ -44,31 +47,61 @@ namespace OtterEngine {
 	/// IRenderer Init() override
 	/// </summary>
 	void VulkanRenderer::Init() {
+		// Decode the scene assets in the background while the device is being set up. The requests only
+		// warm the cache and are dropped: the blocking loads below join the loads or find their results.
+		Resources::LoadAsync<Texture>("viking_room.png");
+		Resources::LoadAsync<Mesh>("viking_room.obj");
+
 		CreateVulkanInstance();
 
 		SetupDebugMessenger();
 		CreateSurface();
 		PickPhysicalDevice();
 		CreateLogicalDevice();
+		CreateAllocator();
+		CreatePipelineCache();
 		CreateSwapchain();
 		CreateImageViews();
 		CreateRenderPass();
-		CreateDescriptorSetLayout();
-		CreateGraphicsPipeline();
 		CreateCommandPool();
-		CreateDepthResources();
-		CreateFramebuffers();
 
+		CreateStagingRing();
+		CreateUploadQueue();
+		CreateGeometryPool();
+
+		// The pipeline layout takes the texture array layout and its length
 		CreateTextureLoader();
-		mTextureLoader->LoadTexture("viking_room.png");
+		mSceneTexture = mTextureLoader->LoadTexture("viking_room.png");
+
+		CreateDescriptorSetLayout();
+		CreatePipelineLayout();
+		LoadShaders();
+		CreatePipelineStates();
+		CreateDepthResources();
+		CreateFramebuffers();
 
 		CreateMeshLoader();
 		mMeshLoader->LoadMesh("viking_room.obj");
 
+		// Both uploads go out in a single batch, the first frame is ordered after it
+		mUploadQueue->Submit();
+
+		// Unlit, only the scene texture is sampled
+		MaterialDesc sceneMaterial;
+		sceneMaterial.mTexture = mSceneTexture;
+		mSceneMaterial = CreateMaterial(sceneMaterial);
+
+		// The scene is drawn from the first frame, its pipelines are not left to a worker
+		for (const auto& [id, mesh] : mMeshLoader->GetMeshes()) {
+			mPipelineStates->Acquire(GetMaterialPipeline(mSceneMaterial, mesh.mVertexFormat), false);
+		}
+
 		CreateUniformBuffers();
+		CreateIndirectDrawer();
 		CreateDescriptorPool();
 		CreateDescriptorSets();
 		CreateCommandBuffers();
+		CreateParallelRecorder();
 		CreateSyncObjects();
 
 		OTTER_CORE_LOG("[VULKAN RENDERER] Otter Vulkan Renderer initialized!");
@@ -85,12 +118,30 @@ namespace OtterEngine {
 		}
 		CleanupSwapchainResources();
 
-		mTextureLoader->ClearResources();
+		// Waits for the pipelines still being created, they go through the pipeline cache
+		mPipelineStates.reset(); // PIPELINE STATES RESET
+
+		// Pipelines compiled during this run are kept for the next launch
+		if (mPipelineCache) {
+			mPipelineCache->Save();
+		}
+		mPipelineCache.reset(); // PIPELINE CACHE RESET
+		mShaderVariants.reset(); // SHADER VARIANTS RESET
+		mShaderLibrary.reset(); // SHADER LIBRARY RESET
+
+		mMaterialPipelines.clear(); // MATERIAL PIPELINES RESET
+		mMaterials.clear(); // MATERIALS RESET
+		mSceneTexture = ResourceHandle<Texture>(); // SCENE TEXTURE RESET
+		mTextureLoader.reset(); // TEXTURE LOADER RESET
 
 		if (mDescriptorPool != VK_NULL_HANDLE) {
 			vkDestroyDescriptorPool(mDevice, mDescriptorPool, nullptr);
 			mDescriptorPool = VK_NULL_HANDLE; // DESCRIPTOR POOL RESET
 		}
+		if (mPipelineLayout != VK_NULL_HANDLE) {
+			vkDestroyPipelineLayout(mDevice, mPipelineLayout, nullptr);
+			mPipelineLayout = VK_NULL_HANDLE; // PIPELINE LAYOUT RESET
+		}
 		if (mDescriptorSetLayout != VK_NULL_HANDLE) {
 			vkDestroyDescriptorSetLayout(mDevice, mDescriptorSetLayout, nullptr);
 			mDescriptorSetLayout = VK_NULL_HANDLE; // DESCRIPTOR SET LAYOUT RESET
@@ -98,18 +149,19 @@ namespace OtterEngine {
 
 		// Buffers cleanup
 
-		for (uint32_t i = 0; i < MAX_ONGOING_FRAMES; ++i) {
-			if (mUniformBuffers[i] != VK_NULL_HANDLE) {
-				vkDestroyBuffer(mDevice, mUniformBuffers[i], nullptr);
-				mUniformBuffers[i] = VK_NULL_HANDLE; // UNIFORM BUFFER RESET
-			}
-			if (mUniformBuffersMemory[i] != VK_NULL_HANDLE) {
-				vkFreeMemory(mDevice, mUniformBuffersMemory[i], nullptr);
-				mUniformBuffersMemory[i] = VK_NULL_HANDLE; // UNIFORM BUFFER MEMORY RESET
-			}
+		for (uint32_t i = 0; i < mUniformBuffers.size(); ++i) {
+			mAllocator->DestroyBuffer(mUniformBuffers[i], mUniformBuffersAllocations[i]); // UNIFORM BUFFER RESET
 		}
 
-		mMeshLoader->ClearResources();
+		mParallelRecorder.reset(); // PARALLEL RECORDER RESET
+		mIndirectDrawer.reset(); // INDIRECT DRAWER RESET
+		mRenderQueue.Clear(); // RENDER QUEUE RESET
+		mMeshLoader.reset(); // MESH LOADER RESET
+		mGeometryPool.reset(); // GEOMETRY POOL RESET
+
+		// The upload queue retires its batches into the staging ring, it has to go first
+		mUploadQueue.reset(); // UPLOAD QUEUE RESET
+		mStagingRing.reset(); // STAGING RING RESET
 
 		// Semaphores and fences cleanup
 
@@ -136,6 +188,9 @@ namespace OtterEngine {
 			mCommandPool = VK_NULL_HANDLE; // COMMAND POOL RESET
 		}
 
+		// Every resource has given its memory back by now, the allocator reports any leak
+		mAllocator.reset(); // ALLOCATOR RESET
+
 		if (mDevice != VK_NULL_HANDLE) {
 			vkDestroyDevice(mDevice, nullptr);
 			mDevice = VK_NULL_HANDLE; // DEVICE RESET
@@ -168,6 +223,21 @@ namespace OtterEngine {
 
 		vkWaitForFences(mDevice, 1, &mActiveFences[mCurrentFrame], VK_TRUE, UINT64_MAX);
 
+		// The frame that last used this slot is done, geometry it could read can be recycled
+		mGeometryPool->Update();
+
+		// Uploads recorded since the last frame are submitted ahead of it
+		mUploadQueue->Submit();
+		mUploadQueue->Poll();
+
+		// Textures whose upload completed get their slot written in this frame's set
+		mTextureLoader->BeginFrame(mCurrentFrame);
+
+		if (mShaderLibrary->Update()) {
+			ReloadPipelines();
+		}
+		mPipelineStates->Update();
+
 		uint32_t imageIndex = 0;
 		VkResult nextImage = vkAcquireNextImageKHR(
 			mDevice,
@@ -197,10 +267,17 @@ namespace OtterEngine {
 
 		UpdateUniformBuffer(mCurrentFrame);
 
+		// Transforms and indirect commands go in this frame's buffers, free since its fence was waited on
+		SubmitScene();
+		if (mIndirectDrawer->Prepare(mCurrentFrame, mRenderQueue, *mGeometryPool)) {
+			WriteInstanceDescriptor(mCurrentFrame);
+		}
+
 		vkResetFences(mDevice, 1, &mActiveFences[mCurrentFrame]);
 
 		vkResetCommandBuffer(mCommandBuffers[imageIndex], 0);
 		RecordCommandBuffer(mCommandBuffers[imageIndex], imageIndex);
+		mRenderQueue.Clear();
 
 		VkSubmitInfo submitInfo{};
 		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -369,6 +446,9 @@ namespace OtterEngine {
 
 		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
 		std::set<uint32_t> uniqueQueueFamilies = { indices.mGraphicsFamily.value(), indices.mPresentFamily.value() };
+		if (indices.mTransferFamily) {
+			uniqueQueueFamilies.insert(indices.mTransferFamily.value());
+		}
 
 		float queuePriority = 1.0f;
 		for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -380,11 +460,32 @@ namespace OtterEngine {
 			queueCreateInfos.push_back(queueCreateInfo);
 		}
 
+		VkPhysicalDeviceFeatures supportedFeatures{};
+		vkGetPhysicalDeviceFeatures(mPhysicalDevice, &supportedFeatures);
+
 		VkPhysicalDeviceFeatures deviceFeatures{};
 		deviceFeatures.samplerAnisotropy = VK_TRUE;
+		// Cooked textures are BC compressed, they get expanded on the CPU where it is missing
+		deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+		// Each material group is one indirect draw, VulkanIndirectDrawer falls back where these are missing
+		deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+		deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+		// Shaders pick their texture in an array with a push constant
+		deviceFeatures.shaderSampledImageArrayDynamicIndexing = supportedFeatures.shaderSampledImageArrayDynamicIndexing;
+
+		mHasDescriptorIndexing = VulkanUtility::SupportsDescriptorIndexing(mPhysicalDevice);
+
+		VkPhysicalDeviceVulkan12Features features12{};
+		features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		features12.descriptorBindingPartiallyBound = VK_TRUE;
+		features12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		features12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
 
 		VkDeviceCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		if (mHasDescriptorIndexing) {
+			createInfo.pNext = &features12;
+		}
 		createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 		createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
@@ -409,6 +510,13 @@ namespace OtterEngine {
 		vkGetDeviceQueue(mDevice, indices.mGraphicsFamily.value(), 0, &mGraphicsQueue);
 		vkGetDeviceQueue(mDevice, indices.mPresentFamily.value(), 0, &mPresentQueue);
 
+		if (indices.mTransferFamily) {
+			vkGetDeviceQueue(mDevice, indices.mTransferFamily.value(), 0, &mTransferQueue);
+		}
+		else {
+			mTransferQueue = mGraphicsQueue;
+		}
+
 		OTTER_CORE_LOG("[VULKAN RENDERER] Logical device and queues created succesfully!");
 	}
 
@@ -431,8 +539,8 @@ namespace OtterEngine {
 	{
 		VkFormat depthFormat = VulkanUtility::FindDepthFormat(mPhysicalDevice);
 
-		VulkanUtility::CreateVkImage(mDevice, mPhysicalDevice,
-			mDepthImage, mDepthImageMemory,
+		VulkanUtility::CreateVkImage(*mAllocator,
+			mDepthImage, mDepthImageAllocation,
 			mSwapchainExtent.width, mSwapchainExtent.height,
 			depthFormat, VK_IMAGE_TILING_OPTIMAL,
 			VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
@@ -446,14 +554,106 @@ namespace OtterEngine {
 			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
 	}
 
+	void VulkanRenderer::CreateAllocator()
+	{
+		mAllocator = std::make_unique<VulkanAllocator>(mDevice, mPhysicalDevice);
+	}
+
+	void VulkanRenderer::CreatePipelineCache()
+	{
+		mPipelineCache = std::make_unique<VulkanPipelineCache>(mDevice, mPhysicalDevice, PIPELINE_CACHE_PATH);
+	}
+
+	void VulkanRenderer::CreateStagingRing()
+	{
+		mStagingRing = std::make_unique<VulkanStagingRing>(*mAllocator);
+	}
+
+	void VulkanRenderer::CreateUploadQueue()
+	{
+		QueueFamilyIndices indices = VulkanUtility::FindQueueFamilies(mPhysicalDevice, mSurface);
+		const uint32_t graphicsFamily = indices.mGraphicsFamily.value();
+
+		mUploadQueue = std::make_unique<VulkanUploadQueue>(mDevice, *mStagingRing,
+			mTransferQueue, indices.mTransferFamily.value_or(graphicsFamily),
+			mGraphicsQueue, graphicsFamily);
+	}
+
+	void VulkanRenderer::CreateGeometryPool()
+	{
+		mGeometryPool = std::make_unique<VulkanGeometryPool>(*mAllocator, *mUploadQueue, mCommandPool, mGraphicsQueue, MAX_ONGOING_FRAMES);
+	}
+
 	void VulkanRenderer::CreateTextureLoader()
 	{
-		mTextureLoader = std::make_unique<VulkanTextureLoader>(mDevice, mPhysicalDevice, mCommandPool, mGraphicsQueue);
+		mTextureLoader = std::make_unique<VulkanTextureLoader>(mDevice, mPhysicalDevice, mAllocator.get(), mUploadQueue.get(),
+			MAX_ONGOING_FRAMES, mHasDescriptorIndexing);
 	}
 
 	void VulkanRenderer::CreateMeshLoader()
 	{
-		mMeshLoader = std::make_unique<VulkanMeshLoader>(mDevice, mPhysicalDevice, mCommandPool, mGraphicsQueue);
+		mMeshLoader = std::make_unique<VulkanMeshLoader>(mGeometryPool.get());
+	}
+
+	void VulkanRenderer::CreateIndirectDrawer()
+	{
+		mIndirectDrawer = std::make_unique<VulkanIndirectDrawer>(*mAllocator, mPhysicalDevice, MAX_ONGOING_FRAMES);
+	}
+
+	void VulkanRenderer::CreateParallelRecorder()
+	{
+		QueueFamilyIndices indices = VulkanUtility::FindQueueFamilies(mPhysicalDevice, mSurface);
+
+		mParallelRecorder = std::make_unique<VulkanParallelRecorder>(mDevice, indices.mGraphicsFamily.value(), MAX_ONGOING_FRAMES);
+	}
+
+	MaterialID VulkanRenderer::CreateMaterial(const MaterialDesc& desc)
+	{
+		OTTER_ASSERT(mMaterials.size() < RenderQueue::MAX_MATERIALS, "[VULKAN RENDERER] Too many materials!");
+
+		Material& material = mMaterials.emplace_back();
+		material.mDesc = desc;
+
+		if ((desc.mFeatures & SHADER_FEATURE_NORMAL_MAP) && !desc.mNormalMap) {
+			OTTER_CORE_WARNING("[VULKAN RENDERER] Material has SHADER_FEATURE_NORMAL_MAP but no normal map, the feature is dropped");
+			material.mDesc.mFeatures &= ~SHADER_FEATURE_NORMAL_MAP;
+		}
+		material.mDesc.mFeatures &= ~SHADER_FEATURE_OCTAHEDRAL_NORMAL;
+
+		return static_cast<MaterialID>(mMaterials.size() - 1);
+	}
+
+	PipelineID VulkanRenderer::GetMaterialPipeline(MaterialID material, const VertexFormat& vertexFormat)
+	{
+		const uint64_t key = (static_cast<uint64_t>(material) << 32) | vertexFormat.GetKey();
+		if (auto it = mMaterialPipelines.find(key); it != mMaterialPipelines.end()) {
+			return it->second;
+		}
+
+		ShaderFeatureFlags features = mMaterials[material].mDesc.mFeatures;
+		if (!vertexFormat.HasNormals()) {
+			features &= ~SHADER_FEATURE_LIT;
+		}
+		if (!vertexFormat.HasColors()) {
+			features &= ~SHADER_FEATURE_VERTEX_COLOR;
+		}
+		if (vertexFormat.mNormal == NormalEncoding::Octahedral16) {
+			features |= SHADER_FEATURE_OCTAHEDRAL_NORMAL;
+		}
+
+		// Materials with the same features share a variant, and so a pipeline state per vertex format
+		const ShaderVariantID variantID = mShaderVariants->GetVariantID(features);
+		const PipelineID pipeline = mPipelineStates->GetHandle(MakePipelineState(variantID, vertexFormat));
+		OTTER_ASSERT(pipeline < RenderQueue::MAX_PIPELINES, "[VULKAN RENDERER] Too many pipeline states!");
+
+		mMaterialPipelines.emplace(key, pipeline);
+		return pipeline;
+	}
+
+	VkPipeline VulkanRenderer::GetPipeline(PipelineID pipeline) const
+	{
+		// Groups whose pipeline is not created yet are skipped
+		return mPipelineStates->Get(pipeline);
 	}
 
 	void VulkanRenderer::CreateSwapchain()
@@ -609,27 +809,29 @@ namespace OtterEngine {
 		VkDeviceSize bufferSize = sizeof(UniformBufferObject);
 
 		mUniformBuffers.resize(MAX_ONGOING_FRAMES);
-		mUniformBuffersMemory.resize(MAX_ONGOING_FRAMES);
+		mUniformBuffersAllocations.resize(MAX_ONGOING_FRAMES);
 		mUniformBuffersMapped.resize(MAX_ONGOING_FRAMES);
 
 		for (uint32_t i = 0; i < MAX_ONGOING_FRAMES; ++i) {
-			VulkanUtility::CreateNewBuffer(mDevice, mPhysicalDevice,
+			VulkanUtility::CreateNewBuffer(*mAllocator,
 				bufferSize,
 				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
 				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
 				VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
 				mUniformBuffers[i],
-				mUniformBuffersMemory[i]);
+				mUniformBuffersAllocations[i]);
 
-			vkMapMemory(mDevice, mUniformBuffersMemory[i], 0, bufferSize, 0, &mUniformBuffersMapped[i]);
+			// Host-visible allocations stay mapped for their whole lifetime
+			mUniformBuffersMapped[i] = mUniformBuffersAllocations[i].pMapped;
 		}
 	}
 
 	void VulkanRenderer::CreateDescriptorPool() {
+		// Textures have their own pool, see VulkanTextureLoader
 		std::array<VkDescriptorPoolSize, 2> poolSizes{};
 		poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 		poolSizes[0].descriptorCount = MAX_ONGOING_FRAMES;
-		poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
 		poolSizes[1].descriptorCount = MAX_ONGOING_FRAMES;
 
 		VkDescriptorPoolCreateInfo poolInfo{};
@@ -666,12 +868,7 @@ namespace OtterEngine {
 			bufferInfo.offset = 0;
 			bufferInfo.range = sizeof(UniformBufferObject);
 
-			VkDescriptorImageInfo imageInfo{};
-			imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			imageInfo.imageView = mTextureLoader->GetCurrentImageView();
-			imageInfo.sampler = mTextureLoader->GetCurrentSampler();
-
-			std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
+			std::array<VkWriteDescriptorSet, 1> descriptorWrites{};
 			descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 			descriptorWrites[0].dstSet = mDescriptorSets[i];
 			descriptorWrites[0].dstBinding = 0;
@@ -680,21 +877,34 @@ namespace OtterEngine {
 			descriptorWrites[0].descriptorCount = 1;
 			descriptorWrites[0].pBufferInfo = &bufferInfo;
 
-			descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[1].dstSet = mDescriptorSets[i];
-			descriptorWrites[1].dstBinding = 1;
-			descriptorWrites[1].dstArrayElement = 0;
-			descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-			descriptorWrites[1].descriptorCount = 1;
-			descriptorWrites[1].pImageInfo = &imageInfo;
-
 			vkUpdateDescriptorSets(mDevice,
 				static_cast<uint32_t>(descriptorWrites.size()),
 				descriptorWrites.data(),
 				0, nullptr);
+
+			WriteInstanceDescriptor(i);
 		}
 	}
 
+	void VulkanRenderer::WriteInstanceDescriptor(uint32_t frameIndex)
+	{
+		VkDescriptorBufferInfo instanceInfo{};
+		instanceInfo.buffer = mIndirectDrawer->GetInstanceBuffer(frameIndex);
+		instanceInfo.offset = 0;
+		instanceInfo.range = mIndirectDrawer->GetInstanceBufferSize(frameIndex);
+
+		VkWriteDescriptorSet descriptorWrite{};
+		descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrite.dstSet = mDescriptorSets[frameIndex];
+		descriptorWrite.dstBinding = 1;
+		descriptorWrite.dstArrayElement = 0;
+		descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		descriptorWrite.descriptorCount = 1;
+		descriptorWrite.pBufferInfo = &instanceInfo;
+
+		vkUpdateDescriptorSets(mDevice, 1, &descriptorWrite, 0, nullptr);
+	}
+
 	void VulkanRenderer::CreateCommandBuffers() {
 		mCommandBuffers.resize(mSwapchainFramebuffers.size());
 
@@ -734,10 +944,62 @@ namespace OtterEngine {
 		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 		renderPassInfo.pClearValues = clearValues.data();
 
-		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		// Draws are recorded concurrently into secondaries, the primary only runs them
+		BuildDrawList();
+		std::span<const VkCommandBuffer> secondaries = mParallelRecorder->Record(mCurrentFrame, mRenderPass, 0,
+			mSwapchainFramebuffers[imageIndex], mDrawList.size(),
+			[this](VkCommandBuffer secondary, size_t begin, size_t end) { RecordDrawSlice(secondary, begin, end); },
+			MIN_DRAWS_PER_SLICE);
 
-		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mGraphicsPipeline);
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
+		if (!secondaries.empty()) {
+			vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaries.size()), secondaries.data());
+		}
+		else {
+			OTTER_CORE_WARNING("[COMMAND] No mesh to render - clearing screen only");
+		}
+
+		vkCmdEndRenderPass(commandBuffer);
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+			OTTER_CORE_CRITICAL("[VULKAN RENDERER] Failed to record command buffer!");
+			throw std::runtime_error("Failed to record command buffer!");
+		}
+	}
+
+	void VulkanRenderer::BuildDrawList()
+	{
+		mDrawList.clear();
+
+		// Texture slots are resolved here, the recording threads only read them
+		mMaterialConstants.assign(mMaterials.size(), DrawConstants{ UINT32_MAX, 0 });
+
+		for (const DrawGroup& group : mRenderQueue.GetGroups()) {
+			// New states are created here, before any thread records with them
+			if (mPipelineStates->Acquire(group.mPipeline, ASYNC_PIPELINE_CREATION) == VK_NULL_HANDLE) continue;
+			if (group.mMaterial >= mMaterials.size()) continue;
+
+			DrawConstants& constants = mMaterialConstants[group.mMaterial];
+			if (constants.mTextureIndex == UINT32_MAX) {
+				const MaterialDesc& material = mMaterials[group.mMaterial].mDesc;
+				constants.mTextureIndex = mTextureLoader->GetTextureIndex(material.mTexture);
+				if (material.mFeatures & SHADER_FEATURE_NORMAL_MAP) {
+					constants.mNormalMapIndex = mTextureLoader->GetTextureIndex(material.mNormalMap);
+				}
+			}
+
+			// Large groups are split so that they can be spread across slices
+			for (uint32_t first = 0; first < group.mCommandCount; first += MAX_COMMANDS_PER_DRAW) {
+				DrawGroup& chunk = mDrawList.emplace_back(group);
+				chunk.mFirstCommand = group.mFirstCommand + first;
+				chunk.mCommandCount = std::min(MAX_COMMANDS_PER_DRAW, group.mCommandCount - first);
+			}
+		}
+	}
+
+	void VulkanRenderer::RecordDrawSlice(VkCommandBuffer commandBuffer, size_t begin, size_t end) const
+	{
 		// Viewport and scissor
 		VkViewport viewport{};
 		viewport.x = 0.0f;
@@ -753,30 +1015,36 @@ namespace OtterEngine {
 		scissor.extent = mSwapchainExtent;
 		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
-		if (mMeshLoader &&
-			mMeshLoader->GetVertexBuffer() != VK_NULL_HANDLE &&
-			mMeshLoader->GetIndexBuffer() != VK_NULL_HANDLE &&
-			mMeshLoader->GetIndexCount() > 0) {
-
-			VkBuffer vertexBuffers[] = { mMeshLoader->GetVertexBuffer() };
-			VkDeviceSize offsets[] = { 0 };
-			vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-
-			vkCmdBindIndexBuffer(commandBuffer, mMeshLoader->GetIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
-
-			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipelineLayout, 0, 1, &mDescriptorSets[mCurrentFrame], 0, nullptr);
-
-			vkCmdDrawIndexed(commandBuffer, mMeshLoader->GetIndexCount(), 1, 0, 0, 0);
-		}
-		else {
-			OTTER_CORE_WARNING("[COMMAND] No mesh to render - clearing screen only");
-		}
+		// Every mesh lives in the same buffers, the vertex buffer is bound once per slice and the index buffer
+		// again whenever the index type changes
+		mGeometryPool->Bind(commandBuffer);
+		VkIndexType boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+
+		// Set 0 holds the frame's uniforms and instances, set 1 the array of every resident texture
+		std::array<VkDescriptorSet, 2> descriptorSets = { mDescriptorSets[mCurrentFrame], mTextureLoader->GetDescriptorSet(mCurrentFrame) };
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipelineLayout, 0,
+			static_cast<uint32_t>(descriptorSets.size()), descriptorSets.data(), 0, nullptr);
+
+		// Groups come sorted by pipeline then material, state only changes between them
+		VkPipeline boundPipeline = VK_NULL_HANDLE;
+		DrawConstants pushedConstants{ UINT32_MAX, UINT32_MAX };
+		for (size_t i = begin; i < end; ++i) {
+			const DrawGroup& group = mDrawList[i];
+
+			VkPipeline pipeline = GetPipeline(group.mPipeline);
+			if (pipeline != boundPipeline) {
+				vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+				boundPipeline = pipeline;
+			}
 
-		vkCmdEndRenderPass(commandBuffer);
+			// Every pipeline shares the layout, constants pushed stay valid across pipeline binds
+			const DrawConstants& constants = mMaterialConstants[group.mMaterial];
+			if (constants != pushedConstants) {
+				vkCmdPushConstants(commandBuffer, mPipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(constants), &constants);
+				pushedConstants = constants;
+			}
 
-		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
-			OTTER_CORE_CRITICAL("[VULKAN RENDERER] Failed to record command buffer!");
-			throw std::runtime_error("Failed to record command buffer!");
+			mIndirectDrawer->Draw(commandBuffer, mCurrentFrame, group, *mGeometryPool, boundIndexType);
 		}
 	}
 
@@ -830,13 +1098,8 @@ namespace OtterEngine {
 			vkDestroyImageView(mDevice, mDepthImageView, nullptr);
 			mDepthImageView = VK_NULL_HANDLE;
 		}
-		if (mDepthImage != VK_NULL_HANDLE) {
-			vkDestroyImage(mDevice, mDepthImage, nullptr);
-			mDepthImage = VK_NULL_HANDLE;
-		}
-		if (mDepthImageMemory != VK_NULL_HANDLE) {
-			vkFreeMemory(mDevice, mDepthImageMemory, nullptr);
-			mDepthImageMemory = VK_NULL_HANDLE;
+		if (mAllocator) {
+			mAllocator->DestroyImage(mDepthImage, mDepthImageAllocation);
 		}
 
 		// Clear image views
@@ -845,14 +1108,9 @@ namespace OtterEngine {
 		}
 		mSwapchainImageViews.clear();
 
-		if (mGraphicsPipeline != VK_NULL_HANDLE) {
-			vkDestroyPipeline(mDevice, mGraphicsPipeline, nullptr);
-			mGraphicsPipeline = VK_NULL_HANDLE;
-		}
-
-		if (mPipelineLayout != VK_NULL_HANDLE) {
-			vkDestroyPipelineLayout(mDevice, mPipelineLayout, nullptr);
-			mPipelineLayout = VK_NULL_HANDLE;
+		// Workers may still be creating pipelines against the render pass
+		if (mPipelineStates) {
+			mPipelineStates->WaitForPending();
 		}
 
 		// Clear render pass
@@ -889,7 +1147,14 @@ namespace OtterEngine {
 		CreateSwapchain();
 		CreateImageViews();
 		CreateRenderPass();
-		CreateGraphicsPipeline();
+
+		// Pipelines survive as long as the new pass is compatible, materials move to new states on their next draw otherwise
+		const uint64_t renderPassKey = GetRenderPassKey();
+		const bool isPassCompatible = mPipelineStates->GetRenderPassKey() == renderPassKey;
+		mPipelineStates->SetRenderPass(mRenderPass, renderPassKey);
+		if (!isPassCompatible) {
+			mMaterialPipelines.clear();
+		}
 		CreateDepthResources();
 		CreateFramebuffers();
 		CreateCommandBuffers();
@@ -897,188 +1162,83 @@ namespace OtterEngine {
 		mImagesInFlight.resize(mSwapchainImages.size(), VK_NULL_HANDLE);
 	}
 
-	VkShaderModule VulkanRenderer::CreateShaderModule(const std::vector<char>& shader) const
-	{
-		OTTER_ASSERT(!shader.empty(), "[VULKAN RENDERER] Shader code is empty!");
+	void VulkanRenderer::LoadShaders() {
+		mShaderLibrary = std::make_unique<ShaderLibrary>();
 
-		// Ensure the size is a multiple of 4, as required by Vulkan for pCode
-		OTTER_ASSERT(shader.size() % 4 == 0, "[VULKAN RENDERER] Shader SPIR-V size not multiple of 4 (size: {})", shader.size());
+		// Variants are compiled as materials ask for them
+		const std::filesystem::path directory = SHADER_DIRECTORY;
+		mShaderVariants = std::make_unique<ShaderVariantCache>(*mShaderLibrary, directory / "triangle.vert", directory / "triangle.frag");
+	}
 
-		VkShaderModuleCreateInfo createInfo{};
-		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		createInfo.codeSize = shader.size();
-		createInfo.pCode = reinterpret_cast<const uint32_t*>(shader.data());
+	void VulkanRenderer::CreatePipelineStates() {
+		mPipelineStates = std::make_unique<VulkanPipelineStateCache>(mDevice, mPipelineCache->Get(), *mShaderLibrary);
+		mPipelineStates->SetRenderPass(mRenderPass, GetRenderPassKey());
+	}
 
-		VkShaderModule shaderModule = VK_NULL_HANDLE;
-		
-		VkResult res = vkCreateShaderModule(mDevice, &createInfo, nullptr, &shaderModule);
+	uint64_t VulkanRenderer::GetRenderPassKey() const {
+		return VulkanPipelineStateCache::MakeRenderPassKey(mSwapchainImageFormat, VulkanUtility::FindDepthFormat(mPhysicalDevice),
+			VK_SAMPLE_COUNT_1_BIT);
+	}
+
+	PipelineStateDesc VulkanRenderer::MakePipelineState(ShaderVariantID variantID, const VertexFormat& vertexFormat) const {
+		const ShaderVariant& variant = mShaderVariants->GetVariant(variantID);
+
+		PipelineStateDesc desc;
+		desc.mVertexShader = variant.mVertex;
+		desc.mFragmentShader = variant.mFragment;
+		desc.mLayout = mPipelineLayout;
+		desc.mRenderPassKey = GetRenderPassKey();
+		desc.mSubpass = 0;
+
+		auto bindingDescription = VertexLayout::GetBindingDescription(vertexFormat);
+		auto attributeDescriptions = VertexLayout::GetAttributeDescriptions(vertexFormat);
+		OTTER_ASSERT(attributeDescriptions.size() <= PipelineStateDesc::MAX_VERTEX_ATTRIBUTES, "[VULKAN RENDERER] Too many vertex attributes!");
+
+		desc.mVertexStride = static_cast<uint16_t>(bindingDescription.stride);
+		desc.mVertexAttributeCount = static_cast<uint8_t>(attributeDescriptions.size());
+		for (size_t i = 0; i < attributeDescriptions.size(); ++i) {
+			desc.mVertexAttributes[i].mFormat = attributeDescriptions[i].format;
+			desc.mVertexAttributes[i].mOffset = static_cast<uint16_t>(attributeDescriptions[i].offset);
+			desc.mVertexAttributes[i].mLocation = static_cast<uint8_t>(attributeDescriptions[i].location);
+		}
+
+		// The fragment shader sizes its texture array with the length of the loader's descriptor array
+		desc.mSpecializationCount = 1;
+		desc.mSpecialization[0] = mTextureLoader->GetCapacity();
 
-		OTTER_ASSERT(res == VK_SUCCESS, "[VULKAN RENDERER] Failed to create shader module! VkResult = {}", std::string(VulkanUtility::VkResultToString(res)));
+		// Alpha tested materials are still opaque, they discard instead of blending
+		desc.mBlendMode = BlendMode::Opaque;
+		return desc;
+	}
+
+	void VulkanRenderer::ReloadPipelines() {
+		// Frames still in flight may be drawing with the old pipelines
+		vkDeviceWaitIdle(mDevice);
 
-		return shaderModule;
+		mPipelineStates->WaitForPending();
+		mPipelineStates->InvalidateAll();
 	}
 
-	void VulkanRenderer::CreateGraphicsPipeline() {
-		auto vertShaderCode = OtterIO::ReadFile("../Shaders/triangle.vert.spv");
-		auto fragShaderCode = OtterIO::ReadFile("../Shaders/triangle.frag.spv");
-
-		OTTER_CORE_LOG("[VULKAN RENDERER] Vert size is: {}", vertShaderCode.size());
-		OTTER_CORE_LOG("[VULKAN RENDERER] Frag size is: {}", fragShaderCode.size());
-
-		VkShaderModule vertShaderModule = CreateShaderModule(vertShaderCode);
-		VkShaderModule fragShaderModule = CreateShaderModule(fragShaderCode);
-
-		// Select pipeline stages for each shader
-
-		VkPipelineShaderStageCreateInfo vertShaderStageInfo{}; // Vertex shader
-		vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-		vertShaderStageInfo.module = vertShaderModule;
-		vertShaderStageInfo.pName = "main";
-
-		VkPipelineShaderStageCreateInfo fragShaderStageInfo{}; // Fragment shader
-		fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-		fragShaderStageInfo.module = fragShaderModule;
-		fragShaderStageInfo.pName = "main";
-
-		VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
-
-		// Vertex input
-		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-
-		auto bindingDescription = VertexLayout::GetBindingDescription();
-		auto attributeDescriptions = VertexLayout::GetAttributeDescriptions();
-
-		vertexInputInfo.vertexBindingDescriptionCount = 1;
-		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-
-		vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-		vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
-
-		// Input Assembly
-		VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
-		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-		inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-		inputAssembly.primitiveRestartEnable = VK_FALSE;
-
-		VkPipelineViewportStateCreateInfo viewportState{};
-		viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-		viewportState.viewportCount = 1;
-		viewportState.scissorCount = 1;
-
-		// Rasterizer
-		VkPipelineRasterizationStateCreateInfo rasterizer{};
-		rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-		rasterizer.depthClampEnable = VK_FALSE;
-		rasterizer.rasterizerDiscardEnable = VK_FALSE;
-		rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-		rasterizer.lineWidth = 1.0f;
-		rasterizer.cullMode = VK_CULL_MODE_BACK_BIT; // VK_CULL_MODE_NONE -> Should be used only for debugging
-		rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE; // Depends on how vertices are drawn
-		rasterizer.depthBiasEnable = VK_FALSE;
-
-		// Multisampling
-		VkPipelineMultisampleStateCreateInfo multisampling{};
-		multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-		multisampling.sampleShadingEnable = VK_FALSE;
-		multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-
-		// Color blending
-		VkPipelineColorBlendAttachmentState colorBlendAttachment{};
-		colorBlendAttachment.colorWriteMask =
-			VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
-			VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-		colorBlendAttachment.blendEnable = VK_FALSE;
-
-		VkPipelineColorBlendStateCreateInfo colorBlending{};
-		colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-		colorBlending.logicOpEnable = VK_FALSE;
-		colorBlending.logicOp = VK_LOGIC_OP_COPY;
-		colorBlending.attachmentCount = 1;
-		colorBlending.pAttachments = &colorBlendAttachment;
-		colorBlending.blendConstants[0] = 0.0f;
-		colorBlending.blendConstants[1] = 0.0f;
-		colorBlending.blendConstants[2] = 0.0f;
-		colorBlending.blendConstants[3] = 0.0f;
-
-		// Dynamic viewport and scissor
-		std::vector<VkDynamicState> dynamicStates = {
-			VK_DYNAMIC_STATE_VIEWPORT,
-			VK_DYNAMIC_STATE_SCISSOR
-		};
-
-		VkPipelineDynamicStateCreateInfo dynamicState{};
-		dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-		dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
-		dynamicState.pDynamicStates = dynamicStates.data();
-
-		// Pipeline Layout
+	void VulkanRenderer::CreatePipelineLayout() {
+		std::array<VkDescriptorSetLayout, 2> setLayouts = { mDescriptorSetLayout, mTextureLoader->GetDescriptorSetLayout() };
+
+		// Texture slots of the draw's material
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(DrawConstants);
+
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.setLayoutCount = 1;
-		pipelineLayoutInfo.pSetLayouts = &mDescriptorSetLayout;
-		pipelineLayoutInfo.pushConstantRangeCount = 0;
+		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+		pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
 
 		if (vkCreatePipelineLayout(mDevice, &pipelineLayoutInfo, nullptr, &mPipelineLayout) != VK_SUCCESS) {
 			OTTER_CORE_CRITICAL("[VULKAN RENDERER] Failed to create pipeline layout!");
 			throw std::runtime_error("Failed to create pipeline layout!");
 		}
-
-		// Depth Stencil
-		VkPipelineDepthStencilStateCreateInfo depthStencil{};
-		depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-		depthStencil.depthTestEnable = VK_TRUE;
-		depthStencil.depthWriteEnable = VK_TRUE;
-		depthStencil.depthCompareOp = VK_COMPARE_OP_LESS; // Lower depth -> Closer
-		depthStencil.depthBoundsTestEnable = VK_FALSE;
-		depthStencil.minDepthBounds = 0.0f;
-		depthStencil.maxDepthBounds = 1.0f;
-		depthStencil.stencilTestEnable = VK_FALSE;
-		depthStencil.front = {};
-		depthStencil.back = {};
-
-		// Pipeline
-		VkGraphicsPipelineCreateInfo pipelineInfo{};
-		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-		pipelineInfo.stageCount = 2;
-		pipelineInfo.pStages = shaderStages;
-		pipelineInfo.pVertexInputState = &vertexInputInfo;
-		pipelineInfo.pInputAssemblyState = &inputAssembly;
-		pipelineInfo.pViewportState = &viewportState;
-		pipelineInfo.pRasterizationState = &rasterizer;
-		pipelineInfo.pMultisampleState = &multisampling;
-		pipelineInfo.pColorBlendState = &colorBlending;
-		pipelineInfo.pDynamicState = &dynamicState;
-		pipelineInfo.pDepthStencilState = &depthStencil;
-		pipelineInfo.layout = mPipelineLayout;
-		pipelineInfo.renderPass = mRenderPass;
-		pipelineInfo.subpass = 0;
-		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
-
-		//OTTER_CORE_LOG("[PIPELINE] Creating graphics pipeline with:");
-		//OTTER_CORE_LOG("[PIPELINE] - Binding: binding={}, stride={}, inputRate={}",
-		//	bindingDescription.binding, bindingDescription.stride, bindingDescription.inputRate);
-
-		//for (size_t i = 0; i < attributeDescriptions.size(); ++i) {
-		//	const auto& attr = attributeDescriptions[i];
-		//	OTTER_CORE_LOG("[PIPELINE] - Attribute[{}]: location={}, binding={}, format={}, offset={}",
-		//		i, attr.location, attr.binding, attr.format, attr.offset);
-		//}
-
-		VkResult res = vkCreateGraphicsPipelines(mDevice, nullptr, 1, &pipelineInfo, nullptr, &mGraphicsPipeline);
-
-		if (res != VK_SUCCESS) {
-			OTTER_CORE_CRITICAL("[VULKAN RENDERER] Failed to create graphics pipeline! VkResult = {}", static_cast<int>(res));
-			throw std::runtime_error("Failed to create graphics pipeline!");
-		}
-
-		OTTER_CORE_LOG("[VULKAN RENDERER] Graphics pipeline created!");
-
-		// Clean up shader modules
-		vkDestroyShaderModule(mDevice, fragShaderModule, nullptr);
-		vkDestroyShaderModule(mDevice, vertShaderModule, nullptr);
 	}
 
 	void VulkanRenderer::CreateDescriptorSetLayout()
@@ -1090,14 +1250,16 @@ namespace OtterEngine {
 		uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 		uboLayoutBinding.pImmutableSamplers = nullptr;
 
-		VkDescriptorSetLayoutBinding samplerLayoutBinding{};
-		samplerLayoutBinding.binding = 1;
-		samplerLayoutBinding.descriptorCount = 1;
-		samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		samplerLayoutBinding.pImmutableSamplers = nullptr;
-		samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+		// Transforms of the instances, indexed with gl_InstanceIndex
+		VkDescriptorSetLayoutBinding instanceLayoutBinding{};
+		instanceLayoutBinding.binding = 1;
+		instanceLayoutBinding.descriptorCount = 1;
+		instanceLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		instanceLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+		instanceLayoutBinding.pImmutableSamplers = nullptr;
 
-		std::array<VkDescriptorSetLayoutBinding, 2> bindings = { uboLayoutBinding, samplerLayoutBinding };
+		// Textures are bound through set 1, owned by the texture loader
+		std::array<VkDescriptorSetLayoutBinding, 2> bindings = { uboLayoutBinding, instanceLayoutBinding };
 
 		VkDescriptorSetLayoutCreateInfo layoutInfo{};
 		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -1111,6 +1273,26 @@ namespace OtterEngine {
 	}
 
 	void VulkanRenderer::UpdateUniformBuffer(uint32_t currentImage) {
+		UniformBufferObject ubo{};
+
+		// View matrix: camera at (2,2,2), looking at origin, with up-vector pointing along positive Z axis
+		ubo.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), // Camera position in World space (eye position) 
+			glm::vec3(0.0f, 0.0f, 0.0f), // Look at origin (center position)
+			glm::vec3(0.0f, 0.0f, 1.0f)); // Up vector (Z-Axis)
+
+		// Perspective projection matrix
+		ubo.proj = glm::perspective(glm::radians(45.0f), // FOV
+			mSwapchainExtent.width / (float)mSwapchainExtent.height, // Aspect ratio (adapt to window resize)
+			0.5f, 20.0f);// Near and far planes
+
+		// Invert Y axis
+		ubo.proj[1][1] *= -1;
+
+		memcpy(mUniformBuffersMapped[currentImage], &ubo, sizeof(ubo));
+		mCamera = ubo;
+	}
+
+	void VulkanRenderer::SubmitScene() {
 
 		// This variable is only initialized once, on the first call
 		// to this function, then it retains its value between calls.
@@ -1121,26 +1303,49 @@ namespace OtterEngine {
 		// Elapsed time since rendering has started
 		float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
 
-		UniformBufferObject ubo{};
 		// Model matrix: rotate around Z axis
-		ubo.model = glm::rotate(glm::mat4(1.0f), // Identity matrix
+		glm::mat4 model = glm::rotate(glm::mat4(1.0f), // Identity matrix
 			time * glm::radians(90.0f), // Create a smooth rotation over time (90 deg/s)
 			glm::vec3(0.0f, 0.0f, 1.0f)); // Rotate around Z axis
 
-		// View matrix: camera at (2,2,2), looking at origin, with up-vector pointing along positive Z axis
-		ubo.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), // Camera position in World space (eye position) 
-			glm::vec3(0.0f, 0.0f, 0.0f), // Look at origin (center position)
-			glm::vec3(0.0f, 0.0f, 1.0f)); // Up vector (Z-Axis)
+		for (const auto& [id, mesh] : mMeshLoader->GetMeshes()) {
+			const PipelineID pipeline = GetMaterialPipeline(mSceneMaterial, mesh.mVertexFormat);
+			const MeshLod& lod = mesh.mLods[SelectLod(mesh, model)];
+			for (uint32_t chunk = lod.mFirstChunk; chunk < lod.mFirstChunk + lod.mChunkCount; ++chunk) {
+				mRenderQueue.Submit(mesh.mGeometry[chunk], mSceneMaterial, model, pipeline);
+			}
+		}
+	}
 
-		// Perspective projection matrix
-		ubo.proj = glm::perspective(glm::radians(45.0f), // FOV
-			mSwapchainExtent.width / (float)mSwapchainExtent.height, // Aspect ratio (adapt to window resize)
-			0.5f, 20.0f);// Near and far planes
+	uint32_t VulkanRenderer::SelectLod(const LoadedMesh& mesh, const glm::mat4& model) const {
+		if (mesh.mLods.size() <= 1) {
+			return 0;
+		}
 
-		// Invert Y axis
-		ubo.proj[1][1] *= -1;
+		// Errors are in model units, the largest scale axis bounds how much they grow in the world
+		const float scale = std::max({ glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])) });
+		const glm::vec3 center = (mesh.mBounds.mMin + mesh.mBounds.mMax) * 0.5f;
+		const float radius = glm::length(mesh.mBounds.mMax - mesh.mBounds.mMin) * 0.5f * scale;
 
-		memcpy(mUniformBuffersMapped[currentImage], &ubo, sizeof(ubo));
+		// Distance to the nearest point of the bounding sphere, the camera inside it gets the full mesh
+		const glm::vec4 viewCenter = mCamera.view * model * glm::vec4(center, 1.0f);
+		const float distance = glm::length(glm::vec3(viewCenter)) - radius;
+		if (distance <= 0.0f) {
+			return 0;
+		}
+
+		// proj[1][1] is the cotangent of half the vertical field of view
+		const float pixelsPerModelUnit = std::abs(mCamera.proj[1][1]) * 0.5f * float(mSwapchainExtent.height) * scale / distance;
+
+		// Errors grow with the level, the first one too large ends the search
+		uint32_t selected = 0;
+		for (uint32_t lod = 1; lod < mesh.mLods.size(); ++lod) {
+			if (mesh.mLods[lod].mError * pixelsPerModelUnit > LOD_PIXEL_ERROR) {
+				break;
+			}
+			selected = lod;
+		}
+		return selected;
 	}
 
 	// Debug methods and utilities
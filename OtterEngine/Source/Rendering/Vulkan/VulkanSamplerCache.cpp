@@ -0,0 +1,75 @@
+#include "OtterPCH.h"
+
+#include "Utils/Hash.h"
+
+#include "Rendering/Vulkan/VulkanSamplerCache.h"
+
+namespace OtterEngine {
+	size_t SamplerDescHash::operator()(const SamplerDesc& desc) const noexcept
+	{
+		return static_cast<size_t>(HashValue(desc));
+	}
+
+	VulkanSamplerCache::VulkanSamplerCache(VkDevice device, VkPhysicalDevice physicalDevice) :
+		mDevice(device) {
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		mMaxSupportedAnisotropy = properties.limits.maxSamplerAnisotropy;
+	}
+
+	VulkanSamplerCache::~VulkanSamplerCache()
+	{
+		Clear();
+	}
+
+	VkSampler VulkanSamplerCache::Get(const SamplerDesc& desc)
+	{
+		auto cached = mSamplers.find(desc);
+		if (cached != mSamplers.end()) {
+			return cached->second;
+		}
+
+		const float anisotropy = std::min(desc.mMaxAnisotropy, mMaxSupportedAnisotropy);
+
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = desc.mMagFilter;
+		samplerInfo.minFilter = desc.mMinFilter;
+
+		samplerInfo.addressModeU = desc.mAddressModeU;
+		samplerInfo.addressModeV = desc.mAddressModeV;
+		samplerInfo.addressModeW = desc.mAddressModeW;
+
+		samplerInfo.anisotropyEnable = anisotropy > 1.0f ? VK_TRUE : VK_FALSE;
+		samplerInfo.maxAnisotropy = std::max(anisotropy, 1.0f);
+
+		samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+		samplerInfo.unnormalizedCoordinates = VK_FALSE;
+
+		samplerInfo.compareEnable = VK_FALSE;
+		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+
+		samplerInfo.mipmapMode = desc.mMipmapMode;
+		samplerInfo.mipLodBias = 0.0f;
+		samplerInfo.minLod = 0.0f;
+		samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+		VkSampler sampler = VK_NULL_HANDLE;
+		if (vkCreateSampler(mDevice, &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+			OTTER_CORE_CRITICAL("[VULKAN SAMPLER CACHE] Failed to create sampler!");
+			return VK_NULL_HANDLE;
+		}
+
+		mSamplers.emplace(desc, sampler);
+		OTTER_CORE_LOG("[VULKAN SAMPLER CACHE] Created sampler #{}", mSamplers.size());
+		return sampler;
+	}
+
+	void VulkanSamplerCache::Clear()
+	{
+		for (auto& [desc, sampler] : mSamplers) {
+			vkDestroySampler(mDevice, sampler, nullptr);
+		}
+		mSamplers.clear();
+	}
+}
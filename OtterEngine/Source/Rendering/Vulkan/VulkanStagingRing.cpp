@@ -0,0 +1,173 @@
+#include "OtterPCH.h"
+
+#include "Rendering/Vulkan/VulkanUtility.h"
+
+#include "Rendering/Vulkan/VulkanStagingRing.h"
+
+namespace OtterEngine {
+	namespace {
+		VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+			return (value + alignment - 1) / alignment * alignment;
+		}
+	}
+
+	VulkanStagingRing::VulkanStagingRing(VulkanAllocator& allocator, VkDeviceSize capacity) :
+		mDevice(allocator.GetDevice()), mAllocator(allocator), mCapacity(capacity) {
+		VulkanUtility::CreateNewBuffer(mAllocator, mCapacity,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			mBuffer, mAllocation);
+
+		// Host-visible memory comes mapped from the allocator
+		pMapped = static_cast<uint8_t*>(mAllocation.pMapped);
+		if (!pMapped) {
+			OTTER_CORE_CRITICAL("[VULKAN STAGING RING] Failed to map the staging ring!");
+		}
+
+		OTTER_CORE_LOG("[VULKAN STAGING RING] Created a {} KB staging ring", mCapacity / 1024);
+	}
+
+	VulkanStagingRing::~VulkanStagingRing()
+	{
+		WaitIdle();
+
+		// Whatever was never committed cannot be in use by the GPU either
+		ReleaseSegment(mPending);
+
+		mAllocator.DestroyBuffer(mBuffer, mAllocation);
+		pMapped = nullptr;
+	}
+
+	StagingAllocation VulkanStagingRing::Allocate(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		if (size == 0) {
+			return StagingAllocation();
+		}
+		alignment = std::max<VkDeviceSize>(alignment, 1);
+
+		if (size <= mCapacity) {
+			StagingAllocation allocation;
+
+			Reclaim();
+			if (TryAllocate(size, alignment, allocation)) {
+				return allocation;
+			}
+
+			// Wait for the oldest uploads one at a time, until enough of the ring is free
+			while (!mInFlight.empty()) {
+				Segment& oldest = mInFlight.front();
+				if (oldest.mFence != VK_NULL_HANDLE) {
+					vkWaitForFences(mDevice, 1, &oldest.mFence, VK_TRUE, UINT64_MAX);
+				}
+				ReleaseSegment(oldest);
+				mInFlight.pop_front();
+
+				if (TryAllocate(size, alignment, allocation)) {
+					return allocation;
+				}
+			}
+
+			OTTER_CORE_WARNING("[VULKAN STAGING RING] Ring is full of uncommitted uploads, staging {} bytes in a dedicated buffer", size);
+		}
+		else {
+			OTTER_CORE_LOG("[VULKAN STAGING RING] Upload of {} bytes exceeds the ring, staging it in a dedicated buffer", size);
+		}
+
+		return AllocateDedicated(size);
+	}
+
+	bool VulkanStagingRing::TryAllocate(VkDeviceSize size, VkDeviceSize alignment, StagingAllocation& allocation)
+	{
+		if (mUsedBytes == 0) {
+			mHead = 0;
+		}
+
+		VkDeviceSize start = AlignUp(mHead, alignment);
+		if (start + size > mCapacity) {
+			// Wrap around, the bytes left at the end of the buffer are skipped
+			start = 0;
+		}
+
+		const VkDeviceSize consumed = (start >= mHead ? start - mHead : mCapacity - mHead) + size;
+		if (consumed > mCapacity - mUsedBytes) {
+			return false;
+		}
+
+		mHead = start + size;
+		mUsedBytes += consumed;
+		mPending.mByteCount += consumed;
+
+		allocation.mBuffer = mBuffer;
+		allocation.mOffset = start;
+		allocation.mSize = size;
+		allocation.pMapped = pMapped + start;
+		return true;
+	}
+
+	StagingAllocation VulkanStagingRing::AllocateDedicated(VkDeviceSize size)
+	{
+		DedicatedBuffer dedicated;
+		VulkanUtility::CreateNewBuffer(mAllocator, size,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			dedicated.mBuffer, dedicated.mAllocation);
+
+		StagingAllocation allocation;
+		allocation.mBuffer = dedicated.mBuffer;
+		allocation.mOffset = 0;
+		allocation.mSize = size;
+		allocation.pMapped = static_cast<uint8_t*>(dedicated.mAllocation.pMapped);
+
+		mPending.mDedicatedBuffers.push_back(dedicated);
+		return allocation;
+	}
+
+	void VulkanStagingRing::Commit(VkFence fence)
+	{
+		if (mPending.mByteCount == 0 && mPending.mDedicatedBuffers.empty()) {
+			return;
+		}
+
+		mPending.mFence = fence;
+		mInFlight.push_back(std::move(mPending));
+		mPending = Segment();
+
+		Reclaim();
+	}
+
+	void VulkanStagingRing::Reclaim()
+	{
+		// Segments retire in submission order, the first one still running stops the scan
+		while (!mInFlight.empty()) {
+			Segment& oldest = mInFlight.front();
+			if (oldest.mFence != VK_NULL_HANDLE && vkGetFenceStatus(mDevice, oldest.mFence) != VK_SUCCESS) {
+				break;
+			}
+			ReleaseSegment(oldest);
+			mInFlight.pop_front();
+		}
+	}
+
+	void VulkanStagingRing::WaitIdle()
+	{
+		while (!mInFlight.empty()) {
+			Segment& oldest = mInFlight.front();
+			if (oldest.mFence != VK_NULL_HANDLE) {
+				vkWaitForFences(mDevice, 1, &oldest.mFence, VK_TRUE, UINT64_MAX);
+			}
+			ReleaseSegment(oldest);
+			mInFlight.pop_front();
+		}
+	}
+
+	void VulkanStagingRing::ReleaseSegment(Segment& segment)
+	{
+		mUsedBytes -= segment.mByteCount;
+		segment.mByteCount = 0;
+
+		for (DedicatedBuffer& dedicated : segment.mDedicatedBuffers) {
+			mAllocator.DestroyBuffer(dedicated.mBuffer, dedicated.mAllocation);
+		}
+		segment.mDedicatedBuffers.clear();
+	}
+}
@@ -6,17 +6,83 @@
 #include "Rendering/Vulkan/VulkanTextureLoader.h"
 
 namespace OtterEngine {
-	VulkanTextureLoader::VulkanTextureLoader(VkDevice device, VkPhysicalDevice physicalDevice,
-		VkCommandPool commandPool, VkQueue graphicsQueue)
+	namespace {
+		VkFormat GetTextureFormat(TextureCompression compression, bool isSRGB) {
+			switch (compression) {
+			case TextureCompression::BC1: return isSRGB ? VK_FORMAT_BC1_RGBA_SRGB_BLOCK : VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+			case TextureCompression::BC7: return isSRGB ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+			case TextureCompression::None:
+			default: return isSRGB ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+			}
+		}
+
+		bool CanSampleFormat(VkPhysicalDevice physicalDevice, VkFormat format) {
+			VkFormatProperties properties{};
+			vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
+			return (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+		}
+
+		uint32_t QueryCapacity(VkPhysicalDevice physicalDevice, bool useDescriptorIndexing) {
+			uint32_t capacity = VulkanTextureLoader::MAX_TEXTURES;
+
+			if (useDescriptorIndexing) {
+				VkPhysicalDeviceVulkan12Properties properties12{};
+				properties12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+
+				VkPhysicalDeviceProperties2 properties{};
+				properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+				properties.pNext = &properties12;
+				vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+				capacity = std::min({ capacity,
+					properties12.maxPerStageDescriptorUpdateAfterBindSamplers,
+					properties12.maxPerStageDescriptorUpdateAfterBindSampledImages,
+					properties12.maxDescriptorSetUpdateAfterBindSamplers,
+					properties12.maxDescriptorSetUpdateAfterBindSampledImages });
+			}
+			else {
+				VkPhysicalDeviceProperties properties{};
+				vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+				capacity = std::min({ capacity,
+					properties.limits.maxPerStageDescriptorSamplers,
+					properties.limits.maxPerStageDescriptorSampledImages,
+					properties.limits.maxDescriptorSetSamplers,
+					properties.limits.maxDescriptorSetSampledImages });
+			}
+
+			return std::max(capacity, 1u);
+		}
+	}
+
+	VulkanTextureLoader::VulkanTextureLoader(VkDevice device, VkPhysicalDevice physicalDevice, VulkanAllocator* allocator,
+		VulkanUploadQueue* uploadQueue, uint32_t framesInFlight, bool useDescriptorIndexing, VkDeviceSize budget) :
+		mDevice(device),
+		mPhysicalDevice(physicalDevice),
+		pAllocator(allocator),
+		pUploadQueue(uploadQueue),
+		mSamplerCache(device, physicalDevice),
+		mUseDescriptorIndexing(useDescriptorIndexing),
+		mFramesInFlight(std::max(framesInFlight, 1u)),
+		mBudget(budget)
 	{
-		mDevice = device;
-		mPhysicalDevice = physicalDevice;
-		mCommandPool = commandPool;
-		mGraphicsQueue = graphicsQueue;
-		mTexture = VK_NULL_HANDLE;
-		mTextureImageMemory = VK_NULL_HANDLE;
-		mImageView = VK_NULL_HANDLE;
-		mTextureSampler = VK_NULL_HANDLE;
+		mCapacity = QueryCapacity(physicalDevice, useDescriptorIndexing);
+		mSlots.resize(mCapacity);
+
+		// Lowest slots are handed out first
+		mFreeSlots.reserve(mCapacity);
+		for (uint32_t index = mCapacity; index > DEFAULT_TEXTURE_INDEX + 1; --index) {
+			mFreeSlots.push_back(index - 1);
+		}
+
+		mStats.mBudgetBytes = mBudget;
+		mStats.mCapacity = mCapacity;
+
+		CreateDefaultTexture();
+		CreateDescriptors();
+
+		OTTER_CORE_LOG("[VULKAN TEXTURE LOADER] {} texture slots, descriptor indexing {}",
+			mCapacity, mUseDescriptorIndexing ? "enabled" : "unavailable");
 	}
 
 	VulkanTextureLoader::~VulkanTextureLoader()
@@ -24,131 +90,432 @@ namespace OtterEngine {
 		ClearResources();
 	}
 
+	void VulkanTextureLoader::CreateDefaultTexture()
+	{
+		ResidentTexture& slot = mSlots[DEFAULT_TEXTURE_INDEX];
+
+		constexpr uint32_t whitePixel = 0xFFFFFFFFu;
+		StagingAllocation staging = pUploadQueue->AllocateStaging(sizeof(whitePixel));
+		memcpy(staging.pMapped, &whitePixel, sizeof(whitePixel));
+
+		VulkanUtility::CreateVkImage(*pAllocator,
+			slot.mImage, slot.mAllocation,
+			1, 1,
+			VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		VkBufferImageCopy region{};
+		region.bufferOffset = staging.mOffset;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.layerCount = 1;
+		region.imageExtent = { 1, 1, 1 };
+
+		// Goes out with the first upload batch, which the renderer submits before its first frame
+		slot.mUploadTicket = pUploadQueue->UploadImage(staging.mBuffer, slot.mImage, 1, { &region, 1 });
+		slot.mImageView = VulkanUtility::CreateImageView(mDevice, slot.mImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT);
+		slot.mSampler = mSamplerCache.Get(SamplerDesc{});
+		slot.mByteSize = sizeof(whitePixel);
+		slot.mIsReady = true;
+		slot.mIsLive = true;
+	}
+
+	void VulkanTextureLoader::CreateDescriptors()
+	{
+		const uint32_t setCount = mUseDescriptorIndexing ? 1 : mFramesInFlight;
+
+		VkDescriptorSetLayoutBinding binding{};
+		binding.binding = 0;
+		binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		binding.descriptorCount = mCapacity;
+		binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+		binding.pImmutableSamplers = nullptr;
+
+		// Slots may be rewritten while the set is bound, and stay unwritten until a texture lands in them
+		const VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
+			| VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT
+			| VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+		bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		bindingFlagsInfo.bindingCount = 1;
+		bindingFlagsInfo.pBindingFlags = &bindingFlags;
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.bindingCount = 1;
+		layoutInfo.pBindings = &binding;
+		if (mUseDescriptorIndexing) {
+			layoutInfo.pNext = &bindingFlagsInfo;
+			layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+		}
+
+		if (vkCreateDescriptorSetLayout(mDevice, &layoutInfo, nullptr, &mSetLayout) != VK_SUCCESS) {
+			OTTER_CORE_CRITICAL("[VULKAN TEXTURE LOADER] Failed to create texture descriptor set layout!");
+			return;
+		}
+
+		VkDescriptorPoolSize poolSize{};
+		poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		poolSize.descriptorCount = mCapacity * setCount;
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.poolSizeCount = 1;
+		poolInfo.pPoolSizes = &poolSize;
+		poolInfo.maxSets = setCount;
+		if (mUseDescriptorIndexing) {
+			poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+		}
+
+		if (vkCreateDescriptorPool(mDevice, &poolInfo, nullptr, &mDescriptorPool) != VK_SUCCESS) {
+			OTTER_CORE_CRITICAL("[VULKAN TEXTURE LOADER] Failed to create texture descriptor pool!");
+			return;
+		}
+
+		std::vector<VkDescriptorSetLayout> layouts(setCount, mSetLayout);
+
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = mDescriptorPool;
+		allocInfo.descriptorSetCount = setCount;
+		allocInfo.pSetLayouts = layouts.data();
+
+		mDescriptorSets.resize(setCount);
+		if (vkAllocateDescriptorSets(mDevice, &allocInfo, mDescriptorSets.data()) != VK_SUCCESS) {
+			OTTER_CORE_CRITICAL("[VULKAN TEXTURE LOADER] Failed to allocate texture descriptor sets!");
+			return;
+		}
+		mDirtySlots.resize(setCount);
+
+		const ResidentTexture& fallback = mSlots[DEFAULT_TEXTURE_INDEX];
+		VkDescriptorImageInfo defaultInfo{};
+		defaultInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		defaultInfo.imageView = fallback.mImageView;
+		defaultInfo.sampler = fallback.mSampler;
+
+		// Without partially bound descriptors the whole array must stay valid, start from the default texture everywhere
+		const uint32_t prefilledCount = mUseDescriptorIndexing ? 1 : mCapacity;
+		std::vector<VkDescriptorImageInfo> imageInfos(prefilledCount, defaultInfo);
+
+		std::vector<VkWriteDescriptorSet> writes(setCount);
+		for (uint32_t i = 0; i < setCount; ++i) {
+			writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].dstSet = mDescriptorSets[i];
+			writes[i].dstBinding = 0;
+			writes[i].dstArrayElement = DEFAULT_TEXTURE_INDEX;
+			writes[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			writes[i].descriptorCount = prefilledCount;
+			writes[i].pImageInfo = imageInfos.data();
+		}
+
+		vkUpdateDescriptorSets(mDevice, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+	}
+
 	ResourceHandle<Texture> VulkanTextureLoader::LoadTexture(const std::filesystem::path& path)
 	{
-		ClearResources();
-		mTextureHandle = Resources::Load<Texture>(path);
+		auto handle = Resources::Load<Texture>(path);
 
-		if (!mTextureHandle) {
+		if (!handle) {
 			OTTER_CORE_ERROR("[VULKAN TEXTURE LOADER] Failed to load texture: {}", path);
 			return ResourceHandle<Texture>();
 		}
 
-		UploadTextureToGPU(*mTextureHandle);
+		auto resident = mSlotByAsset.find(handle.GetID());
+		if (resident != mSlotByAsset.end()) {
+			mSlots[resident->second].mLastUsedFrame = mFrame;
+			return mSlots[resident->second].mHandle;
+		}
 
-		CreateTextureImageView();
-		CreateTextureSampler();
+		// Expanded size when the device cannot sample the cooked format, close enough to pick a slot
+		const uint32_t index = AcquireSlot(handle->GetByteSize());
+		if (index == DEFAULT_TEXTURE_INDEX) {
+			OTTER_CORE_ERROR("[VULKAN TEXTURE LOADER] No texture slot left for: {}", path);
+			return ResourceHandle<Texture>();
+		}
 
-		OTTER_CORE_LOG("[VULKAN TEXTURE LOADER] Texture loaded and uploaded to GPU: {}",
-			mTextureHandle.GetPath());
+		ResidentTexture& slot = mSlots[index];
+		if (!UploadTextureToGPU(*handle, slot)) {
+			mFreeSlots.push_back(index);
+			return ResourceHandle<Texture>();
+		}
 
-		return mTextureHandle;
-	}
+		slot.mHandle = handle;
+		slot.mSampler = mSamplerCache.Get(SamplerDesc{});
+		slot.mLastUsedFrame = mFrame;
+		slot.mIsReady = false;
+		slot.mIsLive = true;
+		mSlotByAsset.emplace(handle.GetID(), index);
 
-	void VulkanTextureLoader::CreateTextureImageView()
-	{
-		mImageView = VulkanUtility::CreateImageView(mDevice ,mTexture, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT);
+		++mStats.mResidentCount;
+		mStats.mResidentBytes += slot.mByteSize;
+
+		OTTER_CORE_LOG("[VULKAN TEXTURE LOADER] Texture {} uploading to slot {}", handle.GetPath(), index);
+
+		return handle;
 	}
 
-	void VulkanTextureLoader::CreateTextureSampler()
+	void VulkanTextureLoader::UnloadTexture(const ResourceHandle<Texture>& texture)
 	{
-		VkSamplerCreateInfo samplerInfo{};
-		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-		samplerInfo.magFilter = VK_FILTER_LINEAR;
-		samplerInfo.minFilter = VK_FILTER_LINEAR;
+		auto resident = mSlotByAsset.find(texture.GetID());
+		if (resident == mSlotByAsset.end()) return;
 
-		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		Release(resident->second);
+	}
 
-		samplerInfo.anisotropyEnable = VK_TRUE;
+	uint32_t VulkanTextureLoader::GetTextureIndex(const ResourceHandle<Texture>& texture)
+	{
+		auto resident = mSlotByAsset.find(texture.GetID());
+		if (resident == mSlotByAsset.end()) return DEFAULT_TEXTURE_INDEX;
 
-		VkPhysicalDeviceProperties properties{};
-		vkGetPhysicalDeviceProperties(mPhysicalDevice, &properties);
-		samplerInfo.maxAnisotropy = properties.limits.maxSamplerAnisotropy;
+		ResidentTexture& slot = mSlots[resident->second];
+		slot.mLastUsedFrame = mFrame;
+		return slot.mIsReady ? resident->second : DEFAULT_TEXTURE_INDEX;
+	}
 
-		samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-		samplerInfo.unnormalizedCoordinates = VK_FALSE;
+	void VulkanTextureLoader::BeginFrame(uint32_t frameIndex)
+	{
+		++mFrame;
 
-		samplerInfo.compareEnable = VK_FALSE;
-		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+		// Retired images are no longer read by any frame, nor by any set still to be rewritten
+		std::erase_if(mRetired, [this](RetiredTexture& retired) {
+			if (retired.mReleaseFrame > mFrame) return false;
 
-		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-		samplerInfo.mipLodBias = 0.0f;
-		samplerInfo.minLod = 0.0f;
-		samplerInfo.maxLod = 0.0f;
+			pUploadQueue->Wait(retired.mUploadTicket);
+			vkDestroyImageView(mDevice, retired.mImageView, nullptr);
+			pAllocator->DestroyImage(retired.mImage, retired.mAllocation);
+			mFreeSlots.push_back(retired.mIndex);
+			return true;
+		});
 
-		if (vkCreateSampler(mDevice, &samplerInfo, nullptr, &mTextureSampler)!= VK_SUCCESS) {
-			OTTER_CORE_CRITICAL("[VULKAN TEXTURE LOADER] Failed to create texture sampler!");
+		// Slots are only handed out once their upload completed, every set then gets them written first
+		for (uint32_t index = DEFAULT_TEXTURE_INDEX + 1; index < mCapacity; ++index) {
+			ResidentTexture& slot = mSlots[index];
+			if (slot.mIsLive && !slot.mIsReady && pUploadQueue->IsComplete(slot.mUploadTicket)) {
+				slot.mIsReady = true;
+				MarkDirty(index);
+			}
 		}
+
+		FlushDescriptorWrites(frameIndex % static_cast<uint32_t>(mDescriptorSets.size()));
 	}
 
-	void VulkanTextureLoader::UploadTextureToGPU(const Texture& tex)
+	bool VulkanTextureLoader::UploadTextureToGPU(const Texture& tex, ResidentTexture& slot)
 	{
-		VkDeviceSize imageSize = tex.GetByteSize();
-		const uint8_t* pixels = tex.GetData();
+		const Texture* source = &tex;
+		VkFormat format = GetTextureFormat(tex.GetCompression(), tex.IsSRGB());
 
-		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingBufferMemory;
+		// Fall back to an expanded copy when the device cannot sample the cooked format
+		std::shared_ptr<Texture> decompressed;
+		if (tex.IsCompressed() && !CanSampleFormat(mPhysicalDevice, format)) {
+			OTTER_CORE_WARNING("[VULKAN TEXTURE LOADER] Block-compressed textures are not supported, decompressing on the CPU");
+			decompressed = tex.Decompress();
+			if (!decompressed) return false;
+			source = decompressed.get();
+			format = GetTextureFormat(TextureCompression::None, tex.IsSRGB());
+		}
 
-		VulkanUtility::CreateNewBuffer(mDevice, mPhysicalDevice, imageSize,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			stagingBuffer, stagingBufferMemory);
+		const uint32_t mipLevels = source->GetMipCount();
 
-		void* data;
-		vkMapMemory(mDevice, stagingBufferMemory, 0, imageSize, 0, &data);
-		memcpy(data, pixels, static_cast<size_t>(imageSize));
-		vkUnmapMemory(mDevice, stagingBufferMemory);
+		// Every level goes in one staging allocation, laid out as stored in the texture.
+		// Offsets stay aligned on whole compressed blocks as copies require.
+		VkDeviceSize imageSize = source->GetByteSize();
+		StagingAllocation staging = pUploadQueue->AllocateStaging(imageSize, VulkanStagingRing::DEFAULT_ALIGNMENT);
+		memcpy(staging.pMapped, source->GetData(), static_cast<size_t>(imageSize));
 
-		uint32_t width = static_cast<uint32_t>(tex.GetWidth());
-		uint32_t height = static_cast<uint32_t>(tex.GetHeight());
+		std::vector<VkBufferImageCopy> regions;
+		regions.reserve(mipLevels);
+		for (uint32_t level = 0; level < mipLevels; ++level) {
+			const TextureMip& mip = source->GetMips()[level];
 
-		VulkanUtility::CreateVkImage(mDevice, mPhysicalDevice,
-			mTexture, mTextureImageMemory,
+			VkBufferImageCopy region{};
+			region.bufferOffset = staging.mOffset + mip.mOffset;
+			region.bufferRowLength = 0;
+			region.bufferImageHeight = 0;
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.mipLevel = level;
+			region.imageSubresource.baseArrayLayer = 0;
+			region.imageSubresource.layerCount = 1;
+			region.imageOffset = { 0, 0, 0 };
+			region.imageExtent = { mip.mWidth, mip.mHeight, 1 };
+			regions.push_back(region);
+		}
+
+		uint32_t width = static_cast<uint32_t>(source->GetWidth());
+		uint32_t height = static_cast<uint32_t>(source->GetHeight());
+
+		VulkanUtility::CreateVkImage(*pAllocator,
+			slot.mImage, slot.mAllocation,
 			width, height,
-			VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
+			format, VK_IMAGE_TILING_OPTIMAL,
 			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			mipLevels);
 
-		VulkanUtility::TransitionImageLayout(mDevice, mCommandPool,
-			mTexture, mGraphicsQueue,
-			VK_FORMAT_R8G8B8A8_SRGB, 
-			VK_IMAGE_LAYOUT_UNDEFINED,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+		// Transitions and copy are recorded together, the renderer submits them with the other uploads
+		slot.mUploadTicket = pUploadQueue->UploadImage(staging.mBuffer, slot.mImage, mipLevels, regions);
+		slot.mImageView = VulkanUtility::CreateImageView(mDevice, slot.mImage, format, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels);
+		slot.mByteSize = imageSize;
+		return true;
+	}
 
-		VulkanUtility::CopyBufferToImage(mDevice, mCommandPool,
-			mGraphicsQueue, stagingBuffer,
-			mTexture, width, height);
+	uint32_t VulkanTextureLoader::AcquireSlot(VkDeviceSize byteSize)
+	{
+		while (mStats.mResidentBytes + byteSize > mBudget && EvictLeastRecentlyUsed()) {}
 
-		VulkanUtility::TransitionImageLayout(mDevice, mCommandPool,
-			mTexture, mGraphicsQueue,
-			VK_FORMAT_R8G8B8A8_SRGB, 
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		if (mStats.mResidentBytes + byteSize > mBudget) {
+			OTTER_CORE_WARNING("[VULKAN TEXTURE LOADER] Texture budget exceeded, every resident texture is still in use");
+		}
 
-		vkDestroyBuffer(mDevice, stagingBuffer, nullptr);
-		vkFreeMemory(mDevice, stagingBufferMemory, nullptr);
+		while (mFreeSlots.empty() && EvictLeastRecentlyUsed()) {}
+
+		// Evicted slots only come back once the frames in flight are done with them
+		if (mFreeSlots.empty()) return DEFAULT_TEXTURE_INDEX;
+
+		const uint32_t index = mFreeSlots.back();
+		mFreeSlots.pop_back();
+		return index;
+	}
+
+	bool VulkanTextureLoader::EvictLeastRecentlyUsed()
+	{
+		uint32_t victim = DEFAULT_TEXTURE_INDEX;
+		uint64_t oldestFrame = UINT64_MAX;
+
+		for (const auto& [id, index] : mSlotByAsset) {
+			const ResidentTexture& slot = mSlots[index];
+			// Frames still in flight may sample it
+			if (slot.mLastUsedFrame + mFramesInFlight > mFrame) continue;
+
+			if (slot.mLastUsedFrame < oldestFrame) {
+				oldestFrame = slot.mLastUsedFrame;
+				victim = index;
+			}
+		}
+
+		if (victim == DEFAULT_TEXTURE_INDEX) return false;
+
+		OTTER_CORE_LOG("[VULKAN TEXTURE LOADER] Evicting texture {} from slot {}", mSlots[victim].mHandle.GetPath(), victim);
+		Release(victim);
+		++mStats.mEvictionCount;
+		return true;
+	}
+
+	void VulkanTextureLoader::Release(uint32_t index)
+	{
+		ResidentTexture& slot = mSlots[index];
+
+		RetiredTexture retired;
+		retired.mIndex = index;
+		retired.mImage = slot.mImage;
+		retired.mAllocation = slot.mAllocation;
+		retired.mImageView = slot.mImageView;
+		retired.mUploadTicket = slot.mUploadTicket;
+		retired.mReleaseFrame = mFrame + mFramesInFlight;
+		mRetired.push_back(retired);
+
+		mSlotByAsset.erase(slot.mHandle.GetID());
+		--mStats.mResidentCount;
+		mStats.mResidentBytes -= slot.mByteSize;
+
+		slot = ResidentTexture{};
+
+		// Partially bound slots may keep a stale descriptor, the others point back at the default texture
+		// before the image is destroyed, each set being rewritten within the next frames in flight
+		if (!mUseDescriptorIndexing) {
+			slot.mImageView = mSlots[DEFAULT_TEXTURE_INDEX].mImageView;
+			slot.mSampler = mSlots[DEFAULT_TEXTURE_INDEX].mSampler;
+			MarkDirty(index);
+		}
+	}
+
+	void VulkanTextureLoader::MarkDirty(uint32_t index)
+	{
+		for (auto& dirty : mDirtySlots) {
+			dirty.push_back(index);
+		}
+	}
+
+	void VulkanTextureLoader::FlushDescriptorWrites(uint32_t setIndex)
+	{
+		std::vector<uint32_t>& dirty = mDirtySlots[setIndex];
+		if (dirty.empty()) return;
+
+		std::vector<VkDescriptorImageInfo> imageInfos;
+		std::vector<VkWriteDescriptorSet> writes;
+		imageInfos.reserve(dirty.size());
+		writes.reserve(dirty.size());
+
+		for (uint32_t index : dirty) {
+			const ResidentTexture& slot = mSlots[index];
+			if (slot.mImageView == VK_NULL_HANDLE) continue;
+
+			VkDescriptorImageInfo& imageInfo = imageInfos.emplace_back();
+			imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			imageInfo.imageView = slot.mImageView;
+			imageInfo.sampler = slot.mSampler;
+
+			VkWriteDescriptorSet& write = writes.emplace_back();
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.dstSet = mDescriptorSets[setIndex];
+			write.dstBinding = 0;
+			write.dstArrayElement = index;
+			write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			write.descriptorCount = 1;
+			write.pImageInfo = &imageInfo;
+		}
+
+		if (!writes.empty()) {
+			vkUpdateDescriptorSets(mDevice, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+		}
+		dirty.clear();
+	}
+
+	void VulkanTextureLoader::LogStats() const
+	{
+		OTTER_CORE_LOG("[VULKAN TEXTURE LOADER] {} / {} textures resident, {:.1f} / {:.1f} MB, {} evictions",
+			mStats.mResidentCount, mStats.mCapacity,
+			mStats.mResidentBytes / (1024.0 * 1024.0), mStats.mBudgetBytes / (1024.0 * 1024.0),
+			mStats.mEvictionCount);
 	}
 
 	void VulkanTextureLoader::ClearResources() {
 		if (mDevice == VK_NULL_HANDLE) return;
 
-		if (mTextureSampler != VK_NULL_HANDLE) {
-			vkDestroySampler(mDevice, mTextureSampler, nullptr);
-			mTextureSampler = VK_NULL_HANDLE;
+		if (pUploadQueue) {
+			pUploadQueue->WaitIdle();
 		}
-		if (mImageView != VK_NULL_HANDLE) {
-			vkDestroyImageView(mDevice, mImageView, nullptr);
-			mImageView = VK_NULL_HANDLE;
+
+		for (RetiredTexture& retired : mRetired) {
+			vkDestroyImageView(mDevice, retired.mImageView, nullptr);
+			pAllocator->DestroyImage(retired.mImage, retired.mAllocation);
 		}
-		if (mTexture != VK_NULL_HANDLE) {
-			vkDestroyImage(mDevice, mTexture, nullptr);
-			mTexture = VK_NULL_HANDLE;
+		mRetired.clear();
+
+		for (ResidentTexture& slot : mSlots) {
+			if (!slot.mIsLive) continue;
+
+			vkDestroyImageView(mDevice, slot.mImageView, nullptr);
+			pAllocator->DestroyImage(slot.mImage, slot.mAllocation);
 		}
-		if (mTextureImageMemory != VK_NULL_HANDLE) {
-			vkFreeMemory(mDevice, mTextureImageMemory, nullptr);
-			mTextureImageMemory = VK_NULL_HANDLE;
+		mSlots.clear();
+		mFreeSlots.clear();
+		mSlotByAsset.clear();
+		mDirtySlots.clear();
+		mSamplerCache.Clear();
+
+		if (mDescriptorPool != VK_NULL_HANDLE) {
+			vkDestroyDescriptorPool(mDevice, mDescriptorPool, nullptr);
+			mDescriptorPool = VK_NULL_HANDLE;
 		}
+		mDescriptorSets.clear();
+
+		if (mSetLayout != VK_NULL_HANDLE) {
+			vkDestroyDescriptorSetLayout(mDevice, mSetLayout, nullptr);
+			mSetLayout = VK_NULL_HANDLE;
+		}
+
+		mStats = TextureResidencyStats{};
+		mDevice = VK_NULL_HANDLE;
 	}
-}
\ No newline at end of file
+}
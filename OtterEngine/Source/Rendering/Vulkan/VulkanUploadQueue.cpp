@@ -0,0 +1,377 @@
+#include "OtterPCH.h"
+
+#include "Rendering/Vulkan/VulkanUtility.h"
+
+#include "Rendering/Vulkan/VulkanUploadQueue.h"
+
+namespace OtterEngine {
+	namespace {
+		VkCommandPool CreateCommandPool(VkDevice device, uint32_t queueFamily) {
+			VkCommandPoolCreateInfo info{};
+			info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+			info.queueFamilyIndex = queueFamily;
+
+			VkCommandPool pool = VK_NULL_HANDLE;
+			if (vkCreateCommandPool(device, &info, nullptr, &pool) != VK_SUCCESS) {
+				OTTER_CORE_CRITICAL("[VULKAN UPLOAD QUEUE] Failed to create command pool for queue family {}!", queueFamily);
+			}
+			return pool;
+		}
+
+		void BeginCommands(VkCommandBuffer commandBuffer) {
+			VkCommandBufferBeginInfo beginInfo{};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+			if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+				OTTER_CORE_CRITICAL("[VULKAN UPLOAD QUEUE] Failed to begin upload command buffer!");
+			}
+		}
+	}
+
+	VulkanUploadQueue::VulkanUploadQueue(VkDevice device, VulkanStagingRing& stagingRing,
+		VkQueue transferQueue, uint32_t transferFamily,
+		VkQueue graphicsQueue, uint32_t graphicsFamily) :
+		mDevice(device), mStagingRing(stagingRing),
+		mTransferQueue(transferQueue), mTransferFamily(transferFamily),
+		mGraphicsQueue(graphicsQueue), mGraphicsFamily(graphicsFamily) {
+		mTransferPool = CreateCommandPool(mDevice, mTransferFamily);
+		if (HasDedicatedTransferQueue()) {
+			mAcquirePool = CreateCommandPool(mDevice, mGraphicsFamily);
+		}
+
+		OTTER_CORE_LOG("[VULKAN UPLOAD QUEUE] Uploading on queue family {} ({})", mTransferFamily,
+			HasDedicatedTransferQueue() ? "dedicated transfer queue" : "shared with graphics");
+	}
+
+	VulkanUploadQueue::~VulkanUploadQueue()
+	{
+		WaitIdle();
+
+		for (std::unique_ptr<Batch>& batch : mBatches) {
+			vkDestroyFence(mDevice, batch->mFence, nullptr);
+			if (batch->mTransferDone != VK_NULL_HANDLE) {
+				vkDestroySemaphore(mDevice, batch->mTransferDone, nullptr);
+			}
+		}
+		mBatches.clear();
+		mFreeBatches.clear();
+
+		// Command buffers go away with their pools
+		if (mAcquirePool != VK_NULL_HANDLE) {
+			vkDestroyCommandPool(mDevice, mAcquirePool, nullptr);
+		}
+		vkDestroyCommandPool(mDevice, mTransferPool, nullptr);
+	}
+
+	StagingAllocation VulkanUploadQueue::AllocateStaging(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		return mStagingRing.Allocate(size, alignment);
+	}
+
+	UploadTicket VulkanUploadQueue::CopyBuffer(VkBuffer src, VkDeviceSize srcOffset, VkBuffer dst, VkDeviceSize dstOffset, VkDeviceSize size,
+		VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+	{
+		Batch& batch = GetRecordingBatch();
+
+		VkBufferCopy copyRegion{};
+		copyRegion.srcOffset = srcOffset;
+		copyRegion.dstOffset = dstOffset;
+		copyRegion.size = size;
+		vkCmdCopyBuffer(batch.mTransferCommands, src, dst, 1, &copyRegion);
+
+		VkBufferMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = dstAccess;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = dst;
+		barrier.offset = dstOffset;
+		barrier.size = size;
+
+		batch.mBufferBarriers.push_back(barrier);
+		batch.mDstStages |= dstStage;
+		return batch.mTicket;
+	}
+
+	UploadTicket VulkanUploadQueue::UploadImage(VkBuffer src, VkImage image, uint32_t mipLevels, std::span<const VkBufferImageCopy> regions,
+		VkImageLayout finalLayout, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+	{
+		Batch& batch = GetRecordingBatch();
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = mipLevels;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(batch.mTransferCommands,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0,
+			0, nullptr,
+			0, nullptr,
+			1, &barrier);
+
+		vkCmdCopyBufferToImage(batch.mTransferCommands, src,
+			image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			static_cast<uint32_t>(regions.size()), regions.data());
+
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = finalLayout;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = dstAccess;
+
+		batch.mImageBarriers.push_back(barrier);
+		batch.mDstStages |= dstStage;
+		return batch.mTicket;
+	}
+
+	UploadTicket VulkanUploadQueue::Submit()
+	{
+		if (!pRecording) {
+			return INVALID_TICKET;
+		}
+
+		Batch& batch = *pRecording;
+		pRecording = nullptr;
+
+		const uint32_t bufferBarrierCount = static_cast<uint32_t>(batch.mBufferBarriers.size());
+		const uint32_t imageBarrierCount = static_cast<uint32_t>(batch.mImageBarriers.size());
+		const bool hasBarriers = bufferBarrierCount > 0 || imageBarrierCount > 0;
+
+		if (!HasDedicatedTransferQueue()) {
+			// Same queue as rendering, one barrier orders every copy before the frames reading it
+			if (hasBarriers) {
+				vkCmdPipelineBarrier(batch.mTransferCommands,
+					VK_PIPELINE_STAGE_TRANSFER_BIT, batch.mDstStages,
+					0,
+					0, nullptr,
+					bufferBarrierCount, batch.mBufferBarriers.data(),
+					imageBarrierCount, batch.mImageBarriers.data());
+			}
+		}
+		else if (hasBarriers) {
+			// Ownership goes from the transfer to the graphics family: the release half only
+			// makes the writes available, the acquire half makes them visible to the readers
+			for (VkBufferMemoryBarrier& barrier : batch.mBufferBarriers) {
+				barrier.srcQueueFamilyIndex = mTransferFamily;
+				barrier.dstQueueFamilyIndex = mGraphicsFamily;
+			}
+			for (VkImageMemoryBarrier& barrier : batch.mImageBarriers) {
+				barrier.srcQueueFamilyIndex = mTransferFamily;
+				barrier.dstQueueFamilyIndex = mGraphicsFamily;
+			}
+
+			std::vector<VkAccessFlags> bufferAccesses(bufferBarrierCount);
+			std::vector<VkAccessFlags> imageAccesses(imageBarrierCount);
+			for (uint32_t i = 0; i < bufferBarrierCount; ++i) {
+				std::swap(bufferAccesses[i], batch.mBufferBarriers[i].dstAccessMask);
+			}
+			for (uint32_t i = 0; i < imageBarrierCount; ++i) {
+				std::swap(imageAccesses[i], batch.mImageBarriers[i].dstAccessMask);
+			}
+
+			vkCmdPipelineBarrier(batch.mTransferCommands,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+				0,
+				0, nullptr,
+				bufferBarrierCount, batch.mBufferBarriers.data(),
+				imageBarrierCount, batch.mImageBarriers.data());
+
+			for (uint32_t i = 0; i < bufferBarrierCount; ++i) {
+				batch.mBufferBarriers[i].srcAccessMask = 0;
+				batch.mBufferBarriers[i].dstAccessMask = bufferAccesses[i];
+			}
+			for (uint32_t i = 0; i < imageBarrierCount; ++i) {
+				batch.mImageBarriers[i].srcAccessMask = 0;
+				batch.mImageBarriers[i].dstAccessMask = imageAccesses[i];
+			}
+
+			BeginCommands(batch.mAcquireCommands);
+			vkCmdPipelineBarrier(batch.mAcquireCommands,
+				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, batch.mDstStages,
+				0,
+				0, nullptr,
+				bufferBarrierCount, batch.mBufferBarriers.data(),
+				imageBarrierCount, batch.mImageBarriers.data());
+			if (vkEndCommandBuffer(batch.mAcquireCommands) != VK_SUCCESS) {
+				OTTER_CORE_CRITICAL("[VULKAN UPLOAD QUEUE] Failed to end acquire command buffer!");
+			}
+		}
+
+		if (vkEndCommandBuffer(batch.mTransferCommands) != VK_SUCCESS) {
+			OTTER_CORE_CRITICAL("[VULKAN UPLOAD QUEUE] Failed to end upload command buffer!");
+		}
+
+		VkSubmitInfo transferSubmit{};
+		transferSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		transferSubmit.commandBufferCount = 1;
+		transferSubmit.pCommandBuffers = &batch.mTransferCommands;
+
+		VkResult res;
+		if (HasDedicatedTransferQueue() && hasBarriers) {
+			transferSubmit.signalSemaphoreCount = 1;
+			transferSubmit.pSignalSemaphores = &batch.mTransferDone;
+			res = vkQueueSubmit(mTransferQueue, 1, &transferSubmit, VK_NULL_HANDLE);
+
+			// Graphics submissions that follow are ordered after the acquire barriers
+			const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+			VkSubmitInfo acquireSubmit{};
+			acquireSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			acquireSubmit.waitSemaphoreCount = 1;
+			acquireSubmit.pWaitSemaphores = &batch.mTransferDone;
+			acquireSubmit.pWaitDstStageMask = &waitStage;
+			acquireSubmit.commandBufferCount = 1;
+			acquireSubmit.pCommandBuffers = &batch.mAcquireCommands;
+
+			if (res == VK_SUCCESS) {
+				res = vkQueueSubmit(mGraphicsQueue, 1, &acquireSubmit, batch.mFence);
+			}
+		}
+		else {
+			res = vkQueueSubmit(mTransferQueue, 1, &transferSubmit, batch.mFence);
+		}
+
+		if (res != VK_SUCCESS) {
+			OTTER_CORE_CRITICAL("[VULKAN UPLOAD QUEUE] Failed to submit upload batch! VkResult: {}", VulkanUtility::VkResultToString(res));
+		}
+
+		// The staging memory of the batch is recycled when its fence signals
+		mStagingRing.Commit(batch.mFence);
+
+		batch.mBufferBarriers.clear();
+		batch.mImageBarriers.clear();
+		batch.mDstStages = 0;
+
+		mInFlight.push_back(&batch);
+		return batch.mTicket;
+	}
+
+	void VulkanUploadQueue::Poll()
+	{
+		// Batches retire in submission order, so the completed tickets form a single range
+		while (!mInFlight.empty() && vkGetFenceStatus(mDevice, mInFlight.front()->mFence) == VK_SUCCESS) {
+			RetireOldest();
+		}
+	}
+
+	bool VulkanUploadQueue::IsComplete(UploadTicket ticket)
+	{
+		if (ticket == INVALID_TICKET) {
+			return true;
+		}
+		if (pRecording && ticket >= pRecording->mTicket) {
+			return false;
+		}
+
+		Poll();
+		return ticket <= mCompletedTicket;
+	}
+
+	void VulkanUploadQueue::Wait(UploadTicket ticket)
+	{
+		if (ticket == INVALID_TICKET) {
+			return;
+		}
+		if (pRecording && ticket >= pRecording->mTicket) {
+			Submit();
+		}
+
+		while (!mInFlight.empty() && mInFlight.front()->mTicket <= ticket) {
+			vkWaitForFences(mDevice, 1, &mInFlight.front()->mFence, VK_TRUE, UINT64_MAX);
+			RetireOldest();
+		}
+	}
+
+	void VulkanUploadQueue::WaitIdle()
+	{
+		Submit();
+		Wait(mNextTicket - 1);
+	}
+
+	VulkanUploadQueue::Batch& VulkanUploadQueue::GetRecordingBatch()
+	{
+		if (pRecording) {
+			return *pRecording;
+		}
+
+		Poll();
+
+		Batch* batch = nullptr;
+		if (!mFreeBatches.empty()) {
+			batch = mFreeBatches.back();
+			mFreeBatches.pop_back();
+			vkResetFences(mDevice, 1, &batch->mFence);
+		}
+		else {
+			batch = CreateBatch();
+		}
+
+		batch->mTicket = mNextTicket++;
+		BeginCommands(batch->mTransferCommands);
+
+		pRecording = batch;
+		return *batch;
+	}
+
+	VulkanUploadQueue::Batch* VulkanUploadQueue::CreateBatch()
+	{
+		std::unique_ptr<Batch> batch = std::make_unique<Batch>();
+
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = 1;
+
+		allocInfo.commandPool = mTransferPool;
+		if (vkAllocateCommandBuffers(mDevice, &allocInfo, &batch->mTransferCommands) != VK_SUCCESS) {
+			OTTER_CORE_CRITICAL("[VULKAN UPLOAD QUEUE] Failed to allocate upload command buffer!");
+		}
+
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		if (vkCreateFence(mDevice, &fenceInfo, nullptr, &batch->mFence) != VK_SUCCESS) {
+			OTTER_CORE_CRITICAL("[VULKAN UPLOAD QUEUE] Failed to create upload fence!");
+		}
+
+		if (HasDedicatedTransferQueue()) {
+			allocInfo.commandPool = mAcquirePool;
+			if (vkAllocateCommandBuffers(mDevice, &allocInfo, &batch->mAcquireCommands) != VK_SUCCESS) {
+				OTTER_CORE_CRITICAL("[VULKAN UPLOAD QUEUE] Failed to allocate acquire command buffer!");
+			}
+
+			VkSemaphoreCreateInfo semaphoreInfo{};
+			semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+			if (vkCreateSemaphore(mDevice, &semaphoreInfo, nullptr, &batch->mTransferDone) != VK_SUCCESS) {
+				OTTER_CORE_CRITICAL("[VULKAN UPLOAD QUEUE] Failed to create upload semaphore!");
+			}
+		}
+
+		mBatches.push_back(std::move(batch));
+		return mBatches.back().get();
+	}
+
+	void VulkanUploadQueue::RetireOldest()
+	{
+		Batch* batch = mInFlight.front();
+		mInFlight.pop_front();
+
+		// Release the staging memory now, the fence gets reset when the batch is reused
+		mStagingRing.Reclaim();
+
+		mCompletedTicket = batch->mTicket;
+		mFreeBatches.push_back(batch);
+	}
+}
@@ -3,7 +3,7 @@
 #include "Rendering/Vulkan/VulkanUtility.h"
 
 namespace OtterEngine {
-	void VulkanUtility::CreateNewBuffer(VkDevice device, VkPhysicalDevice physDevice, VkDeviceSize size, VkBufferUsageFlags usages, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory)
+	void VulkanUtility::CreateNewBuffer(VulkanAllocator& allocator, VkDeviceSize size, VkBufferUsageFlags usages, VkMemoryPropertyFlags properties, VkBuffer& buffer, VulkanAllocation& bufferAllocation)
 	{
 		VkBufferCreateInfo bufferInfo{};
 		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -11,26 +11,13 @@ namespace OtterEngine {
 		bufferInfo.usage = usages;
 		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-		if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
-			OTTER_CORE_CRITICAL("[VULKAN UTILITY] Failed to create buffer!");
+		VkResult res = allocator.CreateBuffer(bufferInfo, properties, buffer, bufferAllocation);
+		if (res != VK_SUCCESS) {
+			OTTER_CORE_CRITICAL("[VULKAN UTILITY] Failed to create buffer of {} bytes! VkResult: {}", size, VkResultToString(res));
 		}
-
-		VkMemoryRequirements memRequirements;
-		vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
-
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = FindMemoryType(physDevice, memRequirements.memoryTypeBits, properties);
-
-		if (vkAllocateMemory(device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-			OTTER_CORE_CRITICAL("[VULKAN UTILITY] Failed to allocate buffer memory!");
-		}
-
-		vkBindBufferMemory(device, buffer, bufferMemory, 0);
 	}
 
-	void VulkanUtility::CreateVkImage(VkDevice device, VkPhysicalDevice physDevice, VkImage& img, VkDeviceMemory& imgMem, uint32_t w, uint32_t h, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties)
+	void VulkanUtility::CreateVkImage(VulkanAllocator& allocator, VkImage& img, VulkanAllocation& imgAllocation, uint32_t w, uint32_t h, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, uint32_t mipLevels)
 	{
 		VkImageCreateInfo imageInfo{};
 		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -38,7 +25,7 @@ namespace OtterEngine {
 		imageInfo.extent.width = w;
 		imageInfo.extent.height = h;
 		imageInfo.extent.depth = 1;
-		imageInfo.mipLevels = 1;
+		imageInfo.mipLevels = mipLevels;
 		imageInfo.arrayLayers = 1;
 
 		imageInfo.format = format;
@@ -52,29 +39,13 @@ namespace OtterEngine {
 		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
 		imageInfo.flags = 0;
 
-		if (vkCreateImage(device, &imageInfo, nullptr, &img) != VK_SUCCESS) {
-			OTTER_CORE_CRITICAL("[VULKAN UTILITY] Failed to create image!");
-		}
-
-		VkMemoryRequirements memReq{};
-
-		vkGetImageMemoryRequirements(device, img, &memReq);
-
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memReq.size;
-		allocInfo.memoryTypeIndex = FindMemoryType(physDevice, memReq.memoryTypeBits, properties);
-
-		if (vkAllocateMemory(device, &allocInfo, nullptr, &imgMem) != VK_SUCCESS) {
-			OTTER_CORE_CRITICAL("[VULKAN UTILITY] Failed to allocate image memory!");
-		}
-
-		if (vkBindImageMemory(device, img, imgMem, 0) != VK_SUCCESS) {
-			OTTER_CORE_CRITICAL("[VULKAN UTILITY] Failed to bind image memory!");
+		VkResult res = allocator.CreateImage(imageInfo, properties, img, imgAllocation);
+		if (res != VK_SUCCESS) {
+			OTTER_CORE_CRITICAL("[VULKAN UTILITY] Failed to create {}x{} image! VkResult: {}", w, h, VkResultToString(res));
 		}
 	}
 
-	VkImageView VulkanUtility::CreateImageView(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags) {
+	VkImageView VulkanUtility::CreateImageView(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels) {
 		VkImageViewCreateInfo viewInfo{};
 		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 		viewInfo.image = image;
@@ -82,7 +53,7 @@ namespace OtterEngine {
 		viewInfo.format = format;
 		viewInfo.subresourceRange.aspectMask = aspectFlags;
 		viewInfo.subresourceRange.baseMipLevel = 0;
-		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.levelCount = mipLevels;
 		viewInfo.subresourceRange.baseArrayLayer = 0;
 		viewInfo.subresourceRange.layerCount = 1;
 
@@ -148,21 +119,32 @@ namespace OtterEngine {
 		submitInfo.commandBufferCount = 1;
 		submitInfo.pCommandBuffers = &buffer;
 
-		if (vkQueueSubmit(grQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
-			OTTER_CORE_CRITICAL("[VULKAN UTILITY] Failed to submit command buffer while copying buffer!");
+		// Wait for this submission only, not for everything else in flight on the queue
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		VkFence fence = VK_NULL_HANDLE;
+		if (vkCreateFence(device, &fenceInfo, nullptr, &fence) != VK_SUCCESS) {
+			OTTER_CORE_CRITICAL("[VULKAN UTILITY] Failed to create fence while copying buffer!");
 		}
 
-		if (vkQueueWaitIdle(grQueue) != VK_SUCCESS) {
-			OTTER_CORE_CRITICAL("[VULKAN UTILITY] Failed to wait for graphics queue while copying buffer!");
+		if (vkQueueSubmit(grQueue, 1, &submitInfo, fence) != VK_SUCCESS) {
+			OTTER_CORE_CRITICAL("[VULKAN UTILITY] Failed to submit command buffer while copying buffer!");
+		}
+		else if (vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX) != VK_SUCCESS) {
+			OTTER_CORE_CRITICAL("[VULKAN UTILITY] Failed to wait for command buffer while copying buffer!");
 		}
 
+		vkDestroyFence(device, fence, nullptr);
 		vkFreeCommandBuffers(device, pool, 1, &buffer);
 	}
 
-	void VulkanUtility::CopyBuffer(VkDevice device, VkQueue queue, VkCommandPool cmdPool, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
+	void VulkanUtility::CopyBuffer(VkDevice device, VkQueue queue, VkCommandPool cmdPool, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset, VkDeviceSize dstOffset) {
 		VkCommandBuffer commandBuffer = BeginSingleTimeCommandBuffer(device, cmdPool);
 
 		VkBufferCopy copyRegion{};
+		copyRegion.srcOffset = srcOffset;
+		copyRegion.dstOffset = dstOffset;
 		copyRegion.size = size;
 
 		vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
@@ -170,7 +152,7 @@ namespace OtterEngine {
 		EndSingleTimeCommandBuffer(device, commandBuffer, cmdPool, queue);
 	}
 
-	void VulkanUtility::TransitionImageLayout(VkDevice device, VkCommandPool cmdPool, VkImage image, VkQueue grQueue, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout)
+	void VulkanUtility::TransitionImageLayout(VkDevice device, VkCommandPool cmdPool, VkImage image, VkQueue grQueue, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels)
 	{
 		VkCommandBuffer commandBuffer = BeginSingleTimeCommandBuffer(device, cmdPool);
 
@@ -195,7 +177,7 @@ namespace OtterEngine {
 		}
 
 		barrier.subresourceRange.baseMipLevel = 0;
-		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.levelCount = mipLevels;
 		barrier.subresourceRange.baseArrayLayer = 0;
 		barrier.subresourceRange.layerCount = 1;
 
@@ -273,6 +255,17 @@ namespace OtterEngine {
 		EndSingleTimeCommandBuffer(device, commandBuffer, commandPool, grQueue);
 	}
 
+	void VulkanUtility::CopyBufferToImage(VkDevice device, VkCommandPool commandPool, VkQueue grQueue, VkBuffer buffer, VkImage image, std::span<const VkBufferImageCopy> regions)
+	{
+		VkCommandBuffer commandBuffer = BeginSingleTimeCommandBuffer(device, commandPool);
+
+		vkCmdCopyBufferToImage(commandBuffer, buffer,
+			image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			static_cast<uint32_t>(regions.size()), regions.data());
+
+		EndSingleTimeCommandBuffer(device, commandBuffer, commandPool, grQueue);
+	}
+
 	VkFormat VulkanUtility::FindSupportedFormat(VkPhysicalDevice device, const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features)
 	{
 		for (VkFormat format : candidates) {
@@ -310,6 +303,16 @@ namespace OtterEngine {
 		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
 		vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
 
+		// Prefer a family that only does transfers, it maps to the copy engine of the GPU
+		for (uint32_t family = 0; family < queueFamilyCount; ++family) {
+			const VkQueueFlags flags = queueFamilies[family].queueFlags;
+			if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT)) {
+				if (!indices.mTransferFamily || !(flags & VK_QUEUE_COMPUTE_BIT)) {
+					indices.mTransferFamily = family;
+				}
+			}
+		}
+
 		int i = 0;
 		for (const auto& queueFamily : queueFamilies) {
 			if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
@@ -355,6 +358,25 @@ namespace OtterEngine {
 			&& supportedFeatures.samplerAnisotropy;
 	}
 
+	bool VulkanUtility::SupportsDescriptorIndexing(VkPhysicalDevice device)
+	{
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(device, &properties);
+		if (properties.apiVersion < VK_API_VERSION_1_2) return false;
+
+		VkPhysicalDeviceVulkan12Features features12{};
+		features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+		VkPhysicalDeviceFeatures2 features{};
+		features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features.pNext = &features12;
+		vkGetPhysicalDeviceFeatures2(device, &features);
+
+		return features12.descriptorBindingPartiallyBound
+			&& features12.descriptorBindingSampledImageUpdateAfterBind
+			&& features12.descriptorBindingUpdateUnusedWhilePending;
+	}
+
 	bool VulkanUtility::CheckDeviceExtensionSupport(VkPhysicalDevice device, std::vector<const char*> deviceExtensions) {
 		uint32_t extensionCount;
 		vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
@@ -0,0 +1,84 @@
+#include "OtterPCH.h"
+
+#include <mutex>
+#include <string>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "Utils/Hash.h"
+#include "Utils/PathFormat.h"
+#include "Resources/AssetID.h"
+
+namespace OtterEngine {
+	namespace {
+		struct InternTable {
+			std::shared_mutex mLock;
+			// Nodes never move, references to the stored paths stay valid while inserting
+			std::unordered_map<AssetID, std::filesystem::path> mPaths;
+		};
+
+		InternTable& GetTable() {
+			static InternTable sTable;
+			return sTable;
+		}
+
+		// Two paths sharing an ID would silently load each other's asset, the second one is refused
+		AssetID CheckCollision(const std::filesystem::path& internedPath, const std::filesystem::path& path, AssetID id) {
+			if (internedPath != path) {
+				OTTER_CORE_ERROR("[ASSET REGISTRY] ID {:#018x} of '{}' is already used by '{}', the asset cannot be loaded",
+					id, path, internedPath);
+				return INVALID_ASSET_ID;
+			}
+			return id;
+		}
+	}
+
+	AssetID AssetRegistry::MakeID(const std::filesystem::path& path)
+	{
+		const std::string key = path.lexically_normal().generic_string();
+
+		const uint64_t hash = HashString(key);
+
+		// Keep the invalid ID free
+		return hash == INVALID_ASSET_ID ? FNV_OFFSET_BASIS : hash;
+	}
+
+	AssetID AssetRegistry::Intern(const std::filesystem::path& path)
+	{
+		return Intern(path, MakeID(path));
+	}
+
+	AssetID AssetRegistry::Intern(const std::filesystem::path& path, AssetID id)
+	{
+		if (id == INVALID_ASSET_ID) {
+			return INVALID_ASSET_ID;
+		}
+
+		const std::filesystem::path normalPath = path.lexically_normal();
+		InternTable& table = GetTable();
+
+		{
+			std::shared_lock lock(table.mLock);
+			if (auto iter = table.mPaths.find(id); iter != table.mPaths.end()) {
+				return CheckCollision(iter->second, normalPath, id);
+			}
+		}
+
+		// Another thread may have registered the ID since the lookup, possibly for another path
+		std::unique_lock lock(table.mLock);
+		auto [iter, isInserted] = table.mPaths.try_emplace(id, normalPath);
+		return isInserted ? id : CheckCollision(iter->second, normalPath, id);
+	}
+
+	const std::filesystem::path& AssetRegistry::GetPath(AssetID id)
+	{
+		static const std::filesystem::path sEmptyPath;
+
+		InternTable& table = GetTable();
+		std::shared_lock lock(table.mLock);
+		if (auto iter = table.mPaths.find(id); iter != table.mPaths.end()) {
+			return iter->second;
+		}
+		return sEmptyPath;
+	}
+}
@@ -0,0 +1,546 @@
+#include "OtterPCH.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "Core/JobSystem.h"
+#include "Resources/BlockCompression.h"
+
+namespace OtterEngine {
+	namespace {
+		constexpr size_t BC1_BLOCK_BYTES = 8;
+		constexpr size_t BC7_BLOCK_BYTES = 16;
+		constexpr int REFINE_ITERATIONS = 3;
+
+		// Interpolation weights of the 4-bit BC7 indices, in 64ths
+		constexpr int BC7_WEIGHTS_4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		/// <summary>
+		/// Finds the direction of largest variance of a set of points with the power method
+		/// </summary>
+		template<int Channels>
+		void ComputePrincipalAxis(const float (*points)[4], int count, float* mean, float* axis) {
+			for (int c = 0; c < Channels; ++c) {
+				mean[c] = 0.0f;
+				for (int i = 0; i < count; ++i) mean[c] += points[i][c];
+				mean[c] /= static_cast<float>(count);
+			}
+
+			float covariance[Channels][Channels] = {};
+			for (int i = 0; i < count; ++i) {
+				for (int r = 0; r < Channels; ++r) {
+					for (int c = 0; c < Channels; ++c) {
+						covariance[r][c] += (points[i][r] - mean[r]) * (points[i][c] - mean[c]);
+					}
+				}
+			}
+
+			// Start from the row of the channel varying the most
+			int start = 0;
+			for (int c = 1; c < Channels; ++c) {
+				if (covariance[c][c] > covariance[start][start]) start = c;
+			}
+			for (int c = 0; c < Channels; ++c) axis[c] = covariance[start][c];
+
+			for (int iteration = 0; iteration < 8; ++iteration) {
+				float next[Channels] = {};
+				for (int r = 0; r < Channels; ++r) {
+					for (int c = 0; c < Channels; ++c) next[r] += covariance[r][c] * axis[c];
+				}
+
+				float length = 0.0f;
+				for (int c = 0; c < Channels; ++c) length += next[c] * next[c];
+				length = std::sqrt(length);
+				if (length < 1e-6f) {
+					for (int c = 0; c < Channels; ++c) axis[c] = 0.0f;
+					return;
+				}
+				for (int c = 0; c < Channels; ++c) axis[c] = next[c] / length;
+			}
+		}
+
+		/// <summary>
+		/// Returns the extremes of the points projected on the axis through their mean
+		/// </summary>
+		template<int Channels>
+		void ComputeAxisEndpoints(const float (*points)[4], int count, const float* mean, const float* axis,
+			float* low, float* high) {
+			float minT = std::numeric_limits<float>::max();
+			float maxT = std::numeric_limits<float>::lowest();
+			for (int i = 0; i < count; ++i) {
+				float t = 0.0f;
+				for (int c = 0; c < Channels; ++c) t += (points[i][c] - mean[c]) * axis[c];
+				minT = std::min(minT, t);
+				maxT = std::max(maxT, t);
+			}
+
+			for (int c = 0; c < Channels; ++c) {
+				low[c] = std::clamp(mean[c] + axis[c] * minT, 0.0f, 255.0f);
+				high[c] = std::clamp(mean[c] + axis[c] * maxT, 0.0f, 255.0f);
+			}
+		}
+
+		/// <summary>
+		/// Least squares fit of two endpoints, given the weight of the first one for every point
+		/// </summary>
+		/// <returns>False if the system is degenerate and the endpoints were left untouched</returns>
+		template<int Channels>
+		bool FitEndpoints(const float (*points)[4], const float* weights, int count, float* first, float* second) {
+			float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+			float ap[Channels] = {}, bp[Channels] = {};
+			for (int i = 0; i < count; ++i) {
+				float a = weights[i];
+				float b = 1.0f - a;
+				aa += a * a;
+				ab += a * b;
+				bb += b * b;
+				for (int c = 0; c < Channels; ++c) {
+					ap[c] += a * points[i][c];
+					bp[c] += b * points[i][c];
+				}
+			}
+
+			float determinant = aa * bb - ab * ab;
+			if (std::fabs(determinant) < 1e-6f) return false;
+
+			float inverse = 1.0f / determinant;
+			for (int c = 0; c < Channels; ++c) {
+				first[c] = std::clamp((bb * ap[c] - ab * bp[c]) * inverse, 0.0f, 255.0f);
+				second[c] = std::clamp((aa * bp[c] - ab * ap[c]) * inverse, 0.0f, 255.0f);
+			}
+			return true;
+		}
+
+		template<int Channels>
+		int SquaredDistance(const int* a, const float* b) {
+			float distance = 0.0f;
+			for (int c = 0; c < Channels; ++c) {
+				float delta = static_cast<float>(a[c]) - b[c];
+				distance += delta * delta;
+			}
+			return static_cast<int>(distance);
+		}
+
+		// ---- BC1 ----
+
+		uint16_t PackRGB565(const float* color) {
+			int r = std::clamp(static_cast<int>(std::lround(color[0] * 31.0f / 255.0f)), 0, 31);
+			int g = std::clamp(static_cast<int>(std::lround(color[1] * 63.0f / 255.0f)), 0, 63);
+			int b = std::clamp(static_cast<int>(std::lround(color[2] * 31.0f / 255.0f)), 0, 31);
+			return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+		}
+
+		void UnpackRGB565(uint16_t packed, int* color) {
+			int r = (packed >> 11) & 31;
+			int g = (packed >> 5) & 63;
+			int b = packed & 31;
+			color[0] = (r << 3) | (r >> 2);
+			color[1] = (g << 2) | (g >> 4);
+			color[2] = (b << 3) | (b >> 2);
+			color[3] = 255;
+		}
+
+		// A block is in the 4-color mode when its first endpoint is greater than the second
+		void BuildBC1Palette(uint16_t color0, uint16_t color1, int (*palette)[4]) {
+			UnpackRGB565(color0, palette[0]);
+			UnpackRGB565(color1, palette[1]);
+
+			for (int c = 0; c < 3; ++c) {
+				if (color0 > color1) {
+					palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+					palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+				}
+				else {
+					palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+					palette[3][c] = 0;
+				}
+			}
+			palette[2][3] = 255;
+			palette[3][3] = color0 > color1 ? 255 : 0;
+		}
+
+		// ---- BC7 ----
+
+		class BlockBitWriter {
+		private:
+			uint8_t* pOutput;
+			uint32_t mPosition = 0;
+
+		public:
+			explicit BlockBitWriter(uint8_t* output) : pOutput(output) {
+				std::fill(output, output + BC7_BLOCK_BYTES, uint8_t(0));
+			}
+
+			void Write(uint32_t value, uint32_t bitCount) {
+				for (uint32_t bit = 0; bit < bitCount; ++bit, ++mPosition) {
+					if ((value >> bit) & 1u) {
+						pOutput[mPosition >> 3] |= static_cast<uint8_t>(1u << (mPosition & 7));
+					}
+				}
+			}
+		};
+
+		class BlockBitReader {
+		private:
+			const uint8_t* pInput;
+			uint32_t mPosition = 0;
+
+		public:
+			explicit BlockBitReader(const uint8_t* input) : pInput(input) {}
+
+			uint32_t Read(uint32_t bitCount) {
+				uint32_t value = 0;
+				for (uint32_t bit = 0; bit < bitCount; ++bit, ++mPosition) {
+					value |= static_cast<uint32_t>((pInput[mPosition >> 3] >> (mPosition & 7)) & 1u) << bit;
+				}
+				return value;
+			}
+		};
+
+		struct BC7Mode6Block {
+			int mEndpoints[2][4] = {};	// 7-bit values
+			int mPBits[2] = {};
+			uint8_t mIndices[16] = {};
+			int mError = std::numeric_limits<int>::max();
+		};
+
+		void ExpandBC7Endpoints(const BC7Mode6Block& block, int (*endpoints)[4]) {
+			for (int e = 0; e < 2; ++e) {
+				for (int c = 0; c < 4; ++c) {
+					endpoints[e][c] = (block.mEndpoints[e][c] << 1) | block.mPBits[e];
+				}
+			}
+		}
+
+		int InterpolateBC7(int first, int second, int weight) {
+			return ((64 - weight) * first + weight * second + 32) >> 6;
+		}
+
+		/// <summary>
+		/// Quantizes a pair of endpoints with every p-bit combination and keeps the lowest error encoding
+		/// </summary>
+		void EvaluateBC7Endpoints(const float (*points)[4], const float* first, const float* second, BC7Mode6Block& best) {
+			for (int pBits = 0; pBits < 4; ++pBits) {
+				BC7Mode6Block candidate;
+				candidate.mPBits[0] = pBits & 1;
+				candidate.mPBits[1] = pBits >> 1;
+
+				for (int c = 0; c < 4; ++c) {
+					candidate.mEndpoints[0][c] = std::clamp(static_cast<int>(std::lround((first[c] - candidate.mPBits[0]) * 0.5f)), 0, 127);
+					candidate.mEndpoints[1][c] = std::clamp(static_cast<int>(std::lround((second[c] - candidate.mPBits[1]) * 0.5f)), 0, 127);
+				}
+
+				int endpoints[2][4];
+				ExpandBC7Endpoints(candidate, endpoints);
+
+				int palette[16][4];
+				for (int i = 0; i < 16; ++i) {
+					for (int c = 0; c < 4; ++c) {
+						palette[i][c] = InterpolateBC7(endpoints[0][c], endpoints[1][c], BC7_WEIGHTS_4[i]);
+					}
+				}
+
+				candidate.mError = 0;
+				for (int p = 0; p < 16; ++p) {
+					int bestIndex = 0;
+					int bestDistance = std::numeric_limits<int>::max();
+					for (int i = 0; i < 16; ++i) {
+						int distance = SquaredDistance<4>(palette[i], points[p]);
+						if (distance < bestDistance) {
+							bestDistance = distance;
+							bestIndex = i;
+						}
+					}
+					candidate.mIndices[p] = static_cast<uint8_t>(bestIndex);
+					candidate.mError += bestDistance;
+					if (candidate.mError >= best.mError) break;
+				}
+
+				if (candidate.mError < best.mError) {
+					best = candidate;
+				}
+			}
+		}
+	}
+
+	size_t BlockCompression::GetBlockByteSize(TextureCompression compression)
+	{
+		switch (compression) {
+		case TextureCompression::BC1: return BC1_BLOCK_BYTES;
+		case TextureCompression::BC7: return BC7_BLOCK_BYTES;
+		case TextureCompression::None:
+		default: return 4;
+		}
+	}
+
+	size_t BlockCompression::GetImageByteSize(TextureCompression compression, uint32_t width, uint32_t height)
+	{
+		if (compression == TextureCompression::None) {
+			return static_cast<size_t>(width) * height * 4;
+		}
+
+		size_t blocksX = (width + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+		size_t blocksY = (height + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+		return blocksX * blocksY * GetBlockByteSize(compression);
+	}
+
+	std::vector<uint8_t> BlockCompression::Compress(TextureCompression compression, const uint8_t* pixels, uint32_t width, uint32_t height)
+	{
+		if (compression == TextureCompression::None) {
+			return std::vector<uint8_t>(pixels, pixels + static_cast<size_t>(width) * height * 4);
+		}
+
+		const uint32_t blocksX = (width + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+		const uint32_t blocksY = (height + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+		const size_t blockBytes = GetBlockByteSize(compression);
+
+		std::vector<uint8_t> output(static_cast<size_t>(blocksX) * blocksY * blockBytes);
+
+		JobSystem::ParallelFor(blocksY, [&](size_t blockY) {
+			uint8_t block[BLOCK_PIXEL_COUNT * 4];
+			for (uint32_t blockX = 0; blockX < blocksX; ++blockX) {
+				for (uint32_t y = 0; y < BLOCK_DIMENSION; ++y) {
+					uint32_t sourceY = std::min<uint32_t>(static_cast<uint32_t>(blockY) * BLOCK_DIMENSION + y, height - 1);
+					for (uint32_t x = 0; x < BLOCK_DIMENSION; ++x) {
+						uint32_t sourceX = std::min(blockX * BLOCK_DIMENSION + x, width - 1);
+						memcpy(&block[(y * BLOCK_DIMENSION + x) * 4], &pixels[(static_cast<size_t>(sourceY) * width + sourceX) * 4], 4);
+					}
+				}
+
+				uint8_t* destination = &output[(blockY * blocksX + blockX) * blockBytes];
+				if (compression == TextureCompression::BC1) {
+					EncodeBC1Block(block, destination);
+				}
+				else {
+					EncodeBC7Block(block, destination);
+				}
+			}
+		});
+
+		return output;
+	}
+
+	std::vector<uint8_t> BlockCompression::Decompress(TextureCompression compression, const uint8_t* blocks, uint32_t width, uint32_t height)
+	{
+		if (compression == TextureCompression::None) {
+			return std::vector<uint8_t>(blocks, blocks + static_cast<size_t>(width) * height * 4);
+		}
+
+		const uint32_t blocksX = (width + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+		const uint32_t blocksY = (height + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+		const size_t blockBytes = GetBlockByteSize(compression);
+
+		std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+		bool hasUnsupportedBlocks = false;
+
+		uint8_t block[BLOCK_PIXEL_COUNT * 4];
+		for (uint32_t blockY = 0; blockY < blocksY; ++blockY) {
+			for (uint32_t blockX = 0; blockX < blocksX; ++blockX) {
+				const uint8_t* source = &blocks[(static_cast<size_t>(blockY) * blocksX + blockX) * blockBytes];
+				if (compression == TextureCompression::BC1) {
+					DecodeBC1Block(source, block);
+				}
+				else if (!DecodeBC7Block(source, block)) {
+					hasUnsupportedBlocks = true;
+				}
+
+				for (uint32_t y = 0; y < BLOCK_DIMENSION && blockY * BLOCK_DIMENSION + y < height; ++y) {
+					for (uint32_t x = 0; x < BLOCK_DIMENSION && blockX * BLOCK_DIMENSION + x < width; ++x) {
+						size_t target = (static_cast<size_t>(blockY * BLOCK_DIMENSION + y) * width + blockX * BLOCK_DIMENSION + x) * 4;
+						memcpy(&pixels[target], &block[(y * BLOCK_DIMENSION + x) * 4], 4);
+					}
+				}
+			}
+		}
+
+		if (hasUnsupportedBlocks) {
+			OTTER_CORE_WARNING("[BLOCK COMPRESSION] Image contains BC7 blocks in modes other than 6, they were not decoded");
+		}
+
+		return pixels;
+	}
+
+	void BlockCompression::EncodeBC1Block(const uint8_t* pixels, uint8_t* output)
+	{
+		float points[BLOCK_PIXEL_COUNT][4];
+		int pointPixels[BLOCK_PIXEL_COUNT];
+		int pointCount = 0;
+		bool isTransparent[BLOCK_PIXEL_COUNT];
+
+		for (uint32_t p = 0; p < BLOCK_PIXEL_COUNT; ++p) {
+			isTransparent[p] = pixels[p * 4 + 3] < 128;
+			if (isTransparent[p]) continue;
+
+			for (int c = 0; c < 4; ++c) points[pointCount][c] = pixels[p * 4 + c];
+			pointPixels[pointCount++] = static_cast<int>(p);
+		}
+
+		const bool hasTransparency = pointCount < static_cast<int>(BLOCK_PIXEL_COUNT);
+		uint16_t bestColors[2] = { 0, 0 };
+		uint32_t bestIndices = 0xFFFFFFFFu; // Fully transparent block
+		int bestError = std::numeric_limits<int>::max();
+
+		if (pointCount > 0) {
+			float mean[3], axis[3], endpoints[2][3];
+			ComputePrincipalAxis<3>(points, pointCount, mean, axis);
+			ComputeAxisEndpoints<3>(points, pointCount, mean, axis, endpoints[1], endpoints[0]);
+
+			for (int iteration = 0; iteration < REFINE_ITERATIONS; ++iteration) {
+				uint16_t colors[2] = { PackRGB565(endpoints[0]), PackRGB565(endpoints[1]) };
+
+				// Transparency requires the 3-color mode, otherwise the 4-color one is preferred
+				if (hasTransparency ? colors[0] > colors[1] : colors[0] < colors[1]) {
+					std::swap(colors[0], colors[1]);
+					std::swap(endpoints[0], endpoints[1]);
+				}
+
+				int palette[4][4];
+				BuildBC1Palette(colors[0], colors[1], palette);
+				const int usableEntries = colors[0] > colors[1] ? 4 : 3;
+
+				uint32_t indices = 0;
+				int error = 0;
+				int selected[BLOCK_PIXEL_COUNT];
+				for (int i = 0; i < pointCount; ++i) {
+					int bestEntry = 0;
+					int bestDistance = std::numeric_limits<int>::max();
+					for (int entry = 0; entry < usableEntries; ++entry) {
+						int distance = SquaredDistance<3>(palette[entry], points[i]);
+						if (distance < bestDistance) {
+							bestDistance = distance;
+							bestEntry = entry;
+						}
+					}
+					selected[i] = bestEntry;
+					error += bestDistance;
+					indices |= static_cast<uint32_t>(bestEntry) << (pointPixels[i] * 2);
+				}
+				for (uint32_t p = 0; p < BLOCK_PIXEL_COUNT; ++p) {
+					if (isTransparent[p]) indices |= 3u << (p * 2);
+				}
+
+				if (error < bestError) {
+					bestError = error;
+					bestColors[0] = colors[0];
+					bestColors[1] = colors[1];
+					bestIndices = indices;
+				}
+				if (error == 0 || colors[0] == colors[1]) break;
+
+				// Weight of the first endpoint for each palette entry
+				const float entryWeights4[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+				const float entryWeights3[4] = { 1.0f, 0.0f, 0.5f, 0.0f };
+				const float* entryWeights = usableEntries == 4 ? entryWeights4 : entryWeights3;
+
+				float weights[BLOCK_PIXEL_COUNT];
+				for (int i = 0; i < pointCount; ++i) weights[i] = entryWeights[selected[i]];
+				if (!FitEndpoints<3>(points, weights, pointCount, endpoints[0], endpoints[1])) break;
+			}
+		}
+
+		output[0] = static_cast<uint8_t>(bestColors[0] & 0xFF);
+		output[1] = static_cast<uint8_t>(bestColors[0] >> 8);
+		output[2] = static_cast<uint8_t>(bestColors[1] & 0xFF);
+		output[3] = static_cast<uint8_t>(bestColors[1] >> 8);
+		for (int i = 0; i < 4; ++i) {
+			output[4 + i] = static_cast<uint8_t>((bestIndices >> (i * 8)) & 0xFF);
+		}
+	}
+
+	void BlockCompression::DecodeBC1Block(const uint8_t* input, uint8_t* pixels)
+	{
+		uint16_t color0 = static_cast<uint16_t>(input[0] | (input[1] << 8));
+		uint16_t color1 = static_cast<uint16_t>(input[2] | (input[3] << 8));
+		uint32_t indices = static_cast<uint32_t>(input[4]) | (static_cast<uint32_t>(input[5]) << 8) |
+			(static_cast<uint32_t>(input[6]) << 16) | (static_cast<uint32_t>(input[7]) << 24);
+
+		int palette[4][4];
+		BuildBC1Palette(color0, color1, palette);
+
+		for (uint32_t p = 0; p < BLOCK_PIXEL_COUNT; ++p) {
+			const int* entry = palette[(indices >> (p * 2)) & 3];
+			for (int c = 0; c < 4; ++c) pixels[p * 4 + c] = static_cast<uint8_t>(entry[c]);
+		}
+	}
+
+	void BlockCompression::EncodeBC7Block(const uint8_t* pixels, uint8_t* output)
+	{
+		float points[BLOCK_PIXEL_COUNT][4];
+		for (uint32_t p = 0; p < BLOCK_PIXEL_COUNT; ++p) {
+			for (int c = 0; c < 4; ++c) points[p][c] = pixels[p * 4 + c];
+		}
+
+		float mean[4], axis[4], endpoints[2][4];
+		ComputePrincipalAxis<4>(points, BLOCK_PIXEL_COUNT, mean, axis);
+		ComputeAxisEndpoints<4>(points, BLOCK_PIXEL_COUNT, mean, axis, endpoints[0], endpoints[1]);
+
+		BC7Mode6Block best;
+		for (int iteration = 0; iteration < REFINE_ITERATIONS && best.mError > 0; ++iteration) {
+			int previousError = best.mError;
+			EvaluateBC7Endpoints(points, endpoints[0], endpoints[1], best);
+			if (iteration > 0 && best.mError >= previousError) break;
+
+			float weights[BLOCK_PIXEL_COUNT];
+			for (uint32_t p = 0; p < BLOCK_PIXEL_COUNT; ++p) {
+				weights[p] = 1.0f - BC7_WEIGHTS_4[best.mIndices[p]] / 64.0f;
+			}
+			if (!FitEndpoints<4>(points, weights, BLOCK_PIXEL_COUNT, endpoints[0], endpoints[1])) break;
+		}
+
+		// The most significant bit of the first index is implicit, so it must be 0
+		if (best.mIndices[0] & 8) {
+			std::swap(best.mEndpoints[0], best.mEndpoints[1]);
+			std::swap(best.mPBits[0], best.mPBits[1]);
+			for (uint8_t& index : best.mIndices) index = static_cast<uint8_t>(15 - index);
+		}
+
+		BlockBitWriter writer(output);
+		writer.Write(1u << 6, 7); // Mode 6
+		for (int c = 0; c < 4; ++c) {
+			writer.Write(static_cast<uint32_t>(best.mEndpoints[0][c]), 7);
+			writer.Write(static_cast<uint32_t>(best.mEndpoints[1][c]), 7);
+		}
+		writer.Write(static_cast<uint32_t>(best.mPBits[0]), 1);
+		writer.Write(static_cast<uint32_t>(best.mPBits[1]), 1);
+		writer.Write(best.mIndices[0], 3);
+		for (uint32_t p = 1; p < BLOCK_PIXEL_COUNT; ++p) {
+			writer.Write(best.mIndices[p], 4);
+		}
+	}
+
+	bool BlockCompression::DecodeBC7Block(const uint8_t* input, uint8_t* pixels)
+	{
+		if ((input[0] & 0x7F) != 0x40) {
+			for (uint32_t p = 0; p < BLOCK_PIXEL_COUNT; ++p) {
+				pixels[p * 4 + 0] = 255;
+				pixels[p * 4 + 1] = 0;
+				pixels[p * 4 + 2] = 255;
+				pixels[p * 4 + 3] = 255;
+			}
+			return false;
+		}
+
+		BlockBitReader reader(input);
+		reader.Read(7);
+
+		BC7Mode6Block block;
+		for (int c = 0; c < 4; ++c) {
+			block.mEndpoints[0][c] = static_cast<int>(reader.Read(7));
+			block.mEndpoints[1][c] = static_cast<int>(reader.Read(7));
+		}
+		block.mPBits[0] = static_cast<int>(reader.Read(1));
+		block.mPBits[1] = static_cast<int>(reader.Read(1));
+
+		int endpoints[2][4];
+		ExpandBC7Endpoints(block, endpoints);
+
+		for (uint32_t p = 0; p < BLOCK_PIXEL_COUNT; ++p) {
+			int weight = BC7_WEIGHTS_4[reader.Read(p == 0 ? 3 : 4)];
+			for (int c = 0; c < 4; ++c) {
+				pixels[p * 4 + c] = static_cast<uint8_t>(InterpolateBC7(endpoints[0][c], endpoints[1][c], weight));
+			}
+		}
+		return true;
+	}
+}
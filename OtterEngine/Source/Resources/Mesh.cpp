@@ -8,42 +8,460 @@
 #define RAPIDOBJ_IMPLEMENTATION
 #include "rapidobj.hpp"
 
-#include "Resources/Mesh.h"
+#include "Core/JobSystem.h"
+#include "Utils/Hash.h"
+#include "Utils/PathFormat.h"
+#include "Resources/MeshFormat.h"
+#include "Resources/ObjIndexDedupTable.h"
 
-// Template specialization for hashing glm vectors
-namespace std {
-	template<>
-	struct hash<glm::vec3> {
-		size_t operator()(const glm::vec3& vec) const noexcept {
-			return (
-				(hash<float>()(vec.x) ^
-					(hash<float>()(vec.y) << 1)) >> 1) ^
-				(hash<float>()(vec.z) << 1);
-		}
-	};
-
-	template<>
-	struct hash<glm::vec2> {
-		size_t operator()(const glm::vec2& vec) const noexcept {
-			return (
-				(hash<float>()(vec.x) ^
-					(hash<float>()(vec.y) << 1)) >> 1);
-		}
-	};
-}
+#include "Resources/Mesh.h"
 
 namespace OtterEngine {
-	struct VertexHash {
-		size_t operator()(const Vertex& vertex) const {
-			return (
-				(std::hash<glm::vec3>()(vertex.mPosition) ^
-					(std::hash<glm::vec3>()(vertex.mNormal) << 1)) >> 1) ^
-				(std::hash<glm::vec2>()(vertex.mTexCoord) << 1) ^
-				(std::hash<glm::vec3>()(vertex.mColor) << 1);
+	namespace {
+		Vertex MakeVertex(const rapidobj::Attributes& attributes, const rapidobj::Index& index) {
+			Vertex vertex{};
+
+			// Position
+			vertex.mPosition = {
+				attributes.positions[3 * index.position_index + 0],
+				attributes.positions[3 * index.position_index + 1],
+				attributes.positions[3 * index.position_index + 2]
+			};
+
+			// Normal
+			if (index.normal_index >= 0) {
+				vertex.mNormal = {
+					attributes.normals[3 * index.normal_index + 0],
+					attributes.normals[3 * index.normal_index + 1],
+					attributes.normals[3 * index.normal_index + 2]
+				};
+			}
+			else {
+				vertex.mNormal = { 0.0f, 0.0f, 0.0f };
+			}
+
+			// Texture coordinates
+			if (index.texcoord_index >= 0) {
+				vertex.mTexCoord = {
+					attributes.texcoords[2 * index.texcoord_index + 0],
+					1.0f - attributes.texcoords[2 * index.texcoord_index + 1]  // Flip V coord (Vulkan requirement)
+				};
+			}
+			else {
+				vertex.mTexCoord = { 0.0f, 0.0f };
+			}
+
+			// Colors of the "v x y z r g b" extension, white without it
+			if (!attributes.colors.empty()) {
+				vertex.mColor = {
+					attributes.colors[3 * index.position_index + 0],
+					attributes.colors[3 * index.position_index + 1],
+					attributes.colors[3 * index.position_index + 2]
+				};
+			}
+			else {
+				vertex.mColor = { 1.0f, 1.0f, 1.0f };
+			}
+
+			return vertex;
+		}
+
+		// Largest vertex count 16-bit indices can address from a chunk's first vertex
+		constexpr uint32_t MAX_CHUNK_VERTICES = 65536;
+
+		struct ChunkedGeometry {
+			std::vector<Vertex> mVertices;
+			std::vector<uint32_t> mIndices;
+			std::vector<MeshChunk> mChunks;
+		};
+
+		/// <summary>
+		/// Cuts the triangle list, in order, in runs using at most MAX_CHUNK_VERTICES vertices, appended to the result.
+		/// Each run gets its own copy of its vertices in order of first use, so only vertices used on both sides of a
+		/// cut are duplicated.
+		/// </summary>
+		void SplitIntoChunks(std::span<const Vertex> vertices, std::span<const uint32_t> indices, ChunkedGeometry& result) {
+			constexpr uint32_t NOT_IN_CHUNK = UINT32_MAX;
+
+			result.mIndices.reserve(result.mIndices.size() + indices.size());
+
+			std::vector<uint32_t> chunkIndices(vertices.size(), NOT_IN_CHUNK);
+			std::vector<uint32_t> chunkVertices;
+			chunkVertices.reserve(MAX_CHUNK_VERTICES);
+			MeshChunk chunk;
+			chunk.mFirstIndex = static_cast<uint32_t>(result.mIndices.size());
+			chunk.mFirstVertex = static_cast<uint32_t>(result.mVertices.size());
+
+			auto closeChunk = [&]() {
+				for (uint32_t vertex : chunkVertices) {
+					result.mVertices.push_back(vertices[vertex]);
+					chunkIndices[vertex] = NOT_IN_CHUNK;
+				}
+				chunk.mVertexCount = static_cast<uint32_t>(chunkVertices.size());
+				chunk.mIndexCount = static_cast<uint32_t>(result.mIndices.size()) - chunk.mFirstIndex;
+				result.mChunks.push_back(chunk);
+
+				chunkVertices.clear();
+				chunk.mFirstIndex = static_cast<uint32_t>(result.mIndices.size());
+				chunk.mFirstVertex = static_cast<uint32_t>(result.mVertices.size());
+			};
+
+			for (size_t triangle = 0; triangle + 2 < indices.size(); triangle += 3) {
+				uint32_t newVertices = 0;
+				for (size_t corner = 0; corner < 3; ++corner) {
+					newVertices += chunkIndices[indices[triangle + corner]] == NOT_IN_CHUNK ? 1 : 0;
+				}
+				if (chunkVertices.size() + newVertices > MAX_CHUNK_VERTICES) {
+					closeChunk();
+				}
+
+				for (size_t corner = 0; corner < 3; ++corner) {
+					const uint32_t vertex = indices[triangle + corner];
+					if (chunkIndices[vertex] == NOT_IN_CHUNK) {
+						chunkIndices[vertex] = static_cast<uint32_t>(chunkVertices.size());
+						chunkVertices.push_back(vertex);
+					}
+					result.mIndices.push_back(chunkIndices[vertex]);
+				}
+			}
+
+			if (!chunkVertices.empty()) {
+				closeChunk();
+			}
+		}
+
+		/// <summary>
+		/// Appends the whole mesh as one chunk
+		/// </summary>
+		void AppendChunk(std::span<const Vertex> vertices, std::span<const uint32_t> indices, ChunkedGeometry& result) {
+			result.mChunks.push_back({
+				static_cast<uint32_t>(result.mIndices.size()), static_cast<uint32_t>(indices.size()),
+				static_cast<uint32_t>(result.mVertices.size()), static_cast<uint32_t>(vertices.size()) });
+			result.mVertices.insert(result.mVertices.end(), vertices.begin(), vertices.end());
+			result.mIndices.insert(result.mIndices.end(), indices.begin(), indices.end());
 		}
-	};
+
+		template<typename T>
+		std::vector<std::byte> PackIndices(std::span<const uint32_t> indices) {
+			std::vector<std::byte> data(indices.size() * sizeof(T));
+			for (size_t i = 0; i < indices.size(); ++i) {
+				const T index = static_cast<T>(indices[i]);
+				memcpy(data.data() + i * sizeof(T), &index, sizeof(T));
+			}
+			return data;
+		}
+	}
+
+	Mesh::Mesh(std::span<const Vertex> vertices, std::span<const uint32_t> indices) :
+		Mesh(std::vector<MeshLodGeometry>{ { { vertices.begin(), vertices.end() }, { indices.begin(), indices.end() }, 0.0f } }) {
+	}
+
+	Mesh::Mesh(std::span<const MeshLodGeometry> lods) {
+		if (lods.empty()) {
+			return;
+		}
+		const MeshLodGeometry& base = lods[0];
+		mImportSettingsHash = HashImportSettings(sImportSettings);
+
+		// Levels only keep base vertices, the format chosen for the base fits them all
+		mVertexFormat = VertexFormat::Choose(base.mVertices, sImportSettings.mQuantization);
+
+		// Bounds of the full precision positions, quantization moves them by less than its error bound
+		if (!base.mVertices.empty()) {
+			mBounds.mMin = mBounds.mMax = base.mVertices[0].mPosition;
+			for (const Vertex& vertex : base.mVertices) {
+				mBounds.mMin = glm::min(mBounds.mMin, vertex.mPosition);
+				mBounds.mMax = glm::max(mBounds.mMax, vertex.mPosition);
+			}
+		}
+
+		// The base mesh decides the index type, coarser levels have fewer vertices and follow it
+		ChunkedGeometry packed;
+		bool isSplit = false;
+		if (base.mVertices.size() > MAX_CHUNK_VERTICES && sImportSettings.mSplitLargeMeshes) {
+			SplitIntoChunks(base.mVertices, base.mIndices, packed);
+
+			const size_t duplicatedBytes = packed.mVertices.size() > base.mVertices.size()
+				? (packed.mVertices.size() - base.mVertices.size()) * mVertexFormat.GetStride()
+				: 0;
+			const size_t savedBytes = base.mIndices.size() * (sizeof(uint32_t) - sizeof(uint16_t));
+			if (duplicatedBytes < savedBytes) {
+				OTTER_CORE_LOG("[MESH] Split {} vertices in {} chunks with 16-bit indices, duplicating {} vertices to save {} bytes",
+					base.mVertices.size(), packed.mChunks.size(), packed.mVertices.size() - std::min(packed.mVertices.size(), base.mVertices.size()),
+					savedBytes - duplicatedBytes);
+				isSplit = true;
+			}
+			else {
+				packed = ChunkedGeometry();
+			}
+		}
+		mIndexType = (base.mVertices.size() <= MAX_CHUNK_VERTICES || isSplit) ? IndexType::UInt16 : IndexType::UInt32;
+
+		for (size_t level = 0; level < lods.size(); ++level) {
+			const MeshLodGeometry& lod = lods[level];
+
+			// The base mesh was already split while choosing the index type
+			const bool isPacked = level == 0 && isSplit;
+			const uint32_t firstChunk = isPacked ? 0 : static_cast<uint32_t>(packed.mChunks.size());
+
+			if (!isPacked) {
+				if (mIndexType == IndexType::UInt16 && lod.mVertices.size() > MAX_CHUNK_VERTICES) {
+					SplitIntoChunks(lod.mVertices, lod.mIndices, packed);
+				}
+				else {
+					AppendChunk(lod.mVertices, lod.mIndices, packed);
+				}
+			}
+
+			mLods.push_back({ firstChunk, static_cast<uint32_t>(packed.mChunks.size()) - firstChunk, lod.mError });
+		}
+
+		// Chunk indices are already relative to their first vertex, as meshlet vertices have to be
+		if (sImportSettings.mBuildMeshlets) {
+			for (MeshChunk& chunk : packed.mChunks) {
+				chunk.mFirstMeshlet = static_cast<uint32_t>(mMeshletGeometry.mMeshlets.size());
+				chunk.mMeshletCount = MeshletBuilder::Build(
+					std::span<const Vertex>(packed.mVertices).subspan(chunk.mFirstVertex, chunk.mVertexCount),
+					std::span<const uint32_t>(packed.mIndices).subspan(chunk.mFirstIndex, chunk.mIndexCount),
+					sImportSettings.mMeshlets, mMeshletGeometry);
+			}
+			OTTER_CORE_LOG("[MESH] Partitioned {} triangles in {} meshlets",
+				packed.mIndices.size() / 3, mMeshletGeometry.mMeshlets.size());
+		}
+
+		mVertexData = EncodeVertices(packed.mVertices, mVertexFormat);
+		mIndexData = mIndexType == IndexType::UInt16 ? PackIndices<uint16_t>(packed.mIndices) : PackIndices<uint32_t>(packed.mIndices);
+		mChunks = std::move(packed.mChunks);
+
+		mVertexView = mVertexData;
+		mIndexView = mIndexData;
+		mChunkView = mChunks;
+		mLodView = mLods;
+		mMeshletView = mMeshletGeometry.mMeshlets;
+		mMeshletVertexView = mMeshletGeometry.mVertices;
+		mMeshletTriangleView = mMeshletGeometry.mTriangles;
+	}
+
+	Mesh::Mesh(std::unique_ptr<MappedFile> mappedFile, const VertexFormat& vertexFormat, std::span<const std::byte> vertexData,
+		IndexType indexType, std::span<const std::byte> indexData, std::span<const MeshChunk> chunks, std::span<const MeshLod> lods,
+		std::span<const Meshlet> meshlets, std::span<const uint32_t> meshletVertices, std::span<const uint8_t> meshletTriangles,
+		const MeshBounds& bounds)
+		: mVertexFormat(vertexFormat), mIndexType(indexType), mMappedFile(std::move(mappedFile)),
+		mVertexView(vertexData), mIndexView(indexData), mChunkView(chunks), mLodView(lods),
+		mMeshletView(meshlets), mMeshletVertexView(meshletVertices), mMeshletTriangleView(meshletTriangles), mBounds(bounds) {
+	}
+
+	std::vector<uint32_t> Mesh::DecodeIndices(uint32_t lod) const {
+		std::vector<uint32_t> indices;
+		if (lod >= mLodView.size()) {
+			return indices;
+		}
+
+		for (const MeshChunk& chunk : mChunkView.subspan(mLodView[lod].mFirstChunk, mLodView[lod].mChunkCount)) {
+			for (uint32_t i = chunk.mFirstIndex; i < chunk.mFirstIndex + chunk.mIndexCount; ++i) {
+				if (mIndexType == IndexType::UInt16) {
+					uint16_t index;
+					memcpy(&index, mIndexView.data() + i * sizeof(uint16_t), sizeof(index));
+					indices.push_back(chunk.mFirstVertex + index);
+				}
+				else {
+					uint32_t index;
+					memcpy(&index, mIndexView.data() + i * sizeof(uint32_t), sizeof(index));
+					indices.push_back(chunk.mFirstVertex + index);
+				}
+			}
+		}
+		return indices;
+	}
+
+	uint64_t Mesh::HashImportSettings(const MeshImportSettings& settings) {
+		uint64_t hash = FNV_OFFSET_BASIS;
+
+		// Field by field, padding bytes between them are not initialized
+		hash = HashValue(settings.mOptimize, hash);
+		hash = HashValue(settings.mOptimization.mCacheSize, hash);
+		hash = HashValue(settings.mOptimization.mOverdrawThreshold, hash);
+
+		hash = HashValue(settings.mQuantization.mEnabled, hash);
+		hash = HashValue(settings.mQuantization.mMaxPositionError, hash);
+		hash = HashValue(settings.mQuantization.mMaxNormalError, hash);
+		hash = HashValue(settings.mQuantization.mMaxTexCoordError, hash);
+
+		hash = HashValue(settings.mGenerateLods, hash);
+		hash = HashValue(MeshSimplifier::VERSION, hash);
+		const std::vector<float>& ratios = settings.mSimplification.mTriangleRatios;
+		hash = HashValue(ratios.size(), hash);
+		hash = HashBytes(ratios.data(), ratios.size() * sizeof(float), hash);
+		hash = HashValue(settings.mSimplification.mMaxError, hash);
+		hash = HashValue(settings.mSimplification.mNormalWeight, hash);
+		hash = HashValue(settings.mSimplification.mTexCoordWeight, hash);
+		hash = HashValue(settings.mSimplification.mMinReduction, hash);
+
+		hash = HashValue(settings.mSplitLargeMeshes, hash);
+
+		hash = HashValue(settings.mBuildMeshlets, hash);
+		hash = HashValue(settings.mMeshlets.mMaxVertices, hash);
+		hash = HashValue(settings.mMeshlets.mMaxTriangles, hash);
+		return hash;
+	}
 
 	std::shared_ptr<Mesh> Mesh::LoadFromFile(const std::filesystem::path& path) {
+		if (path.extension() == COOKED_MESH_EXTENSION) {
+			// Without its source, a cooked mesh is used even if it was imported with other settings
+			return LoadCooked(path, false);
+		}
+
+		if (path.extension() == ".obj") {
+			// Prefer a cooked copy sitting next to the source, as long as it is not stale
+			std::filesystem::path cookedPath = path;
+			cookedPath.replace_extension(COOKED_MESH_EXTENSION);
+
+			std::error_code cookedError, sourceError;
+			auto cookedTime = std::filesystem::last_write_time(cookedPath, cookedError);
+			auto sourceTime = std::filesystem::last_write_time(path, sourceError);
+			if (!cookedError && (sourceError || cookedTime >= sourceTime)) {
+				if (auto cooked = LoadCooked(cookedPath, true)) {
+					return cooked;
+				}
+				OTTER_CORE_WARNING("[MESH] Falling back to source mesh '{}'", path);
+			}
+
+			return ImportObj(path);
+		}
+
+		OTTER_CORE_WARNING("[MESH] Unsupported mesh format: {}", path);
+		return nullptr;
+	}
+
+	std::shared_ptr<Mesh> Mesh::LoadCooked(const std::filesystem::path& path, bool requireCurrentSettings) {
+		auto startTime = std::chrono::high_resolution_clock::now();
+
+		std::unique_ptr<MappedFile> file = MappedFile::Open(path);
+		if (!file) {
+			return nullptr;
+		}
+
+		if (file->GetSize() < sizeof(CookedMeshHeader)) {
+			OTTER_CORE_ERROR("[MESH] Cooked mesh '{}' is truncated", path);
+			return nullptr;
+		}
+
+		CookedMeshHeader header;
+		memcpy(&header, file->GetData(), sizeof(header));
+
+		if (header.mMagic != COOKED_MESH_MAGIC || header.mVersion != COOKED_MESH_VERSION) {
+			OTTER_CORE_ERROR("[MESH] '{}' is not a cooked mesh of version {} (found magic 0x{:x}, version {})",
+				path, COOKED_MESH_VERSION, header.mMagic, header.mVersion);
+			return nullptr;
+		}
+
+		const uint64_t settingsHash = HashImportSettings(sImportSettings);
+		if (header.mImportSettingsHash != settingsHash) {
+			if (requireCurrentSettings) {
+				OTTER_CORE_WARNING("[MESH] Cooked mesh '{}' was imported with other settings than the current ones, re-cook it", path);
+				return nullptr;
+			}
+			OTTER_CORE_WARNING("[MESH] Cooked mesh '{}' was imported with other settings than the current ones", path);
+		}
+
+		VertexFormat vertexFormat;
+		if (!VertexFormat::FromKey(header.mVertexFormat, vertexFormat) || header.mVertexStride != vertexFormat.GetStride() ||
+			(header.mIndexStride != sizeof(uint16_t) && header.mIndexStride != sizeof(uint32_t))) {
+			OTTER_CORE_ERROR("[MESH] Cooked mesh '{}' was built with a different vertex layout, re-cook it", path);
+			return nullptr;
+		}
+		const IndexType indexType = header.mIndexStride == sizeof(uint16_t) ? IndexType::UInt16 : IndexType::UInt32;
+
+		const uint64_t fileSize = file->GetSize();
+		const uint64_t vertexBytes = header.mVertexCount * header.mVertexStride;
+		const uint64_t indexBytes = header.mIndexCount * header.mIndexStride;
+		const uint64_t chunkBytes = header.mChunkCount * sizeof(MeshChunk);
+		const uint64_t lodBytes = header.mLodCount * sizeof(MeshLod);
+		const uint64_t meshletBytes = header.mMeshletCount * sizeof(Meshlet);
+		const uint64_t meshletVertexBytes = header.mMeshletVertexCount * sizeof(uint32_t);
+		const uint64_t meshletTriangleBytes = header.mMeshletTriangleCount * sizeof(uint8_t);
+		if (header.mIndexOffset % header.mIndexStride != 0 || header.mChunkOffset % alignof(MeshChunk) != 0 ||
+			header.mLodOffset % alignof(MeshLod) != 0 || header.mMeshletOffset % alignof(Meshlet) != 0 ||
+			header.mMeshletVertexOffset % alignof(uint32_t) != 0 ||
+			header.mVertexOffset > fileSize || vertexBytes > fileSize - header.mVertexOffset ||
+			header.mIndexOffset > fileSize || indexBytes > fileSize - header.mIndexOffset ||
+			header.mChunkOffset > fileSize || chunkBytes > fileSize - header.mChunkOffset ||
+			header.mLodOffset > fileSize || lodBytes > fileSize - header.mLodOffset ||
+			header.mMeshletOffset > fileSize || meshletBytes > fileSize - header.mMeshletOffset ||
+			header.mMeshletVertexOffset > fileSize || meshletVertexBytes > fileSize - header.mMeshletVertexOffset ||
+			header.mMeshletTriangleOffset > fileSize || meshletTriangleBytes > fileSize - header.mMeshletTriangleOffset) {
+			OTTER_CORE_ERROR("[MESH] Cooked mesh '{}' has corrupted block offsets", path);
+			return nullptr;
+		}
+
+		std::span<const std::byte> vertexData(
+			file->GetData() + header.mVertexOffset,
+			static_cast<size_t>(vertexBytes));
+		std::span<const std::byte> indexData(
+			file->GetData() + header.mIndexOffset,
+			static_cast<size_t>(indexBytes));
+		std::span<const MeshChunk> chunks(
+			reinterpret_cast<const MeshChunk*>(file->GetData() + header.mChunkOffset),
+			static_cast<size_t>(header.mChunkCount));
+		std::span<const MeshLod> lods(
+			reinterpret_cast<const MeshLod*>(file->GetData() + header.mLodOffset),
+			static_cast<size_t>(header.mLodCount));
+		std::span<const Meshlet> meshlets(
+			reinterpret_cast<const Meshlet*>(file->GetData() + header.mMeshletOffset),
+			static_cast<size_t>(header.mMeshletCount));
+		std::span<const uint32_t> meshletVertices(
+			reinterpret_cast<const uint32_t*>(file->GetData() + header.mMeshletVertexOffset),
+			static_cast<size_t>(header.mMeshletVertexCount));
+		std::span<const uint8_t> meshletTriangles(
+			reinterpret_cast<const uint8_t*>(file->GetData() + header.mMeshletTriangleOffset),
+			static_cast<size_t>(header.mMeshletTriangleCount));
+
+		// Draws trust the chunks, a corrupted one would read out of the mesh's buffers
+		for (const MeshChunk& chunk : chunks) {
+			if (uint64_t(chunk.mFirstVertex) + chunk.mVertexCount > header.mVertexCount ||
+				uint64_t(chunk.mFirstIndex) + chunk.mIndexCount > header.mIndexCount ||
+				(indexType == IndexType::UInt16 && chunk.mVertexCount > MAX_CHUNK_VERTICES) ||
+				uint64_t(chunk.mFirstMeshlet) + chunk.mMeshletCount > header.mMeshletCount) {
+				OTTER_CORE_ERROR("[MESH] Cooked mesh '{}' has corrupted chunks", path);
+				return nullptr;
+			}
+		}
+		for (const MeshLod& lod : lods) {
+			if (uint64_t(lod.mFirstChunk) + lod.mChunkCount > header.mChunkCount) {
+				OTTER_CORE_ERROR("[MESH] Cooked mesh '{}' has corrupted levels of detail", path);
+				return nullptr;
+			}
+		}
+		for (const Meshlet& meshlet : meshlets) {
+			if (uint64_t(meshlet.mVertexOffset) + meshlet.mVertexCount > header.mMeshletVertexCount ||
+				uint64_t(meshlet.mTriangleOffset) + uint64_t(meshlet.mTriangleCount) * 3 > header.mMeshletTriangleCount) {
+				OTTER_CORE_ERROR("[MESH] Cooked mesh '{}' has corrupted meshlets", path);
+				return nullptr;
+			}
+		}
+
+		MeshBounds bounds;
+		bounds.mMin = { header.mBoundsMin[0], header.mBoundsMin[1], header.mBoundsMin[2] };
+		bounds.mMax = { header.mBoundsMax[0], header.mBoundsMax[1], header.mBoundsMax[2] };
+
+		auto mesh = std::make_shared<Mesh>(std::move(file), vertexFormat, vertexData, indexType, indexData, chunks, lods,
+			meshlets, meshletVertices, meshletTriangles, bounds);
+		mesh->mImportSettingsHash = header.mImportSettingsHash;
+
+		float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+		OTTER_CORE_LOG(
+			"[MESH] Mapped cooked mesh: {} vertices, {} indices from {} in {:.2f} ms",
+			mesh->GetVertexCount(),
+			mesh->GetIndexCount(),
+			path,
+			elapsedMs
+		);
+
+		return mesh;
+	}
+
+	std::shared_ptr<Mesh> Mesh::ImportObj(const std::filesystem::path& path) {
+		auto startTime = std::chrono::high_resolution_clock::now();
 		std::string pathStr = path.string();
 
 		if (path.extension() == ".obj") {
@@ -65,63 +483,113 @@ namespace OtterEngine {
 				OTTER_CORE_CRITICAL("[MESH] Failed to triangulate mesh {}", pathStr);
 			}
 
-			std::vector<Vertex> vertices;
-			std::vector<uint32_t> indices;
-			std::unordered_map<Vertex, uint32_t, VertexHash> uniqueVertices;
-
-			for (const auto& shape : result.shapes) {
-				for (const auto& index : shape.mesh.indices) {
-					Vertex vertex{};
-
-					// Position
-					vertex.mPosition = {
-						result.attributes.positions[3 * index.position_index + 0],
-						result.attributes.positions[3 * index.position_index + 1],
-						result.attributes.positions[3 * index.position_index + 2]
-					};
-
-					// Normal
-					if (index.normal_index >= 0) {
-						vertex.mNormal = {
-							result.attributes.normals[3 * index.normal_index + 0],
-							result.attributes.normals[3 * index.normal_index + 1],
-							result.attributes.normals[3 * index.normal_index + 2]
-						};
-					}
-					else {
-						vertex.mNormal = { 0.0f, 0.0f, 0.0f };
-					}
+			const auto& shapes = result.shapes;
+			const uint32_t importThreads = sImportSettings.mImportThreads;
 
-					// Texture coordinates
-					if (index.texcoord_index >= 0) {
-						vertex.mTexCoord = {
-							result.attributes.texcoords[2 * index.texcoord_index + 0],
-							1.0f - result.attributes.texcoords[2 * index.texcoord_index + 1]  // Flip V coord (Vulkan requirement)
-						};
-					}
-					else {
-						vertex.mTexCoord = { 0.0f, 0.0f };
-					}
+			// Each shape writes its corners at a fixed offset of the shared index array
+			std::vector<size_t> shapeIndexOffsets(shapes.size() + 1, 0);
+			for (size_t shapeIndex = 0; shapeIndex < shapes.size(); ++shapeIndex) {
+				shapeIndexOffsets[shapeIndex + 1] = shapeIndexOffsets[shapeIndex] + shapes[shapeIndex].mesh.indices.size();
+			}
 
-					vertex.mColor = { 1.0f, 1.0f, 1.0f };
+			std::vector<uint32_t> indices(shapeIndexOffsets.back());
+			std::vector<std::vector<rapidobj::Index>> shapeUniqueKeys(shapes.size());
+			std::vector<std::pair<uint32_t, uint32_t>> shapePositionRanges(shapes.size(), { UINT32_MAX, 0 });
 
-					if (uniqueVertices.count(vertex) == 0) {
-						uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-						vertices.push_back(vertex);
+			// Deduplicate each shape on its own on the worker pool. Corners are keyed on their
+			// OBJ index triple and the index array receives shape-local vertex ids for now.
+			JobSystem::ParallelFor(shapes.size(), [&](size_t shapeIndex) {
+				const auto& shapeIndices = shapes[shapeIndex].mesh.indices;
+				uint32_t* localIndices = indices.data() + shapeIndexOffsets[shapeIndex];
+
+				auto& [positionBegin, positionEnd] = shapePositionRanges[shapeIndex];
+				for (const auto& index : shapeIndices) {
+					positionBegin = std::min(positionBegin, static_cast<uint32_t>(index.position_index));
+					positionEnd = std::max(positionEnd, static_cast<uint32_t>(index.position_index) + 1);
+				}
+
+				ObjIndexDedupTable<rapidobj::Index> shapeTable(positionBegin, positionEnd, shapeIndices.size());
+				for (size_t corner = 0; corner < shapeIndices.size(); ++corner) {
+					localIndices[corner] = shapeTable.FindOrInsert(shapeIndices[corner]);
+				}
+				shapeUniqueKeys[shapeIndex] = shapeTable.TakeUniqueKeys();
+			}, importThreads);
+
+			// Merge in shape order through a global table, which assigns ids by first occurrence
+			// exactly like a serial import would, whatever the number of threads
+			std::vector<rapidobj::Index> uniqueKeys;
+			std::vector<std::vector<uint32_t>> shapeRemaps(shapes.size());
+
+			if (shapes.size() == 1) {
+				uniqueKeys = std::move(shapeUniqueKeys[0]);
+			}
+			else {
+				size_t localKeyCount = 0;
+				uint32_t positionBegin = UINT32_MAX;
+				uint32_t positionEnd = 0;
+				for (size_t shapeIndex = 0; shapeIndex < shapes.size(); ++shapeIndex) {
+					localKeyCount += shapeUniqueKeys[shapeIndex].size();
+					positionBegin = std::min(positionBegin, shapePositionRanges[shapeIndex].first);
+					positionEnd = std::max(positionEnd, shapePositionRanges[shapeIndex].second);
+				}
+
+				ObjIndexDedupTable<rapidobj::Index> globalTable(positionBegin, positionEnd, localKeyCount);
+				for (size_t shapeIndex = 0; shapeIndex < shapes.size(); ++shapeIndex) {
+					auto& remap = shapeRemaps[shapeIndex];
+					remap.reserve(shapeUniqueKeys[shapeIndex].size());
+					for (const auto& key : shapeUniqueKeys[shapeIndex]) {
+						remap.push_back(globalTable.FindOrInsert(key));
 					}
+					shapeUniqueKeys[shapeIndex] = {};
+				}
+				uniqueKeys = globalTable.TakeUniqueKeys();
 
-					indices.push_back(uniqueVertices[vertex]);
+				JobSystem::ParallelFor(shapes.size(), [&](size_t shapeIndex) {
+					const auto& remap = shapeRemaps[shapeIndex];
+					for (size_t i = shapeIndexOffsets[shapeIndex]; i < shapeIndexOffsets[shapeIndex + 1]; ++i) {
+						indices[i] = remap[indices[i]];
+					}
+				}, importThreads);
+			}
+
+			// Only unique keys are turned into full vertices
+			static constexpr size_t VERTEX_BATCH_SIZE = 16384;
+			std::vector<Vertex> vertices(uniqueKeys.size());
+			JobSystem::ParallelFor((uniqueKeys.size() + VERTEX_BATCH_SIZE - 1) / VERTEX_BATCH_SIZE, [&](size_t batch) {
+				size_t end = std::min(uniqueKeys.size(), (batch + 1) * VERTEX_BATCH_SIZE);
+				for (size_t i = batch * VERTEX_BATCH_SIZE; i < end; ++i) {
+					vertices[i] = MakeVertex(result.attributes, uniqueKeys[i]);
 				}
+			}, importThreads);
+
+			if (sImportSettings.mOptimize) {
+				MeshOptimizer::Optimize(vertices, indices, sImportSettings.mOptimization);
 			}
 
+			float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
 			OTTER_CORE_LOG(
-				"[MESH] Loaded: {} vertices, {} indices from {}",
+				"[MESH] Loaded: {} vertices, {} indices from {} in {:.2f} ms",
 				vertices.size(),
 				indices.size(),
-				path.string()
+				path.string(),
+				elapsedMs
 			);
 
-			return std::make_shared<Mesh>(std::move(vertices), std::move(indices));
+			std::vector<MeshLodGeometry> lods;
+			if (sImportSettings.mGenerateLods) {
+				lods = MeshSimplifier::BuildLodChain(vertices, indices, sImportSettings.mSimplification);
+				if (sImportSettings.mOptimize) {
+					for (MeshLodGeometry& lod : lods) {
+						MeshOptimizer::Optimize(lod.mVertices, lod.mIndices, sImportSettings.mOptimization);
+					}
+				}
+			}
+			lods.insert(lods.begin(), MeshLodGeometry{ std::move(vertices), std::move(indices), 0.0f });
+
+			auto mesh = std::make_shared<Mesh>(lods);
+			OTTER_CORE_LOG("[MESH] Packed vertices of {} in {} bytes each instead of {} (format {:#010x})",
+				path.string(), mesh->GetVertexStride(), sizeof(Vertex), mesh->GetVertexFormat().GetKey());
+			return mesh;
 		}
 		return nullptr;
 	}
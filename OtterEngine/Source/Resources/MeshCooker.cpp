@@ -0,0 +1,122 @@
+#include "OtterPCH.h"
+
+#include <fstream>
+
+#include "Utils/PathFormat.h"
+#include "Resources/MeshFormat.h"
+
+#include "Resources/MeshCooker.h"
+
+namespace OtterEngine {
+	namespace {
+		void WritePadding(std::ofstream& stream, uint64_t alignedOffset) {
+			static constexpr char zeros[COOKED_MESH_BLOCK_ALIGNMENT] = {};
+			uint64_t current = static_cast<uint64_t>(stream.tellp());
+			stream.write(zeros, static_cast<std::streamsize>(alignedOffset - current));
+		}
+	}
+
+	bool MeshCooker::Cook(const std::filesystem::path& source, std::filesystem::path destination)
+	{
+		if (destination.empty()) {
+			destination = source;
+			destination.replace_extension(COOKED_MESH_EXTENSION);
+		}
+
+		auto mesh = Mesh::ImportObj(source);
+		if (!mesh || !mesh->IsValid()) {
+			OTTER_CORE_ERROR("[MESH COOKER] Failed to import '{}'", source);
+			return false;
+		}
+
+		return Write(*mesh, destination);
+	}
+
+	bool MeshCooker::Write(const Mesh& mesh, const std::filesystem::path& destination)
+	{
+		CookedMeshHeader header;
+		header.mVertexStride = mesh.GetVertexStride();
+		header.mVertexFormat = mesh.GetVertexFormat().GetKey();
+		header.mIndexStride = mesh.GetIndexStride();
+		header.mVertexCount = mesh.GetVertexCount();
+		header.mIndexCount = mesh.GetIndexCount();
+		header.mImportSettingsHash = mesh.GetImportSettingsHash();
+		header.mVertexOffset = AlignCookedOffset(sizeof(CookedMeshHeader));
+		header.mIndexOffset = AlignCookedOffset(header.mVertexOffset + mesh.GetVertexBufferSize());
+		header.mChunkCount = mesh.GetChunks().size();
+		header.mChunkOffset = AlignCookedOffset(header.mIndexOffset + mesh.GetIndexBufferSize());
+		header.mLodCount = mesh.GetLods().size();
+		header.mLodOffset = AlignCookedOffset(header.mChunkOffset + mesh.GetChunks().size_bytes());
+		header.mMeshletCount = mesh.GetMeshlets().size();
+		header.mMeshletOffset = AlignCookedOffset(header.mLodOffset + mesh.GetLods().size_bytes());
+		header.mMeshletVertexCount = mesh.GetMeshletVertices().size();
+		header.mMeshletVertexOffset = AlignCookedOffset(header.mMeshletOffset + mesh.GetMeshlets().size_bytes());
+		header.mMeshletTriangleCount = mesh.GetMeshletTriangles().size();
+		header.mMeshletTriangleOffset = AlignCookedOffset(header.mMeshletVertexOffset + mesh.GetMeshletVertices().size_bytes());
+
+		const MeshBounds& bounds = mesh.GetBounds();
+		for (int axis = 0; axis < 3; ++axis) {
+			header.mBoundsMin[axis] = bounds.mMin[axis];
+			header.mBoundsMax[axis] = bounds.mMax[axis];
+		}
+
+		// Write next to the destination first, so readers never map a half-written file
+		std::filesystem::path tempPath = destination;
+		tempPath += ".tmp";
+
+		{
+			std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+			if (!stream.is_open()) {
+				OTTER_CORE_ERROR("[MESH COOKER] Failed to open '{}' for writing", tempPath);
+				return false;
+			}
+
+			stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+			WritePadding(stream, header.mVertexOffset);
+			stream.write(reinterpret_cast<const char*>(mesh.GetVertexData().data()),
+				static_cast<std::streamsize>(mesh.GetVertexBufferSize()));
+
+			WritePadding(stream, header.mIndexOffset);
+			stream.write(reinterpret_cast<const char*>(mesh.GetIndexData().data()),
+				static_cast<std::streamsize>(mesh.GetIndexBufferSize()));
+
+			WritePadding(stream, header.mChunkOffset);
+			stream.write(reinterpret_cast<const char*>(mesh.GetChunks().data()),
+				static_cast<std::streamsize>(mesh.GetChunks().size_bytes()));
+
+			WritePadding(stream, header.mLodOffset);
+			stream.write(reinterpret_cast<const char*>(mesh.GetLods().data()),
+				static_cast<std::streamsize>(mesh.GetLods().size_bytes()));
+
+			WritePadding(stream, header.mMeshletOffset);
+			stream.write(reinterpret_cast<const char*>(mesh.GetMeshlets().data()),
+				static_cast<std::streamsize>(mesh.GetMeshlets().size_bytes()));
+
+			WritePadding(stream, header.mMeshletVertexOffset);
+			stream.write(reinterpret_cast<const char*>(mesh.GetMeshletVertices().data()),
+				static_cast<std::streamsize>(mesh.GetMeshletVertices().size_bytes()));
+
+			WritePadding(stream, header.mMeshletTriangleOffset);
+			stream.write(reinterpret_cast<const char*>(mesh.GetMeshletTriangles().data()),
+				static_cast<std::streamsize>(mesh.GetMeshletTriangles().size_bytes()));
+
+			if (!stream.good()) {
+				OTTER_CORE_ERROR("[MESH COOKER] Failed while writing '{}'", tempPath);
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempPath, destination, error);
+		if (error) {
+			OTTER_CORE_ERROR("[MESH COOKER] Failed to move cooked mesh to '{}': {}", destination, error.message());
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+
+		OTTER_CORE_LOG("[MESH COOKER] Cooked {} vertices, {} indices in {} levels of detail and {} meshlets into {}",
+			header.mVertexCount, header.mIndexCount, header.mLodCount, header.mMeshletCount, destination);
+		return true;
+	}
+}
@@ -0,0 +1,310 @@
+#include "OtterPCH.h"
+
+#include "Resources/MeshOptimizer.h"
+
+namespace OtterEngine {
+	namespace {
+		constexpr int64_t NO_VERTEX = -1;
+
+		/// <summary>
+		/// FIFO post-transform cache tracked with insertion times, a vertex is cached while fewer than cacheSize
+		/// vertices were inserted after it
+		/// </summary>
+		class VertexCacheSimulator {
+		private:
+			std::vector<uint32_t> mTimestamps;
+			uint32_t mCacheSize = 0;
+			uint32_t mTime = 0;
+
+		public:
+			VertexCacheSimulator(size_t vertexCount, uint32_t cacheSize) :
+				mTimestamps(vertexCount, 0), mCacheSize(cacheSize), mTime(cacheSize + 1) {
+			}
+
+			/// <summary>
+			/// Returns true on a miss, which inserts the vertex
+			/// </summary>
+			bool Access(uint32_t vertex) {
+				if (mTime - mTimestamps[vertex] > mCacheSize) {
+					mTimestamps[vertex] = mTime++;
+					return true;
+				}
+				return false;
+			}
+
+			// How long ago the vertex was inserted, larger than the cache size once evicted
+			uint32_t GetAge(uint32_t vertex) const { return mTime - mTimestamps[vertex]; }
+
+			void Flush() { mTime += mCacheSize + 1; }
+		};
+	}
+
+	void MeshOptimizer::Optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const MeshOptimizationSettings& settings)
+	{
+		if (indices.empty() || settings.mCacheSize == 0) {
+			return;
+		}
+
+		auto startTime = std::chrono::high_resolution_clock::now();
+		const VertexCacheStats before = AnalyzeVertexCache(indices, vertices.size(), settings.mCacheSize);
+
+		std::vector<uint32_t> clusters;
+		indices = OptimizeVertexCache(indices, vertices.size(), settings.mCacheSize, &clusters);
+		if (settings.mOverdrawThreshold > 1.0f) {
+			OptimizeOverdraw(indices, vertices, clusters, settings.mCacheSize, settings.mOverdrawThreshold);
+		}
+		OptimizeVertexFetch(vertices, indices);
+
+		const VertexCacheStats after = AnalyzeVertexCache(indices, vertices.size(), settings.mCacheSize);
+
+		float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+		OTTER_CORE_LOG("[MESH OPTIMIZER] ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f} on a {} entry cache, {} dead ends, in {:.2f} ms",
+			before.mAcmr, after.mAcmr, before.mAtvr, after.mAtvr, settings.mCacheSize, clusters.size(), elapsedMs);
+	}
+
+	VertexCacheStats MeshOptimizer::AnalyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize)
+	{
+		VertexCacheStats stats;
+		if (indices.empty() || vertexCount == 0) {
+			return stats;
+		}
+
+		VertexCacheSimulator cache(vertexCount, cacheSize);
+		for (uint32_t index : indices) {
+			stats.mTransformedVertices += cache.Access(index) ? 1 : 0;
+		}
+
+		stats.mAcmr = static_cast<float>(stats.mTransformedVertices) / static_cast<float>(indices.size() / 3);
+		stats.mAtvr = static_cast<float>(stats.mTransformedVertices) / static_cast<float>(vertexCount);
+		return stats;
+	}
+
+	std::vector<uint32_t> MeshOptimizer::OptimizeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize,
+		std::vector<uint32_t>* clusters)
+	{
+		std::vector<uint32_t> result;
+		if (indices.empty()) {
+			return result;
+		}
+		result.reserve(indices.size());
+
+		const size_t triangleCount = indices.size() / 3;
+
+		// Triangles using each vertex, and how many of them are still to emit
+		std::vector<uint32_t> liveCounts(vertexCount, 0);
+		for (uint32_t index : indices) {
+			++liveCounts[index];
+		}
+
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+			adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + liveCounts[vertex];
+		}
+
+		std::vector<uint32_t> adjacency(indices.size());
+		std::vector<uint32_t> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); ++i) {
+			adjacency[fillOffsets[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		VertexCacheSimulator cache(vertexCount, cacheSize);
+		std::vector<bool> isEmitted(triangleCount, false);
+		std::vector<uint32_t> deadEndStack;
+		std::vector<uint32_t> candidates;
+		size_t inputCursor = 0;
+
+		// Recently emitted vertices first, then the next live vertex in input order
+		auto skipDeadEnd = [&]() -> int64_t {
+			while (!deadEndStack.empty()) {
+				const uint32_t vertex = deadEndStack.back();
+				deadEndStack.pop_back();
+				if (liveCounts[vertex] > 0) {
+					return vertex;
+				}
+			}
+			for (; inputCursor < indices.size(); ++inputCursor) {
+				if (liveCounts[indices[inputCursor]] > 0) {
+					return indices[inputCursor];
+				}
+			}
+			return NO_VERTEX;
+		};
+
+		if (clusters) {
+			clusters->assign(1, 0);
+		}
+
+		int64_t fanningVertex = indices[0];
+		while (fanningVertex != NO_VERTEX) {
+			// Emit every remaining triangle around the fanning vertex
+			candidates.clear();
+			for (uint32_t a = adjacencyOffsets[fanningVertex]; a < adjacencyOffsets[fanningVertex + 1]; ++a) {
+				const uint32_t triangle = adjacency[a];
+				if (isEmitted[triangle]) {
+					continue;
+				}
+
+				for (uint32_t corner = 0; corner < 3; ++corner) {
+					const uint32_t vertex = indices[3 * triangle + corner];
+					result.push_back(vertex);
+					deadEndStack.push_back(vertex);
+					candidates.push_back(vertex);
+					--liveCounts[vertex];
+					cache.Access(vertex);
+				}
+				isEmitted[triangle] = true;
+			}
+
+			// Fan next around the oldest candidate that will still be cached once its own fan is emitted
+			int64_t nextVertex = NO_VERTEX;
+			int64_t bestPriority = -1;
+			for (uint32_t vertex : candidates) {
+				if (liveCounts[vertex] == 0) {
+					continue;
+				}
+
+				int64_t priority = 0;
+				const uint32_t age = cache.GetAge(vertex);
+				if (age + 2 * liveCounts[vertex] <= cacheSize) {
+					priority = age;
+				}
+				if (priority > bestPriority) {
+					bestPriority = priority;
+					nextVertex = vertex;
+				}
+			}
+
+			if (nextVertex == NO_VERTEX) {
+				nextVertex = skipDeadEnd();
+				if (clusters && nextVertex != NO_VERTEX) {
+					clusters->push_back(static_cast<uint32_t>(result.size() / 3));
+				}
+			}
+			fanningVertex = nextVertex;
+		}
+
+		OTTER_ASSERT(result.size() == indices.size(), "[MESH OPTIMIZER] Tipsify emitted {} indices out of {}!", result.size(), indices.size());
+		return result;
+	}
+
+	void MeshOptimizer::OptimizeOverdraw(std::span<uint32_t> indices, std::span<const Vertex> vertices, std::span<const uint32_t> clusters,
+		uint32_t cacheSize, float threshold)
+	{
+		const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+		if (triangleCount == 0 || clusters.empty()) {
+			return;
+		}
+
+		// Cut the dead-end clusters wherever their own ACMR, with a cold cache, is close enough to the mesh's,
+		// so that drawing the pieces in any order keeps the ACMR in the order of threshold times the original
+		const float clusterThreshold = AnalyzeVertexCache(indices, vertices.size(), cacheSize).mAcmr * threshold;
+
+		std::vector<uint32_t> boundaries;
+		VertexCacheSimulator cache(vertices.size(), cacheSize);
+		for (size_t cluster = 0; cluster < clusters.size(); ++cluster) {
+			const uint32_t end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : triangleCount;
+
+			uint32_t start = clusters[cluster];
+			uint32_t misses = 0;
+			boundaries.push_back(start);
+			cache.Flush();
+
+			for (uint32_t triangle = start; triangle < end; ++triangle) {
+				for (uint32_t corner = 0; corner < 3; ++corner) {
+					misses += cache.Access(indices[3 * triangle + corner]) ? 1 : 0;
+				}
+
+				if (triangle + 1 < end && static_cast<float>(misses) <= clusterThreshold * static_cast<float>(triangle + 1 - start)) {
+					start = triangle + 1;
+					misses = 0;
+					boundaries.push_back(start);
+					cache.Flush();
+				}
+			}
+		}
+
+		struct ClusterSortKey {
+			uint32_t mFirstTriangle = 0;
+			uint32_t mTriangleCount = 0;
+			float mSortKey = 0.0f;
+		};
+
+		std::vector<ClusterSortKey> sortKeys(boundaries.size());
+		std::vector<glm::vec3> centroids(boundaries.size(), glm::vec3(0.0f));
+		std::vector<glm::vec3> normals(boundaries.size(), glm::vec3(0.0f));
+		glm::vec3 meshCentroid(0.0f);
+		float meshArea = 0.0f;
+
+		// Area-weighted centroid and normal of every cluster
+		for (size_t cluster = 0; cluster < boundaries.size(); ++cluster) {
+			const uint32_t start = boundaries[cluster];
+			const uint32_t end = cluster + 1 < boundaries.size() ? boundaries[cluster + 1] : triangleCount;
+			sortKeys[cluster].mFirstTriangle = start;
+			sortKeys[cluster].mTriangleCount = end - start;
+
+			float clusterArea = 0.0f;
+			for (uint32_t triangle = start; triangle < end; ++triangle) {
+				const glm::vec3& a = vertices[indices[3 * triangle + 0]].mPosition;
+				const glm::vec3& b = vertices[indices[3 * triangle + 1]].mPosition;
+				const glm::vec3& c = vertices[indices[3 * triangle + 2]].mPosition;
+
+				const glm::vec3 normal = glm::cross(b - a, c - a);
+				const float area = glm::length(normal);
+				centroids[cluster] += (a + b + c) * (area / 3.0f);
+				normals[cluster] += normal;
+				clusterArea += area;
+			}
+
+			meshCentroid += centroids[cluster];
+			meshArea += clusterArea;
+			if (clusterArea > 0.0f) {
+				centroids[cluster] /= clusterArea;
+			}
+		}
+		if (meshArea > 0.0f) {
+			meshCentroid /= meshArea;
+		}
+
+		// Clusters far out along their normal occlude the rest from most viewpoints, they go first
+		for (size_t cluster = 0; cluster < boundaries.size(); ++cluster) {
+			const float normalLength = glm::length(normals[cluster]);
+			if (normalLength > 0.0f) {
+				sortKeys[cluster].mSortKey = glm::dot(centroids[cluster] - meshCentroid, normals[cluster] / normalLength);
+			}
+		}
+
+		std::stable_sort(sortKeys.begin(), sortKeys.end(), [](const ClusterSortKey& a, const ClusterSortKey& b) {
+			return a.mSortKey > b.mSortKey;
+		});
+
+		std::vector<uint32_t> sorted;
+		sorted.reserve(indices.size());
+		for (const ClusterSortKey& cluster : sortKeys) {
+			const auto first = indices.begin() + 3 * static_cast<size_t>(cluster.mFirstTriangle);
+			sorted.insert(sorted.end(), first, first + 3 * static_cast<size_t>(cluster.mTriangleCount));
+		}
+		std::copy(sorted.begin(), sorted.end(), indices.begin());
+	}
+
+	void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>& vertices, std::span<uint32_t> indices)
+	{
+		constexpr uint32_t UNUSED = UINT32_MAX;
+
+		std::vector<uint32_t> remap(vertices.size(), UNUSED);
+		uint32_t nextVertex = 0;
+		for (uint32_t& index : indices) {
+			if (remap[index] == UNUSED) {
+				remap[index] = nextVertex++;
+			}
+			index = remap[index];
+		}
+
+		std::vector<Vertex> reordered(nextVertex);
+		for (size_t vertex = 0; vertex < vertices.size(); ++vertex) {
+			if (remap[vertex] != UNUSED) {
+				reordered[remap[vertex]] = vertices[vertex];
+			}
+		}
+		vertices = std::move(reordered);
+	}
+}
@@ -0,0 +1,638 @@
+#include "OtterPCH.h"
+
+#include <bit>
+#include <array>
+#include <numeric>
+#include <unordered_map>
+
+#include "Resources/MeshOptimizer.h"
+
+#include "Resources/MeshSimplifier.h"
+
+namespace OtterEngine {
+	namespace {
+		// Position, normal and texture coordinates
+		constexpr size_t ATTRIBUTE_QUADRIC_SIZE = 8;
+		constexpr size_t POSITION_QUADRIC_SIZE = 3;
+		// Border planes outweigh the surface ones, so that borders only move along themselves
+		constexpr float BORDER_WEIGHT = 10.0f;
+		// Largest rotation a triangle may go through in a collapse, as the cosine of its angle
+		constexpr float MIN_NORMAL_COSINE = 0.0f;
+		constexpr uint32_t NO_TWIN = UINT32_MAX;
+
+		template <size_t QUADRIC_SIZE>
+		using QuadricPoint = std::array<float, QUADRIC_SIZE>;
+
+		template <size_t QUADRIC_SIZE>
+		float Dot(const QuadricPoint<QUADRIC_SIZE>& a, const QuadricPoint<QUADRIC_SIZE>& b) {
+			float result = 0.0f;
+			for (size_t i = 0; i < QUADRIC_SIZE; ++i) {
+				result += a[i] * b[i];
+			}
+			return result;
+		}
+
+		/// <summary>
+		/// Sum of area weighted squared distances to planes of the attribute space, as v^T A v + 2 b.v + c.
+		/// Only the upper triangle of the symmetric A is stored.
+		/// </summary>
+		template <size_t QUADRIC_SIZE>
+		struct Quadric {
+			std::array<float, QUADRIC_SIZE * (QUADRIC_SIZE + 1) / 2> mA{};
+			QuadricPoint<QUADRIC_SIZE> mB{};
+			float mC = 0.0f;
+			// Area the planes were weighted by, errors are averaged over it
+			float mWeight = 0.0f;
+
+			Quadric& operator+=(const Quadric& other) {
+				for (size_t i = 0; i < mA.size(); ++i) {
+					mA[i] += other.mA[i];
+				}
+				for (size_t i = 0; i < QUADRIC_SIZE; ++i) {
+					mB[i] += other.mB[i];
+				}
+				mC += other.mC;
+				mWeight += other.mWeight;
+				return *this;
+			}
+
+			float Evaluate(const QuadricPoint<QUADRIC_SIZE>& point) const {
+				float result = mC + 2.0f * Dot(mB, point);
+				size_t element = 0;
+				for (size_t row = 0; row < QUADRIC_SIZE; ++row) {
+					result += mA[element++] * point[row] * point[row];
+					for (size_t column = row + 1; column < QUADRIC_SIZE; ++column) {
+						result += 2.0f * mA[element++] * point[row] * point[column];
+					}
+				}
+				return result;
+			}
+		};
+
+		// Normals and texture coordinates next to positions, to order collapses
+		using AttributeQuadric = Quadric<ATTRIBUTE_QUADRIC_SIZE>;
+		using AttributePoint = QuadricPoint<ATTRIBUTE_QUADRIC_SIZE>;
+		// Positions alone, to measure how far a level is from the base mesh
+		using PositionQuadric = Quadric<POSITION_QUADRIC_SIZE>;
+		using PositionPoint = QuadricPoint<POSITION_QUADRIC_SIZE>;
+
+		/// <summary>
+		/// Distance to the plane of a triangle spanned in the attribute space (Garland and Heckbert 1998),
+		/// a degenerate triangle gives an empty quadric
+		/// </summary>
+		template <size_t QUADRIC_SIZE>
+		Quadric<QUADRIC_SIZE> MakeTriangleQuadric(const QuadricPoint<QUADRIC_SIZE>& p0, const QuadricPoint<QUADRIC_SIZE>& p1,
+			const QuadricPoint<QUADRIC_SIZE>& p2, float area)
+		{
+			Quadric<QUADRIC_SIZE> quadric;
+
+			QuadricPoint<QUADRIC_SIZE> e1, e2;
+			for (size_t i = 0; i < QUADRIC_SIZE; ++i) {
+				e1[i] = p1[i] - p0[i];
+				e2[i] = p2[i] - p0[i];
+			}
+
+			const float length1 = std::sqrt(Dot(e1, e1));
+			if (length1 <= 1e-12f) {
+				return quadric;
+			}
+			for (float& value : e1) value /= length1;
+
+			const float projection = Dot(e1, e2);
+			for (size_t i = 0; i < QUADRIC_SIZE; ++i) {
+				e2[i] -= projection * e1[i];
+			}
+			const float length2 = std::sqrt(Dot(e2, e2));
+			if (length2 <= 1e-12f) {
+				return quadric;
+			}
+			for (float& value : e2) value /= length2;
+
+			const float p0e1 = Dot(p0, e1);
+			const float p0e2 = Dot(p0, e2);
+
+			size_t element = 0;
+			for (size_t row = 0; row < QUADRIC_SIZE; ++row) {
+				for (size_t column = row; column < QUADRIC_SIZE; ++column) {
+					const float identity = row == column ? 1.0f : 0.0f;
+					quadric.mA[element++] = area * (identity - e1[row] * e1[column] - e2[row] * e2[column]);
+				}
+				quadric.mB[row] = area * (p0e1 * e1[row] + p0e2 * e2[row] - p0[row]);
+			}
+			quadric.mC = area * (Dot(p0, p0) - p0e1 * p0e1 - p0e2 * p0e2);
+			quadric.mWeight = area;
+			return quadric;
+		}
+
+		/// <summary>
+		/// Distance to the plane through a border edge perpendicular to its triangle, positions only
+		/// </summary>
+		template <size_t QUADRIC_SIZE>
+		Quadric<QUADRIC_SIZE> MakeBorderQuadric(const glm::vec3& a, const glm::vec3& b, const glm::vec3& faceNormal, float borderWeight) {
+			Quadric<QUADRIC_SIZE> quadric;
+
+			const glm::vec3 edge = b - a;
+			const glm::vec3 normal = glm::cross(edge, faceNormal);
+			const float length = glm::length(normal);
+			if (length <= 1e-12f) {
+				return quadric;
+			}
+
+			const glm::vec3 planeNormal = normal / length;
+			const float distance = -glm::dot(planeNormal, a);
+			const float weight = borderWeight * glm::dot(edge, edge);
+
+			size_t element = 0;
+			for (size_t row = 0; row < QUADRIC_SIZE; ++row) {
+				for (size_t column = row; column < QUADRIC_SIZE; ++column) {
+					if (row < 3 && column < 3) {
+						quadric.mA[element] = weight * planeNormal[row] * planeNormal[column];
+					}
+					++element;
+				}
+				if (row < 3) {
+					quadric.mB[row] = weight * distance * planeNormal[row];
+				}
+			}
+			quadric.mC = weight * distance * distance;
+			return quadric;
+		}
+
+		/// <summary>
+		/// Triangles around each vertex, as offsets into one array
+		/// </summary>
+		struct VertexTriangles {
+			std::vector<uint32_t> mOffsets;
+			std::vector<uint32_t> mTriangles;
+
+			VertexTriangles(std::span<const uint32_t> indices, size_t vertexCount) : mOffsets(vertexCount + 1, 0) {
+				for (uint32_t index : indices) {
+					++mOffsets[index + 1];
+				}
+				for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+					mOffsets[vertex + 1] += mOffsets[vertex];
+				}
+
+				mTriangles.resize(indices.size());
+				std::vector<uint32_t> cursors(mOffsets.begin(), mOffsets.end() - 1);
+				for (size_t index = 0; index < indices.size(); ++index) {
+					mTriangles[cursors[indices[index]]++] = static_cast<uint32_t>(index / 3);
+				}
+			}
+
+			std::span<const uint32_t> Around(uint32_t vertex) const {
+				return { mTriangles.data() + mOffsets[vertex], mTriangles.data() + mOffsets[vertex + 1] };
+			}
+		};
+
+		enum class VertexKind : uint8_t {
+			Manifold,
+			// On exactly two open edges, only collapses along them
+			Border,
+			// One of the two vertices split at a position, on two edges of the split. Collapses along them
+			// together with its twin, so that both sides of the seam keep meeting.
+			Seam,
+			// Positions split more than twice, non-manifold or complex borders
+			Locked
+		};
+
+		/// <summary>
+		/// Incremental edge collapser over one index buffer, quadrics carry over between calls to Collapse so
+		/// that every level is measured against the base mesh
+		/// </summary>
+		class EdgeCollapser {
+		private:
+			struct EdgeCollapse {
+				uint32_t mFrom = 0;
+				uint32_t mTo = 0;
+				float mCost = 0.0f;
+			};
+
+			std::span<const Vertex> mVertices;
+			std::vector<AttributePoint> mPoints;
+			std::vector<AttributeQuadric> mQuadrics;
+			std::vector<PositionQuadric> mPositionQuadrics;
+			// The other vertex at the same position, NO_TWIN for vertices alone at theirs or locked
+			std::vector<uint32_t> mTwins;
+			std::vector<bool> mIsLocked;
+			std::vector<uint32_t> mIndices;
+			// Model units per normalized unit
+			float mScale = 1.0f;
+			// Largest distance reached by positions, squared, in normalized units
+			float mPositionError = 0.0f;
+			// Whether the last pass stopped at the error bound rather than running out of collapses
+			bool mHasReachedErrorBound = false;
+			// Used vertices that could not move in the last pass
+			uint32_t mLockedVertexCount = 0;
+
+			static uint32_t CountEdgeTriangles(const VertexTriangles& adjacency, std::span<const uint32_t> indices, uint32_t from, uint32_t to) {
+				uint32_t count = 0;
+				for (uint32_t triangle : adjacency.Around(from)) {
+					const uint32_t* corners = &indices[size_t(triangle) * 3];
+					count += (corners[0] == to || corners[1] == to || corners[2] == to) ? 1 : 0;
+				}
+				return count;
+			}
+
+			/// <summary>
+			/// True when an open edge runs along a seam, its twin edge open on the other side
+			/// </summary>
+			bool IsSeamEdge(const VertexTriangles& adjacency, uint32_t from, uint32_t to) const {
+				const uint32_t twinFrom = mTwins[from];
+				const uint32_t twinTo = mTwins[to];
+				return twinFrom != NO_TWIN && twinTo != NO_TWIN && CountEdgeTriangles(adjacency, mIndices, twinFrom, twinTo) == 1;
+			}
+
+			VertexKind Classify(const VertexTriangles& adjacency, uint32_t vertex) const {
+				if (mIsLocked[vertex]) {
+					return VertexKind::Locked;
+				}
+
+				uint32_t borderEdges = 0;
+				uint32_t seamEdges = 0;
+				for (uint32_t triangle : adjacency.Around(vertex)) {
+					for (size_t corner = 0; corner < 3; ++corner) {
+						const uint32_t other = mIndices[size_t(triangle) * 3 + corner];
+						if (other == vertex) {
+							continue;
+						}
+
+						const uint32_t count = CountEdgeTriangles(adjacency, mIndices, vertex, other);
+						if (count > 2) {
+							return VertexKind::Locked;
+						}
+						if (count == 1) {
+							++borderEdges;
+							seamEdges += IsSeamEdge(adjacency, vertex, other) ? 1 : 0;
+						}
+					}
+				}
+
+				// A split vertex anywhere but in the middle of a seam would open it by moving
+				if (mTwins[vertex] != NO_TWIN) {
+					return borderEdges == 2 && seamEdges == 2 ? VertexKind::Seam : VertexKind::Locked;
+				}
+				if (borderEdges == 0) return VertexKind::Manifold;
+				if (borderEdges == 2) return VertexKind::Border;
+				return VertexKind::Locked;
+			}
+
+			/// <summary>
+			/// True when moving a vertex onto another turns one of its triangles over, or close to
+			/// </summary>
+			bool Flips(const VertexTriangles& adjacency, std::span<const uint32_t> remap, uint32_t from, uint32_t to) const {
+				const glm::vec3& target = mVertices[to].mPosition;
+
+				for (uint32_t triangle : adjacency.Around(from)) {
+					std::array<uint32_t, 3> corners;
+					for (size_t corner = 0; corner < 3; ++corner) {
+						corners[corner] = remap[mIndices[size_t(triangle) * 3 + corner]];
+					}
+
+					// Triangles along the edge disappear, and earlier collapses of the pass may have removed others
+					if (corners[0] == to || corners[1] == to || corners[2] == to ||
+						corners[0] == corners[1] || corners[1] == corners[2] || corners[2] == corners[0]) {
+						continue;
+					}
+
+					const glm::vec3& p0 = mVertices[corners[0]].mPosition;
+					const glm::vec3& p1 = mVertices[corners[1]].mPosition;
+					const glm::vec3& p2 = mVertices[corners[2]].mPosition;
+					const glm::vec3 before = glm::cross(p1 - p0, p2 - p0);
+
+					const glm::vec3 q0 = corners[0] == from ? target : p0;
+					const glm::vec3 q1 = corners[1] == from ? target : p1;
+					const glm::vec3 q2 = corners[2] == from ? target : p2;
+					const glm::vec3 after = glm::cross(q1 - q0, q2 - q0);
+
+					if (glm::dot(before, after) < MIN_NORMAL_COSINE * glm::length(before) * glm::length(after)) {
+						return true;
+					}
+				}
+				return false;
+			}
+
+			float GetCost(uint32_t from, uint32_t to) const {
+				const float weight = mQuadrics[from].mWeight + mQuadrics[to].mWeight;
+				const float error = mQuadrics[from].Evaluate(mPoints[to]) + mQuadrics[to].Evaluate(mPoints[to]);
+				return std::max(error, 0.0f) / std::max(weight, 1e-12f);
+			}
+
+			/// <summary>
+			/// Moves a vertex onto another, keeping the largest position error reached
+			/// </summary>
+			void Apply(std::vector<uint32_t>& remap, uint32_t from, uint32_t to) {
+				const PositionPoint target = { mPoints[to][0], mPoints[to][1], mPoints[to][2] };
+				const float weight = mPositionQuadrics[from].mWeight + mPositionQuadrics[to].mWeight;
+				const float error = mPositionQuadrics[from].Evaluate(target) + mPositionQuadrics[to].Evaluate(target);
+				mPositionError = std::max(mPositionError, error / std::max(weight, 1e-12f));
+
+				remap[from] = to;
+				mQuadrics[to] += mQuadrics[from];
+				mPositionQuadrics[to] += mPositionQuadrics[from];
+			}
+
+			/// <summary>
+			/// Applies the cheapest collapses not sharing a vertex, up to the target. False once nothing collapses.
+			/// </summary>
+			bool CollapsePass(size_t targetIndexCount, float maxError) {
+				const uint32_t vertexCount = static_cast<uint32_t>(mVertices.size());
+				VertexTriangles adjacency(mIndices, vertexCount);
+
+				std::vector<VertexKind> kinds(vertexCount, VertexKind::Locked);
+				mLockedVertexCount = 0;
+				for (uint32_t vertex = 0; vertex < vertexCount; ++vertex) {
+					if (!adjacency.Around(vertex).empty()) {
+						kinds[vertex] = Classify(adjacency, vertex);
+						mLockedVertexCount += kinds[vertex] == VertexKind::Locked ? 1 : 0;
+					}
+				}
+
+				auto canCollapse = [&](uint32_t from, uint32_t to) {
+					switch (kinds[from]) {
+					case VertexKind::Manifold: return true;
+					case VertexKind::Border: return CountEdgeTriangles(adjacency, mIndices, from, to) == 1;
+					case VertexKind::Seam:
+						return kinds[mTwins[from]] == VertexKind::Seam && CountEdgeTriangles(adjacency, mIndices, from, to) == 1 &&
+							IsSeamEdge(adjacency, from, to);
+					case VertexKind::Locked: return false;
+					}
+					return false;
+				};
+
+				// Each directed edge of a triangle once, border edges have no twin and are added reversed as well.
+				// A seam collapse is listed from one side only, and costs the most of its two halves.
+				std::vector<EdgeCollapse> collapses;
+				collapses.reserve(mIndices.size());
+				auto addCollapse = [&](uint32_t from, uint32_t to) {
+					if (!canCollapse(from, to)) {
+						return;
+					}
+					if (kinds[from] != VertexKind::Seam) {
+						collapses.push_back({ from, to, GetCost(from, to) });
+					}
+					else if (from < mTwins[from]) {
+						collapses.push_back({ from, to, std::max(GetCost(from, to), GetCost(mTwins[from], mTwins[to])) });
+					}
+				};
+
+				for (size_t triangle = 0; triangle < mIndices.size(); triangle += 3) {
+					for (size_t corner = 0; corner < 3; ++corner) {
+						const uint32_t a = mIndices[triangle + corner];
+						const uint32_t b = mIndices[triangle + (corner + 1) % 3];
+
+						addCollapse(a, b);
+						if (kinds[b] == VertexKind::Border || kinds[b] == VertexKind::Seam) {
+							addCollapse(b, a);
+						}
+					}
+				}
+
+				std::sort(collapses.begin(), collapses.end(), [](const EdgeCollapse& a, const EdgeCollapse& b) {
+					return a.mCost < b.mCost;
+				});
+
+				// Interior and seam collapses remove two triangles, border ones a single triangle
+				const size_t trianglesToRemove = (mIndices.size() - targetIndexCount) / 3;
+				size_t removedTriangles = 0;
+
+				std::vector<uint32_t> remap(vertexCount);
+				std::iota(remap.begin(), remap.end(), 0u);
+				std::vector<bool> isTouched(vertexCount, false);
+				size_t collapseCount = 0;
+				mHasReachedErrorBound = false;
+
+				for (const EdgeCollapse& collapse : collapses) {
+					if (removedTriangles >= trianglesToRemove) {
+						break;
+					}
+					if (collapse.mCost > maxError) {
+						mHasReachedErrorBound = true;
+						break;
+					}
+					if (isTouched[collapse.mFrom] || isTouched[collapse.mTo] ||
+						Flips(adjacency, remap, collapse.mFrom, collapse.mTo)) {
+						continue;
+					}
+
+					const VertexKind kind = kinds[collapse.mFrom];
+					if (kind == VertexKind::Seam) {
+						const uint32_t twinFrom = mTwins[collapse.mFrom];
+						const uint32_t twinTo = mTwins[collapse.mTo];
+						if (isTouched[twinFrom] || isTouched[twinTo] || Flips(adjacency, remap, twinFrom, twinTo)) {
+							continue;
+						}
+
+						Apply(remap, twinFrom, twinTo);
+						isTouched[twinFrom] = isTouched[twinTo] = true;
+					}
+
+					Apply(remap, collapse.mFrom, collapse.mTo);
+					isTouched[collapse.mFrom] = isTouched[collapse.mTo] = true;
+
+					removedTriangles += kind == VertexKind::Border ? 1 : 2;
+					++collapseCount;
+				}
+
+				if (collapseCount == 0) {
+					return false;
+				}
+
+				size_t writeIndex = 0;
+				for (size_t triangle = 0; triangle < mIndices.size(); triangle += 3) {
+					const uint32_t a = remap[mIndices[triangle]];
+					const uint32_t b = remap[mIndices[triangle + 1]];
+					const uint32_t c = remap[mIndices[triangle + 2]];
+					if (a != b && b != c && c != a) {
+						mIndices[writeIndex++] = a;
+						mIndices[writeIndex++] = b;
+						mIndices[writeIndex++] = c;
+					}
+				}
+				mIndices.resize(writeIndex);
+				return true;
+			}
+
+			/// <summary>
+			/// Pairs the vertices split on normals or texture coordinates at a position into twins, and locks positions
+			/// split more than twice
+			/// </summary>
+			void FindSeams() {
+				std::unordered_map<uint64_t, uint32_t> firstAtPosition;
+				firstAtPosition.reserve(mVertices.size());
+				for (uint32_t vertex = 0; vertex < mVertices.size(); ++vertex) {
+					const glm::vec3& position = mVertices[vertex].mPosition;
+					const uint64_t hash = (uint64_t(std::bit_cast<uint32_t>(position.x)) * 0x9E3779B97F4A7C15ull) ^
+						(uint64_t(std::bit_cast<uint32_t>(position.y)) * 0xC2B2AE3D27D4EB4Full) ^
+						(uint64_t(std::bit_cast<uint32_t>(position.z)) * 0x165667B19E3779F9ull);
+
+					auto [entry, isNew] = firstAtPosition.try_emplace(hash, vertex);
+					if (isNew) {
+						continue;
+					}
+
+					// A hash collision between two positions locks them for nothing but breaks no seam
+					const uint32_t first = entry->second;
+					if (mVertices[first].mPosition == position && mTwins[first] == NO_TWIN && !mIsLocked[first]) {
+						mTwins[first] = vertex;
+						mTwins[vertex] = first;
+						continue;
+					}
+
+					for (uint32_t locked : { first, mTwins[first], vertex }) {
+						if (locked != NO_TWIN) {
+							mIsLocked[locked] = true;
+						}
+					}
+				}
+			}
+
+		public:
+			EdgeCollapser(std::span<const Vertex> vertices, std::span<const uint32_t> indices, const MeshSimplificationSettings& settings) :
+				mVertices(vertices), mPoints(vertices.size()), mQuadrics(vertices.size()), mPositionQuadrics(vertices.size()),
+				mTwins(vertices.size(), NO_TWIN), mIsLocked(vertices.size(), false), mIndices(indices.begin(), indices.end()) {
+				if (vertices.empty()) {
+					return;
+				}
+
+				// Positions are brought to a unit sized box so that attributes weigh the same on any mesh
+				glm::vec3 min = vertices[0].mPosition;
+				glm::vec3 max = vertices[0].mPosition;
+				for (const Vertex& vertex : vertices) {
+					min = glm::min(min, vertex.mPosition);
+					max = glm::max(max, vertex.mPosition);
+				}
+				const glm::vec3 center = (min + max) * 0.5f;
+				mScale = std::max(glm::length(max - min) * 0.5f, 1e-12f);
+
+				for (size_t vertex = 0; vertex < vertices.size(); ++vertex) {
+					const Vertex& source = vertices[vertex];
+					const glm::vec3 position = (source.mPosition - center) / mScale;
+					mPoints[vertex] = {
+						position.x, position.y, position.z,
+						source.mNormal.x * settings.mNormalWeight,
+						source.mNormal.y * settings.mNormalWeight,
+						source.mNormal.z * settings.mNormalWeight,
+						source.mTexCoord.x * settings.mTexCoordWeight,
+						source.mTexCoord.y * settings.mTexCoordWeight
+					};
+				}
+
+				FindSeams();
+
+				VertexTriangles adjacency(mIndices, vertices.size());
+				for (size_t triangle = 0; triangle < mIndices.size(); triangle += 3) {
+					const uint32_t i0 = mIndices[triangle];
+					const uint32_t i1 = mIndices[triangle + 1];
+					const uint32_t i2 = mIndices[triangle + 2];
+
+					const glm::vec3 p0(mPoints[i0][0], mPoints[i0][1], mPoints[i0][2]);
+					const glm::vec3 p1(mPoints[i1][0], mPoints[i1][1], mPoints[i1][2]);
+					const glm::vec3 p2(mPoints[i2][0], mPoints[i2][1], mPoints[i2][2]);
+					const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+					const float area = glm::length(normal) * 0.5f;
+
+					const AttributeQuadric quadric = MakeTriangleQuadric(mPoints[i0], mPoints[i1], mPoints[i2], area);
+					const PositionQuadric positionQuadric = MakeTriangleQuadric<POSITION_QUADRIC_SIZE>(
+						{ p0.x, p0.y, p0.z }, { p1.x, p1.y, p1.z }, { p2.x, p2.y, p2.z }, area);
+
+					const std::array<uint32_t, 3> corners = { i0, i1, i2 };
+					for (uint32_t corner : corners) {
+						mQuadrics[corner] += quadric;
+						mPositionQuadrics[corner] += positionQuadric;
+					}
+
+					// Seams count as borders too, they stay where they are as long as their twins do
+					const std::array<glm::vec3, 3> positions = { p0, p1, p2 };
+					for (size_t corner = 0; corner < 3; ++corner) {
+						const size_t next = (corner + 1) % 3;
+						if (CountEdgeTriangles(adjacency, mIndices, corners[corner], corners[next]) == 1) {
+							const AttributeQuadric border = MakeBorderQuadric<ATTRIBUTE_QUADRIC_SIZE>(positions[corner], positions[next],
+								normal, BORDER_WEIGHT);
+							const PositionQuadric positionBorder = MakeBorderQuadric<POSITION_QUADRIC_SIZE>(positions[corner], positions[next],
+								normal, 1.0f);
+							for (uint32_t vertex : { corners[corner], corners[next] }) {
+								mQuadrics[vertex] += border;
+								mPositionQuadrics[vertex] += positionBorder;
+							}
+						}
+					}
+				}
+			}
+
+			/// <summary>
+			/// Collapses until the target or the error bound, in model units, is reached
+			/// </summary>
+			void Collapse(size_t targetIndexCount, float maxError) {
+				const float normalizedError = maxError / mScale;
+				while (mIndices.size() > targetIndexCount && CollapsePass(targetIndexCount, normalizedError * normalizedError)) {
+				}
+			}
+
+			const std::vector<uint32_t>& GetIndices() const { return mIndices; }
+			// Largest distance from positions to the base surface, in model units. Attributes only order the collapses.
+			float GetError() const { return std::sqrt(mPositionError) * mScale; }
+			float GetScale() const { return mScale; }
+			bool HasReachedErrorBound() const { return mHasReachedErrorBound; }
+			uint32_t GetLockedVertexCount() const { return mLockedVertexCount; }
+		};
+	}
+
+	std::vector<MeshLodGeometry> MeshSimplifier::BuildLodChain(std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+		const MeshSimplificationSettings& settings)
+	{
+		std::vector<MeshLodGeometry> lods;
+		if (indices.empty() || settings.mTriangleRatios.empty()) {
+			return lods;
+		}
+
+		auto startTime = std::chrono::high_resolution_clock::now();
+
+		EdgeCollapser collapser(vertices, indices, settings);
+		const float maxError = settings.mMaxError * collapser.GetScale();
+		const size_t baseTriangles = indices.size() / 3;
+
+		for (float ratio : settings.mTriangleRatios) {
+			const size_t previousIndexCount = collapser.GetIndices().size();
+			const size_t targetIndexCount = static_cast<size_t>(float(baseTriangles) * ratio) * 3;
+			collapser.Collapse(targetIndexCount, maxError);
+
+			const size_t indexCount = collapser.GetIndices().size();
+			if (indexCount == 0 || float(indexCount) > float(previousIndexCount) * settings.mMinReduction) {
+				// Flat shaded meshes split every position more than twice and lock all of their vertices
+				if (indexCount > targetIndexCount && !collapser.HasReachedErrorBound() && collapser.GetLockedVertexCount() > 0) {
+					OTTER_CORE_WARNING("[MESH SIMPLIFIER] LOD {} abandoned at {} of {} triangles, {} vertices are locked on attribute seams or non-manifold edges",
+						lods.size() + 1, indexCount / 3, targetIndexCount / 3, collapser.GetLockedVertexCount());
+				}
+				break;
+			}
+
+			MeshLodGeometry& lod = lods.emplace_back();
+			lod.mVertices.assign(vertices.begin(), vertices.end());
+			lod.mIndices = collapser.GetIndices();
+			lod.mError = collapser.GetError();
+			MeshOptimizer::OptimizeVertexFetch(lod.mVertices, lod.mIndices);
+		}
+
+		float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+		for (size_t level = 0; level < lods.size(); ++level) {
+			OTTER_CORE_LOG("[MESH SIMPLIFIER] LOD {}: {} triangles ({:.1f}%), {} vertices, error {:.5f}",
+				level + 1, lods[level].mIndices.size() / 3, 100.0f * float(lods[level].mIndices.size()) / float(indices.size()),
+				lods[level].mVertices.size(), lods[level].mError);
+		}
+		OTTER_CORE_LOG("[MESH SIMPLIFIER] Built {} of {} levels in {:.2f} ms", lods.size(), settings.mTriangleRatios.size(), elapsedMs);
+		return lods;
+	}
+
+	std::vector<uint32_t> MeshSimplifier::Simplify(std::span<const Vertex> vertices, std::span<const uint32_t> indices, size_t targetIndexCount,
+		float maxError, const MeshSimplificationSettings& settings, float* resultError)
+	{
+		EdgeCollapser collapser(vertices, indices, settings);
+		collapser.Collapse(targetIndexCount, maxError);
+
+		if (resultError) {
+			*resultError = collapser.GetError();
+		}
+		return collapser.GetIndices();
+	}
+}
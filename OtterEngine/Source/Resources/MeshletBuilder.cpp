@@ -0,0 +1,293 @@
+#include "OtterPCH.h"
+
+#include <limits>
+
+#include "Resources/MeshletBuilder.h"
+
+namespace OtterEngine {
+	namespace {
+		constexpr uint32_t NOT_IN_MESHLET = UINT32_MAX;
+		// Cones wider than this, as the smallest cosine between a normal and the axis, cull too rarely to be worth testing
+		constexpr float MIN_CONE_SPREAD = 0.1f;
+
+		/// <summary>
+		/// Triangles around each vertex, as offsets into one array
+		/// </summary>
+		struct VertexTriangles {
+			std::vector<uint32_t> mOffsets;
+			std::vector<uint32_t> mTriangles;
+
+			VertexTriangles(std::span<const uint32_t> indices, size_t vertexCount) : mOffsets(vertexCount + 1, 0) {
+				for (uint32_t index : indices) {
+					++mOffsets[index + 1];
+				}
+				for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+					mOffsets[vertex + 1] += mOffsets[vertex];
+				}
+
+				mTriangles.resize(indices.size());
+				std::vector<uint32_t> cursors(mOffsets.begin(), mOffsets.end() - 1);
+				for (size_t index = 0; index < indices.size(); ++index) {
+					mTriangles[cursors[indices[index]]++] = static_cast<uint32_t>(index / 3);
+				}
+			}
+
+			std::span<const uint32_t> Around(uint32_t vertex) const {
+				return { mTriangles.data() + mOffsets[vertex], mTriangles.data() + mOffsets[vertex + 1] };
+			}
+		};
+
+		/// <summary>
+		/// Ritter's bounding sphere: starts from two far apart vertices and grows to take in the ones left outside
+		/// </summary>
+		void ComputeSphere(std::span<const Vertex> vertices, std::span<const uint32_t> meshletVertices, Meshlet& meshlet) {
+			auto farthestFrom = [&](const glm::vec3& point) {
+				glm::vec3 farthest = point;
+				float farthestDistance = -1.0f;
+				for (uint32_t vertex : meshletVertices) {
+					const glm::vec3& position = vertices[vertex].mPosition;
+					const glm::vec3 offset = position - point;
+					const float distance = glm::dot(offset, offset);
+					if (distance > farthestDistance) {
+						farthestDistance = distance;
+						farthest = position;
+					}
+				}
+				return farthest;
+			};
+
+			const glm::vec3 a = farthestFrom(vertices[meshletVertices[0]].mPosition);
+			const glm::vec3 b = farthestFrom(a);
+			glm::vec3 center = (a + b) * 0.5f;
+			float radius = glm::length(b - a) * 0.5f;
+
+			for (uint32_t vertex : meshletVertices) {
+				const glm::vec3& position = vertices[vertex].mPosition;
+				const float distance = glm::length(position - center);
+				if (distance > radius) {
+					const float grownRadius = (radius + distance) * 0.5f;
+					center += (position - center) * ((grownRadius - radius) / distance);
+					radius = grownRadius;
+				}
+			}
+
+			meshlet.mCenter[0] = center.x;
+			meshlet.mCenter[1] = center.y;
+			meshlet.mCenter[2] = center.z;
+			meshlet.mRadius = radius;
+		}
+
+		/// <summary>
+		/// Normal cone around the average of the face normals, as wide as the normal farthest from it
+		/// </summary>
+		void ComputeCone(std::span<const Vertex> vertices, std::span<const uint32_t> meshletVertices, std::span<const uint8_t> triangles,
+			Meshlet& meshlet) {
+			std::vector<glm::vec3> normals;
+			normals.reserve(triangles.size() / 3);
+
+			glm::vec3 axis(0.0f);
+			for (size_t corner = 0; corner < triangles.size(); corner += 3) {
+				const glm::vec3& p0 = vertices[meshletVertices[triangles[corner]]].mPosition;
+				const glm::vec3& p1 = vertices[meshletVertices[triangles[corner + 1]]].mPosition;
+				const glm::vec3& p2 = vertices[meshletVertices[triangles[corner + 2]]].mPosition;
+
+				const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+				const float length = glm::length(normal);
+				if (length > 1e-12f) {
+					normals.push_back(normal / length);
+					axis += normals.back();
+				}
+			}
+
+			const float axisLength = glm::length(axis);
+			if (normals.empty() || axisLength <= 1e-12f) {
+				return;
+			}
+			axis /= axisLength;
+
+			float spread = 1.0f;
+			for (const glm::vec3& normal : normals) {
+				spread = std::min(spread, glm::dot(axis, normal));
+			}
+
+			meshlet.mConeAxis[0] = axis.x;
+			meshlet.mConeAxis[1] = axis.y;
+			meshlet.mConeAxis[2] = axis.z;
+			// Sine of the cone's half angle, the viewer has to be that far past the plane of the axis to see only backs
+			meshlet.mConeCutoff = spread <= MIN_CONE_SPREAD ? 1.0f : std::sqrt(1.0f - spread * spread);
+		}
+
+		/// <summary>
+		/// Corners of a triangle rotated to start from the smallest one, winding kept
+		/// </summary>
+		std::array<uint32_t, 3> CanonicalTriangle(uint32_t a, uint32_t b, uint32_t c) {
+			if (b < a && b < c) return { b, c, a };
+			if (c < a && c < b) return { c, a, b };
+			return { a, b, c };
+		}
+	}
+
+	uint32_t MeshletBuilder::Build(std::span<const Vertex> vertices, std::span<const uint32_t> indices, const MeshletSettings& settings,
+		MeshletGeometry& result)
+	{
+		// Corners are stored in 8 bits and every triangle has to fit on its own
+		OTTER_ASSERT(settings.mMaxVertices >= 3 && settings.mMaxVertices <= 256 && settings.mMaxTriangles >= 1,
+			"[MESHLET BUILDER] Meshlets of {} vertices and {} triangles are not supported!", settings.mMaxVertices, settings.mMaxTriangles);
+
+		const size_t triangleCount = indices.size() / 3;
+		const size_t firstMeshlet = result.mMeshlets.size();
+		if (triangleCount == 0) {
+			return 0;
+		}
+
+		const VertexTriangles adjacency(indices, vertices.size());
+		std::vector<bool> isEmitted(triangleCount, false);
+		std::vector<uint32_t> localIndices(vertices.size(), NOT_IN_MESHLET);
+
+		Meshlet meshlet;
+		meshlet.mVertexOffset = static_cast<uint32_t>(result.mVertices.size());
+		meshlet.mTriangleOffset = static_cast<uint32_t>(result.mTriangles.size());
+		glm::vec3 positionSum(0.0f);
+
+		// Unemitted triangles touching the meshlet, emitted ones are dropped lazily
+		std::vector<uint32_t> candidates;
+		size_t seedCursor = 0;
+
+		auto countNewVertices = [&](uint32_t triangle) {
+			uint32_t count = 0;
+			for (size_t corner = 0; corner < 3; ++corner) {
+				count += localIndices[indices[size_t(triangle) * 3 + corner]] == NOT_IN_MESHLET ? 1 : 0;
+			}
+			return count;
+		};
+
+		auto closeMeshlet = [&]() {
+			const std::span<const uint32_t> meshletVertices(result.mVertices.data() + meshlet.mVertexOffset, meshlet.mVertexCount);
+			const std::span<const uint8_t> meshletTriangles(result.mTriangles.data() + meshlet.mTriangleOffset, size_t(meshlet.mTriangleCount) * 3);
+			ComputeSphere(vertices, meshletVertices, meshlet);
+			ComputeCone(vertices, meshletVertices, meshletTriangles, meshlet);
+
+			for (uint32_t vertex : meshletVertices) {
+				localIndices[vertex] = NOT_IN_MESHLET;
+			}
+			result.mMeshlets.push_back(meshlet);
+
+			meshlet = Meshlet();
+			meshlet.mVertexOffset = static_cast<uint32_t>(result.mVertices.size());
+			meshlet.mTriangleOffset = static_cast<uint32_t>(result.mTriangles.size());
+			positionSum = glm::vec3(0.0f);
+			candidates.clear();
+		};
+
+		auto emitTriangle = [&](uint32_t triangle) {
+			for (size_t corner = 0; corner < 3; ++corner) {
+				const uint32_t vertex = indices[size_t(triangle) * 3 + corner];
+				if (localIndices[vertex] == NOT_IN_MESHLET) {
+					localIndices[vertex] = meshlet.mVertexCount++;
+					result.mVertices.push_back(vertex);
+					positionSum += vertices[vertex].mPosition;
+
+					for (uint32_t neighbour : adjacency.Around(vertex)) {
+						if (!isEmitted[neighbour]) {
+							candidates.push_back(neighbour);
+						}
+					}
+				}
+				result.mTriangles.push_back(static_cast<uint8_t>(localIndices[vertex]));
+			}
+			isEmitted[triangle] = true;
+			++meshlet.mTriangleCount;
+		};
+
+		for (size_t emitted = 0; emitted < triangleCount; ++emitted) {
+			// Cheapest neighbour first, then the closest one to the meshlet center
+			uint32_t best = NOT_IN_MESHLET;
+			uint32_t bestNewVertices = UINT32_MAX;
+			float bestDistance = std::numeric_limits<float>::max();
+			const glm::vec3 center = meshlet.mVertexCount > 0 ? positionSum / float(meshlet.mVertexCount) : glm::vec3(0.0f);
+
+			size_t liveCandidates = 0;
+			for (uint32_t triangle : candidates) {
+				if (isEmitted[triangle]) {
+					continue;
+				}
+				candidates[liveCandidates++] = triangle;
+
+				const uint32_t newVertices = countNewVertices(triangle);
+				if (meshlet.mVertexCount + newVertices > settings.mMaxVertices || newVertices > bestNewVertices) {
+					continue;
+				}
+
+				const glm::vec3 centroid = (vertices[indices[size_t(triangle) * 3]].mPosition +
+					vertices[indices[size_t(triangle) * 3 + 1]].mPosition +
+					vertices[indices[size_t(triangle) * 3 + 2]].mPosition) / 3.0f;
+				const glm::vec3 offset = centroid - center;
+				const float distance = glm::dot(offset, offset);
+				if (newVertices < bestNewVertices || distance < bestDistance) {
+					best = triangle;
+					bestNewVertices = newVertices;
+					bestDistance = distance;
+				}
+			}
+			candidates.resize(liveCandidates);
+
+			// Without a connected triangle, the next one in index order is usually nearby once the mesh is optimized
+			if (best == NOT_IN_MESHLET) {
+				while (isEmitted[seedCursor]) {
+					++seedCursor;
+				}
+				if (meshlet.mVertexCount + countNewVertices(static_cast<uint32_t>(seedCursor)) > settings.mMaxVertices) {
+					closeMeshlet();
+				}
+				best = static_cast<uint32_t>(seedCursor);
+			}
+
+			emitTriangle(best);
+			if (meshlet.mTriangleCount == settings.mMaxTriangles) {
+				closeMeshlet();
+			}
+		}
+
+		if (meshlet.mTriangleCount > 0) {
+			closeMeshlet();
+		}
+
+		OTTER_ASSERT(CoversTriangles(result, std::span<const Meshlet>(result.mMeshlets).subspan(firstMeshlet), indices),
+			"[MESHLET BUILDER] Meshlets do not cover the {} triangles of the mesh!", triangleCount);
+		return static_cast<uint32_t>(result.mMeshlets.size() - firstMeshlet);
+	}
+
+	bool MeshletBuilder::CoversTriangles(const MeshletGeometry& geometry, std::span<const Meshlet> meshlets, std::span<const uint32_t> indices)
+	{
+		std::vector<std::array<uint32_t, 3>> expected;
+		expected.reserve(indices.size() / 3);
+		for (size_t corner = 0; corner + 2 < indices.size(); corner += 3) {
+			expected.push_back(CanonicalTriangle(indices[corner], indices[corner + 1], indices[corner + 2]));
+		}
+
+		std::vector<std::array<uint32_t, 3>> covered;
+		covered.reserve(expected.size());
+		for (const Meshlet& meshlet : meshlets) {
+			if (uint64_t(meshlet.mVertexOffset) + meshlet.mVertexCount > geometry.mVertices.size() ||
+				uint64_t(meshlet.mTriangleOffset) + uint64_t(meshlet.mTriangleCount) * 3 > geometry.mTriangles.size()) {
+				return false;
+			}
+
+			const uint32_t* meshletVertices = geometry.mVertices.data() + meshlet.mVertexOffset;
+			const uint8_t* triangles = geometry.mTriangles.data() + meshlet.mTriangleOffset;
+			for (size_t corner = 0; corner < size_t(meshlet.mTriangleCount) * 3; corner += 3) {
+				if (triangles[corner] >= meshlet.mVertexCount || triangles[corner + 1] >= meshlet.mVertexCount ||
+					triangles[corner + 2] >= meshlet.mVertexCount) {
+					return false;
+				}
+				covered.push_back(CanonicalTriangle(meshletVertices[triangles[corner]], meshletVertices[triangles[corner + 1]],
+					meshletVertices[triangles[corner + 2]]));
+			}
+		}
+
+		// Same triangles as often, in any order
+		std::sort(expected.begin(), expected.end());
+		std::sort(covered.begin(), covered.end());
+		return expected == covered;
+	}
+}
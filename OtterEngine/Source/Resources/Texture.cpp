@@ -1,39 +1,207 @@
 #include "OtterPCH.h"
 
+// stb_image picks SSE2 by itself on x86, NEON has to be requested explicitly
+#if defined(__ARM_NEON) || defined(_M_ARM64)
+#define STBI_NEON
+#endif
 #define STB_IMAGE_IMPLEMENTATION
-#define STB_NO_SIMD // TODO
 #include <stb_image.h>
 
+#include "Utils/PathFormat.h"
+#include "Utils/MappedFile.h"
+#include "Resources/BlockCompression.h"
 #include "Resources/Texture.h"
 
 namespace OtterEngine {
+	namespace {
+		// The vector keeps owning the pixels, the buffer only aliases its storage
+		Texture::PixelBuffer MakePixelBuffer(std::vector<uint8_t> pixels) {
+			auto owner = std::make_shared<std::vector<uint8_t>>(std::move(pixels));
+			return Texture::PixelBuffer(owner, owner->data());
+		}
+
+		bool IsSourceImage(const std::filesystem::path& path) {
+			std::string extension = path.extension().string();
+			std::transform(extension.begin(), extension.end(), extension.begin(),
+				[](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+			return extension == ".png" || extension == ".jpg" || extension == ".jpeg" ||
+				extension == ".tga" || extension == ".bmp";
+		}
+	}
+
 	Texture::Texture(int width, int height, int channels, std::vector<uint8_t> pixels)
-		: mWidth(width), mHeight(height), mChannels(channels), mPixels(std::move(pixels)) { }
+		: mWidth(width), mHeight(height), mChannels(channels), mByteSize(pixels.size()) {
+		mPixels = MakePixelBuffer(std::move(pixels));
+		mMips.push_back({ static_cast<uint32_t>(width), static_cast<uint32_t>(height), 0, mByteSize });
+	}
+
+	Texture::Texture(int width, int height, int channels, PixelBuffer pixels, size_t byteSize)
+		: mWidth(width), mHeight(height), mChannels(channels), mPixels(std::move(pixels)), mByteSize(byteSize) {
+		mMips.push_back({ static_cast<uint32_t>(width), static_cast<uint32_t>(height), 0, byteSize });
+	}
+
+	Texture::Texture(TextureCompression compression, std::vector<TextureMip> mips, PixelBuffer pixels, size_t byteSize, bool isSRGB)
+		: mChannels(4), mPixels(std::move(pixels)), mByteSize(byteSize),
+		mCompression(compression), mIsSRGB(isSRGB), mMips(std::move(mips)) {
+		if (!mMips.empty()) {
+			mWidth = static_cast<int>(mMips[0].mWidth);
+			mHeight = static_cast<int>(mMips[0].mHeight);
+		}
+	}
 
 	std::shared_ptr<Texture> Texture::LoadFromFile(const std::filesystem::path& path)
 	{
+		if (path.extension() == COOKED_TEXTURE_EXTENSION) {
+			return LoadCooked(path);
+		}
+
+		if (IsSourceImage(path)) {
+			// Prefer a cooked copy sitting next to the source, as long as it is not stale
+			std::filesystem::path cookedPath = path;
+			cookedPath.replace_extension(COOKED_TEXTURE_EXTENSION);
+
+			std::error_code cookedError, sourceError;
+			auto cookedTime = std::filesystem::last_write_time(cookedPath, cookedError);
+			auto sourceTime = std::filesystem::last_write_time(path, sourceError);
+			if (!cookedError && (sourceError || cookedTime >= sourceTime)) {
+				if (auto cooked = LoadCooked(cookedPath)) {
+					return cooked;
+				}
+				OTTER_CORE_WARNING("[TEXTURE] Falling back to source image '{}'", path);
+			}
+
+			return ImportImage(path);
+		}
+
+		OTTER_CORE_WARNING("[TEXTURE] Unsupported texture format: {}", path);
+		return nullptr;
+	}
+
+	std::shared_ptr<Texture> Texture::ImportImage(const std::filesystem::path& path)
+	{
+		auto startTime = std::chrono::high_resolution_clock::now();
+
+		std::unique_ptr<MappedFile> file = MappedFile::Open(path);
+		if (!file) {
+			return nullptr;
+		}
+
 		int width, height, channels;
-		std::string pathStr = path.string();
-		stbi_uc* pixels = stbi_load(pathStr.c_str(), 
+		stbi_uc* pixels = stbi_load_from_memory(
+			reinterpret_cast<const stbi_uc*>(file->GetData()),
+			static_cast<int>(file->GetSize()),
 			&width,
-            &height, 
+			&height,
 			&channels,
 			STBI_rgb_alpha);
 
 		if (!pixels) {
 			const char* reason = stbi_failure_reason();
-			OTTER_CORE_ERROR("[TEXTURE] Failed to load '{}': {}", pathStr, reason ? reason : "Unknown error");
+			OTTER_CORE_ERROR("[TEXTURE] Failed to load '{}': {}", path.string(), reason ? reason : "Unknown error");
 			return nullptr;
 		}
 
+		// Take ownership of the decoder output as is, stb_image releases it
+		PixelBuffer pixelData(pixels, [](const uint8_t* data) { stbi_image_free(const_cast<uint8_t*>(data)); });
 		const size_t imageSize = static_cast<size_t>(width) * height * 4;
-		std::vector<uint8_t> pixelData(imageSize);
-        memcpy(pixelData.data(), pixels, imageSize);
 
-        stbi_image_free(pixels);
+		float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+		OTTER_CORE_LOG("[TEXTURE] Loaded: {}x{} ({} channels -> 4) in {:.2f} ms", width, height, channels, elapsedMs);
+
+		return std::make_shared<Texture>(width, height, 4, std::move(pixelData), imageSize);
+	}
+
+	std::shared_ptr<Texture> Texture::LoadCooked(const std::filesystem::path& path)
+	{
+		auto startTime = std::chrono::high_resolution_clock::now();
+
+		std::unique_ptr<MappedFile> file = MappedFile::Open(path);
+		if (!file) {
+			return nullptr;
+		}
+
+		const uint64_t fileSize = file->GetSize();
+		if (fileSize < sizeof(CookedTextureHeader)) {
+			OTTER_CORE_ERROR("[TEXTURE] Cooked texture '{}' is truncated", path);
+			return nullptr;
+		}
+
+		CookedTextureHeader header;
+		memcpy(&header, file->GetData(), sizeof(header));
+
+		if (header.mMagic != COOKED_TEXTURE_MAGIC || header.mVersion != COOKED_TEXTURE_VERSION) {
+			OTTER_CORE_ERROR("[TEXTURE] '{}' is not a cooked texture of version {} (found magic 0x{:x}, version {})",
+				path, COOKED_TEXTURE_VERSION, header.mMagic, header.mVersion);
+			return nullptr;
+		}
+
+		const auto compression = static_cast<TextureCompression>(header.mCompression);
+		if (compression != TextureCompression::None && compression != TextureCompression::BC1 &&
+			compression != TextureCompression::BC7) {
+			OTTER_CORE_ERROR("[TEXTURE] Cooked texture '{}' uses unknown compression {}", path, header.mCompression);
+			return nullptr;
+		}
+
+		const uint64_t mipTableEnd = sizeof(CookedTextureHeader) + static_cast<uint64_t>(header.mMipCount) * sizeof(CookedTextureMip);
+		if (header.mMipCount == 0 || header.mMipCount > 32 || mipTableEnd > fileSize ||
+			header.mDataOffset < mipTableEnd || header.mDataOffset > fileSize ||
+			header.mDataSize > fileSize - header.mDataOffset) {
+			OTTER_CORE_ERROR("[TEXTURE] Cooked texture '{}' has corrupted block offsets", path);
+			return nullptr;
+		}
+
+		std::vector<TextureMip> mips(header.mMipCount);
+		for (uint32_t level = 0; level < header.mMipCount; ++level) {
+			CookedTextureMip cookedMip;
+			memcpy(&cookedMip, file->GetData() + sizeof(CookedTextureHeader) + level * sizeof(CookedTextureMip), sizeof(cookedMip));
 
-		OTTER_CORE_LOG("[TEXTURE] Loaded: {}x{} ({} channels -> 4)", width, height, channels);
+			const bool isConsistent = cookedMip.mWidth > 0 && cookedMip.mHeight > 0 &&
+				cookedMip.mSize == BlockCompression::GetImageByteSize(compression, cookedMip.mWidth, cookedMip.mHeight) &&
+				cookedMip.mOffset <= header.mDataSize && cookedMip.mSize <= header.mDataSize - cookedMip.mOffset &&
+				(level > 0 || (cookedMip.mWidth == header.mWidth && cookedMip.mHeight == header.mHeight));
+			if (!isConsistent) {
+				OTTER_CORE_ERROR("[TEXTURE] Cooked texture '{}' has a corrupted mip {}", path, level);
+				return nullptr;
+			}
+
+			mips[level] = { cookedMip.mWidth, cookedMip.mHeight,
+				static_cast<size_t>(cookedMip.mOffset), static_cast<size_t>(cookedMip.mSize) };
+		}
+
+		// The mip data is read in place, the buffer keeps the mapping alive
+		std::shared_ptr<MappedFile> mapping = std::move(file);
+		PixelBuffer pixels(mapping, reinterpret_cast<const uint8_t*>(mapping->GetData() + header.mDataOffset));
+
+		auto texture = std::make_shared<Texture>(compression, std::move(mips), std::move(pixels),
+			static_cast<size_t>(header.mDataSize), (header.mFlags & COOKED_TEXTURE_FLAG_SRGB) != 0);
+
+		float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+		OTTER_CORE_LOG("[TEXTURE] Mapped cooked texture: {}x{}, {} mips from {} in {:.2f} ms",
+			header.mWidth, header.mHeight, header.mMipCount, path, elapsedMs);
+
+		return texture;
+	}
+
+	std::shared_ptr<Texture> Texture::Decompress() const
+	{
+		if (!IsCompressed()) {
+			return nullptr;
+		}
+
+		std::vector<TextureMip> mips;
+		std::vector<uint8_t> pixels;
+		mips.reserve(mMips.size());
+
+		for (uint32_t level = 0; level < GetMipCount(); ++level) {
+			const TextureMip& mip = mMips[level];
+			std::vector<uint8_t> decoded = BlockCompression::Decompress(mCompression, GetMipData(level).data(), mip.mWidth, mip.mHeight);
+
+			mips.push_back({ mip.mWidth, mip.mHeight, pixels.size(), decoded.size() });
+			pixels.insert(pixels.end(), decoded.begin(), decoded.end());
+		}
 
-		return std::make_shared<Texture>(width, height, 4, std::move(pixelData));
+		size_t byteSize = pixels.size();
+		return std::make_shared<Texture>(TextureCompression::None, std::move(mips),
+			MakePixelBuffer(std::move(pixels)), byteSize, mIsSRGB);
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,231 @@
+#include "OtterPCH.h"
+
+#include <cmath>
+#include <limits>
+#include <fstream>
+
+#include "Core/JobSystem.h"
+#include "Utils/PathFormat.h"
+#include "Resources/BlockCompression.h"
+
+#include "Resources/TextureCooker.h"
+
+namespace OtterEngine {
+	namespace {
+		struct MipImage {
+			uint32_t mWidth = 0;
+			uint32_t mHeight = 0;
+			std::vector<uint8_t> mPixels;
+		};
+
+		const char* GetCompressionName(TextureCompression compression) {
+			switch (compression) {
+			case TextureCompression::BC1: return "BC1";
+			case TextureCompression::BC7: return "BC7";
+			case TextureCompression::None:
+			default: return "RGBA8";
+			}
+		}
+
+		float SRGBToLinear(float value) {
+			return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+		}
+
+		float LinearToSRGB(float value) {
+			return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+		}
+
+		/// <summary>
+		/// Halves an image with a 2x2 box filter, color channels are averaged in linear space for sRGB images
+		/// </summary>
+		MipImage Downsample(const MipImage& source, bool isSRGB) {
+			static const auto sLinearTable = []() {
+				std::array<float, 256> table{};
+				for (int i = 0; i < 256; ++i) table[i] = SRGBToLinear(i / 255.0f);
+				return table;
+			}();
+
+			MipImage target;
+			target.mWidth = std::max(1u, source.mWidth / 2);
+			target.mHeight = std::max(1u, source.mHeight / 2);
+			target.mPixels.resize(static_cast<size_t>(target.mWidth) * target.mHeight * 4);
+
+			JobSystem::ParallelFor(target.mHeight, [&](size_t y) {
+				uint32_t y0 = std::min(static_cast<uint32_t>(y) * 2, source.mHeight - 1);
+				uint32_t y1 = std::min(y0 + 1, source.mHeight - 1);
+
+				for (uint32_t x = 0; x < target.mWidth; ++x) {
+					uint32_t x0 = std::min(x * 2, source.mWidth - 1);
+					uint32_t x1 = std::min(x0 + 1, source.mWidth - 1);
+
+					const uint8_t* samples[4] = {
+						&source.mPixels[(static_cast<size_t>(y0) * source.mWidth + x0) * 4],
+						&source.mPixels[(static_cast<size_t>(y0) * source.mWidth + x1) * 4],
+						&source.mPixels[(static_cast<size_t>(y1) * source.mWidth + x0) * 4],
+						&source.mPixels[(static_cast<size_t>(y1) * source.mWidth + x1) * 4]
+					};
+
+					uint8_t* output = &target.mPixels[(y * target.mWidth + x) * 4];
+					for (int c = 0; c < 4; ++c) {
+						float sum = 0.0f;
+						const bool isLinearized = isSRGB && c < 3;
+						for (const uint8_t* sample : samples) {
+							sum += isLinearized ? sLinearTable[sample[c]] : sample[c] / 255.0f;
+						}
+
+						float average = sum * 0.25f;
+						if (isLinearized) average = LinearToSRGB(average);
+						output[c] = static_cast<uint8_t>(std::clamp(std::lround(average * 255.0f), 0l, 255l));
+					}
+				}
+			});
+
+			return target;
+		}
+
+		void WritePadding(std::ofstream& stream, uint64_t alignedOffset) {
+			static constexpr char zeros[COOKED_TEXTURE_BLOCK_ALIGNMENT] = {};
+			uint64_t current = static_cast<uint64_t>(stream.tellp());
+			stream.write(zeros, static_cast<std::streamsize>(alignedOffset - current));
+		}
+	}
+
+	bool TextureCooker::Cook(const std::filesystem::path& source, std::filesystem::path destination,
+		const TextureCookSettings& settings)
+	{
+		if (destination.empty()) {
+			destination = source;
+			destination.replace_extension(COOKED_TEXTURE_EXTENSION);
+		}
+
+		auto image = Texture::ImportImage(source);
+		if (!image || !image->IsValid()) {
+			OTTER_CORE_ERROR("[TEXTURE COOKER] Failed to import '{}'", source);
+			return false;
+		}
+
+		auto startTime = std::chrono::high_resolution_clock::now();
+
+		// Build the whole chain down to 1x1
+		std::vector<MipImage> levels;
+		levels.push_back({ static_cast<uint32_t>(image->GetWidth()), static_cast<uint32_t>(image->GetHeight()),
+			std::vector<uint8_t>(image->GetPixels().begin(), image->GetPixels().end()) });
+		while (settings.mGenerateMips && (levels.back().mWidth > 1 || levels.back().mHeight > 1)) {
+			levels.push_back(Downsample(levels.back(), settings.mIsSRGB));
+		}
+
+		std::vector<TextureMip> mips;
+		std::vector<uint8_t> data;
+		double lowestPSNR = std::numeric_limits<double>::infinity();
+
+		for (uint32_t level = 0; level < levels.size(); ++level) {
+			const MipImage& mip = levels[level];
+			std::vector<uint8_t> encoded = BlockCompression::Compress(settings.mCompression, mip.mPixels.data(), mip.mWidth, mip.mHeight);
+
+			// Validate by decoding the blocks exactly as they will be stored
+			if (settings.mMinPSNR > 0.0 && settings.mCompression != TextureCompression::None) {
+				std::vector<uint8_t> decoded = BlockCompression::Decompress(settings.mCompression, encoded.data(), mip.mWidth, mip.mHeight);
+				double psnr = ComputePSNR(mip.mPixels.data(), decoded.data(), static_cast<size_t>(mip.mWidth) * mip.mHeight);
+				lowestPSNR = std::min(lowestPSNR, psnr);
+
+				OTTER_CORE_TRACE("[TEXTURE COOKER] Mip {} ({}x{}): {:.2f} dB", level, mip.mWidth, mip.mHeight, psnr);
+				if (psnr < settings.mMinPSNR) {
+					OTTER_CORE_ERROR("[TEXTURE COOKER] Mip {} of '{}' reaches {:.2f} dB once compressed, below the {:.2f} dB threshold",
+						level, source, psnr, settings.mMinPSNR);
+					return false;
+				}
+			}
+
+			size_t offset = static_cast<size_t>(AlignCookedTextureOffset(data.size()));
+			data.resize(offset);
+			data.insert(data.end(), encoded.begin(), encoded.end());
+			mips.push_back({ mip.mWidth, mip.mHeight, offset, encoded.size() });
+		}
+
+		float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+		OTTER_CORE_LOG("[TEXTURE COOKER] Encoded {} mips as {} in {:.2f} ms, lowest PSNR {:.2f} dB",
+			mips.size(), GetCompressionName(settings.mCompression), elapsedMs, lowestPSNR);
+
+		size_t byteSize = data.size();
+		auto owner = std::make_shared<std::vector<uint8_t>>(std::move(data));
+		Texture cooked(settings.mCompression, std::move(mips), Texture::PixelBuffer(owner, owner->data()),
+			byteSize, settings.mIsSRGB);
+
+		return Write(cooked, destination);
+	}
+
+	bool TextureCooker::Write(const Texture& texture, const std::filesystem::path& destination)
+	{
+		CookedTextureHeader header;
+		header.mCompression = static_cast<uint32_t>(texture.GetCompression());
+		header.mFlags = texture.IsSRGB() ? COOKED_TEXTURE_FLAG_SRGB : 0;
+		header.mWidth = static_cast<uint32_t>(texture.GetWidth());
+		header.mHeight = static_cast<uint32_t>(texture.GetHeight());
+		header.mMipCount = texture.GetMipCount();
+		header.mDataOffset = AlignCookedTextureOffset(sizeof(CookedTextureHeader) + header.mMipCount * sizeof(CookedTextureMip));
+
+		std::vector<CookedTextureMip> mipTable;
+		uint64_t dataSize = 0;
+		for (const TextureMip& mip : texture.GetMips()) {
+			uint64_t offset = AlignCookedTextureOffset(dataSize);
+			mipTable.push_back({ mip.mWidth, mip.mHeight, offset, mip.mSize });
+			dataSize = offset + mip.mSize;
+		}
+		header.mDataSize = dataSize;
+
+		// Write next to the destination first, so readers never map a half-written file
+		std::filesystem::path tempPath = destination;
+		tempPath += ".tmp";
+
+		{
+			std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+			if (!stream.is_open()) {
+				OTTER_CORE_ERROR("[TEXTURE COOKER] Failed to open '{}' for writing", tempPath);
+				return false;
+			}
+
+			stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			stream.write(reinterpret_cast<const char*>(mipTable.data()),
+				static_cast<std::streamsize>(mipTable.size() * sizeof(CookedTextureMip)));
+
+			for (uint32_t level = 0; level < header.mMipCount; ++level) {
+				WritePadding(stream, header.mDataOffset + mipTable[level].mOffset);
+				std::span<const uint8_t> mipData = texture.GetMipData(level);
+				stream.write(reinterpret_cast<const char*>(mipData.data()), static_cast<std::streamsize>(mipData.size()));
+			}
+
+			if (!stream.good()) {
+				OTTER_CORE_ERROR("[TEXTURE COOKER] Failed while writing '{}'", tempPath);
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempPath, destination, error);
+		if (error) {
+			OTTER_CORE_ERROR("[TEXTURE COOKER] Failed to move cooked texture to '{}': {}", destination, error.message());
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+
+		OTTER_CORE_LOG("[TEXTURE COOKER] Cooked {}x{} texture, {} mips, {} bytes into {}",
+			header.mWidth, header.mHeight, header.mMipCount, header.mDataSize, destination);
+		return true;
+	}
+
+	double TextureCooker::ComputePSNR(const uint8_t* reference, const uint8_t* test, size_t pixelCount)
+	{
+		uint64_t squaredError = 0;
+		for (size_t i = 0; i < pixelCount * 4; ++i) {
+			int delta = static_cast<int>(reference[i]) - static_cast<int>(test[i]);
+			squaredError += static_cast<uint64_t>(delta * delta);
+		}
+
+		if (squaredError == 0) {
+			return std::numeric_limits<double>::infinity();
+		}
+
+		double meanSquaredError = static_cast<double>(squaredError) / static_cast<double>(pixelCount * 4);
+		return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+	}
+}
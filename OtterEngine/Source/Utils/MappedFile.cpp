@@ -0,0 +1,85 @@
+#include "OtterPCH.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "Utils/PathFormat.h"
+#include "Utils/MappedFile.h"
+
+namespace OtterEngine {
+	MappedFile::~MappedFile()
+	{
+#ifdef _WIN32
+		if (pData) UnmapViewOfFile(pData);
+		if (mMappingHandle) CloseHandle(mMappingHandle);
+		if (mFileHandle && mFileHandle != INVALID_HANDLE_VALUE) CloseHandle(mFileHandle);
+#else
+		if (pData) munmap(const_cast<std::byte*>(pData), mSize);
+		if (mFileDescriptor >= 0) close(mFileDescriptor);
+#endif
+	}
+
+	std::unique_ptr<MappedFile> MappedFile::Open(const std::filesystem::path& path)
+	{
+		std::unique_ptr<MappedFile> file(new MappedFile());
+
+#ifdef _WIN32
+		file->mFileHandle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file->mFileHandle == INVALID_HANDLE_VALUE) {
+			OTTER_CORE_ERROR("[MAPPED FILE] Failed to open '{}'", path);
+			return nullptr;
+		}
+
+		LARGE_INTEGER fileSize{};
+		if (!GetFileSizeEx(file->mFileHandle, &fileSize) || fileSize.QuadPart == 0) {
+			OTTER_CORE_ERROR("[MAPPED FILE] '{}' is empty or its size is unavailable", path);
+			return nullptr;
+		}
+		file->mSize = static_cast<size_t>(fileSize.QuadPart);
+
+		file->mMappingHandle = CreateFileMappingW(file->mFileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!file->mMappingHandle) {
+			OTTER_CORE_ERROR("[MAPPED FILE] Failed to create file mapping for '{}'", path);
+			return nullptr;
+		}
+
+		file->pData = static_cast<const std::byte*>(MapViewOfFile(file->mMappingHandle, FILE_MAP_READ, 0, 0, 0));
+#else
+		file->mFileDescriptor = open(path.c_str(), O_RDONLY);
+		if (file->mFileDescriptor < 0) {
+			OTTER_CORE_ERROR("[MAPPED FILE] Failed to open '{}'", path);
+			return nullptr;
+		}
+
+		struct stat fileStat{};
+		if (fstat(file->mFileDescriptor, &fileStat) != 0 || fileStat.st_size == 0) {
+			OTTER_CORE_ERROR("[MAPPED FILE] '{}' is empty or its size is unavailable", path);
+			return nullptr;
+		}
+		file->mSize = static_cast<size_t>(fileStat.st_size);
+
+		void* mapping = mmap(nullptr, file->mSize, PROT_READ, MAP_PRIVATE, file->mFileDescriptor, 0);
+		if (mapping != MAP_FAILED) {
+			// Cooked assets are consumed front to back right after mapping
+			madvise(mapping, file->mSize, MADV_WILLNEED);
+			file->pData = static_cast<const std::byte*>(mapping);
+		}
+#endif
+
+		if (!file->pData) {
+			OTTER_CORE_ERROR("[MAPPED FILE] Failed to map '{}' in memory", path);
+			return nullptr;
+		}
+
+		return file;
+	}
+}
@@ -2,6 +2,7 @@
 
 #include <fstream>
 
+#include "Utils/PathFormat.h"
 #include "Utils/OtterIO.h"
 
 namespace OtterEngine {
@@ -21,4 +22,49 @@ namespace OtterEngine {
 
 		return buffer;
 	}
+
+	std::optional<std::vector<char>> OtterIO::TryReadFile(const std::filesystem::path& path) {
+		std::ifstream file(path, std::ios::ate | std::ios::binary);
+		if (!file.is_open()) return std::nullopt;
+
+		std::vector<char> buffer(static_cast<size_t>(file.tellg()));
+
+		file.seekg(0, std::ios::beg);
+		file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+		if (!file.good()) return std::nullopt;
+
+		return buffer;
+	}
+
+	bool OtterIO::WriteFileAtomic(const std::filesystem::path& path, std::span<const char> data) {
+		std::error_code error;
+		if (path.has_parent_path()) {
+			std::filesystem::create_directories(path.parent_path(), error);
+		}
+
+		std::filesystem::path tempPath = path;
+		tempPath += ".tmp";
+
+		{
+			std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+			if (!stream.is_open()) {
+				OTTER_CORE_ERROR("[IO] Failed to open '{}' for writing", tempPath);
+				return false;
+			}
+
+			stream.write(data.data(), static_cast<std::streamsize>(data.size()));
+			if (!stream.good()) {
+				OTTER_CORE_ERROR("[IO] Failed while writing '{}'", tempPath);
+				return false;
+			}
+		}
+
+		std::filesystem::rename(tempPath, path, error);
+		if (error) {
+			OTTER_CORE_ERROR("[IO] Failed to move '{}' to '{}': {}", tempPath, path, error.message());
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+		return true;
+	}
 }
@@ -0,0 +1,123 @@
+#include "OtterPCH.h"
+
+#include "Utils/RangeAllocator.h"
+
+namespace OtterEngine {
+	RangeAllocator::RangeAllocator(uint64_t size)
+	{
+		Reset(size);
+	}
+
+	void RangeAllocator::Reset(uint64_t size)
+	{
+		mSize = size;
+		mUsedBytes = 0;
+		mAllocationCount = 0;
+		mFreeByOffset.clear();
+		mFreeBySize.clear();
+
+		if (size > 0) {
+			InsertFreeRange(0, size);
+		}
+	}
+
+	uint64_t RangeAllocator::Allocate(uint64_t size, uint64_t alignment)
+	{
+		if (size == 0) {
+			return INVALID_OFFSET;
+		}
+		alignment = std::max<uint64_t>(alignment, 1);
+
+		// Smallest free range that still fits once its start is aligned
+		for (auto candidate = mFreeBySize.lower_bound({ size, 0 }); candidate != mFreeBySize.end(); ++candidate) {
+			const uint64_t rangeOffset = candidate->second;
+			const uint64_t rangeSize = candidate->first;
+
+			const uint64_t alignedOffset = (rangeOffset + alignment - 1) / alignment * alignment;
+			const uint64_t padding = alignedOffset - rangeOffset;
+			if (padding + size > rangeSize) {
+				continue;
+			}
+
+			EraseFreeRange(mFreeByOffset.find(rangeOffset));
+
+			// The padding in front and whatever is left behind stay free
+			if (padding > 0) {
+				InsertFreeRange(rangeOffset, padding);
+			}
+			if (padding + size < rangeSize) {
+				InsertFreeRange(alignedOffset + size, rangeSize - padding - size);
+			}
+
+			mUsedBytes += size;
+			++mAllocationCount;
+			return alignedOffset;
+		}
+
+		return INVALID_OFFSET;
+	}
+
+	void RangeAllocator::Free(uint64_t offset, uint64_t size)
+	{
+		OTTER_ASSERT(offset != INVALID_OFFSET && offset + size <= mSize, "[RANGE ALLOCATOR] Freeing a range outside of the allocator!");
+		OTTER_ASSERT(mAllocationCount > 0 && mUsedBytes >= size, "[RANGE ALLOCATOR] Freeing more than was allocated!");
+
+		mUsedBytes -= size;
+		--mAllocationCount;
+
+		uint64_t start = offset;
+		uint64_t end = offset + size;
+
+		// Merge with the free neighbours on both sides
+		auto next = mFreeByOffset.lower_bound(offset);
+		if (next != mFreeByOffset.end() && next->first == end) {
+			end += next->second;
+			next = std::next(next);
+			EraseFreeRange(std::prev(next));
+		}
+		if (next != mFreeByOffset.begin()) {
+			auto previous = std::prev(next);
+			if (previous->first + previous->second == start) {
+				start = previous->first;
+				EraseFreeRange(previous);
+			}
+		}
+
+		InsertFreeRange(start, end - start);
+	}
+
+	void RangeAllocator::Grow(uint64_t newSize)
+	{
+		if (newSize <= mSize) {
+			return;
+		}
+
+		const uint64_t oldSize = mSize;
+		mSize = newSize;
+
+		// Extend the free range touching the old end if there is one
+		if (!mFreeByOffset.empty()) {
+			auto last = std::prev(mFreeByOffset.end());
+			if (last->first + last->second == oldSize) {
+				const uint64_t offset = last->first;
+				EraseFreeRange(last);
+				InsertFreeRange(offset, newSize - offset);
+				return;
+			}
+		}
+
+		InsertFreeRange(oldSize, newSize - oldSize);
+	}
+
+	void RangeAllocator::InsertFreeRange(uint64_t offset, uint64_t size)
+	{
+		mFreeByOffset.emplace(offset, size);
+		mFreeBySize.emplace(size, offset);
+	}
+
+	void RangeAllocator::EraseFreeRange(std::map<uint64_t, uint64_t>::iterator range)
+	{
+		mFreeBySize.erase({ range->second, range->first });
+		mFreeByOffset.erase(range);
+	}
+}
@@ -0,0 +1,78 @@
+#include <new>
+#include <atomic>
+#include <cstdlib>
+#include <algorithm>
+
+#include "AllocationCounter.h"
+
+namespace {
+	std::atomic<uint64_t> sAllocationCount{ 0 };
+	std::atomic<size_t> sLiveBytes{ 0 };
+	std::atomic<size_t> sPeakBytes{ 0 };
+
+	// Room in front of each block for its size and the pointer malloc returned
+	constexpr size_t HEADER_SIZE = 2 * sizeof(void*);
+
+	void* CountedAllocate(size_t size, size_t alignment) {
+		alignment = std::max(alignment, HEADER_SIZE);
+		void* block = std::malloc(size + alignment + HEADER_SIZE);
+		if (!block) {
+			// Built without exceptions, there is no std::bad_alloc to throw
+			std::abort();
+		}
+
+		const uintptr_t start = reinterpret_cast<uintptr_t>(block) + HEADER_SIZE;
+		void** user = reinterpret_cast<void**>((start + alignment - 1) / alignment * alignment);
+		user[-1] = reinterpret_cast<void*>(size);
+		user[-2] = block;
+
+		sAllocationCount.fetch_add(1, std::memory_order_relaxed);
+		const size_t live = sLiveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+		size_t peak = sPeakBytes.load(std::memory_order_relaxed);
+		while (live > peak && !sPeakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+		}
+		return user;
+	}
+
+	void CountedFree(void* pointer) {
+		if (!pointer) {
+			return;
+		}
+
+		void** user = static_cast<void**>(pointer);
+		sLiveBytes.fetch_sub(reinterpret_cast<size_t>(user[-1]), std::memory_order_relaxed);
+		std::free(user[-2]);
+	}
+}
+
+namespace OtterTest {
+	AllocationCounter::AllocationCounter() :
+		mStartCount(sAllocationCount.load()),
+		mStartBytes(sLiveBytes.load()) {
+		sPeakBytes.store(mStartBytes);
+	}
+
+	uint64_t AllocationCounter::GetAllocationCount() const {
+		return sAllocationCount.load() - mStartCount;
+	}
+
+	size_t AllocationCounter::GetPeakBytes() const {
+		const size_t peak = sPeakBytes.load();
+		return peak > mStartBytes ? peak - mStartBytes : 0;
+	}
+}
+
+// The nothrow and sized forms of the standard library forward to these
+void* operator new(size_t size) { return CountedAllocate(size, alignof(std::max_align_t)); }
+void* operator new[](size_t size) { return CountedAllocate(size, alignof(std::max_align_t)); }
+void* operator new(size_t size, std::align_val_t alignment) { return CountedAllocate(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment) { return CountedAllocate(size, static_cast<size_t>(alignment)); }
+
+void operator delete(void* pointer) noexcept { CountedFree(pointer); }
+void operator delete[](void* pointer) noexcept { CountedFree(pointer); }
+void operator delete(void* pointer, size_t) noexcept { CountedFree(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { CountedFree(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { CountedFree(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { CountedFree(pointer); }
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept { CountedFree(pointer); }
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept { CountedFree(pointer); }
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace OtterTest {
+
+	/// <summary>
+	/// Heap allocations made through operator new by every thread of the test binary since construction.
+	/// The binary replaces the global operator new and delete to keep these counts, see AllocationCounter.cpp.
+	/// Only one counter is meant to be alive at a time, each one restarts the peak.
+	/// </summary>
+	class AllocationCounter {
+	private:
+		uint64_t mStartCount = 0;
+		size_t mStartBytes = 0;
+
+	public:
+		AllocationCounter();
+
+		// Calls to operator new
+		uint64_t GetAllocationCount() const;
+
+		// Most bytes allocated at once beyond the ones that were live at construction
+		size_t GetPeakBytes() const;
+	};
+}
@@ -0,0 +1,115 @@
+#include <latch>
+#include <thread>
+
+#include "Resources/AssetID.h"
+#include "Resources/Resources.h"
+
+#include "OtterTest.h"
+#include "AllocationCounter.h"
+
+using namespace OtterEngine;
+
+namespace {
+	struct NeverLoaded {
+		static std::shared_ptr<NeverLoaded> LoadFromFile(const fs::path&) { return nullptr; }
+		bool IsValid() const { return true; }
+	};
+
+	struct AlwaysLoaded {
+		static std::shared_ptr<AlwaysLoaded> LoadFromFile(const fs::path&) { return std::make_shared<AlwaysLoaded>(); }
+		bool IsValid() const { return true; }
+	};
+}
+
+OTTER_TEST(AssetRegistry, InternsNormalizedPaths) {
+	const AssetID id = AssetRegistry::Intern("Registry/Textures/Brick.png");
+	OTTER_CHECK(id != INVALID_ASSET_ID);
+	OTTER_CHECK(id == AssetRegistry::MakeID("Registry/Textures/Brick.png"));
+	OTTER_CHECK(AssetRegistry::Intern("Registry/Textures/./Brick.png") == id);
+	OTTER_CHECK(AssetRegistry::Intern("Registry/Meshes/../Textures/Brick.png") == id);
+	OTTER_CHECK(AssetRegistry::GetPath(id) == fs::path("Registry/Textures/Brick.png"));
+	OTTER_CHECK(AssetRegistry::Intern("Registry/Textures/Stone.png") != id);
+}
+
+OTTER_TEST(AssetRegistry, RefusesCollidingPath) {
+	const AssetID id = AssetRegistry::Intern("Registry/Collision/First.png");
+	OTTER_REQUIRE(id != INVALID_ASSET_ID);
+
+	// The first path keeps the ID, the second one gets none instead of sharing it
+	OTTER_CHECK(AssetRegistry::Intern("Registry/Collision/Second.png", id) == INVALID_ASSET_ID);
+	OTTER_CHECK(AssetRegistry::Intern("Registry/Collision/First.png", id) == id);
+	OTTER_CHECK(AssetRegistry::GetPath(id) == fs::path("Registry/Collision/First.png"));
+	OTTER_CHECK(AssetRegistry::Intern("Registry/Collision/Second.png", INVALID_ASSET_ID) == INVALID_ASSET_ID);
+
+	// Loads refuse the invalid ID without looking anything up
+	OTTER_CHECK(!Resources::Load<NeverLoaded>(INVALID_ASSET_ID));
+	ResourceRequest<NeverLoaded> request = Resources::LoadAsync<NeverLoaded>(INVALID_ASSET_ID);
+	OTTER_CHECK(request.IsReady() && request.HasFailed());
+
+	bool isCallbackRun = false;
+	request.OnComplete([&](const ResourceHandle<NeverLoaded>& handle) { isCallbackRun = !handle; });
+	Resources::Update();
+	OTTER_CHECK(isCallbackRun);
+}
+
+OTTER_TEST(AssetRegistry, OneOfConcurrentCollidingPathsWins) {
+	constexpr uint32_t THREAD_COUNT = 8;
+	constexpr uint32_t ROUNDS = 64;
+
+	for (uint32_t round = 0; round < ROUNDS; ++round) {
+		// An ID nothing else uses, claimed by two paths at once
+		const std::string prefix = "Registry/Race" + std::to_string(round);
+		const AssetID id = AssetRegistry::MakeID(prefix + "/Shared");
+
+		std::vector<AssetID> results(THREAD_COUNT);
+		std::latch start(THREAD_COUNT);
+		std::vector<std::thread> threads;
+		for (uint32_t thread = 0; thread < THREAD_COUNT; ++thread) {
+			threads.emplace_back([&, thread]() {
+				start.arrive_and_wait();
+				results[thread] = AssetRegistry::Intern(prefix + (thread % 2 ? "/A" : "/B"), id);
+			});
+		}
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+
+		// Every thread interning the winning path gets the ID, every other thread gets nothing
+		const fs::path& winner = AssetRegistry::GetPath(id);
+		OTTER_REQUIRE(winner == fs::path(prefix + "/A") || winner == fs::path(prefix + "/B"));
+		for (uint32_t thread = 0; thread < THREAD_COUNT; ++thread) {
+			const bool isWinner = fs::path(prefix + (thread % 2 ? "/A" : "/B")) == winner;
+			OTTER_CHECK(results[thread] == (isWinner ? id : INVALID_ASSET_ID));
+		}
+	}
+}
+
+OTTER_BENCHMARK(AssetRegistry, AllocationsPerCacheHit) {
+	constexpr uint32_t LOOKUPS = 100000;
+
+	Resources::AddLoader<AlwaysLoaded>();
+	const fs::path path = "Registry/Benchmark/Hot.png";
+	const AssetID id = Resources::GetAssetID(path);
+	ResourceHandle<AlwaysLoaded> resident = Resources::Load<AlwaysLoaded>(id);
+	OTTER_REQUIRE(resident);
+
+	// The path is built once, what is left is interning it again on every call
+	auto countHits = [&](const char* label, auto&& load) {
+		auto hits = [&]() {
+			for (uint32_t lookup = 0; lookup < LOOKUPS; ++lookup) {
+				OTTER_CHECK(load());
+			}
+		};
+		OtterTest::Measure(label, 1, hits);
+
+		const OtterTest::AllocationCounter counter;
+		hits();
+		std::printf("    %-48s %10.2f\n", "  heap allocations per hit", double(counter.GetAllocationCount()) / double(LOOKUPS));
+	};
+
+	countHits("100k cache hits through an AssetID", [&]() { return Resources::Load<AlwaysLoaded>(id); });
+	countHits("100k cache hits through a path", [&]() { return Resources::Load<AlwaysLoaded>(path); });
+
+	resident = ResourceHandle<AlwaysLoaded>();
+	Resources::ClearAll();
+}
@@ -0,0 +1,225 @@
+#include <cmath>
+#include <array>
+#include <limits>
+
+#include "Resources/BlockCompression.h"
+
+#include "OtterTest.h"
+#include "TestImages.h"
+
+using namespace OtterEngine;
+
+namespace {
+	using Block = std::array<uint8_t, BlockCompression::BLOCK_PIXEL_COUNT * 4>;
+
+	Block MakeSolidBlock(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+		Block block;
+		for (uint32_t p = 0; p < BlockCompression::BLOCK_PIXEL_COUNT; ++p) {
+			block[p * 4 + 0] = r;
+			block[p * 4 + 1] = g;
+			block[p * 4 + 2] = b;
+			block[p * 4 + 3] = a;
+		}
+		return block;
+	}
+
+	// Every channel ramps along x, alpha too unless the block is opaque
+	Block MakeGradientBlock(int from, int to, bool isOpaque) {
+		Block block;
+		for (uint32_t y = 0; y < 4; ++y) {
+			for (uint32_t x = 0; x < 4; ++x) {
+				const int value = from + (to - from) * int(x) / 3;
+				uint8_t* pixel = &block[(y * 4 + x) * 4];
+				pixel[0] = uint8_t(value);
+				pixel[1] = uint8_t(value / 2 + 64);
+				pixel[2] = uint8_t(255 - value);
+				pixel[3] = uint8_t(isOpaque ? 255 : 255 - value / 2);
+			}
+		}
+		return block;
+	}
+
+	double ComputePSNR(const uint8_t* a, const uint8_t* b, size_t pixelCount, int channels) {
+		double squaredError = 0.0;
+		for (size_t p = 0; p < pixelCount; ++p) {
+			for (int c = 0; c < channels; ++c) {
+				const double delta = double(a[p * 4 + c]) - double(b[p * 4 + c]);
+				squaredError += delta * delta;
+			}
+		}
+		if (squaredError == 0.0) return std::numeric_limits<double>::infinity();
+		const double meanSquaredError = squaredError / double(pixelCount * channels);
+		return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+	}
+
+	int GetMaxError(const Block& a, const Block& b, int channels) {
+		int maxError = 0;
+		for (uint32_t p = 0; p < BlockCompression::BLOCK_PIXEL_COUNT; ++p) {
+			for (int c = 0; c < channels; ++c) {
+				maxError = std::max(maxError, std::abs(int(a[p * 4 + c]) - int(b[p * 4 + c])));
+			}
+		}
+		return maxError;
+	}
+
+	Block RoundTripBC1(const Block& block, uint16_t* colors = nullptr) {
+		uint8_t encoded[8];
+		BlockCompression::EncodeBC1Block(block.data(), encoded);
+		if (colors) {
+			colors[0] = uint16_t(encoded[0] | (encoded[1] << 8));
+			colors[1] = uint16_t(encoded[2] | (encoded[3] << 8));
+		}
+
+		Block decoded;
+		BlockCompression::DecodeBC1Block(encoded, decoded.data());
+		return decoded;
+	}
+
+	Block RoundTripBC7(const Block& block, uint8_t* encoded = nullptr) {
+		uint8_t storage[16];
+		encoded = encoded ? encoded : storage;
+		BlockCompression::EncodeBC7Block(block.data(), encoded);
+
+		Block decoded;
+		OTTER_CHECK(BlockCompression::DecodeBC7Block(encoded, decoded.data()));
+		return decoded;
+	}
+}
+
+OTTER_TEST(BlockCompression, BC1SolidBlocks) {
+	// Colors on the 5:6:5 grid come back exactly
+	const Block exact = MakeSolidBlock(132, 65, 222, 255);
+	OTTER_CHECK(RoundTripBC1(exact) == exact);
+
+	// Others within half a 5:6:5 step
+	OtterTest::Random random;
+	for (int i = 0; i < 256; ++i) {
+		const Block solid = MakeSolidBlock(uint8_t(random.Below(256)), uint8_t(random.Below(256)), uint8_t(random.Below(256)), 255);
+		const Block decoded = RoundTripBC1(solid);
+		OTTER_CHECK(GetMaxError(solid, decoded, 3) <= 4);
+		for (uint32_t p = 0; p < BlockCompression::BLOCK_PIXEL_COUNT; ++p) {
+			OTTER_CHECK(decoded[p * 4 + 3] == 255);
+		}
+	}
+}
+
+OTTER_TEST(BlockCompression, BC1GradientUsesFourColors) {
+	const Block gradient = MakeGradientBlock(20, 230, true);
+
+	uint16_t colors[2];
+	const Block decoded = RoundTripBC1(gradient, colors);
+
+	// Opaque blocks are encoded in the 4-color mode, which BC1 signals with color0 > color1
+	OTTER_CHECK(colors[0] > colors[1]);
+	OTTER_CHECK(ComputePSNR(gradient.data(), decoded.data(), 16, 3) > 35.0);
+}
+
+OTTER_TEST(BlockCompression, BC1AlphaPunchthrough) {
+	Block block = MakeGradientBlock(40, 200, true);
+	for (uint32_t p = 0; p < BlockCompression::BLOCK_PIXEL_COUNT; ++p) {
+		block[p * 4 + 3] = (p % 3 == 0) ? 0 : 255;
+	}
+
+	uint16_t colors[2];
+	const Block decoded = RoundTripBC1(block, colors);
+
+	// Transparency is only available in the 3-color mode, color0 <= color1
+	OTTER_CHECK(colors[0] <= colors[1]);
+	for (uint32_t p = 0; p < BlockCompression::BLOCK_PIXEL_COUNT; ++p) {
+		OTTER_CHECK(decoded[p * 4 + 3] == ((p % 3 == 0) ? 0 : 255));
+		if (p % 3 != 0) {
+			for (int c = 0; c < 3; ++c) {
+				OTTER_CHECK(std::abs(int(decoded[p * 4 + c]) - int(block[p * 4 + c])) <= 40);
+			}
+		}
+	}
+
+	// Alpha is cut at 128
+	const Block edge = MakeSolidBlock(90, 90, 90, 128);
+	OTTER_CHECK(RoundTripBC1(edge)[3] == 255);
+	const Block transparent = MakeSolidBlock(90, 90, 90, 127);
+	const Block decodedTransparent = RoundTripBC1(transparent);
+	for (uint32_t p = 0; p < BlockCompression::BLOCK_PIXEL_COUNT; ++p) {
+		OTTER_CHECK(decodedTransparent[p * 4 + 3] == 0);
+	}
+}
+
+OTTER_TEST(BlockCompression, BC7SolidBlocksPickPBits) {
+	// Mode 6 stores 7 bits per channel plus one p-bit per endpoint: a solid color whose channels are all even
+	// or all odd is exact once the matching p-bit is picked
+	const Block even = MakeSolidBlock(200, 50, 98, 254);
+	const Block odd = MakeSolidBlock(201, 51, 99, 255);
+
+	// Every pixel of a solid block reads the first endpoint, whose p-bit is bit 63 of the block
+	uint8_t encoded[16];
+	OTTER_CHECK(RoundTripBC7(even, encoded) == even);
+	OTTER_CHECK(((encoded[7] >> 7) & 1) == 0);
+	OTTER_CHECK(RoundTripBC7(odd, encoded) == odd);
+	OTTER_CHECK(((encoded[7] >> 7) & 1) == 1);
+
+	// Mixed parities interpolate between both p-bits, within one step
+	OtterTest::Random random;
+	for (int i = 0; i < 256; ++i) {
+		const Block solid = MakeSolidBlock(uint8_t(random.Below(256)), uint8_t(random.Below(256)),
+			uint8_t(random.Below(256)), uint8_t(random.Below(256)));
+		OTTER_CHECK(GetMaxError(solid, RoundTripBC7(solid), 4) <= 1);
+	}
+}
+
+OTTER_TEST(BlockCompression, BC7Gradients) {
+	const Block opaque = MakeGradientBlock(10, 240, true);
+	OTTER_CHECK(ComputePSNR(opaque.data(), RoundTripBC7(opaque).data(), 16, 4) > 40.0);
+	const Block translucent = MakeGradientBlock(10, 240, false);
+	OTTER_CHECK(ComputePSNR(translucent.data(), RoundTripBC7(translucent).data(), 16, 4) > 40.0);
+
+	// A ramp landing on the palette between the even endpoints 0 and 252 is exact. The p-bits are shared by
+	// the four channels, so the alpha has to be even too.
+	static constexpr int WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+	Block ramp;
+	for (uint32_t p = 0; p < BlockCompression::BLOCK_PIXEL_COUNT; ++p) {
+		const uint8_t value = uint8_t((WEIGHTS[p] * 252 + 32) >> 6);
+		ramp[p * 4 + 0] = ramp[p * 4 + 1] = ramp[p * 4 + 2] = value;
+		ramp[p * 4 + 3] = 254;
+	}
+	OTTER_CHECK(RoundTripBC7(ramp) == ramp);
+}
+
+OTTER_TEST(BlockCompression, BC7RejectsOtherModes) {
+	uint8_t mode5[16] = { 0x20 };
+	Block decoded;
+	OTTER_CHECK(!BlockCompression::DecodeBC7Block(mode5, decoded.data()));
+	OTTER_CHECK(decoded == MakeSolidBlock(255, 0, 255, 255));
+}
+
+OTTER_TEST(BlockCompression, ImagesWithPartialBlocks) {
+	constexpr uint32_t WIDTH = 37;
+	constexpr uint32_t HEIGHT = 22;
+	const std::vector<uint8_t> pixels = OtterTest::MakeImage(WIDTH, HEIGHT);
+
+	for (TextureCompression compression : { TextureCompression::BC1, TextureCompression::BC7 }) {
+		const std::vector<uint8_t> blocks = BlockCompression::Compress(compression, pixels.data(), WIDTH, HEIGHT);
+		OTTER_REQUIRE(blocks.size() == BlockCompression::GetImageByteSize(compression, WIDTH, HEIGHT));
+		OTTER_CHECK(blocks.size() == 10 * 6 * BlockCompression::GetBlockByteSize(compression));
+
+		const std::vector<uint8_t> decoded = BlockCompression::Decompress(compression, blocks.data(), WIDTH, HEIGHT);
+		OTTER_REQUIRE(decoded.size() == pixels.size());
+		const double psnr = ComputePSNR(pixels.data(), decoded.data(), WIDTH * HEIGHT, 3);
+		OTTER_CHECK(psnr > 32.0);
+	}
+}
+
+OTTER_BENCHMARK(BlockCompression, EncodeImage) {
+	constexpr uint32_t SIZE = 1024;
+	const std::vector<uint8_t> pixels = OtterTest::MakeImage(SIZE, SIZE);
+
+	for (TextureCompression compression : { TextureCompression::BC1, TextureCompression::BC7 }) {
+		std::vector<uint8_t> blocks;
+		const char* label = compression == TextureCompression::BC1 ? "Encode BC1 1024x1024" : "Encode BC7 1024x1024";
+		OtterTest::Measure(label, 3, [&]() {
+			blocks = BlockCompression::Compress(compression, pixels.data(), SIZE, SIZE);
+		});
+
+		const std::vector<uint8_t> decoded = BlockCompression::Decompress(compression, blocks.data(), SIZE, SIZE);
+		std::printf("    %.2f dB\n", ComputePSNR(pixels.data(), decoded.data(), size_t(SIZE) * SIZE, 4));
+	}
+}
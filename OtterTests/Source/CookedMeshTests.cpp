@@ -0,0 +1,182 @@
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#include "Resources/Mesh.h"
+#include "Resources/MeshCooker.h"
+#include "Resources/MeshFormat.h"
+
+#include "OtterTest.h"
+#include "TestMeshes.h"
+
+using namespace OtterEngine;
+
+namespace {
+	/// <summary>
+	/// Drops the cached pages of a file, so that the next read comes from the disk. Linux only.
+	/// </summary>
+	/// <returns>Whether the pages were dropped</returns>
+	bool EvictFromPageCache(const fs::path& path) {
+#ifdef __linux__
+		const int fileDescriptor = open(path.c_str(), O_RDONLY);
+		if (fileDescriptor < 0) {
+			return false;
+		}
+		// Only clean pages can be dropped, and none are on file systems held in memory like tmpfs
+		bool isEvicted = fdatasync(fileDescriptor) == 0 && posix_fadvise(fileDescriptor, 0, 0, POSIX_FADV_DONTNEED) == 0;
+
+		const size_t size = static_cast<size_t>(fs::file_size(path));
+		void* mapping = isEvicted ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fileDescriptor, 0) : MAP_FAILED;
+		if (mapping != MAP_FAILED) {
+			const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+			std::vector<unsigned char> residency((size + pageSize - 1) / pageSize);
+			isEvicted = mincore(mapping, size, residency.data()) == 0 &&
+				std::none_of(residency.begin(), residency.end(), [](unsigned char page) { return page & 1; });
+			munmap(mapping, size);
+		}
+		close(fileDescriptor);
+		return isEvicted;
+#else
+		return false;
+#endif
+	}
+}
+
+OTTER_TEST(CookedMesh, RoundTripsEveryBlock) {
+	const fs::path source = OtterTest::GetTempDirectory() / "grid.obj";
+	const fs::path cooked = OtterTest::GetTempDirectory() / "grid.omesh";
+	OtterTest::WriteGridObj(source, 64);
+
+	auto imported = Mesh::ImportObj(source);
+	OTTER_REQUIRE(imported && imported->IsValid());
+	OTTER_REQUIRE(MeshCooker::Write(*imported, cooked));
+
+	auto mapped = Mesh::LoadFromFile(cooked);
+	OTTER_REQUIRE(mapped && mapped->IsValid());
+	OTTER_CHECK(mapped->IsMemoryMapped());
+	OTTER_CHECK(mapped->GetVertexFormat().GetKey() == imported->GetVertexFormat().GetKey());
+	OTTER_CHECK(mapped->GetIndexType() == imported->GetIndexType());
+	OTTER_CHECK(mapped->GetImportSettingsHash() == imported->GetImportSettingsHash());
+	OTTER_CHECK(OtterTest::SameBytes(mapped->GetVertexData(), imported->GetVertexData()));
+	OTTER_CHECK(OtterTest::SameBytes(mapped->GetIndexData(), imported->GetIndexData()));
+	OTTER_CHECK(OtterTest::SameBytes(mapped->GetChunks(), imported->GetChunks()));
+	OTTER_CHECK(OtterTest::SameBytes(mapped->GetLods(), imported->GetLods()));
+	OTTER_CHECK(OtterTest::SameBytes(mapped->GetMeshlets(), imported->GetMeshlets()));
+	OTTER_CHECK(OtterTest::SameBytes(mapped->GetMeshletVertices(), imported->GetMeshletVertices()));
+	OTTER_CHECK(OtterTest::SameBytes(mapped->GetMeshletTriangles(), imported->GetMeshletTriangles()));
+}
+
+OTTER_TEST(CookedMesh, PrefersFreshCookedCopy) {
+	const fs::path source = OtterTest::GetTempDirectory() / "grid.obj";
+	OtterTest::WriteGridObj(source, 16);
+	OTTER_REQUIRE(MeshCooker::Cook(source));
+
+	auto mesh = Mesh::LoadFromFile(source);
+	OTTER_REQUIRE(mesh);
+	OTTER_CHECK(mesh->IsMemoryMapped());
+}
+
+OTTER_TEST(CookedMesh, RejectsCopyCookedWithOtherSettings) {
+	OtterTest::ImportSettingsScope scope;
+
+	const fs::path source = OtterTest::GetTempDirectory() / "grid.obj";
+	const fs::path cooked = OtterTest::GetTempDirectory() / "grid.omesh";
+	OtterTest::WriteGridObj(source, 16);
+	OTTER_REQUIRE(MeshCooker::Cook(source, cooked));
+
+	// Every setting shaping the mesh has to invalidate the cooked copy
+	const MeshImportSettings base = Mesh::GetImportSettings();
+	std::vector<MeshImportSettings> changes(6, base);
+	changes[0].mQuantization.mEnabled = !base.mQuantization.mEnabled;
+	changes[1].mOptimize = !base.mOptimize;
+	changes[2].mSplitLargeMeshes = !base.mSplitLargeMeshes;
+	changes[3].mSimplification.mTriangleRatios.push_back(0.0625f);
+	changes[4].mMeshlets.mMaxTriangles = base.mMeshlets.mMaxTriangles / 2;
+	changes[5].mOptimization.mCacheSize = base.mOptimization.mCacheSize * 2;
+
+	for (const MeshImportSettings& settings : changes) {
+		OTTER_CHECK(Mesh::HashImportSettings(settings) != Mesh::HashImportSettings(base));
+
+		Mesh::SetImportSettings(settings);
+		auto mesh = Mesh::LoadFromFile(source);
+		OTTER_REQUIRE(mesh && mesh->IsValid());
+		OTTER_CHECK(!mesh->IsMemoryMapped());
+		OTTER_CHECK(mesh->GetImportSettingsHash() == Mesh::HashImportSettings(settings));
+
+		// Loaded directly, the cooked file is still used as there is nothing else to read
+		auto direct = Mesh::LoadFromFile(cooked);
+		OTTER_CHECK(direct && direct->IsMemoryMapped());
+	}
+
+	// The thread count does not change the imported mesh
+	MeshImportSettings threads = base;
+	threads.mImportThreads = base.mImportThreads + 3;
+	OTTER_CHECK(Mesh::HashImportSettings(threads) == Mesh::HashImportSettings(base));
+
+	Mesh::SetImportSettings(base);
+	auto mesh = Mesh::LoadFromFile(source);
+	OTTER_CHECK(mesh && mesh->IsMemoryMapped());
+}
+
+OTTER_TEST(CookedMesh, RejectsCorruptedHeader) {
+	const fs::path source = OtterTest::GetTempDirectory() / "grid.obj";
+	const fs::path cooked = OtterTest::GetTempDirectory() / "grid.omesh";
+	OtterTest::WriteGridObj(source, 8);
+	OTTER_REQUIRE(MeshCooker::Cook(source, cooked));
+
+	std::vector<char> bytes(fs::file_size(cooked));
+	{
+		std::ifstream stream(cooked, std::ios::binary);
+		stream.read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+	}
+
+	CookedMeshHeader header;
+	std::memcpy(&header, bytes.data(), sizeof(header));
+	header.mChunkOffset = bytes.size();
+	std::memcpy(bytes.data(), &header, sizeof(header));
+	{
+		std::ofstream stream(cooked, std::ios::binary | std::ios::trunc);
+		stream.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+	}
+
+	OTTER_CHECK(Mesh::LoadFromFile(cooked) == nullptr);
+}
+
+OTTER_BENCHMARK(CookedMesh, ImportVersusMap) {
+	// The sample scene's model, copied so that no cooked file sits next to it
+	const fs::path sample = fs::path(OTTER_RESOURCES_DIR) / "viking_room.obj";
+	const fs::path source = OtterTest::GetTempDirectory() / "mesh.obj";
+	const fs::path cooked = OtterTest::GetTempDirectory() / "mesh.omesh";
+	std::error_code error;
+	if (!fs::copy_file(sample, source, error)) {
+		std::printf("    %s is missing, using a generated grid\n", sample.string().c_str());
+		OtterTest::WriteGridObj(source, 512);
+	}
+
+	// First load of the source: nothing cooked, and the file read from disk where the page cache can be dropped
+	const bool isCold = EvictFromPageCache(source);
+	const auto start = std::chrono::high_resolution_clock::now();
+	auto first = Mesh::LoadFromFile(source);
+	const double coldMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	OTTER_REQUIRE(first && first->IsValid() && !first->IsMemoryMapped());
+	std::printf("    %-48s %10.4f ms\n", isCold ? "Import .obj, cold first load" : "Import .obj, first load (page cache kept)", coldMs);
+	std::printf("    %-48s %10zu\n", "  vertices", first->GetVertexCount());
+
+	const double importMs = OtterTest::Measure("Import .obj, warm repeats", 5, [&]() {
+		auto mesh = Mesh::ImportObj(source);
+		OTTER_CHECK(mesh && mesh->IsValid());
+	});
+
+	OTTER_REQUIRE(MeshCooker::Cook(source, cooked));
+	const double mapMs = OtterTest::Measure("Map cooked .omesh", 50, [&]() {
+		auto mesh = Mesh::LoadFromFile(cooked);
+		OTTER_CHECK(mesh && mesh->IsMemoryMapped());
+	});
+	std::printf("    Mapping is %.1fx faster than a warm import, %.1fx than the first one\n", importMs / mapMs, coldMs / mapMs);
+}
@@ -0,0 +1,127 @@
+#include <array>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+
+#include "Resources/MeshOptimizer.h"
+
+#include "OtterTest.h"
+#include "TestMeshes.h"
+
+using namespace OtterEngine;
+
+namespace {
+	/// <summary>
+	/// Shuffles the triangles and renumbers the vertices of a mesh at random, the worst order to draw it in
+	/// </summary>
+	void Shuffle(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, uint64_t seed) {
+		OtterTest::Random random(seed);
+
+		std::vector<uint32_t> remap(vertices.size());
+		std::iota(remap.begin(), remap.end(), 0u);
+		for (size_t i = remap.size() - 1; i > 0; --i) {
+			std::swap(remap[i], remap[random.Below(uint32_t(i + 1))]);
+		}
+		std::vector<Vertex> shuffledVertices(vertices.size());
+		for (size_t vertex = 0; vertex < vertices.size(); ++vertex) {
+			shuffledVertices[remap[vertex]] = vertices[vertex];
+		}
+		vertices.swap(shuffledVertices);
+
+		const size_t triangleCount = indices.size() / 3;
+		for (size_t triangle = triangleCount - 1; triangle > 0; --triangle) {
+			const size_t other = random.Below(uint32_t(triangle + 1));
+			std::swap_ranges(indices.begin() + triangle * 3, indices.begin() + triangle * 3 + 3, indices.begin() + other * 3);
+		}
+		for (uint32_t& index : indices) {
+			index = remap[index];
+		}
+	}
+
+	/// <summary>
+	/// Triangles as the ids stored in their vertices, each rotated to start with its smallest id so that
+	/// the winding is kept, sorted
+	/// </summary>
+	std::vector<std::array<uint32_t, 3>> GetTriangleSet(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) {
+		std::vector<std::array<uint32_t, 3>> triangles;
+		for (size_t corner = 0; corner + 2 < indices.size(); corner += 3) {
+			std::array<uint32_t, 3> triangle;
+			for (size_t i = 0; i < 3; ++i) {
+				triangle[i] = static_cast<uint32_t>(vertices[indices[corner + i]].mColor.x);
+			}
+			std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+			triangles.push_back(triangle);
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	/// <summary>
+	/// Optimizes a copy of the mesh and checks it draws the same triangles, no worse for the vertex cache
+	/// </summary>
+	void CheckOptimizedMesh(std::vector<Vertex> vertices, std::vector<uint32_t> indices) {
+		// Every vertex carries its id through the renumbering, exact as a float
+		for (size_t vertex = 0; vertex < vertices.size(); ++vertex) {
+			vertices[vertex].mColor = glm::vec3(float(vertex), 0.0f, 0.0f);
+		}
+
+		const MeshOptimizationSettings settings;
+		const std::vector<std::array<uint32_t, 3>> triangles = GetTriangleSet(vertices, indices);
+		const VertexCacheStats before = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size(), settings.mCacheSize);
+		const size_t vertexCount = vertices.size();
+
+		MeshOptimizer::Optimize(vertices, indices, settings);
+
+		OTTER_REQUIRE(vertices.size() == vertexCount);
+		OTTER_CHECK(GetTriangleSet(vertices, indices) == triangles);
+
+		const VertexCacheStats after = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size(), settings.mCacheSize);
+		OTTER_CHECK(after.mAcmr <= before.mAcmr);
+		OTTER_CHECK(after.mAtvr <= before.mAtvr);
+		OTTER_CHECK(after.mAtvr >= 1.0f);
+
+		// Vertices are numbered in order of first use
+		uint32_t nextVertex = 0;
+		for (uint32_t index : indices) {
+			OTTER_CHECK(index <= nextVertex);
+			nextVertex = std::max(nextVertex, index + 1);
+		}
+	}
+}
+
+OTTER_TEST(MeshOptimizer, GridKeepsItsTriangles) {
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	OtterTest::MakeGrid(48, vertices, indices);
+	CheckOptimizedMesh(vertices, indices);
+}
+
+OTTER_TEST(MeshOptimizer, ShuffledMeshKeepsItsTriangles) {
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	OtterTest::MakeGrid(48, vertices, indices);
+	Shuffle(vertices, indices, 22);
+	CheckOptimizedMesh(vertices, indices);
+
+	OtterTest::MakeTorus(40, 24, vertices, indices);
+	Shuffle(vertices, indices, 23);
+	CheckOptimizedMesh(vertices, indices);
+}
+
+OTTER_TEST(MeshOptimizer, ShuffledGridBeatsTheRowOrder) {
+	// Rows of 49 vertices overflow a 16 entry cache: the row order transforms every vertex about twice
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	OtterTest::MakeGrid(48, vertices, indices);
+	const MeshOptimizationSettings settings;
+	const VertexCacheStats rows = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size(), settings.mCacheSize);
+
+	Shuffle(vertices, indices, 24);
+	const VertexCacheStats shuffled = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size(), settings.mCacheSize);
+	MeshOptimizer::Optimize(vertices, indices, settings);
+	const VertexCacheStats optimized = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size(), settings.mCacheSize);
+
+	OTTER_CHECK(shuffled.mAcmr > 2.0f);
+	OTTER_CHECK(optimized.mAcmr < rows.mAcmr);
+	OTTER_CHECK(optimized.mAtvr < rows.mAtvr);
+}
@@ -0,0 +1,172 @@
+#include <map>
+#include <tuple>
+#include <vector>
+
+#include "Resources/MeshSimplifier.h"
+
+#include "OtterTest.h"
+#include "TestMeshes.h"
+
+using namespace OtterEngine;
+
+namespace {
+	using PositionKey = std::tuple<float, float, float>;
+
+	PositionKey ToKey(const glm::vec3& position) {
+		return { position.x, position.y, position.z };
+	}
+
+	/// <summary>
+	/// Edges between positions bordered by a single triangle, with vertices split on attributes welded back together
+	/// </summary>
+	std::vector<std::pair<glm::vec3, glm::vec3>> FindOpenEdges(std::span<const Vertex> vertices, std::span<const uint32_t> indices) {
+		std::map<std::pair<PositionKey, PositionKey>, int> edges;
+		for (size_t triangle = 0; triangle < indices.size(); triangle += 3) {
+			for (size_t corner = 0; corner < 3; ++corner) {
+				PositionKey a = ToKey(vertices[indices[triangle + corner]].mPosition);
+				PositionKey b = ToKey(vertices[indices[triangle + (corner + 1) % 3]].mPosition);
+				++edges[std::minmax(a, b)];
+			}
+		}
+
+		std::vector<std::pair<glm::vec3, glm::vec3>> openEdges;
+		for (const auto& [edge, count] : edges) {
+			if (count == 1) {
+				const auto& [a, b] = edge;
+				openEdges.push_back({ glm::vec3(std::get<0>(a), std::get<1>(a), std::get<2>(a)),
+					glm::vec3(std::get<0>(b), std::get<1>(b), std::get<2>(b)) });
+			}
+		}
+		return openEdges;
+	}
+
+	/// <summary>
+	/// Splits the vertices of the grid column at x == column, the triangles right of it using copies with shifted texture coordinates
+	/// </summary>
+	void SplitGridColumn(uint32_t cells, uint32_t column, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+		const uint32_t side = cells + 1;
+		std::vector<uint32_t> copies(side);
+		for (uint32_t y = 0; y < side; ++y) {
+			Vertex copy = vertices[y * side + column];
+			copy.mTexCoord.x += 1.0f;
+			copies[y] = static_cast<uint32_t>(vertices.size());
+			vertices.push_back(copy);
+		}
+
+		for (size_t triangle = 0; triangle < indices.size(); triangle += 3) {
+			const uint32_t* corners = &indices[triangle];
+			const bool isRight = std::max({ corners[0] % side, corners[1] % side, corners[2] % side }) > column;
+			for (size_t corner = 0; corner < 3; ++corner) {
+				uint32_t& index = indices[triangle + corner];
+				if (isRight && index % side == column) {
+					index = copies[index / side];
+				}
+			}
+		}
+	}
+}
+
+OTTER_TEST(MeshSimplifier, ErrorMeasuresPositionsOnly) {
+	constexpr uint32_t CELLS = 16;
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	OtterTest::MakeGrid(CELLS, vertices, indices);
+
+	// A flat grid with noisy normals, every collapse keeps the surface where it was
+	OtterTest::Random random(5);
+	for (Vertex& vertex : vertices) {
+		vertex.mPosition.z = 0.0f;
+		vertex.mNormal = glm::normalize(glm::vec3(random.Range(-0.3f, 0.3f), random.Range(-0.3f, 0.3f), 1.0f));
+	}
+
+	float error = -1.0f;
+	const std::vector<uint32_t> simplified = MeshSimplifier::Simplify(vertices, indices, indices.size() * 3 / 4, 1.0f, {}, &error);
+	OTTER_REQUIRE(simplified.size() <= indices.size() * 3 / 4);
+	// Float quadrics leave a floor of about 3e-4 of the bounds radius, the normals would weigh a hundred times more
+	OTTER_CHECK(error >= 0.0f && error < 0.01f);
+
+	// Bending the grid shows up as a distance
+	OtterTest::MakeGrid(CELLS, vertices, indices);
+	MeshSimplifier::Simplify(vertices, indices, indices.size() / 4, 1.0f, {}, &error);
+	OTTER_CHECK(error > 0.01f && error < 1.0f);
+}
+
+OTTER_TEST(MeshSimplifier, SeamsCollapseWithTheirTwins) {
+	constexpr uint32_t CELLS = 16;
+	constexpr uint32_t COLUMN = 8;
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	OtterTest::MakeGrid(CELLS, vertices, indices);
+	SplitGridColumn(CELLS, COLUMN, vertices, indices);
+
+	MeshSimplificationSettings settings;
+	settings.mMaxError = 0.1f;
+	const std::vector<MeshLodGeometry> lods = MeshSimplifier::BuildLodChain(vertices, indices, settings);
+	OTTER_REQUIRE(lods.size() == settings.mTriangleRatios.size());
+
+	for (const MeshLodGeometry& lod : lods) {
+		// The seam never opens, the only open edges are on the sides of the grid
+		for (const auto& [a, b] : FindOpenEdges(lod.mVertices, lod.mIndices)) {
+			const bool isOnSide = (a.x == 0.0f && b.x == 0.0f) || (a.x == float(CELLS) && b.x == float(CELLS)) ||
+				(a.y == 0.0f && b.y == 0.0f) || (a.y == float(CELLS) && b.y == float(CELLS));
+			OTTER_CHECK(isOnSide);
+		}
+
+		// Both sides of it are simplified, each keeping its texture coordinates
+		uint32_t leftSeamVertices = 0;
+		uint32_t rightSeamVertices = 0;
+		for (const Vertex& vertex : lod.mVertices) {
+			if (vertex.mPosition.x == float(COLUMN)) {
+				++(vertex.mTexCoord.x > 1.0f ? rightSeamVertices : leftSeamVertices);
+			}
+		}
+		OTTER_CHECK(leftSeamVertices == rightSeamVertices);
+		OTTER_CHECK(leftSeamVertices >= 2 && leftSeamVertices <= CELLS);
+	}
+	OTTER_CHECK(lods.back().mIndices.size() / 3 <= indices.size() / 3 / 4);
+}
+
+OTTER_TEST(MeshSimplifier, ErrorsGrowWithinTheBound) {
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	OtterTest::MakeTorus(48, 24, vertices, indices);
+
+	const MeshSimplificationSettings settings;
+	const std::vector<MeshLodGeometry> lods = MeshSimplifier::BuildLodChain(vertices, indices, settings);
+	OTTER_REQUIRE(!lods.empty());
+
+	// The torus spans 5 x 5 x 1, its bounds have a radius of 3.57
+	const float maxError = settings.mMaxError * std::sqrt(5.0f * 5.0f * 2.0f + 1.0f) * 0.5f;
+	float previousError = 0.0f;
+	for (const MeshLodGeometry& lod : lods) {
+		OTTER_CHECK(lod.mError >= previousError);
+		OTTER_CHECK(lod.mError <= maxError);
+		OTTER_CHECK(FindOpenEdges(lod.mVertices, lod.mIndices).empty());
+		previousError = lod.mError;
+	}
+}
+
+OTTER_TEST(MeshSimplifier, FlatShadedMeshesKeepTheBaseOnly) {
+	std::vector<Vertex> smoothVertices;
+	std::vector<uint32_t> smoothIndices;
+	OtterTest::MakeTorus(24, 12, smoothVertices, smoothIndices);
+
+	// Every triangle with its own vertices, each position is shared by six of them
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	for (size_t triangle = 0; triangle < smoothIndices.size(); triangle += 3) {
+		const glm::vec3& p0 = smoothVertices[smoothIndices[triangle]].mPosition;
+		const glm::vec3& p1 = smoothVertices[smoothIndices[triangle + 1]].mPosition;
+		const glm::vec3& p2 = smoothVertices[smoothIndices[triangle + 2]].mPosition;
+		const glm::vec3 normal = glm::normalize(glm::cross(p1 - p0, p2 - p0));
+		for (size_t corner = 0; corner < 3; ++corner) {
+			Vertex vertex = smoothVertices[smoothIndices[triangle + corner]];
+			vertex.mNormal = normal;
+			indices.push_back(static_cast<uint32_t>(vertices.size()));
+			vertices.push_back(vertex);
+		}
+	}
+
+	// Logs why, instead of silently returning no level
+	OTTER_CHECK(MeshSimplifier::BuildLodChain(vertices, indices, {}).empty());
+}
@@ -0,0 +1,122 @@
+#include <vector>
+
+#include "Resources/MeshletBuilder.h"
+
+#include "OtterTest.h"
+#include "TestMeshes.h"
+
+using namespace OtterEngine;
+
+namespace {
+	/// <summary>
+	/// Checks the meshlets built from a triangle list: every triangle once, sizes within the limits and bounds
+	/// around every vertex and facing
+	/// </summary>
+	void CheckMeshlets(std::span<const Vertex> vertices, std::span<const uint32_t> indices, const MeshletSettings& settings,
+		const MeshletGeometry& geometry, std::span<const Meshlet> meshlets)
+	{
+		OTTER_CHECK(MeshletBuilder::CoversTriangles(geometry, meshlets, indices));
+		OTTER_CHECK(meshlets.size() >= (indices.size() / 3 + settings.mMaxTriangles - 1) / settings.mMaxTriangles);
+
+		OtterTest::Random random(17);
+		for (const Meshlet& meshlet : meshlets) {
+			OTTER_CHECK(meshlet.mVertexCount > 0 && meshlet.mVertexCount <= settings.mMaxVertices);
+			OTTER_CHECK(meshlet.mTriangleCount > 0 && meshlet.mTriangleCount <= settings.mMaxTriangles);
+
+			const std::span<const uint32_t> meshletVertices(geometry.mVertices.data() + meshlet.mVertexOffset, meshlet.mVertexCount);
+			const glm::vec3 center(meshlet.mCenter[0], meshlet.mCenter[1], meshlet.mCenter[2]);
+			for (uint32_t vertex : meshletVertices) {
+				OTTER_CHECK(glm::length(vertices[vertex].mPosition - center) <= meshlet.mRadius * 1.0001f + 1e-6f);
+			}
+
+			// No triangle of a culled meshlet faces the viewer
+			for (int viewer = 0; viewer < 64; ++viewer) {
+				const glm::vec3 position = center + glm::vec3(random.Range(-10.0f, 10.0f), random.Range(-10.0f, 10.0f), random.Range(-10.0f, 10.0f));
+				if (!meshlet.IsBackFacing(position)) {
+					continue;
+				}
+
+				const uint8_t* triangles = geometry.mTriangles.data() + meshlet.mTriangleOffset;
+				for (size_t corner = 0; corner < size_t(meshlet.mTriangleCount) * 3; corner += 3) {
+					const glm::vec3& p0 = vertices[meshletVertices[triangles[corner]]].mPosition;
+					const glm::vec3& p1 = vertices[meshletVertices[triangles[corner + 1]]].mPosition;
+					const glm::vec3& p2 = vertices[meshletVertices[triangles[corner + 2]]].mPosition;
+					OTTER_CHECK(glm::dot(glm::cross(p1 - p0, p2 - p0), p0 - position) >= -1e-4f);
+				}
+			}
+		}
+	}
+}
+
+OTTER_TEST(Meshlet, GridWithinLimitsAndBounds) {
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	OtterTest::MakeGrid(48, vertices, indices);
+
+	const MeshletSettings settings;
+	OTTER_REQUIRE(settings.mMaxVertices == 64 && settings.mMaxTriangles == 124);
+
+	MeshletGeometry geometry;
+	const uint32_t count = MeshletBuilder::Build(vertices, indices, settings, geometry);
+	OTTER_REQUIRE(count == geometry.mMeshlets.size());
+	CheckMeshlets(vertices, indices, settings, geometry, geometry.mMeshlets);
+}
+
+OTTER_TEST(Meshlet, TorusWithinLimitsAndBounds) {
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	OtterTest::MakeTorus(64, 32, vertices, indices);
+
+	const MeshletSettings settings;
+	MeshletGeometry geometry;
+	MeshletBuilder::Build(vertices, indices, settings, geometry);
+	CheckMeshlets(vertices, indices, settings, geometry, geometry.mMeshlets);
+
+	// A closed mesh leaves room for more triangles than vertices, most meshlets are full on one of the two
+	size_t fullMeshlets = 0;
+	for (const Meshlet& meshlet : geometry.mMeshlets) {
+		fullMeshlets += meshlet.mTriangleCount == settings.mMaxTriangles || meshlet.mVertexCount + 2 > settings.mMaxVertices ? 1 : 0;
+	}
+	OTTER_CHECK(fullMeshlets * 4 >= geometry.mMeshlets.size() * 3);
+}
+
+OTTER_TEST(Meshlet, SmallLimitsAndAppendedChunks) {
+	std::vector<Vertex> gridVertices;
+	std::vector<uint32_t> gridIndices;
+	OtterTest::MakeGrid(20, gridVertices, gridIndices);
+
+	std::vector<Vertex> torusVertices;
+	std::vector<uint32_t> torusIndices;
+	OtterTest::MakeTorus(24, 12, torusVertices, torusIndices);
+
+	MeshletSettings settings;
+	settings.mMaxVertices = 16;
+	settings.mMaxTriangles = 10;
+
+	// The second chunk's meshlets continue the arrays of the first, each still covering only its own triangles
+	MeshletGeometry geometry;
+	const uint32_t gridCount = MeshletBuilder::Build(gridVertices, gridIndices, settings, geometry);
+	const size_t gridTriangles = geometry.mTriangles.size();
+	const uint32_t torusCount = MeshletBuilder::Build(torusVertices, torusIndices, settings, geometry);
+	OTTER_REQUIRE(gridCount + torusCount == geometry.mMeshlets.size());
+
+	const std::span<const Meshlet> meshlets(geometry.mMeshlets);
+	CheckMeshlets(gridVertices, gridIndices, settings, geometry, meshlets.first(gridCount));
+	CheckMeshlets(torusVertices, torusIndices, settings, geometry, meshlets.subspan(gridCount));
+	OTTER_CHECK(meshlets[gridCount].mTriangleOffset == gridTriangles);
+	OTTER_CHECK(!MeshletBuilder::CoversTriangles(geometry, meshlets, torusIndices));
+}
+
+OTTER_BENCHMARK(Meshlet, Build) {
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	OtterTest::MakeTorus(512, 256, vertices, indices);
+
+	MeshletGeometry geometry;
+	OtterTest::Measure("Partition a 262k triangle torus", 5, [&]() {
+		geometry = MeshletGeometry();
+		MeshletBuilder::Build(vertices, indices, {}, geometry);
+	});
+	std::printf("    %zu meshlets, %.1f triangles each\n", geometry.mMeshlets.size(),
+		double(indices.size() / 3) / double(geometry.mMeshlets.size()));
+}
@@ -0,0 +1,293 @@
+#include <fstream>
+#include <unordered_map>
+
+#include "Core/JobSystem.h"
+#include "Resources/Mesh.h"
+#include "Resources/ObjIndexDedupTable.h"
+
+#include "OtterTest.h"
+#include "TestMeshes.h"
+#include "AllocationCounter.h"
+
+using namespace OtterEngine;
+
+namespace {
+	// Hash of the whole vertex the importer used before the dedup table, kept to compare against
+	struct VertexHash {
+		static size_t HashVec2(const glm::vec2& vec) {
+			return (std::hash<float>()(vec.x) ^ (std::hash<float>()(vec.y) << 1)) >> 1;
+		}
+		static size_t HashVec3(const glm::vec3& vec) {
+			return ((std::hash<float>()(vec.x) ^ (std::hash<float>()(vec.y) << 1)) >> 1) ^ (std::hash<float>()(vec.z) << 1);
+		}
+
+		size_t operator()(const Vertex& vertex) const {
+			return ((HashVec3(vertex.mPosition) ^ (HashVec3(vertex.mNormal) << 1)) >> 1) ^
+				(HashVec2(vertex.mTexCoord) << 1) ^
+				(HashVec3(vertex.mColor) << 1);
+		}
+	};
+
+	// Same members as rapidobj::Index, which the engine does not expose
+	struct ObjIndex {
+		int position_index;
+		int texcoord_index;
+		int normal_index;
+	};
+
+	/// <summary>
+	/// Corners of a cells x cells grid the way an OBJ exporter writes them: one position and
+	/// texcoord per grid vertex, a single shared normal
+	/// </summary>
+	std::vector<ObjIndex> MakeGridCorners(uint32_t cells) {
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		OtterTest::MakeGrid(cells, vertices, indices);
+
+		std::vector<ObjIndex> corners;
+		corners.reserve(indices.size());
+		for (uint32_t index : indices) {
+			corners.push_back({ int(index), int(index), 0 });
+		}
+		return corners;
+	}
+
+	std::shared_ptr<Mesh> ImportObjText(const fs::path& path, const char* text) {
+		{
+			std::ofstream stream(path, std::ios::trunc);
+			stream << text;
+		}
+
+		// Only the imported level is looked at
+		MeshImportSettings settings = Mesh::GetImportSettings();
+		settings.mGenerateLods = false;
+		Mesh::SetImportSettings(settings);
+		return Mesh::ImportObj(path);
+	}
+}
+
+OTTER_TEST(ObjDedup, MergesSharedCorners) {
+	constexpr uint32_t CELLS = 32;
+	const std::vector<ObjIndex> corners = MakeGridCorners(CELLS);
+
+	ObjIndexDedupTable<ObjIndex> table(0, (CELLS + 1) * (CELLS + 1), corners.size());
+	std::vector<uint32_t> ids;
+	for (const ObjIndex& corner : corners) {
+		ids.push_back(table.FindOrInsert(corner));
+	}
+
+	// One vertex per grid vertex, each corner mapped back to its own triple
+	OTTER_CHECK(table.GetUniqueKeys().size() == (CELLS + 1) * (CELLS + 1));
+	for (size_t i = 0; i < corners.size(); ++i) {
+		const ObjIndex& key = table.GetUniqueKeys()[ids[i]];
+		OTTER_CHECK(key.position_index == corners[i].position_index && key.texcoord_index == corners[i].texcoord_index);
+	}
+
+	// Ids follow the first occurrence of each triple
+	uint32_t nextId = 0;
+	for (uint32_t id : ids) {
+		OTTER_CHECK(id <= nextId);
+		nextId = std::max(nextId, id + 1);
+	}
+}
+
+OTTER_TEST(ObjDedup, KeepsCornersDifferingInOneIndex) {
+	ObjIndexDedupTable<ObjIndex> table(3, 5, 6);
+	const uint32_t base = table.FindOrInsert({ 3, 4, 5 });
+	OTTER_CHECK(table.FindOrInsert({ 3, 4, 5 }) == base);
+	OTTER_CHECK(table.FindOrInsert({ 3, 4, 6 }) != base);
+	OTTER_CHECK(table.FindOrInsert({ 3, 5, 5 }) != base);
+	OTTER_CHECK(table.FindOrInsert({ 4, 4, 5 }) != base);
+	// Missing attributes index -1
+	OTTER_CHECK(table.FindOrInsert({ 3, -1, -1 }) != base);
+	OTTER_CHECK(table.FindOrInsert({ 3, -1, -1 }) == 4);
+	OTTER_CHECK(table.GetUniqueKeys().size() == 5);
+}
+
+OTTER_TEST(ObjDedup, HoldsExactlyTheCornerCount) {
+	// Tables get no more buckets than corners, filling them with unique corners chains
+	// positions wrapping around, all of which must still be told apart
+	for (uint32_t cornerCount : { 1u, 10u, 16u, 17u, 1000u, 65536u }) {
+		for (uint32_t positionBegin : { 0u, 5u, 100000u }) {
+			const uint32_t positionEnd = positionBegin + cornerCount * 3;
+			ObjIndexDedupTable<ObjIndex> table(positionBegin, positionEnd, cornerCount);
+			OTTER_CHECK(table.GetBucketCount() >= cornerCount && table.GetBucketCount() < size_t(cornerCount) * 2);
+
+			auto makeCorner = [&](uint32_t corner) {
+				return ObjIndex{ int(positionEnd - 1 - corner * 3), int(corner % 7), -1 };
+			};
+			for (uint32_t corner = 0; corner < cornerCount; ++corner) {
+				OTTER_CHECK(table.FindOrInsert(makeCorner(corner)) == corner);
+			}
+			for (uint32_t corner = 0; corner < cornerCount; ++corner) {
+				OTTER_CHECK(table.FindOrInsert(makeCorner(corner)) == corner);
+			}
+			OTTER_CHECK(table.GetUniqueKeys().size() == cornerCount);
+
+			// Positions outside of the range are still deduplicated
+			const uint32_t outside = table.FindOrInsert({ int(positionEnd + 7), 0, 0 });
+			OTTER_CHECK(outside == cornerCount);
+			OTTER_CHECK(table.FindOrInsert({ int(positionEnd + 7), 0, 0 }) == outside);
+		}
+	}
+}
+
+OTTER_TEST(ObjDedup, ImportMergesIndicesNotValues) {
+	OtterTest::ImportSettingsScope scope;
+
+	// Two triangles sharing an edge through their indices: 4 vertices
+	auto shared = ImportObjText(OtterTest::GetTempDirectory() / "shared.obj",
+		"v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+		"f 1 2 3\nf 1 3 4\n");
+	OTTER_REQUIRE(shared && shared->IsValid());
+	OTTER_CHECK(shared->GetVertexCount() == 4);
+
+	// The same edge written twice under other indices is not merged: 6 vertices
+	auto unshared = ImportObjText(OtterTest::GetTempDirectory() / "unshared.obj",
+		"v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 0 0\nv 1 1 0\nv 0 1 0\n"
+		"f 1 2 3\nf 4 5 6\n");
+	OTTER_REQUIRE(unshared && unshared->IsValid());
+	OTTER_CHECK(unshared->GetVertexCount() == 6);
+
+	// A shared position with distinct normals splits the corner: 5 vertices
+	auto split = ImportObjText(OtterTest::GetTempDirectory() / "split.obj",
+		"v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nvn 0 0 1\nvn 0 0 1\n"
+		"f 1//1 2//1 3//1\nf 1//2 3//1 4//1\n");
+	OTTER_REQUIRE(split && split->IsValid());
+	OTTER_CHECK(split->GetVertexCount() == 5);
+}
+
+OTTER_TEST(ObjDedup, SameMeshForAnyThreadCount) {
+	OtterTest::ImportSettingsScope scope;
+
+	// Objects share the vertices along their boundaries, which the merge has to deduplicate
+	const fs::path source = OtterTest::GetTempDirectory() / "grid.obj";
+	OtterTest::WriteGridObj(source, 48, 7);
+
+	MeshImportSettings settings = Mesh::GetImportSettings();
+	settings.mImportThreads = 1;
+	Mesh::SetImportSettings(settings);
+	auto serial = Mesh::ImportObj(source);
+	OTTER_REQUIRE(serial && serial->IsValid());
+
+	for (uint32_t threads : { 0u, 2u, 3u, 8u }) {
+		settings.mImportThreads = threads;
+		Mesh::SetImportSettings(settings);
+		auto parallel = Mesh::ImportObj(source);
+		OTTER_REQUIRE(parallel && parallel->IsValid());
+		OTTER_CHECK(OtterTest::SameBytes(parallel->GetVertexData(), serial->GetVertexData()));
+		OTTER_CHECK(OtterTest::SameBytes(parallel->GetIndexData(), serial->GetIndexData()));
+		OTTER_CHECK(OtterTest::SameBytes(parallel->GetChunks(), serial->GetChunks()));
+	}
+
+	// 49 x 49 grid vertices, each kept once however the rows were spread over objects
+	OTTER_CHECK(serial->GetChunks()[serial->GetLods()[0].mFirstChunk].mVertexCount == 49 * 49);
+}
+
+OTTER_BENCHMARK(ObjDedup, TableVersusUnorderedMap) {
+	constexpr uint32_t CELLS = 1024;
+	const std::vector<ObjIndex> corners = MakeGridCorners(CELLS);
+
+	// The attributes the corners index, texcoords flipped like the importer does
+	std::vector<Vertex> grid;
+	std::vector<uint32_t> gridIndices;
+	OtterTest::MakeGrid(CELLS, grid, gridIndices);
+	auto makeVertex = [&](const ObjIndex& corner) {
+		Vertex vertex{};
+		vertex.mPosition = grid[corner.position_index].mPosition;
+		vertex.mNormal = corner.normal_index >= 0 ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f);
+		vertex.mTexCoord = corner.texcoord_index >= 0 ? glm::vec2(grid[corner.texcoord_index].mTexCoord.x, 1.0f - grid[corner.texcoord_index].mTexCoord.y) : glm::vec2(0.0f);
+		vertex.mColor = glm::vec3(1.0f);
+		return vertex;
+	};
+
+	// Corners deduplicated on their indices, vertices assembled once per unique corner
+	auto dedupWithTable = [&](std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+		ObjIndexDedupTable<ObjIndex> table(0, (CELLS + 1) * (CELLS + 1), corners.size());
+		indices.resize(corners.size());
+		for (size_t i = 0; i < corners.size(); ++i) {
+			indices[i] = table.FindOrInsert(corners[i]);
+		}
+		vertices.reserve(table.GetUniqueKeys().size());
+		for (const ObjIndex& key : table.GetUniqueKeys()) {
+			vertices.push_back(makeVertex(key));
+		}
+	};
+
+	// What the importer did before the table: a full vertex per corner, looked up by value
+	auto dedupWithMap = [&](std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+		std::unordered_map<Vertex, uint32_t, VertexHash> uniqueVertices;
+		for (const ObjIndex& corner : corners) {
+			const Vertex vertex = makeVertex(corner);
+			if (uniqueVertices.count(vertex) == 0) {
+				uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
+				vertices.push_back(vertex);
+			}
+			indices.push_back(uniqueVertices[vertex]);
+		}
+	};
+
+	const double tableMs = OtterTest::Measure("Position buckets (6.3M corners)", 5, [&]() {
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		dedupWithTable(vertices, indices);
+		OTTER_CHECK(vertices.size() == (CELLS + 1) * (CELLS + 1));
+	});
+	const double mapMs = OtterTest::Measure("unordered_map<Vertex, uint32_t, VertexHash>", 5, [&]() {
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		dedupWithMap(vertices, indices);
+		OTTER_CHECK(vertices.size() == (CELLS + 1) * (CELLS + 1));
+	});
+	std::printf("    %-48s %10.2f\n", "  speedup of the table", mapMs / tableMs);
+
+	// Both number vertices in order of first use, down to the same indices
+	std::vector<Vertex> tableVertices, mapVertices;
+	std::vector<uint32_t> tableIndices, mapIndices;
+	size_t tablePeakBytes = 0;
+	size_t mapPeakBytes = 0;
+	{
+		const OtterTest::AllocationCounter counter;
+		dedupWithTable(tableVertices, tableIndices);
+		tablePeakBytes = counter.GetPeakBytes();
+	}
+	{
+		const OtterTest::AllocationCounter counter;
+		dedupWithMap(mapVertices, mapIndices);
+		mapPeakBytes = counter.GetPeakBytes();
+	}
+	OTTER_CHECK(tableIndices == mapIndices);
+	OTTER_CHECK(tableVertices == mapVertices);
+
+	// Peaks include the vertices and indices produced, kept alive after the runs
+	std::printf("    %-48s %10.1f MB\n", "Peak heap, position buckets", double(tablePeakBytes) / (1024.0 * 1024.0));
+	std::printf("    %-48s %10.1f MB\n", "Peak heap, unordered_map", double(mapPeakBytes) / (1024.0 * 1024.0));
+}
+
+OTTER_BENCHMARK(ObjDedup, ImportScaling) {
+	OtterTest::ImportSettingsScope scope;
+
+	const fs::path source = OtterTest::GetTempDirectory() / "grid.obj";
+	OtterTest::WriteGridObj(source, 512, 64);
+
+	// Only the deduplication and the vertex assembly follow mImportThreads, leave the rest of the import out
+	MeshImportSettings settings = Mesh::GetImportSettings();
+	settings.mOptimize = false;
+	settings.mGenerateLods = false;
+	settings.mBuildMeshlets = false;
+	settings.mSplitLargeMeshes = false;
+
+	double serialMs = 0.0;
+	for (uint32_t threads = 1; threads <= std::max(JobSystem::GetWorkerCount(), 1u); threads *= 2) {
+		settings.mImportThreads = threads;
+		Mesh::SetImportSettings(settings);
+
+		const std::string label = "Import .obj (64 objects), " + std::to_string(threads) + " thread(s)";
+		const double ms = OtterTest::Measure(label.c_str(), 3, [&]() {
+			auto mesh = Mesh::ImportObj(source);
+			OTTER_CHECK(mesh && mesh->IsValid());
+		});
+		serialMs = threads == 1 ? ms : serialMs;
+		std::printf("    Speedup %.2fx\n", serialMs / ms);
+	}
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <span>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+namespace OtterTest {
+
+	/// <summary>
+	/// A test or benchmark registered by OTTER_TEST / OTTER_BENCHMARK, run by suite name
+	/// </summary>
+	struct TestCase {
+		const char* mSuite = nullptr;
+		const char* mName = nullptr;
+		void (*mBody)() = nullptr;
+		bool mIsBenchmark = false;
+	};
+
+	std::vector<TestCase>& GetRegistry();
+
+	struct Registrar {
+		Registrar(const char* suite, const char* name, void (*body)(), bool isBenchmark) {
+			GetRegistry().push_back({ suite, name, body, isBenchmark });
+		}
+	};
+
+	/// <summary>
+	/// Records a failed check of the running test, the test keeps going
+	/// </summary>
+	void ReportFailure(const char* expression, const char* file, int line);
+
+	/// <summary>
+	/// Empty directory private to the running test, removed once it is over
+	/// </summary>
+	const std::filesystem::path& GetTempDirectory();
+
+	/// <summary>
+	/// Runs the body the given number of times after one warm-up run and prints the average duration
+	/// </summary>
+	template<typename Body>
+	double Measure(const char* label, size_t iterations, Body&& body) {
+		body();
+
+		const auto start = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < iterations; ++i) {
+			body();
+		}
+		const double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		const double averageMs = elapsedMs / static_cast<double>(iterations);
+		std::printf("    %-48s %10.4f ms\n", label, averageMs);
+		return averageMs;
+	}
+
+	template<typename T>
+	bool SameBytes(std::span<const T> a, std::span<const T> b) {
+		return a.size_bytes() == b.size_bytes() && std::memcmp(a.data(), b.data(), a.size_bytes()) == 0;
+	}
+
+	/// <summary>
+	/// Small deterministic generator, so that generated test data is the same on every platform
+	/// </summary>
+	class Random {
+	private:
+		uint64_t mState;
+
+	public:
+		explicit Random(uint64_t seed = 0x9E3779B97F4A7C15ull) : mState(seed) {}
+
+		uint64_t Next() {
+			mState ^= mState << 13;
+			mState ^= mState >> 7;
+			mState ^= mState << 17;
+			return mState;
+		}
+
+		// In [min, max)
+		float Range(float min, float max) {
+			return min + (max - min) * static_cast<float>(Next() >> 40) / static_cast<float>(1ull << 24);
+		}
+
+		// In [0, count)
+		uint32_t Below(uint32_t count) { return static_cast<uint32_t>(Next() % count); }
+	};
+}
+
+#define OTTER_TEST_CONCAT_IMPL(a, b) a##b
+#define OTTER_TEST_CONCAT(a, b) OTTER_TEST_CONCAT_IMPL(a, b)
+
+#define OTTER_TEST_REGISTER(suite, name, isBenchmark)																	\
+	static void OTTER_TEST_CONCAT(suite, OTTER_TEST_CONCAT(_, name))();													\
+	static ::OtterTest::Registrar OTTER_TEST_CONCAT(sRegistrar_, OTTER_TEST_CONCAT(suite, OTTER_TEST_CONCAT(_, name)))(	\
+		#suite, #name, &OTTER_TEST_CONCAT(suite, OTTER_TEST_CONCAT(_, name)), isBenchmark);								\
+	static void OTTER_TEST_CONCAT(suite, OTTER_TEST_CONCAT(_, name))()
+
+// Tests run under CTest, one CTest entry per suite
+#define OTTER_TEST(suite, name) OTTER_TEST_REGISTER(suite, name, false)
+// Benchmarks only run when asked for with --benchmarks, they report timings and check nothing but their results
+#define OTTER_BENCHMARK(suite, name) OTTER_TEST_REGISTER(suite, name, true)
+
+#define OTTER_CHECK(condition)																							\
+	do {																												\
+		if (!(condition)) {																								\
+			::OtterTest::ReportFailure(#condition, __FILE__, __LINE__);													\
+		}																												\
+	} while (0)
+
+// Stops the test on failure, for checks the rest of the test depends on
+#define OTTER_REQUIRE(condition)																						\
+	do {																												\
+		if (!(condition)) {																								\
+			::OtterTest::ReportFailure(#condition, __FILE__, __LINE__);													\
+			return;																										\
+		}																												\
+	} while (0)
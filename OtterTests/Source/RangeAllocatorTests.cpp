@@ -0,0 +1,196 @@
+#include <map>
+#include <vector>
+
+#include "Utils/RangeAllocator.h"
+
+#include "OtterTest.h"
+
+using namespace OtterEngine;
+
+namespace {
+	constexpr uint64_t ALIGNMENTS[] = { 1, 3, 16, 48, 256, 1000 };
+
+	/// <summary>
+	/// Live allocations of a RangeAllocator by offset, checking that none of them overlap
+	/// </summary>
+	class LiveRanges {
+	private:
+		std::map<uint64_t, uint64_t> mRanges;
+		std::vector<uint64_t> mOffsets; // For picking one at random
+		uint64_t mUsedBytes = 0;
+
+	public:
+		bool Insert(uint64_t offset, uint64_t size) {
+			auto next = mRanges.lower_bound(offset);
+			if (next != mRanges.end() && offset + size > next->first) return false;
+			if (next != mRanges.begin() && std::prev(next)->first + std::prev(next)->second > offset) return false;
+
+			mRanges.emplace_hint(next, offset, size);
+			mOffsets.push_back(offset);
+			mUsedBytes += size;
+			return true;
+		}
+
+		std::pair<uint64_t, uint64_t> Remove(size_t index) {
+			std::swap(mOffsets[index], mOffsets.back());
+			auto range = mRanges.find(mOffsets.back());
+			mOffsets.pop_back();
+
+			const std::pair<uint64_t, uint64_t> removed = *range;
+			mRanges.erase(range);
+			mUsedBytes -= removed.second;
+			return removed;
+		}
+
+		size_t GetCount() const { return mRanges.size(); }
+		uint64_t GetUsedBytes() const { return mUsedBytes; }
+	};
+}
+
+OTTER_TEST(RangeAllocator, CoalescesFreedNeighbours) {
+	RangeAllocator allocator(300);
+	const uint64_t a = allocator.Allocate(100);
+	const uint64_t b = allocator.Allocate(100);
+	const uint64_t c = allocator.Allocate(100);
+	OTTER_REQUIRE(a != RangeAllocator::INVALID_OFFSET && b != RangeAllocator::INVALID_OFFSET && c != RangeAllocator::INVALID_OFFSET);
+	OTTER_CHECK(allocator.Allocate(1) == RangeAllocator::INVALID_OFFSET);
+
+	// Two holes that are not adjacent stay apart
+	allocator.Free(a, 100);
+	allocator.Free(c, 100);
+	OTTER_CHECK(allocator.GetFreeBytes() == 200);
+	OTTER_CHECK(allocator.GetLargestFreeRange() == 100);
+	OTTER_CHECK(allocator.Allocate(150) == RangeAllocator::INVALID_OFFSET);
+
+	// Freeing the middle merges all three
+	allocator.Free(b, 100);
+	OTTER_CHECK(allocator.IsEmpty());
+	OTTER_CHECK(allocator.GetLargestFreeRange() == 300);
+	OTTER_CHECK(allocator.Allocate(300) == 0);
+}
+
+OTTER_TEST(RangeAllocator, PicksTheSmallestFittingRange) {
+	RangeAllocator allocator(1000);
+
+	// Holes of 50, 20 and 30 bytes between live allocations, and the tail after them
+	uint64_t offsets[7];
+	const uint64_t sizes[7] = { 50, 10, 20, 10, 30, 10, 100 };
+	for (int i = 0; i < 7; ++i) {
+		offsets[i] = allocator.Allocate(sizes[i]);
+	}
+	allocator.Free(offsets[0], sizes[0]);
+	allocator.Free(offsets[2], sizes[2]);
+	allocator.Free(offsets[4], sizes[4]);
+
+	OTTER_CHECK(allocator.Allocate(25) == offsets[4]);
+	OTTER_CHECK(allocator.Allocate(20) == offsets[2]);
+	OTTER_CHECK(allocator.Allocate(5) == offsets[4] + 25);
+	OTTER_CHECK(allocator.Allocate(40) == offsets[0]);
+	OTTER_CHECK(allocator.Allocate(60) == offsets[6] + sizes[6]);
+}
+
+OTTER_TEST(RangeAllocator, AlignsToAnyAlignment) {
+	RangeAllocator allocator(10000);
+	OTTER_REQUIRE(allocator.Allocate(7) == 0);
+
+	// The padding in front of an aligned range stays free and is found again by smaller requests
+	const uint64_t aligned = allocator.Allocate(100, 48);
+	OTTER_CHECK(aligned == 48);
+	OTTER_CHECK(allocator.Allocate(41, 1) == 7);
+	OTTER_CHECK(allocator.GetLargestFreeRange() == 10000 - 148);
+
+	const uint64_t odd = allocator.Allocate(10, 1000);
+	OTTER_CHECK(odd == 1000);
+	OTTER_CHECK(allocator.Allocate(3, 3) == 150);
+
+	// No aligned start left with enough room behind it
+	RangeAllocator small(100);
+	OTTER_CHECK(small.Allocate(10, 96) == 0);
+	OTTER_CHECK(small.Allocate(10, 96) == RangeAllocator::INVALID_OFFSET);
+	OTTER_CHECK(small.Allocate(4, 96) == 96);
+}
+
+OTTER_TEST(RangeAllocator, GrowExtendsTheLastFreeRange) {
+	RangeAllocator allocator(100);
+	const uint64_t first = allocator.Allocate(60);
+	OTTER_CHECK(allocator.Allocate(60) == RangeAllocator::INVALID_OFFSET);
+
+	allocator.Grow(200);
+	OTTER_CHECK(allocator.GetLargestFreeRange() == 140);
+	OTTER_CHECK(allocator.Allocate(140) == 60);
+
+	// Full up to the old end, the new bytes form a range of their own
+	allocator.Grow(300);
+	OTTER_CHECK(allocator.GetLargestFreeRange() == 100);
+	allocator.Free(first, 60);
+	allocator.Free(60, 140);
+	OTTER_CHECK(allocator.GetLargestFreeRange() == 300);
+}
+
+OTTER_TEST(RangeAllocator, ChurnKeepsRangesDisjointAndCoalescesBack) {
+	constexpr uint64_t SIZE = 1ull << 24;
+	constexpr int OPERATIONS = 100000;
+
+	RangeAllocator allocator(SIZE);
+	LiveRanges live;
+	OtterTest::Random random(42);
+
+	int failedAllocations = 0;
+	for (int operation = 0; operation < OPERATIONS; ++operation) {
+		// Allocations win slightly more often, so the space fills up and frees under pressure
+		if (live.GetCount() == 0 || random.Below(100) < 55) {
+			const uint64_t size = 1 + random.Below(random.Below(8) == 0 ? 65536 : 1024);
+			const uint64_t alignment = ALIGNMENTS[random.Below(std::size(ALIGNMENTS))];
+
+			const uint64_t offset = allocator.Allocate(size, alignment);
+			if (offset == RangeAllocator::INVALID_OFFSET) {
+				++failedAllocations;
+				continue;
+			}
+			OTTER_REQUIRE(offset % alignment == 0);
+			OTTER_REQUIRE(offset + size <= SIZE);
+			OTTER_REQUIRE(live.Insert(offset, size));
+		}
+		else {
+			const auto [offset, size] = live.Remove(random.Below(static_cast<uint32_t>(live.GetCount())));
+			allocator.Free(offset, size);
+		}
+
+		OTTER_REQUIRE(allocator.GetUsedBytes() == live.GetUsedBytes());
+		OTTER_REQUIRE(allocator.GetAllocationCount() == live.GetCount());
+	}
+	OTTER_CHECK(failedAllocations > 0); // The space did fill up
+
+	// Every byte freed, the space is a single range again
+	while (live.GetCount() > 0) {
+		const auto [offset, size] = live.Remove(random.Below(static_cast<uint32_t>(live.GetCount())));
+		allocator.Free(offset, size);
+	}
+	OTTER_CHECK(allocator.IsEmpty());
+	OTTER_CHECK(allocator.GetFreeBytes() == SIZE);
+	OTTER_CHECK(allocator.GetLargestFreeRange() == SIZE);
+}
+
+OTTER_BENCHMARK(RangeAllocator, Churn) {
+	constexpr int OPERATIONS = 100000;
+
+	RangeAllocator allocator(1ull << 24);
+	std::vector<std::pair<uint64_t, uint64_t>> live;
+	live.reserve(OPERATIONS);
+	OtterTest::Random random(7);
+
+	OtterTest::Measure("100k allocations and frees", 5, [&]() {
+		for (int operation = 0; operation < OPERATIONS; ++operation) {
+			if (live.empty() || random.Below(2) == 0) {
+				const uint64_t size = 1 + random.Below(4096);
+				const uint64_t offset = allocator.Allocate(size, ALIGNMENTS[random.Below(std::size(ALIGNMENTS))]);
+				if (offset != RangeAllocator::INVALID_OFFSET) live.emplace_back(offset, size);
+			}
+			else {
+				std::swap(live[random.Below(static_cast<uint32_t>(live.size()))], live.back());
+				allocator.Free(live.back().first, live.back().second);
+				live.pop_back();
+			}
+		}
+	});
+}
@@ -0,0 +1,193 @@
+#include <tuple>
+#include <algorithm>
+#include <vector>
+
+#include "Rendering/RenderQueue.h"
+
+#include "OtterTest.h"
+
+using namespace OtterEngine;
+
+namespace {
+	// Translation carrying what an instance was submitted with, to follow it through the sort
+	glm::mat4 MakeTransform(uint32_t mesh, MaterialID material, PipelineID pipeline, uint32_t serial) {
+		glm::mat4 transform(1.0f);
+		transform[3] = glm::vec4(float(mesh), float(material), float(pipeline), float(serial));
+		return transform;
+	}
+
+	/// <summary>
+	/// Checks that groups and commands tile the instances in order, and that every instance sits under
+	/// the mesh, material and pipeline it was submitted with
+	/// </summary>
+	void CheckLayout(const RenderQueue& queue, std::span<const glm::mat4> instances) {
+		uint32_t nextCommand = 0;
+		uint32_t nextInstance = 0;
+		for (const DrawGroup& group : queue.GetGroups()) {
+			OTTER_CHECK(group.mFirstCommand == nextCommand);
+			OTTER_CHECK(group.mCommandCount > 0);
+			nextCommand += group.mCommandCount;
+
+			for (uint32_t c = group.mFirstCommand; c < group.mFirstCommand + group.mCommandCount; ++c) {
+				const DrawCommand& command = queue.GetCommands()[c];
+				OTTER_CHECK(command.mFirstInstance == nextInstance);
+				OTTER_CHECK(command.mInstanceCount > 0);
+				nextInstance += command.mInstanceCount;
+
+				for (uint32_t i = command.mFirstInstance; i < command.mFirstInstance + command.mInstanceCount; ++i) {
+					OTTER_CHECK(instances[i][3].x == float(command.mMesh));
+					OTTER_CHECK(instances[i][3].y == float(group.mMaterial));
+					OTTER_CHECK(instances[i][3].z == float(group.mPipeline));
+				}
+			}
+		}
+		OTTER_CHECK(nextCommand == queue.GetCommands().size());
+		OTTER_CHECK(nextInstance == queue.GetInstanceCount());
+	}
+}
+
+OTTER_TEST(RenderQueue, SortsByPipelineThenMaterialThenMesh) {
+	RenderQueue queue;
+	const std::tuple<uint32_t, MaterialID, PipelineID> submissions[] = {
+		{ 7, 2, 1 }, { 3, 5, 0 }, { 9, 2, 0 }, { 1, 2, 1 }, { 3, 2, 0 }, { 4, 0, 1 },
+	};
+	uint32_t serial = 0;
+	for (const auto& [mesh, material, pipeline] : submissions) {
+		queue.Submit(mesh, material, MakeTransform(mesh, material, pipeline, serial++), pipeline);
+	}
+
+	std::vector<glm::mat4> instances(queue.GetInstanceCount());
+	queue.Build(instances);
+	CheckLayout(queue, instances);
+
+	// (pipeline, material): (0, 2) (0, 5) (1, 0) (1, 2)
+	const auto groups = queue.GetGroups();
+	OTTER_REQUIRE(groups.size() == 4);
+	const std::pair<PipelineID, MaterialID> expectedGroups[] = { { 0, 2 }, { 0, 5 }, { 1, 0 }, { 1, 2 } };
+	for (size_t g = 0; g < groups.size(); ++g) {
+		OTTER_CHECK(groups[g].mPipeline == expectedGroups[g].first);
+		OTTER_CHECK(groups[g].mMaterial == expectedGroups[g].second);
+	}
+
+	const uint32_t expectedMeshes[] = { 3, 9, 3, 4, 1, 7 };
+	const auto commands = queue.GetCommands();
+	OTTER_REQUIRE(commands.size() == 6);
+	for (size_t c = 0; c < commands.size(); ++c) {
+		OTTER_CHECK(commands[c].mMesh == expectedMeshes[c]);
+		OTTER_CHECK(commands[c].mInstanceCount == 1);
+	}
+
+	const RenderQueueStats& stats = queue.GetStats();
+	OTTER_CHECK(stats.mInstanceCount == 6 && stats.mCommandCount == 6 && stats.mGroupCount == 4);
+}
+
+OTTER_TEST(RenderQueue, MergesIdenticalKeysIntoOneInstancedCommand) {
+	RenderQueue queue;
+
+	// Interleaved with another mesh of the same material, the copies still end up in one command each
+	for (uint32_t serial = 0; serial < 10; ++serial) {
+		queue.Submit(5, 1, MakeTransform(5, 1, 0, serial));
+		queue.Submit(6, 1, MakeTransform(6, 1, 0, serial));
+	}
+
+	std::vector<glm::mat4> instances(queue.GetInstanceCount());
+	queue.Build(instances);
+	CheckLayout(queue, instances);
+
+	OTTER_REQUIRE(queue.GetGroups().size() == 1);
+	OTTER_CHECK(queue.GetGroups()[0].mCommandCount == 2);
+	OTTER_REQUIRE(queue.GetCommands().size() == 2);
+	OTTER_CHECK(queue.GetCommands()[0].mInstanceCount == 10);
+	OTTER_CHECK(queue.GetCommands()[1].mInstanceCount == 10);
+
+	// Every transform is written exactly once
+	std::vector<int> seen(20, 0);
+	for (const glm::mat4& instance : instances) {
+		++seen[size_t(instance[3].w) * 2 + (instance[3].x == 6.0f ? 1 : 0)];
+	}
+	OTTER_CHECK(std::all_of(seen.begin(), seen.end(), [](int count) { return count == 1; }));
+}
+
+OTTER_TEST(RenderQueue, SplitsGroupsOnPipelineOrMaterial) {
+	RenderQueue queue;
+
+	// The same mesh under two materials and under two pipelines, at the extremes of every key field
+	constexpr uint32_t MESH = UINT32_MAX;
+	constexpr MaterialID MATERIAL = RenderQueue::MAX_MATERIALS - 1;
+	constexpr PipelineID PIPELINE = RenderQueue::MAX_PIPELINES - 1;
+	queue.Submit(MESH, MATERIAL, MakeTransform(MESH, MATERIAL, PIPELINE, 0), PIPELINE);
+	queue.Submit(MESH, MATERIAL, MakeTransform(MESH, MATERIAL, 0, 1), 0);
+	queue.Submit(MESH, 0, MakeTransform(MESH, 0, 0, 2), 0);
+	queue.Submit(MESH, MATERIAL, MakeTransform(MESH, MATERIAL, PIPELINE, 3), PIPELINE);
+
+	std::vector<glm::mat4> instances(queue.GetInstanceCount());
+	queue.Build(instances);
+	CheckLayout(queue, instances);
+
+	const auto groups = queue.GetGroups();
+	OTTER_REQUIRE(groups.size() == 3);
+	OTTER_CHECK(groups[0].mPipeline == 0 && groups[0].mMaterial == 0);
+	OTTER_CHECK(groups[1].mPipeline == 0 && groups[1].mMaterial == MATERIAL);
+	OTTER_CHECK(groups[2].mPipeline == PIPELINE && groups[2].mMaterial == MATERIAL);
+
+	OTTER_REQUIRE(queue.GetCommands().size() == 3);
+	OTTER_CHECK(queue.GetCommands()[2].mMesh == MESH);
+	OTTER_CHECK(queue.GetCommands()[2].mInstanceCount == 2);
+}
+
+OTTER_TEST(RenderQueue, RandomSubmissionsAndReuse) {
+	RenderQueue queue;
+	OtterTest::Random random(3);
+
+	for (int frame = 0; frame < 4; ++frame) {
+		queue.Clear();
+		const uint32_t count = 1000 + random.Below(3000);
+		for (uint32_t serial = 0; serial < count; ++serial) {
+			const uint32_t mesh = random.Below(32);
+			const MaterialID material = random.Below(16);
+			const PipelineID pipeline = random.Below(4);
+			queue.Submit(mesh, material, MakeTransform(mesh, material, pipeline, serial), pipeline);
+		}
+		OTTER_REQUIRE(queue.GetInstanceCount() == count);
+
+		std::vector<glm::mat4> instances(count);
+		queue.Build(instances);
+		CheckLayout(queue, instances);
+
+		// Keys strictly increase from one command to the next, so no two commands could have been merged
+		uint64_t previousKey = 0;
+		bool isFirst = true;
+		for (const DrawGroup& group : queue.GetGroups()) {
+			for (uint32_t c = group.mFirstCommand; c < group.mFirstCommand + group.mCommandCount; ++c) {
+				const uint64_t key = (uint64_t(group.mPipeline) << 56) | (uint64_t(group.mMaterial) << 32) | queue.GetCommands()[c].mMesh;
+				OTTER_CHECK(isFirst || key > previousKey);
+				previousKey = key;
+				isFirst = false;
+			}
+		}
+
+		std::vector<int> seen(count, 0);
+		for (const glm::mat4& instance : instances) {
+			++seen[size_t(instance[3].w)];
+		}
+		OTTER_CHECK(std::all_of(seen.begin(), seen.end(), [](int timesSeen) { return timesSeen == 1; }));
+	}
+}
+
+OTTER_BENCHMARK(RenderQueue, Build) {
+	constexpr uint32_t INSTANCE_COUNT = 100000;
+
+	RenderQueue queue;
+	queue.Reserve(INSTANCE_COUNT);
+	std::vector<glm::mat4> instances(INSTANCE_COUNT);
+	OtterTest::Random random(11);
+
+	OtterTest::Measure("Submit and build 100k shuffled instances", 10, [&]() {
+		queue.Clear();
+		for (uint32_t i = 0; i < INSTANCE_COUNT; ++i) {
+			queue.Submit(random.Below(500), random.Below(64), glm::mat4(1.0f), random.Below(4));
+		}
+		queue.Build(instances);
+	});
+	std::printf("    %u commands in %u groups\n", queue.GetStats().mCommandCount, queue.GetStats().mGroupCount);
+}
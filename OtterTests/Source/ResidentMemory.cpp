@@ -0,0 +1,76 @@
+#include <cstdio>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__linux__)
+#include <fstream>
+#include <string>
+#include <malloc.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "ResidentMemory.h"
+
+namespace {
+	struct ResidentSizes {
+		size_t mCurrent = 0;
+		size_t mPeak = 0;
+	};
+
+	ResidentSizes QueryResidentSizes() {
+		ResidentSizes sizes;
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters{};
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+			sizes.mCurrent = counters.WorkingSetSize;
+			sizes.mPeak = counters.PeakWorkingSetSize;
+		}
+#elif defined(__linux__)
+		// VmHWM is the peak getrusage reports as ru_maxrss, but /proc/self/clear_refs can restart it
+		std::ifstream status("/proc/self/status");
+		std::string line;
+		while (std::getline(status, line)) {
+			size_t kilobytes = 0;
+			if (std::sscanf(line.c_str(), "VmRSS: %zu kB", &kilobytes) == 1) {
+				sizes.mCurrent = kilobytes * 1024;
+			}
+			else if (std::sscanf(line.c_str(), "VmHWM: %zu kB", &kilobytes) == 1) {
+				sizes.mPeak = kilobytes * 1024;
+			}
+		}
+#else
+		// Bytes on Apple platforms, there is no current size to start from
+		rusage usage{};
+		getrusage(RUSAGE_SELF, &usage);
+		sizes.mPeak = static_cast<size_t>(usage.ru_maxrss);
+		sizes.mCurrent = sizes.mPeak;
+#endif
+		return sizes;
+	}
+}
+
+namespace OtterTest {
+	ResidentMemory::ResidentMemory() {
+#ifdef __linux__
+#ifdef __GLIBC__
+		// Freed memory malloc kept would be reused without adding to the resident size
+		malloc_trim(0);
+#endif
+		// Writing 5 resets the peak to the current resident size
+		if (std::FILE* clearRefs = std::fopen("/proc/self/clear_refs", "w")) {
+			std::fputs("5", clearRefs);
+			std::fclose(clearRefs);
+		}
+#endif
+		mStartBytes = QueryResidentSizes().mCurrent;
+	}
+
+	size_t ResidentMemory::GetPeakBytes() const {
+		const size_t peak = QueryResidentSizes().mPeak;
+		return peak > mStartBytes ? peak - mStartBytes : 0;
+	}
+}
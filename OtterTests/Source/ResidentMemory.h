@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+
+namespace OtterTest {
+
+	/// <summary>
+	/// Peak resident memory of the test binary since construction, malloc and file mappings included,
+	/// for code that allocates outside of operator new. Only Linux can restart the peak, elsewhere
+	/// the peak of the whole process is compared to the resident size at construction.
+	/// </summary>
+	class ResidentMemory {
+	private:
+		size_t mStartBytes = 0;
+
+	public:
+		ResidentMemory();
+
+		// Most bytes resident at once beyond the ones that were resident at construction
+		size_t GetPeakBytes() const;
+	};
+}
@@ -0,0 +1,204 @@
+#include <atomic>
+#include <thread>
+
+#include "Resources/Resources.h"
+
+#include "OtterTest.h"
+
+using namespace OtterEngine;
+
+namespace {
+	/// <summary>
+	/// Resource of a fixed size, counting its decodes and the instances alive
+	/// </summary>
+	struct SizedBlob {
+		static constexpr std::size_t BYTE_SIZE = 100;
+		static inline std::atomic<int> sDecodeCount{ 0 };
+		static inline std::atomic<int> sAliveCount{ 0 };
+
+		SizedBlob() { sAliveCount.fetch_add(1); }
+		~SizedBlob() { sAliveCount.fetch_sub(1); }
+
+		static std::shared_ptr<SizedBlob> LoadFromFile(const fs::path&) {
+			sDecodeCount.fetch_add(1);
+			return std::make_shared<SizedBlob>();
+		}
+
+		bool IsValid() const { return true; }
+		std::size_t GetByteSize() const { return BYTE_SIZE; }
+	};
+
+	/// <summary>
+	/// Gives the blob cache a budget of the given number of blobs and empties it once the test is over
+	/// </summary>
+	struct CacheScope {
+		explicit CacheScope(std::size_t blobBudget) {
+			Resources::AddLoader<SizedBlob>();
+			ResourceCache::SetRetentionPolicy<SizedBlob>({ blobBudget * SizedBlob::BYTE_SIZE });
+			ResourceCache::ResetStats<SizedBlob>();
+			SizedBlob::sDecodeCount = 0;
+		}
+		~CacheScope() {
+			Resources::ClearAll();
+			ResourceCache::SetRetentionPolicy<SizedBlob>({});
+		}
+	};
+
+	ResourceHandle<SizedBlob> LoadBlob(int index) {
+		return Resources::Load<SizedBlob>("Blobs/Blob" + std::to_string(index));
+	}
+}
+
+OTTER_TEST(ResourceCache, RetainsOnlyUnreferencedResources) {
+	CacheScope scope(4);
+
+	SizedBlob* address = nullptr;
+	{
+		auto handle = LoadBlob(0);
+		OTTER_REQUIRE(handle);
+		address = &*handle;
+
+		// Referenced resources are not charged to the budget
+		OTTER_CHECK(ResourceCache::GetStats<SizedBlob>().mRetainedBytes == 0);
+	}
+
+	// The last handle dropped, the cache keeps it within the budget
+	OTTER_CHECK(ResourceCache::GetStats<SizedBlob>().mRetainedBytes == SizedBlob::BYTE_SIZE);
+	OTTER_CHECK(SizedBlob::sAliveCount == 1);
+
+	// Found again without decoding, which takes it back out of the budget
+	auto handle = LoadBlob(0);
+	OTTER_CHECK(&*handle == address);
+	OTTER_CHECK(SizedBlob::sDecodeCount == 1);
+	OTTER_CHECK(ResourceCache::GetStats<SizedBlob>().mRetainedBytes == 0);
+	OTTER_CHECK(ResourceCache::GetStats<SizedBlob>().mHits == 1);
+}
+
+OTTER_TEST(ResourceCache, EvictsLeastRecentlyUsedFirst) {
+	CacheScope scope(2);
+
+	LoadBlob(0);
+	LoadBlob(1);
+	OTTER_CHECK(ResourceCache::GetStats<SizedBlob>().mEvictions == 0);
+
+	// Blob 0 becomes the most recently used, so the third blob pushes blob 1 out
+	LoadBlob(0);
+	LoadBlob(2);
+
+	ResourceCacheStats stats = ResourceCache::GetStats<SizedBlob>();
+	OTTER_CHECK(stats.mEvictions == 1);
+	OTTER_CHECK(stats.mRetainedBytes == 2 * SizedBlob::BYTE_SIZE);
+	OTTER_CHECK(stats.mEntryCount == 2);
+	OTTER_CHECK(SizedBlob::sAliveCount == 2);
+
+	const int decodes = SizedBlob::sDecodeCount;
+	LoadBlob(0);
+	LoadBlob(2);
+	OTTER_CHECK(SizedBlob::sDecodeCount == decodes);
+	LoadBlob(1);
+	OTTER_CHECK(SizedBlob::sDecodeCount == decodes + 1);
+}
+
+OTTER_TEST(ResourceCache, NeverEvictsReferencedResources) {
+	CacheScope scope(1);
+
+	// Far over the budget, but every blob is still referenced
+	std::vector<ResourceHandle<SizedBlob>> handles;
+	for (int index = 0; index < 8; ++index) {
+		handles.push_back(LoadBlob(index));
+	}
+
+	ResourceCacheStats stats = ResourceCache::GetStats<SizedBlob>();
+	OTTER_CHECK(stats.mEvictions == 0);
+	OTTER_CHECK(stats.mRetainedBytes == 0);
+	OTTER_CHECK(stats.mEntryCount == 8);
+	for (int index = 0; index < 8; ++index) {
+		OTTER_CHECK(LoadBlob(index).GetSharedPtr() == handles[index].GetSharedPtr());
+	}
+	OTTER_CHECK(SizedBlob::sDecodeCount == 8);
+
+	// Released one by one, only the budget's worth stays
+	handles.clear();
+	stats = ResourceCache::GetStats<SizedBlob>();
+	OTTER_CHECK(stats.mEvictions == 7);
+	OTTER_CHECK(stats.mRetainedBytes == SizedBlob::BYTE_SIZE);
+	OTTER_CHECK(SizedBlob::sAliveCount == 1);
+}
+
+OTTER_TEST(ResourceCache, ForgetsUnreferencedEntriesWithoutBudget) {
+	CacheScope scope(0);
+
+	for (int index = 0; index < 16; ++index) {
+		LoadBlob(index);
+	}
+
+	// Nothing is kept, not even the entries
+	ResourceCacheStats stats = ResourceCache::GetStats<SizedBlob>();
+	OTTER_CHECK(stats.mEntryCount == 0);
+	OTTER_CHECK(stats.mRetainedBytes == 0);
+	OTTER_CHECK(SizedBlob::sAliveCount == 0);
+
+	LoadBlob(0);
+	OTTER_CHECK(SizedBlob::sDecodeCount == 17);
+}
+
+OTTER_TEST(ResourceCache, ShrinkingTheBudgetEvicts) {
+	CacheScope scope(8);
+
+	for (int index = 0; index < 8; ++index) {
+		LoadBlob(index);
+	}
+	OTTER_CHECK(ResourceCache::GetStats<SizedBlob>().mRetainedBytes == 8 * SizedBlob::BYTE_SIZE);
+
+	ResourceCache::SetRetentionPolicy<SizedBlob>({ 3 * SizedBlob::BYTE_SIZE });
+	ResourceCacheStats stats = ResourceCache::GetStats<SizedBlob>();
+	OTTER_CHECK(stats.mEvictions == 5);
+	OTTER_CHECK(stats.mEntryCount == 3);
+	OTTER_CHECK(SizedBlob::sAliveCount == 3);
+}
+
+OTTER_TEST(ResourceCache, HandlesOutliveClear) {
+	CacheScope scope(4);
+
+	auto handle = LoadBlob(0);
+	Resources::ClearAll();
+	Resources::AddLoader<SizedBlob>();
+
+	// The cleared entry is gone, the handle keeps the resource until it drops
+	OTTER_CHECK(ResourceCache::GetStats<SizedBlob>().mEntryCount == 0);
+	OTTER_CHECK(SizedBlob::sAliveCount == 1);
+	auto reloaded = LoadBlob(0);
+	OTTER_CHECK(reloaded.GetSharedPtr() != handle.GetSharedPtr());
+
+	handle = {};
+	OTTER_CHECK(SizedBlob::sAliveCount == 1);
+	OTTER_CHECK(ResourceCache::GetStats<SizedBlob>().mRetainedBytes == 0);
+}
+
+OTTER_TEST(ResourceCache, ConcurrentReleaseAndReuse) {
+	CacheScope scope(4);
+
+	constexpr int BLOB_COUNT = 8;
+	constexpr int ITERATIONS = 20000;
+	const uint32_t threadCount = std::max(std::thread::hardware_concurrency(), 4u);
+
+	std::vector<std::thread> threads;
+	for (uint32_t thread = 0; thread < threadCount; ++thread) {
+		threads.emplace_back([thread]() {
+			OtterTest::Random random(thread + 1);
+			for (int iteration = 0; iteration < ITERATIONS; ++iteration) {
+				auto handle = LoadBlob(int(random.Below(BLOB_COUNT)));
+				OTTER_CHECK(handle);
+			}
+		});
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	// Whatever the interleaving, the books balance once every handle is gone
+	ResourceCacheStats stats = ResourceCache::GetStats<SizedBlob>();
+	OTTER_CHECK(stats.mRetainedBytes <= 4 * SizedBlob::BYTE_SIZE);
+	OTTER_CHECK(stats.mRetainedBytes == stats.mEntryCount * SizedBlob::BYTE_SIZE);
+	OTTER_CHECK(SizedBlob::sAliveCount == int(stats.mEntryCount));
+}
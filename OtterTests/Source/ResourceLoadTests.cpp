@@ -0,0 +1,189 @@
+#include <latch>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#include "Core/JobSystem.h"
+#include "Resources/Texture.h"
+#include "Resources/Resources.h"
+
+#include "OtterTest.h"
+#include "TestImages.h"
+
+using namespace OtterEngine;
+
+namespace {
+	/// <summary>
+	/// Resource counting how many times it was decoded, its loader taking long enough for loads to overlap
+	/// </summary>
+	struct CountedResource {
+		static inline std::atomic<int> sDecodeCount{ 0 };
+
+		uint32_t mValue = 0;
+
+		static std::shared_ptr<CountedResource> LoadFromFile(const fs::path& path) {
+			sDecodeCount.fetch_add(1);
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			auto resource = std::make_shared<CountedResource>();
+			resource->mValue = static_cast<uint32_t>(path.string().size());
+			return resource;
+		}
+
+		bool IsValid() const { return true; }
+	};
+
+	/// <summary>
+	/// Registers the counted resource loader and forgets every cached resource once the test is over
+	/// </summary>
+	struct ResourcesScope {
+		ResourcesScope() {
+			Resources::AddLoader<CountedResource>();
+			CountedResource::sDecodeCount = 0;
+		}
+		~ResourcesScope() { Resources::ClearAll(); }
+	};
+
+	uint32_t GetThreadCount() {
+		return std::max(std::thread::hardware_concurrency(), 4u);
+	}
+}
+
+OTTER_TEST(ResourceLoads, ConcurrentLoadsDecodeOnce) {
+	ResourcesScope scope;
+
+	constexpr uint32_t ASSET_COUNT = 4;
+	const uint32_t threadCount = GetThreadCount() * 2;
+
+	// Every thread asks for every asset at once, half of them blocking and half through LoadAsync
+	std::vector<std::vector<std::shared_ptr<CountedResource>>> results(threadCount);
+	std::latch start(threadCount);
+	std::vector<std::thread> threads;
+	for (uint32_t thread = 0; thread < threadCount; ++thread) {
+		threads.emplace_back([&, thread]() {
+			start.arrive_and_wait();
+			for (uint32_t asset = 0; asset < ASSET_COUNT; ++asset) {
+				const fs::path path = "Counted/Asset" + std::to_string((asset + thread) % ASSET_COUNT);
+				ResourceHandle<CountedResource> handle = thread % 2 == 0 ?
+					Resources::Load<CountedResource>(path) :
+					Resources::LoadAsync<CountedResource>(path).Wait();
+				results[thread].push_back(handle.GetSharedPtr());
+			}
+		});
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	OTTER_CHECK(CountedResource::sDecodeCount == int(ASSET_COUNT));
+	for (uint32_t thread = 0; thread < threadCount; ++thread) {
+		for (uint32_t asset = 0; asset < ASSET_COUNT; ++asset) {
+			// Both lists are rotated by the thread index, compare the same asset
+			const uint32_t firstThreadSlot = (asset + thread) % ASSET_COUNT;
+			OTTER_REQUIRE(results[thread][asset] != nullptr);
+			OTTER_CHECK(results[thread][asset] == results[0][firstThreadSlot]);
+		}
+	}
+}
+
+OTTER_TEST(ResourceLoads, AsyncJoinsBlockingLoad) {
+	ResourcesScope scope;
+
+	const AssetID id = Resources::GetAssetID("Counted/Shared");
+	ResourceRequest<CountedResource> request;
+	std::shared_ptr<CountedResource> blocking;
+	{
+		std::latch start(2);
+		std::thread loader([&]() {
+			start.arrive_and_wait();
+			blocking = Resources::Load<CountedResource>(id).GetSharedPtr();
+		});
+		start.arrive_and_wait();
+		request = Resources::LoadAsync<CountedResource>(id);
+		loader.join();
+	}
+
+	OTTER_CHECK(request.Wait().GetSharedPtr() == blocking);
+	OTTER_CHECK(Resources::Load<CountedResource>(id).GetSharedPtr() == blocking);
+	OTTER_CHECK(CountedResource::sDecodeCount == 1);
+}
+
+OTTER_TEST(ResourceLoads, BlockingLoadOnWorkersTakesOverQueuedLoad) {
+	ResourcesScope scope;
+
+	const uint32_t workerCount = JobSystem::GetWorkerCount();
+	OTTER_REQUIRE(workerCount > 0);
+	const AssetID id = Resources::GetAssetID("Counted/Queued");
+
+	// Every worker is held until the asynchronous load is queued behind them, then loads the same asset blocking.
+	// Waiting for the queued job would never return, one of them has to perform the load instead.
+	std::latch queued(1);
+	std::latch done(workerCount);
+	std::vector<std::shared_ptr<CountedResource>> results(workerCount);
+	for (uint32_t worker = 0; worker < workerCount; ++worker) {
+		JobSystem::Submit([&, worker]() {
+			queued.wait();
+			results[worker] = Resources::Load<CountedResource>(id).GetSharedPtr();
+			done.count_down();
+		});
+	}
+	const ResourceRequest<CountedResource> request = Resources::LoadAsync<CountedResource>(id);
+	queued.count_down();
+	done.wait();
+
+	OTTER_REQUIRE(results[0] != nullptr);
+	for (const std::shared_ptr<CountedResource>& result : results) {
+		OTTER_CHECK(result == results[0]);
+	}
+	OTTER_CHECK(request.Wait().GetSharedPtr() == results[0]);
+	OTTER_CHECK(CountedResource::sDecodeCount == 1);
+}
+
+OTTER_BENCHMARK(ResourceLoads, CacheHitContention) {
+	ResourcesScope scope;
+	Resources::AddLoader<Texture>();
+
+	constexpr uint32_t TEXTURE_COUNT = 8;
+	constexpr uint32_t LOOKUPS_PER_THREAD = 100000;
+
+	// A small hot set of textures, loaded once and kept alive so that every later load is a cache hit.
+	// Absolute paths are used as they are, whatever the resources folder.
+	std::vector<fs::path> paths;
+	std::vector<ResourceHandle<Texture>> handles;
+	for (uint32_t texture = 0; texture < TEXTURE_COUNT; ++texture) {
+		paths.push_back(OtterTest::GetTempDirectory() / ("texture" + std::to_string(texture) + ".png"));
+		OtterTest::WritePng(paths.back(), 64, 64, OtterTest::MakeImage(64, 64, texture + 1));
+		handles.push_back(Resources::Load<Texture>(paths.back()));
+		OTTER_REQUIRE(handles.back());
+	}
+
+	// Loads by path like the renderer's, the path interned on every call
+	for (uint32_t threadCount : { 1u, 2u, 4u, 8u, 16u, 32u }) {
+		const std::string label = std::to_string(threadCount) + " thread(s), ns per hit";
+		std::latch start(threadCount + 1);
+		std::vector<std::thread> threads;
+		for (uint32_t thread = 0; thread < threadCount; ++thread) {
+			threads.emplace_back([&, thread]() {
+				start.arrive_and_wait();
+				for (uint32_t lookup = 0; lookup < LOOKUPS_PER_THREAD; ++lookup) {
+					auto handle = Resources::Load<Texture>(paths[(lookup + thread) % TEXTURE_COUNT]);
+					OTTER_CHECK(handle);
+				}
+			});
+		}
+
+		// Thread creation is left out of the timing
+		start.arrive_and_wait();
+		const auto begin = std::chrono::high_resolution_clock::now();
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+
+		const double elapsedNs = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - begin).count();
+		std::printf("    %-48s %10.1f\n", label.c_str(), elapsedNs / double(LOOKUPS_PER_THREAD * threadCount));
+	}
+
+	// Every texture was decoded once, by the loads before the sweep
+	for (uint32_t texture = 0; texture < TEXTURE_COUNT; ++texture) {
+		OTTER_CHECK(Resources::Load<Texture>(paths[texture]).GetSharedPtr() == handles[texture].GetSharedPtr());
+	}
+}
@@ -0,0 +1,103 @@
+#include <fstream>
+
+#include "Rendering/ShaderCompiler.h"
+
+#include "OtterTest.h"
+
+using namespace OtterEngine;
+namespace fs = std::filesystem;
+
+namespace {
+	void WriteSource(const fs::path& path, const std::string& content) {
+		fs::create_directories(path.parent_path());
+		std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+		stream << content;
+	}
+
+	std::vector<fs::path> ComputeDependencies(const ShaderSourceDesc& desc) {
+		std::vector<ShaderDependency> dependencies;
+		ShaderCompiler::ComputeKey(desc, &dependencies);
+
+		std::vector<fs::path> paths;
+		for (const ShaderDependency& dependency : dependencies) {
+			paths.push_back(dependency.mPath.lexically_normal());
+		}
+		return paths;
+	}
+}
+
+OTTER_TEST(ShaderCompiler, ResolvesIncludesFromTheIncluderThenTheSource) {
+	const fs::path root = OtterTest::GetTempDirectory() / "Shaders";
+	WriteSource(root / "Main.frag", "#version 450\n#include \"Lib/Lighting.glsl\"\nvoid main() {}\n");
+	// Common.glsl exists next to both files, the one next to the includer wins
+	WriteSource(root / "Lib/Lighting.glsl", "#include \"Common.glsl\"\n  #  include <Shared.glsl>\n");
+	WriteSource(root / "Lib/Common.glsl", "// Lib\n");
+	WriteSource(root / "Common.glsl", "// Root\n");
+	// Only next to the source
+	WriteSource(root / "Shared.glsl", "#include \"Common.glsl\"\n");
+
+	const std::vector<fs::path> dependencies = ComputeDependencies({ .mPath = root / "Main.frag", .mStage = ShaderStage::Fragment, .mDefines = {} });
+	const std::vector<fs::path> expected = {
+		root / "Main.frag", root / "Lib/Lighting.glsl", root / "Lib/Common.glsl", root / "Shared.glsl", root / "Common.glsl"
+	};
+	OTTER_CHECK(dependencies == expected);
+}
+
+OTTER_TEST(ShaderCompiler, FollowsEveryIncludeOnce) {
+	const fs::path root = OtterTest::GetTempDirectory();
+	// A cycle, a repeated include, one in an inactive branch and one that does not exist
+	WriteSource(root / "A.vert", "#include \"B.glsl\"\n#include \"B.glsl\"\n#if 0\n#include \"Optional.glsl\"\n#endif\n#include \"Missing.glsl\"\n");
+	WriteSource(root / "B.glsl", "#include \"A.vert\"\n#include \"./B.glsl\"\n");
+	WriteSource(root / "Optional.glsl", "");
+
+	const std::vector<fs::path> dependencies = ComputeDependencies({ .mPath = root / "A.vert", .mStage = ShaderStage::Vertex, .mDefines = {} });
+	const std::vector<fs::path> expected = { root / "A.vert", root / "B.glsl", root / "Optional.glsl" };
+	OTTER_CHECK(dependencies == expected);
+
+	// A missing source has no key, missing includes are left to the compiler
+	OTTER_CHECK(ShaderCompiler::ComputeKey({ .mPath = root / "Missing.vert", .mStage = ShaderStage::Vertex, .mDefines = {} }) == 0);
+	OTTER_CHECK(ShaderCompiler::ComputeKey({ .mPath = root / "A.vert", .mStage = ShaderStage::Vertex, .mDefines = {} }) != 0);
+}
+
+OTTER_TEST(ShaderCompiler, KeyFollowsContentNotTimestamps) {
+	const fs::path root = OtterTest::GetTempDirectory();
+	WriteSource(root / "Mesh.vert", "#include \"Skinning.glsl\"\nvoid main() {}\n");
+	WriteSource(root / "Skinning.glsl", "const int BONES = 64;\n");
+
+	const ShaderSourceDesc desc = { root / "Mesh.vert", ShaderStage::Vertex, { { "SKINNED", "1" } } };
+	const uint64_t key = ShaderCompiler::ComputeKey(desc);
+	OTTER_REQUIRE(key != 0);
+	OTTER_CHECK(ShaderCompiler::ComputeKey(desc) == key);
+
+	// Rewriting the same content keeps the key
+	WriteSource(root / "Skinning.glsl", "const int BONES = 64;\n");
+	fs::last_write_time(root / "Skinning.glsl", fs::last_write_time(root / "Skinning.glsl") + std::chrono::hours(1));
+	OTTER_CHECK(ShaderCompiler::ComputeKey(desc) == key);
+
+	// Editing an include changes it, undoing the edit brings it back
+	WriteSource(root / "Skinning.glsl", "const int BONES = 128;\n");
+	const uint64_t editedKey = ShaderCompiler::ComputeKey(desc);
+	OTTER_CHECK(editedKey != key);
+	WriteSource(root / "Skinning.glsl", "const int BONES = 64;\n");
+	OTTER_CHECK(ShaderCompiler::ComputeKey(desc) == key);
+
+	// So do the stage and the defines, names and values never running into each other
+	ShaderSourceDesc other = desc;
+	other.mStage = ShaderStage::Compute;
+	OTTER_CHECK(ShaderCompiler::ComputeKey(other) != key);
+	other = desc;
+	other.mDefines = { { "SKINNED", "2" } };
+	OTTER_CHECK(ShaderCompiler::ComputeKey(other) != key);
+	other.mDefines = { { "SKINNED1", "" } };
+	OTTER_CHECK(ShaderCompiler::ComputeKey(other) != key);
+	other.mDefines = {};
+	OTTER_CHECK(ShaderCompiler::ComputeKey(other) != key);
+}
+
+OTTER_TEST(ShaderCompiler, KeyCoversTheCompilerVersion) {
+	// More than the SPIR-V version, which stays the same across compiler releases
+	const std::string& identity = ShaderCompiler::GetCompilerIdentity();
+	OTTER_CHECK(!identity.empty());
+	OTTER_CHECK(&ShaderCompiler::GetCompilerIdentity() == &identity);
+	std::printf("    %s\n", identity.c_str());
+}
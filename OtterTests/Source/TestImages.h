@@ -0,0 +1,320 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include <algorithm>
+#include <filesystem>
+
+#include "OtterTest.h"
+
+namespace OtterTest {
+
+	/// <summary>
+	/// RGBA8 image with smooth gradients, sharp edges and some noise, like a typical color texture
+	/// </summary>
+	inline std::vector<uint8_t> MakeImage(uint32_t width, uint32_t height, uint64_t seed = 1) {
+		Random random(seed);
+		std::vector<uint8_t> pixels(size_t(width) * height * 4);
+		for (uint32_t y = 0; y < height; ++y) {
+			for (uint32_t x = 0; x < width; ++x) {
+				uint8_t* pixel = &pixels[(size_t(y) * width + x) * 4];
+				const bool isTile = ((x / 32) + (y / 32)) % 2 == 0;
+				pixel[0] = static_cast<uint8_t>(x * 255 / std::max(width - 1, 1u));
+				pixel[1] = static_cast<uint8_t>(y * 255 / std::max(height - 1, 1u));
+				pixel[2] = static_cast<uint8_t>((isTile ? 200 : 40) + random.Below(16));
+				pixel[3] = 255;
+			}
+		}
+		return pixels;
+	}
+
+	/// <summary>
+	/// Writes an uncompressed 32-bit .tga
+	/// </summary>
+	inline void WriteTga(const std::filesystem::path& path, uint32_t width, uint32_t height, const std::vector<uint8_t>& rgba) {
+		std::array<uint8_t, 18> header{};
+		header[2] = 2; // Uncompressed true color
+		header[12] = static_cast<uint8_t>(width);
+		header[13] = static_cast<uint8_t>(width >> 8);
+		header[14] = static_cast<uint8_t>(height);
+		header[15] = static_cast<uint8_t>(height >> 8);
+		header[16] = 32;
+		header[17] = 0x28; // Top-left origin, 8 alpha bits
+
+		std::vector<uint8_t> bgra(rgba.size());
+		for (size_t i = 0; i < rgba.size(); i += 4) {
+			bgra[i + 0] = rgba[i + 2];
+			bgra[i + 1] = rgba[i + 1];
+			bgra[i + 2] = rgba[i + 0];
+			bgra[i + 3] = rgba[i + 3];
+		}
+
+		std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+		stream.write(reinterpret_cast<const char*>(header.data()), header.size());
+		stream.write(reinterpret_cast<const char*>(bgra.data()), static_cast<std::streamsize>(bgra.size()));
+	}
+
+	/// <summary>
+	/// Writes an RGBA8 .png. Rows use the Sub filter, the zlib stream only stored blocks:
+	/// decoding still goes through the inflate and unfiltering paths.
+	/// </summary>
+	inline void WritePng(const std::filesystem::path& path, uint32_t width, uint32_t height, const std::vector<uint8_t>& rgba) {
+		auto crc32 = [](const uint8_t* data, size_t size, uint32_t crc = 0) {
+			crc = ~crc;
+			for (size_t i = 0; i < size; ++i) {
+				crc ^= data[i];
+				for (int bit = 0; bit < 8; ++bit) {
+					crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+				}
+			}
+			return ~crc;
+		};
+		auto appendBigEndian = [](std::vector<uint8_t>& bytes, uint32_t value) {
+			bytes.insert(bytes.end(), { uint8_t(value >> 24), uint8_t(value >> 16), uint8_t(value >> 8), uint8_t(value) });
+		};
+
+		// Filtered scanlines
+		const size_t stride = size_t(width) * 4;
+		std::vector<uint8_t> raw;
+		raw.reserve((stride + 1) * height);
+		for (uint32_t y = 0; y < height; ++y) {
+			const uint8_t* row = &rgba[y * stride];
+			raw.push_back(1);
+			for (size_t i = 0; i < stride; ++i) {
+				raw.push_back(static_cast<uint8_t>(row[i] - (i >= 4 ? row[i - 4] : 0)));
+			}
+		}
+
+		// zlib stream of stored blocks
+		std::vector<uint8_t> zlib = { 0x78, 0x01 };
+		for (size_t offset = 0; offset < raw.size(); offset += 65535) {
+			const uint16_t size = static_cast<uint16_t>(std::min<size_t>(raw.size() - offset, 65535));
+			const bool isLast = offset + size >= raw.size();
+			zlib.insert(zlib.end(), { uint8_t(isLast ? 1 : 0), uint8_t(size), uint8_t(size >> 8), uint8_t(~size), uint8_t(~size >> 8) });
+			zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + size);
+		}
+		uint32_t a = 1, b = 0;
+		for (uint8_t byte : raw) {
+			a = (a + byte) % 65521;
+			b = (b + a) % 65521;
+		}
+		appendBigEndian(zlib, (b << 16) | a);
+
+		std::vector<uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		auto appendChunk = [&](const char* type, const std::vector<uint8_t>& data) {
+			appendBigEndian(png, static_cast<uint32_t>(data.size()));
+			const size_t typeOffset = png.size();
+			png.insert(png.end(), type, type + 4);
+			png.insert(png.end(), data.begin(), data.end());
+			appendBigEndian(png, crc32(&png[typeOffset], data.size() + 4));
+		};
+
+		std::vector<uint8_t> header;
+		appendBigEndian(header, width);
+		appendBigEndian(header, height);
+		header.insert(header.end(), { 8, 6, 0, 0, 0 }); // 8 bits, RGBA, deflate, adaptive filtering, no interlace
+		appendChunk("IHDR", header);
+		appendChunk("IDAT", zlib);
+		appendChunk("IEND", {});
+
+		std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+		stream.write(reinterpret_cast<const char*>(png.data()), static_cast<std::streamsize>(png.size()));
+	}
+
+	/// <summary>
+	/// Writes a baseline .jpg, 4:4:4 with the example tables of the JPEG standard scaled to the given quality
+	/// </summary>
+	inline void WriteJpg(const std::filesystem::path& path, uint32_t width, uint32_t height, const std::vector<uint8_t>& rgba, int quality = 90) {
+		static constexpr uint8_t ZIGZAG[64] = {
+			0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5, 12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+			35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51, 58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+		};
+		static constexpr uint8_t LUMA_QUANT[64] = {
+			16, 11, 10, 16, 24, 40, 51, 61, 12, 12, 14, 19, 26, 58, 60, 55, 14, 13, 16, 24, 40, 57, 69, 56, 14, 17, 22, 29, 51, 87, 80, 62,
+			18, 22, 37, 56, 68, 109, 103, 77, 24, 35, 55, 64, 81, 104, 113, 92, 49, 64, 78, 87, 103, 121, 120, 101, 72, 92, 95, 98, 112, 100, 103, 99,
+		};
+		static constexpr uint8_t CHROMA_QUANT[64] = {
+			17, 18, 24, 47, 99, 99, 99, 99, 18, 21, 26, 66, 99, 99, 99, 99, 24, 26, 56, 99, 99, 99, 99, 99, 47, 66, 99, 99, 99, 99, 99, 99,
+			99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+		};
+
+		// Code counts per length from 1 to 16 bits, then the symbols in code order
+		struct HuffmanSpec {
+			uint8_t mCounts[16];
+			std::vector<uint8_t> mSymbols;
+		};
+		const HuffmanSpec dcLuma = { { 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 }, { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 } };
+		const HuffmanSpec dcChroma = { { 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0 }, { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 } };
+		const HuffmanSpec acLuma = { { 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7D }, {
+			0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xA1, 0x08,
+			0x23, 0x42, 0xB1, 0xC1, 0x15, 0x52, 0xD1, 0xF0, 0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0A, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x25, 0x26, 0x27, 0x28,
+			0x29, 0x2A, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+			0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+			0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6,
+			0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE1, 0xE2,
+			0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA } };
+		const HuffmanSpec acChroma = { { 0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77 }, {
+			0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71, 0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91,
+			0xA1, 0xB1, 0xC1, 0x09, 0x23, 0x33, 0x52, 0xF0, 0x15, 0x62, 0x72, 0xD1, 0x0A, 0x16, 0x24, 0x34, 0xE1, 0x25, 0xF1, 0x17, 0x18, 0x19, 0x1A, 0x26,
+			0x27, 0x28, 0x29, 0x2A, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58,
+			0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+			0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4,
+			0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA,
+			0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA } };
+
+		// Canonical codes, indexed by symbol: code in the low bits, then its length
+		using HuffmanCodes = std::array<std::pair<uint16_t, uint8_t>, 256>;
+		auto buildCodes = [](const HuffmanSpec& spec) {
+			HuffmanCodes codes{};
+			uint16_t code = 0;
+			size_t symbol = 0;
+			for (uint8_t length = 1; length <= 16; ++length) {
+				for (uint8_t i = 0; i < spec.mCounts[length - 1]; ++i) {
+					codes[spec.mSymbols[symbol++]] = { code++, length };
+				}
+				code <<= 1;
+			}
+			return codes;
+		};
+		const HuffmanCodes dcCodes[2] = { buildCodes(dcLuma), buildCodes(dcChroma) };
+		const HuffmanCodes acCodes[2] = { buildCodes(acLuma), buildCodes(acChroma) };
+
+		std::array<uint8_t, 64> quant[2];
+		const int scale = quality < 50 ? 5000 / std::max(quality, 1) : 200 - 2 * std::min(quality, 100);
+		for (size_t i = 0; i < 64; ++i) {
+			quant[0][i] = static_cast<uint8_t>(std::clamp((LUMA_QUANT[i] * scale + 50) / 100, 1, 255));
+			quant[1][i] = static_cast<uint8_t>(std::clamp((CHROMA_QUANT[i] * scale + 50) / 100, 1, 255));
+		}
+
+		std::vector<uint8_t> jpg = { 0xFF, 0xD8 };
+		auto appendSegment = [&](uint8_t marker, const std::vector<uint8_t>& data) {
+			const size_t length = data.size() + 2;
+			jpg.insert(jpg.end(), { 0xFF, marker, uint8_t(length >> 8), uint8_t(length) });
+			jpg.insert(jpg.end(), data.begin(), data.end());
+		};
+
+		std::vector<uint8_t> tables;
+		for (uint8_t table = 0; table < 2; ++table) {
+			tables.push_back(table);
+			for (uint8_t index : ZIGZAG) {
+				tables.push_back(quant[table][index]);
+			}
+		}
+		appendSegment(0xDB, tables);
+
+		appendSegment(0xC0, { 8, uint8_t(height >> 8), uint8_t(height), uint8_t(width >> 8), uint8_t(width), 3,
+			1, 0x11, 0, 2, 0x11, 1, 3, 0x11, 1 });
+
+		tables.clear();
+		const std::pair<uint8_t, const HuffmanSpec*> specs[4] = { { 0x00, &dcLuma }, { 0x10, &acLuma }, { 0x01, &dcChroma }, { 0x11, &acChroma } };
+		for (const auto& [tableClass, spec] : specs) {
+			tables.push_back(tableClass);
+			tables.insert(tables.end(), spec->mCounts, spec->mCounts + 16);
+			tables.insert(tables.end(), spec->mSymbols.begin(), spec->mSymbols.end());
+		}
+		appendSegment(0xC4, tables);
+
+		appendSegment(0xDA, { 3, 1, 0x00, 2, 0x11, 3, 0x11, 0, 63, 0 });
+
+		// Entropy coded data, a 0xFF byte is followed by a stuffed zero
+		uint32_t bitBuffer = 0;
+		int bitCount = 0;
+		auto writeBits = [&](uint32_t bits, int count) {
+			bitBuffer = (bitBuffer << count) | (bits & ((1u << count) - 1));
+			bitCount += count;
+			while (bitCount >= 8) {
+				const uint8_t byte = static_cast<uint8_t>(bitBuffer >> (bitCount - 8));
+				jpg.push_back(byte);
+				if (byte == 0xFF) {
+					jpg.push_back(0);
+				}
+				bitCount -= 8;
+			}
+		};
+		// Magnitude category of a coefficient, and its bits: negative values are stored as value - 1
+		auto writeValue = [&](const HuffmanCodes& codes, uint8_t runLength, int value) {
+			const int magnitude = std::abs(value);
+			int category = 0;
+			while ((magnitude >> category) != 0) {
+				++category;
+			}
+			const auto [code, length] = codes[(runLength << 4) | category];
+			writeBits(code, length);
+			if (category > 0) {
+				writeBits(static_cast<uint32_t>(value < 0 ? value - 1 : value), category);
+			}
+		};
+
+		float cosines[8][8];
+		for (int u = 0; u < 8; ++u) {
+			for (int x = 0; x < 8; ++x) {
+				cosines[u][x] = (u == 0 ? std::sqrt(0.125f) : 0.5f) * std::cos(float((2 * x + 1) * u) * 3.14159265f / 16.0f);
+			}
+		}
+
+		int previousDC[3] = {};
+		for (uint32_t blockY = 0; blockY < height; blockY += 8) {
+			for (uint32_t blockX = 0; blockX < width; blockX += 8) {
+				// Edge blocks repeat the last row and column
+				float samples[3][8][8];
+				for (uint32_t y = 0; y < 8; ++y) {
+					for (uint32_t x = 0; x < 8; ++x) {
+						const uint8_t* pixel = &rgba[(size_t(std::min(blockY + y, height - 1)) * width + std::min(blockX + x, width - 1)) * 4];
+						const float r = pixel[0], g = pixel[1], b = pixel[2];
+						samples[0][y][x] = 0.299f * r + 0.587f * g + 0.114f * b - 128.0f;
+						samples[1][y][x] = -0.168736f * r - 0.331264f * g + 0.5f * b;
+						samples[2][y][x] = 0.5f * r - 0.418688f * g - 0.081312f * b;
+					}
+				}
+
+				for (int component = 0; component < 3; ++component) {
+					const int table = component == 0 ? 0 : 1;
+
+					int coefficients[64];
+					for (int v = 0; v < 8; ++v) {
+						for (int u = 0; u < 8; ++u) {
+							float sum = 0.0f;
+							for (int y = 0; y < 8; ++y) {
+								for (int x = 0; x < 8; ++x) {
+									sum += cosines[v][y] * cosines[u][x] * samples[component][y][x];
+								}
+							}
+							coefficients[v * 8 + u] = static_cast<int>(std::lround(sum / quant[table][v * 8 + u]));
+						}
+					}
+
+					writeValue(dcCodes[table], 0, coefficients[0] - previousDC[component]);
+					previousDC[component] = coefficients[0];
+
+					uint8_t zeroRun = 0;
+					for (int i = 1; i < 64; ++i) {
+						const int coefficient = coefficients[ZIGZAG[i]];
+						if (coefficient == 0) {
+							++zeroRun;
+							continue;
+						}
+						for (; zeroRun >= 16; zeroRun -= 16) {
+							writeValue(acCodes[table], 15, 0);
+						}
+						writeValue(acCodes[table], zeroRun, coefficient);
+						zeroRun = 0;
+					}
+					if (zeroRun > 0) {
+						writeValue(acCodes[table], 0, 0);
+					}
+				}
+			}
+		}
+		// The last byte is padded with ones
+		if (bitCount > 0) {
+			writeBits(0x7F, 8 - bitCount);
+		}
+		jpg.insert(jpg.end(), { 0xFF, 0xD9 });
+
+		std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+		stream.write(reinterpret_cast<const char*>(jpg.data()), static_cast<std::streamsize>(jpg.size()));
+	}
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include <filesystem>
+
+#include "Rendering/Vertex.h"
+#include "Resources/Mesh.h"
+
+namespace OtterTest {
+
+	/// <summary>
+	/// Restores the mesh import settings a test changed
+	/// </summary>
+	struct ImportSettingsScope {
+		OtterEngine::MeshImportSettings mPrevious = OtterEngine::Mesh::GetImportSettings();
+		~ImportSettingsScope() { OtterEngine::Mesh::SetImportSettings(mPrevious); }
+	};
+
+	/// <summary>
+	/// Open grid of cells x cells quads over a wavy height field, with normals and texture coordinates
+	/// </summary>
+	inline void MakeGrid(uint32_t cells, std::vector<OtterEngine::Vertex>& vertices, std::vector<uint32_t>& indices) {
+		vertices.clear();
+		indices.clear();
+
+		const uint32_t side = cells + 1;
+		for (uint32_t y = 0; y < side; ++y) {
+			for (uint32_t x = 0; x < side; ++x) {
+				OtterEngine::Vertex vertex{};
+				vertex.mPosition = glm::vec3(float(x), float(y), std::sin(float(x) * 0.3f) * std::cos(float(y) * 0.2f));
+				vertex.mNormal = glm::vec3(0.0f, 0.0f, 1.0f);
+				vertex.mTexCoord = glm::vec2(float(x) / float(cells), float(y) / float(cells));
+				vertex.mColor = glm::vec3(1.0f);
+				vertices.push_back(vertex);
+			}
+		}
+
+		for (uint32_t y = 0; y < cells; ++y) {
+			for (uint32_t x = 0; x < cells; ++x) {
+				const uint32_t corner = y * side + x;
+				indices.insert(indices.end(), { corner, corner + 1, corner + side + 1, corner, corner + side + 1, corner + side });
+			}
+		}
+	}
+
+	/// <summary>
+	/// Closed torus, every vertex shared by all its triangles: no border and no attribute seam
+	/// </summary>
+	inline void MakeTorus(uint32_t rings, uint32_t sides, std::vector<OtterEngine::Vertex>& vertices, std::vector<uint32_t>& indices) {
+		constexpr float TWO_PI = 6.28318530718f;
+		constexpr float MAJOR_RADIUS = 2.0f;
+		constexpr float MINOR_RADIUS = 0.5f;
+
+		vertices.clear();
+		indices.clear();
+
+		for (uint32_t ring = 0; ring < rings; ++ring) {
+			const float u = TWO_PI * float(ring) / float(rings);
+			for (uint32_t side = 0; side < sides; ++side) {
+				const float v = TWO_PI * float(side) / float(sides);
+				const glm::vec3 normal(std::cos(u) * std::cos(v), std::sin(u) * std::cos(v), std::sin(v));
+
+				OtterEngine::Vertex vertex{};
+				vertex.mPosition = glm::vec3(std::cos(u) * MAJOR_RADIUS, std::sin(u) * MAJOR_RADIUS, 0.0f) + normal * MINOR_RADIUS;
+				vertex.mNormal = normal;
+				vertex.mTexCoord = glm::vec2(float(ring) / float(rings), float(side) / float(sides));
+				vertex.mColor = glm::vec3(1.0f);
+				vertices.push_back(vertex);
+			}
+		}
+
+		for (uint32_t ring = 0; ring < rings; ++ring) {
+			const uint32_t nextRing = (ring + 1) % rings;
+			for (uint32_t side = 0; side < sides; ++side) {
+				const uint32_t nextSide = (side + 1) % sides;
+				const uint32_t a = ring * sides + side;
+				const uint32_t b = nextRing * sides + side;
+				const uint32_t c = nextRing * sides + nextSide;
+				const uint32_t d = ring * sides + nextSide;
+				indices.insert(indices.end(), { a, b, c, a, c, d });
+			}
+		}
+	}
+
+	/// <summary>
+	/// Writes a grid as a Wavefront .obj, its rows spread over the given number of objects
+	/// </summary>
+	inline void WriteGridObj(const std::filesystem::path& path, uint32_t cells, uint32_t objectCount = 1) {
+		std::vector<OtterEngine::Vertex> vertices;
+		std::vector<uint32_t> indices;
+		MakeGrid(cells, vertices, indices);
+
+		std::ofstream stream(path, std::ios::trunc);
+		for (const OtterEngine::Vertex& vertex : vertices) {
+			stream << "v " << vertex.mPosition.x << ' ' << vertex.mPosition.y << ' ' << vertex.mPosition.z << '\n';
+		}
+		for (const OtterEngine::Vertex& vertex : vertices) {
+			stream << "vt " << vertex.mTexCoord.x << ' ' << vertex.mTexCoord.y << '\n';
+		}
+		stream << "vn 0 0 1\n";
+
+		const size_t triangleCount = indices.size() / 3;
+		for (size_t triangle = 0; triangle < triangleCount; ++triangle) {
+			if (triangle * objectCount % triangleCount < objectCount) {
+				stream << "o Part" << triangle * objectCount / triangleCount << '\n';
+			}
+
+			stream << 'f';
+			for (size_t corner = 0; corner < 3; ++corner) {
+				const uint32_t index = indices[triangle * 3 + corner] + 1;
+				stream << ' ' << index << '/' << index << "/1";
+			}
+			stream << '\n';
+		}
+	}
+}
@@ -0,0 +1,317 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <vulkan/vulkan.h>
+
+#include "Rendering/ShaderVariants.h"
+#include "Rendering/Vulkan/VulkanUtility.h"
+#include "Rendering/Vulkan/VulkanPipelineStateCache.h"
+
+namespace OtterTest {
+
+	/// <summary>
+	/// Headless device on the first physical device with a graphics queue, no window or surface involved.
+	/// Without a Vulkan driver it stays empty and tells so, Vulkan tests return straight away then.
+	/// </summary>
+	class VulkanTestDevice {
+	private:
+		VkInstance mInstance = VK_NULL_HANDLE;
+		VkPhysicalDevice mPhysicalDevice = VK_NULL_HANDLE;
+		VkDevice mDevice = VK_NULL_HANDLE;
+		VkQueue mQueue = VK_NULL_HANDLE;
+		uint32_t mQueueFamily = UINT32_MAX;
+		VkCommandPool mCommandPool = VK_NULL_HANDLE;
+
+	public:
+		VulkanTestDevice() {
+			VkApplicationInfo appInfo{};
+			appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+			appInfo.pApplicationName = "Otter Tests";
+			appInfo.pEngineName = "Otter Engine";
+			appInfo.apiVersion = VK_API_VERSION_1_2;
+
+			VkInstanceCreateInfo instanceInfo{};
+			instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+			instanceInfo.pApplicationInfo = &appInfo;
+
+			if (vkCreateInstance(&instanceInfo, nullptr, &mInstance) != VK_SUCCESS) {
+				mInstance = VK_NULL_HANDLE;
+				std::printf("    Skipped, no Vulkan driver\n");
+				return;
+			}
+
+			uint32_t deviceCount = 0;
+			vkEnumeratePhysicalDevices(mInstance, &deviceCount, nullptr);
+			std::vector<VkPhysicalDevice> devices(deviceCount);
+			vkEnumeratePhysicalDevices(mInstance, &deviceCount, devices.data());
+
+			for (VkPhysicalDevice device : devices) {
+				uint32_t familyCount = 0;
+				vkGetPhysicalDeviceQueueFamilyProperties(device, &familyCount, nullptr);
+				std::vector<VkQueueFamilyProperties> families(familyCount);
+				vkGetPhysicalDeviceQueueFamilyProperties(device, &familyCount, families.data());
+
+				for (uint32_t family = 0; family < familyCount && mPhysicalDevice == VK_NULL_HANDLE; ++family) {
+					if (families[family].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+						mPhysicalDevice = device;
+						mQueueFamily = family;
+					}
+				}
+			}
+
+			if (mPhysicalDevice == VK_NULL_HANDLE) {
+				std::printf("    Skipped, no Vulkan device with a graphics queue\n");
+				return;
+			}
+
+			const float priority = 1.0f;
+			VkDeviceQueueCreateInfo queueInfo{};
+			queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+			queueInfo.queueFamilyIndex = mQueueFamily;
+			queueInfo.queueCount = 1;
+			queueInfo.pQueuePriorities = &priority;
+
+			VkDeviceCreateInfo deviceInfo{};
+			deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+			deviceInfo.queueCreateInfoCount = 1;
+			deviceInfo.pQueueCreateInfos = &queueInfo;
+
+			if (vkCreateDevice(mPhysicalDevice, &deviceInfo, nullptr, &mDevice) != VK_SUCCESS) {
+				mDevice = VK_NULL_HANDLE;
+				std::printf("    Skipped, failed to create a Vulkan device\n");
+				return;
+			}
+			vkGetDeviceQueue(mDevice, mQueueFamily, 0, &mQueue);
+
+			VkCommandPoolCreateInfo poolInfo{};
+			poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+			poolInfo.queueFamilyIndex = mQueueFamily;
+			vkCreateCommandPool(mDevice, &poolInfo, nullptr, &mCommandPool);
+
+			VkPhysicalDeviceProperties properties{};
+			vkGetPhysicalDeviceProperties(mPhysicalDevice, &properties);
+			std::printf("    Running on %s\n", properties.deviceName);
+		}
+
+		~VulkanTestDevice() {
+			if (mDevice != VK_NULL_HANDLE) {
+				vkDeviceWaitIdle(mDevice);
+				vkDestroyCommandPool(mDevice, mCommandPool, nullptr);
+				vkDestroyDevice(mDevice, nullptr);
+			}
+			if (mInstance != VK_NULL_HANDLE) {
+				vkDestroyInstance(mInstance, nullptr);
+			}
+		}
+
+		VulkanTestDevice(const VulkanTestDevice&) = delete;
+		VulkanTestDevice& operator=(const VulkanTestDevice&) = delete;
+
+		explicit operator bool() const noexcept { return mDevice != VK_NULL_HANDLE; }
+
+		VkFence CreateFence() const {
+			VkFenceCreateInfo fenceInfo{};
+			fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+			VkFence fence = VK_NULL_HANDLE;
+			vkCreateFence(mDevice, &fenceInfo, nullptr, &fence);
+			return fence;
+		}
+
+		/// <summary>
+		/// Submits no work but the fence, which signals once everything submitted before it completed
+		/// </summary>
+		void SignalFence(VkFence fence) const {
+			vkQueueSubmit(mQueue, 0, nullptr, fence);
+		}
+
+		VkInstance GetInstance() const noexcept { return mInstance; }
+		VkPhysicalDevice GetPhysicalDevice() const noexcept { return mPhysicalDevice; }
+		VkDevice GetDevice() const noexcept { return mDevice; }
+		VkQueue GetQueue() const noexcept { return mQueue; }
+		uint32_t GetQueueFamily() const noexcept { return mQueueFamily; }
+		VkCommandPool GetCommandPool() const noexcept { return mCommandPool; }
+	};
+
+	/// <summary>
+	/// The renderer's pipelines without the renderer: every variant of Shaders/triangle.* a material can ask for,
+	/// in full precision and quantized vertex formats, against a color and depth pass like the swapchain's.
+	/// The descriptor and push constant layouts match the renderer's.
+	/// </summary>
+	class TestPipelineSet {
+	public:
+		static constexpr VkFormat COLOR_FORMAT = VK_FORMAT_B8G8R8A8_UNORM;
+		static constexpr uint32_t TEXTURE_CAPACITY = 64;
+
+	private:
+		VkDevice mDevice = VK_NULL_HANDLE;
+		VkRenderPass mRenderPass = VK_NULL_HANDLE;
+		uint64_t mRenderPassKey = 0;
+		std::array<VkDescriptorSetLayout, 2> mSetLayouts = {};
+		VkPipelineLayout mLayout = VK_NULL_HANDLE;
+
+		OtterEngine::ShaderLibrary mShaders;
+		std::unique_ptr<OtterEngine::ShaderVariantCache> mVariants;
+		std::vector<OtterEngine::PipelineStateDesc> mStates;
+
+		void CreateRenderPass(VkFormat depthFormat) {
+			std::array<VkAttachmentDescription, 2> attachments{};
+			attachments[0].format = COLOR_FORMAT;
+			attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+			attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+			attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+			attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			attachments[0].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+			attachments[1] = attachments[0];
+			attachments[1].format = depthFormat;
+			attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+			VkAttachmentReference colorReference{ 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+			VkAttachmentReference depthReference{ 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+
+			VkSubpassDescription subpass{};
+			subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+			subpass.colorAttachmentCount = 1;
+			subpass.pColorAttachments = &colorReference;
+			subpass.pDepthStencilAttachment = &depthReference;
+
+			VkRenderPassCreateInfo renderPassInfo{};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+			renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+			renderPassInfo.pAttachments = attachments.data();
+			renderPassInfo.subpassCount = 1;
+			renderPassInfo.pSubpasses = &subpass;
+
+			vkCreateRenderPass(mDevice, &renderPassInfo, nullptr, &mRenderPass);
+			mRenderPassKey = OtterEngine::VulkanPipelineStateCache::MakeRenderPassKey(COLOR_FORMAT, depthFormat, VK_SAMPLE_COUNT_1_BIT);
+		}
+
+		void CreateLayout() {
+			std::array<VkDescriptorSetLayoutBinding, 2> frameBindings{};
+			frameBindings[0].binding = 0;
+			frameBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			frameBindings[0].descriptorCount = 1;
+			frameBindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+			frameBindings[1].binding = 1;
+			frameBindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			frameBindings[1].descriptorCount = 1;
+			frameBindings[1].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+			VkDescriptorSetLayoutBinding textureBinding{};
+			textureBinding.binding = 0;
+			textureBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			textureBinding.descriptorCount = TEXTURE_CAPACITY;
+			textureBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+			VkDescriptorSetLayoutCreateInfo setInfo{};
+			setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+			setInfo.bindingCount = static_cast<uint32_t>(frameBindings.size());
+			setInfo.pBindings = frameBindings.data();
+			vkCreateDescriptorSetLayout(mDevice, &setInfo, nullptr, &mSetLayouts[0]);
+
+			setInfo.bindingCount = 1;
+			setInfo.pBindings = &textureBinding;
+			vkCreateDescriptorSetLayout(mDevice, &setInfo, nullptr, &mSetLayouts[1]);
+
+			// Texture slots of the draw's material, see VulkanRenderer::DrawConstants
+			VkPushConstantRange pushConstantRange{};
+			pushConstantRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+			pushConstantRange.offset = 0;
+			pushConstantRange.size = 2 * sizeof(uint32_t);
+
+			VkPipelineLayoutCreateInfo layoutInfo{};
+			layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+			layoutInfo.setLayoutCount = static_cast<uint32_t>(mSetLayouts.size());
+			layoutInfo.pSetLayouts = mSetLayouts.data();
+			layoutInfo.pushConstantRangeCount = 1;
+			layoutInfo.pPushConstantRanges = &pushConstantRange;
+			vkCreatePipelineLayout(mDevice, &layoutInfo, nullptr, &mLayout);
+		}
+
+		// Same state as VulkanRenderer::MakePipelineState
+		OtterEngine::PipelineStateDesc MakeState(OtterEngine::ShaderVariantID variantID, const OtterEngine::VertexFormat& vertexFormat) const {
+			const OtterEngine::ShaderVariant& variant = mVariants->GetVariant(variantID);
+
+			OtterEngine::PipelineStateDesc desc;
+			desc.mVertexShader = variant.mVertex;
+			desc.mFragmentShader = variant.mFragment;
+			desc.mLayout = mLayout;
+			desc.mRenderPassKey = mRenderPassKey;
+
+			const auto attributes = OtterEngine::VertexLayout::GetAttributeDescriptions(vertexFormat);
+			desc.mVertexStride = static_cast<uint16_t>(vertexFormat.GetStride());
+			desc.mVertexAttributeCount = static_cast<uint8_t>(attributes.size());
+			for (size_t i = 0; i < attributes.size(); ++i) {
+				desc.mVertexAttributes[i].mFormat = attributes[i].format;
+				desc.mVertexAttributes[i].mOffset = static_cast<uint16_t>(attributes[i].offset);
+				desc.mVertexAttributes[i].mLocation = static_cast<uint8_t>(attributes[i].location);
+			}
+
+			desc.mSpecializationCount = 1;
+			desc.mSpecialization[0] = TEXTURE_CAPACITY;
+			return desc;
+		}
+
+	public:
+		TestPipelineSet(VkDevice device, VkPhysicalDevice physicalDevice) : mDevice(device) {
+			CreateRenderPass(OtterEngine::VulkanUtility::FindDepthFormat(physicalDevice));
+			CreateLayout();
+
+			const std::filesystem::path directory = OTTER_SHADER_DIR;
+			mVariants = std::make_unique<OtterEngine::ShaderVariantCache>(mShaders, directory / "triangle.vert", directory / "triangle.frag");
+
+			OtterEngine::VertexFormat quantized;
+			quantized.mPosition = OtterEngine::PositionEncoding::Float16;
+			quantized.mNormal = OtterEngine::NormalEncoding::Octahedral16;
+			quantized.mTexCoord = OtterEngine::TexCoordEncoding::Unorm16;
+
+			// Every set of material features, the bits below normal decoding, which the vertex format adds
+			// like VulkanRenderer::GetMaterialPipeline does
+			for (const OtterEngine::VertexFormat& format : { OtterEngine::VertexFormat(), quantized }) {
+				const bool isOctahedral = format.mNormal == OtterEngine::NormalEncoding::Octahedral16;
+				for (OtterEngine::ShaderFeatureFlags features = 0; features < OtterEngine::SHADER_FEATURE_OCTAHEDRAL_NORMAL; ++features) {
+					const OtterEngine::ShaderFeatureFlags variantFeatures = isOctahedral ? features | OtterEngine::SHADER_FEATURE_OCTAHEDRAL_NORMAL : features;
+					mStates.push_back(MakeState(mVariants->GetVariantID(variantFeatures), format));
+				}
+			}
+		}
+
+		~TestPipelineSet() {
+			vkDestroyPipelineLayout(mDevice, mLayout, nullptr);
+			for (VkDescriptorSetLayout setLayout : mSetLayouts) {
+				vkDestroyDescriptorSetLayout(mDevice, setLayout, nullptr);
+			}
+			vkDestroyRenderPass(mDevice, mRenderPass, nullptr);
+		}
+
+		TestPipelineSet(const TestPipelineSet&) = delete;
+		TestPipelineSet& operator=(const TestPipelineSet&) = delete;
+
+		/// <summary>
+		/// Creates every pipeline of the set on the calling thread, through the given VkPipelineCache
+		/// </summary>
+		/// <returns>The cache owning the pipelines, they are destroyed with it</returns>
+		std::unique_ptr<OtterEngine::VulkanPipelineStateCache> Create(VkPipelineCache pipelineCache, std::vector<VkPipeline>& pipelines) const {
+			auto states = std::make_unique<OtterEngine::VulkanPipelineStateCache>(mDevice, pipelineCache, mShaders);
+			states->SetRenderPass(mRenderPass, mRenderPassKey);
+
+			pipelines.clear();
+			for (const OtterEngine::PipelineStateDesc& desc : mStates) {
+				pipelines.push_back(states->Acquire(states->GetHandle(desc), false));
+			}
+			return states;
+		}
+
+		VkRenderPass GetRenderPass() const noexcept { return mRenderPass; }
+		VkPipelineLayout GetLayout() const noexcept { return mLayout; }
+	};
+}
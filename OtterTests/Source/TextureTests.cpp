@@ -0,0 +1,114 @@
+#include <cmath>
+#include <string>
+
+#include "Resources/Texture.h"
+#include "Resources/TextureCooker.h"
+
+#include "OtterTest.h"
+#include "TestImages.h"
+#include "ResidentMemory.h"
+
+using namespace OtterEngine;
+
+OTTER_TEST(Texture, ImportsSourceImagesExactly) {
+	constexpr uint32_t WIDTH = 97;
+	constexpr uint32_t HEIGHT = 61;
+	const std::vector<uint8_t> pixels = OtterTest::MakeImage(WIDTH, HEIGHT);
+
+	const fs::path png = OtterTest::GetTempDirectory() / "image.png";
+	const fs::path tga = OtterTest::GetTempDirectory() / "image.tga";
+	OtterTest::WritePng(png, WIDTH, HEIGHT, pixels);
+	OtterTest::WriteTga(tga, WIDTH, HEIGHT, pixels);
+
+	for (const fs::path& path : { png, tga }) {
+		auto texture = Texture::ImportImage(path);
+		OTTER_REQUIRE(texture && texture->IsValid());
+		OTTER_CHECK(texture->GetWidth() == int(WIDTH) && texture->GetHeight() == int(HEIGHT));
+		OTTER_CHECK(texture->GetMipCount() == 1);
+		OTTER_CHECK(!texture->IsCompressed());
+		OTTER_CHECK(OtterTest::SameBytes(texture->GetPixels(), std::span<const uint8_t>(pixels)));
+	}
+}
+
+OTTER_TEST(Texture, RejectsTruncatedImage) {
+	const std::vector<uint8_t> pixels = OtterTest::MakeImage(64, 64);
+	const fs::path png = OtterTest::GetTempDirectory() / "image.png";
+	OtterTest::WritePng(png, 64, 64, pixels);
+	fs::resize_file(png, fs::file_size(png) / 2);
+
+	OTTER_CHECK(Texture::ImportImage(png) == nullptr);
+	OTTER_CHECK(Texture::ImportImage(OtterTest::GetTempDirectory() / "missing.png") == nullptr);
+}
+
+OTTER_TEST(Texture, ImportsJpgClosely) {
+	constexpr uint32_t WIDTH = 97;
+	constexpr uint32_t HEIGHT = 61;
+	const std::vector<uint8_t> pixels = OtterTest::MakeImage(WIDTH, HEIGHT);
+
+	const fs::path jpg = OtterTest::GetTempDirectory() / "image.jpg";
+	OtterTest::WriteJpg(jpg, WIDTH, HEIGHT, pixels);
+
+	auto texture = Texture::ImportImage(jpg);
+	OTTER_REQUIRE(texture && texture->IsValid());
+	OTTER_CHECK(texture->GetWidth() == int(WIDTH) && texture->GetHeight() == int(HEIGHT));
+
+	// Lossy, but close to the source on every color channel
+	const std::span<const uint8_t> decoded = texture->GetPixels();
+	OTTER_REQUIRE(decoded.size() == pixels.size());
+	double squaredError = 0.0;
+	for (size_t i = 0; i < pixels.size(); i += 4) {
+		for (size_t channel = 0; channel < 3; ++channel) {
+			const double difference = double(decoded[i + channel]) - double(pixels[i + channel]);
+			squaredError += difference * difference;
+		}
+		OTTER_CHECK(decoded[i + 3] == 255);
+	}
+	const double psnr = 10.0 * std::log10(255.0 * 255.0 / (squaredError / (pixels.size() / 4 * 3)));
+	OTTER_CHECK(psnr > 30.0);
+}
+
+OTTER_BENCHMARK(Texture, DecodeVersusCooked) {
+	constexpr uint32_t SIZES[] = { 256, 1024, 2048 };
+
+	// Throughput counts the decoded RGBA bytes. stb_image allocates with malloc, so the peak is the
+	// resident memory of the process while decoding: the decoded pixels, the decoder's buffers and the mapped file.
+	double pngMs = 0.0;
+	for (uint32_t size : SIZES) {
+		const std::vector<uint8_t> pixels = OtterTest::MakeImage(size, size);
+		const double decodedMB = double(pixels.size()) / (1024.0 * 1024.0);
+
+		const fs::path png = OtterTest::GetTempDirectory() / "image.png";
+		const fs::path jpg = OtterTest::GetTempDirectory() / "image.jpg";
+		OtterTest::WritePng(png, size, size, pixels);
+		OtterTest::WriteJpg(jpg, size, size, pixels);
+
+		for (const fs::path& path : { png, jpg }) {
+			const std::string label = "Decode " + path.extension().string() + " " + std::to_string(size) + "x" + std::to_string(size);
+			const double elapsedMs = OtterTest::Measure(label.c_str(), size >= 2048 ? 5 : 20, [&]() {
+				auto texture = Texture::ImportImage(path);
+				OTTER_CHECK(texture && texture->IsValid());
+			});
+			pngMs = path == png ? elapsedMs : pngMs;
+
+			const OtterTest::ResidentMemory memory;
+			{
+				auto texture = Texture::ImportImage(path);
+				OTTER_CHECK(texture && texture->IsValid());
+			}
+			std::printf("    %-48s %10.1f MB/s\n", "  decoded", decodedMB / (elapsedMs / 1000.0));
+			std::printf("    %-48s %10.1f MB\n", "  peak resident growth", double(memory.GetPeakBytes()) / (1024.0 * 1024.0));
+		}
+	}
+
+	// Cooked copies of the largest image are mapped instead, with their whole mip chain. Only load times matter
+	// here, the quality of the steep gradients of the smallest levels is not checked.
+	TextureCookSettings settings;
+	settings.mMinPSNR = 0.0;
+	const fs::path cooked = OtterTest::GetTempDirectory() / "image.otex";
+	OTTER_REQUIRE(TextureCooker::Cook(OtterTest::GetTempDirectory() / "image.png", cooked, settings));
+	const double cookedMs = OtterTest::Measure("Map cooked BC7 with mips", 50, [&]() {
+		auto texture = Texture::LoadFromFile(cooked);
+		OTTER_CHECK(texture && texture->IsCompressed());
+	});
+	std::printf("    Mapping is %.1fx faster than decoding the .png\n", pngMs / cookedMs);
+}
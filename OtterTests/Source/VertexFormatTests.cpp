@@ -0,0 +1,214 @@
+#include <cmath>
+#include <limits>
+
+#include "Rendering/VertexFormat.h"
+
+#include "OtterTest.h"
+
+using namespace OtterEngine;
+
+namespace {
+	Vertex MakeVertex(const glm::vec3& position, const glm::vec3& normal = glm::vec3(0.0f, 0.0f, 1.0f),
+		const glm::vec2& texCoord = glm::vec2(0.5f), const glm::vec3& color = glm::vec3(1.0f))
+	{
+		return { position, normal, texCoord, color };
+	}
+
+	Vertex RoundTrip(const Vertex& vertex, const VertexFormat& format) {
+		const std::vector<std::byte> packed = EncodeVertices({ &vertex, 1 }, format);
+		OTTER_CHECK(packed.size() == format.GetStride());
+		return DecodeVertices(packed, format).front();
+	}
+
+	VertexFormat MakeFormat(PositionEncoding position, NormalEncoding normal, TexCoordEncoding texCoord, ColorEncoding color) {
+		VertexFormat format;
+		format.mPosition = position;
+		format.mNormal = normal;
+		format.mTexCoord = texCoord;
+		format.mColor = color;
+		return format;
+	}
+
+	const VertexFormat COMPACT = MakeFormat(PositionEncoding::Float16, NormalEncoding::Octahedral16, TexCoordEncoding::Unorm16, ColorEncoding::Unorm8);
+}
+
+OTTER_TEST(VertexFormat, LayoutAndKeys) {
+	OTTER_CHECK(VertexFormat().GetStride() == 12 + 12 + 8 + 4);
+	OTTER_CHECK(COMPACT.GetStride() == 8 + 4 + 4 + 4);
+
+	const VertexFormat bare = MakeFormat(PositionEncoding::Float16, NormalEncoding::None, TexCoordEncoding::Float32, ColorEncoding::None);
+	OTTER_CHECK(bare.GetStride() == 8 + 8);
+	OTTER_CHECK(bare.GetOffsets().mTexCoord == 8);
+
+	for (const VertexFormat& format : { VertexFormat(), COMPACT, bare }) {
+		VertexFormat read;
+		OTTER_CHECK(VertexFormat::FromKey(format.GetKey(), read) && read == format);
+	}
+	VertexFormat unknown;
+	OTTER_CHECK(!VertexFormat::FromKey(COMPACT.GetKey() + 0x300, unknown));
+}
+
+OTTER_TEST(VertexFormat, HalfPositions) {
+	// Halves hold small integers, binary fractions and the largest finite half exactly
+	for (float value : { 0.0f, 1.0f, -3.0f, 0.5f, -0.125f, 1024.0f, 65504.0f, -65504.0f }) {
+		const Vertex vertex = MakeVertex(glm::vec3(value, -value, value));
+		OTTER_CHECK(RoundTrip(vertex, COMPACT).mPosition == vertex.mPosition);
+	}
+
+	// Denormals are multiples of 2^-24, the sign survives
+	const float smallest = std::ldexp(1.0f, -24);
+	for (float value : { smallest, -smallest, 3.0f * smallest, 1023.0f * smallest, std::ldexp(1.0f, -14) }) {
+		const Vertex vertex = MakeVertex(glm::vec3(value));
+		OTTER_CHECK(RoundTrip(vertex, COMPACT).mPosition == vertex.mPosition);
+	}
+	const glm::vec3 rounded = RoundTrip(MakeVertex(glm::vec3(2.6f * smallest, 0.4f * smallest, -0.4f * smallest)), COMPACT).mPosition;
+	OTTER_CHECK(rounded.x == 3.0f * smallest);
+	OTTER_CHECK(rounded.y == 0.0f && rounded.z == 0.0f && std::signbit(rounded.z));
+
+	// Past the half range the error is infinite, so the format falls back to full precision
+	const VertexQuantizationSettings settings;
+	for (float value : { 65520.0f, -70000.0f, 1e20f }) {
+		const Vertex vertices[] = { MakeVertex(glm::vec3(0.0f)), MakeVertex(glm::vec3(1.0f, value, 1.0f)) };
+		const float error = MeasureQuantizationError(vertices, COMPACT).mPosition;
+		OTTER_CHECK(!(error <= settings.mMaxPositionError));
+		OTTER_CHECK(VertexFormat::Choose(vertices, settings).mPosition == PositionEncoding::Float32);
+	}
+	// 65519 still rounds down to 65504
+	const Vertex edge = MakeVertex(glm::vec3(65519.0f));
+	OTTER_CHECK(RoundTrip(edge, COMPACT).mPosition == glm::vec3(65504.0f));
+
+	// Values that are not finite to begin with stay what they were
+	const glm::vec3 special = RoundTrip(MakeVertex(glm::vec3(std::numeric_limits<float>::infinity(),
+		-std::numeric_limits<float>::infinity(), std::numeric_limits<float>::quiet_NaN())), COMPACT).mPosition;
+	OTTER_CHECK(std::isinf(special.x) && special.x > 0.0f);
+	OTTER_CHECK(std::isinf(special.y) && special.y < 0.0f);
+	OTTER_CHECK(std::isnan(special.z));
+}
+
+OTTER_TEST(VertexFormat, HalfPositionsWithinTheErrorBound) {
+	OtterTest::Random random(5);
+	VertexQuantizationSettings settings;
+
+	// Half a half-ulp at 1 is 2^-12 per component, within the default bound of 1e-3
+	std::vector<Vertex> unitCube;
+	for (int i = 0; i < 1000; ++i) {
+		unitCube.push_back(MakeVertex({ random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f) }));
+	}
+	const float error = MeasureQuantizationError(unitCube, COMPACT).mPosition;
+	OTTER_CHECK(error > 0.0f && error <= std::sqrt(3.0f) * std::ldexp(1.0f, -12));
+	OTTER_CHECK(VertexFormat::Choose(unitCube, settings).mPosition == PositionEncoding::Float16);
+
+	// Between 64 and 128 it is 2^-5, too coarse
+	std::vector<Vertex> farAway = unitCube;
+	for (Vertex& vertex : farAway) {
+		vertex.mPosition += glm::vec3(100.0f);
+	}
+	OTTER_CHECK(VertexFormat::Choose(farAway, settings).mPosition == PositionEncoding::Float32);
+
+	settings.mMaxPositionError = 1.0f;
+	OTTER_CHECK(VertexFormat::Choose(farAway, settings).mPosition == PositionEncoding::Float16);
+	settings.mEnabled = false;
+	OTTER_CHECK(VertexFormat::Choose(farAway, settings).mPosition == PositionEncoding::Float32);
+}
+
+OTTER_TEST(VertexFormat, OctahedralNormals) {
+	// One snorm16 step on the octahedron is under 1e-4 radians anywhere on the sphere
+	constexpr float MAX_ANGLE = 1e-4f;
+	auto angleTo = [](const glm::vec3& normal) {
+		const glm::vec3 decoded = RoundTrip(MakeVertex(glm::vec3(0.0f), normal), COMPACT).mNormal;
+		OTTER_CHECK(std::fabs(glm::length(decoded) - 1.0f) < 1e-5f);
+		return std::atan2(glm::length(glm::cross(normal, decoded)), glm::dot(normal, decoded));
+	};
+
+	// Poles and axes land on corners of the octahedron and come back exactly
+	for (const glm::vec3& axis : { glm::vec3(0, 0, 1), glm::vec3(0, 0, -1), glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0),
+		glm::vec3(0, 1, 0), glm::vec3(0, -1, 0) }) {
+		OTTER_CHECK(RoundTrip(MakeVertex(glm::vec3(0.0f), axis), COMPACT).mNormal == axis);
+	}
+
+	// The -z hemisphere is folded over the corners, including directions right at its rim
+	OtterTest::Random random(9);
+	float maxAngle = 0.0f;
+	for (int i = 0; i < 4096; ++i) {
+		glm::vec3 normal(random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f), -random.Range(0.0f, 1.0f));
+		if (i % 8 == 0) normal.z = -1e-4f * random.Range(0.0f, 1.0f);
+		if (glm::length(normal) < 1e-3f) continue;
+		normal = glm::normalize(normal);
+
+		const glm::vec3 decoded = RoundTrip(MakeVertex(glm::vec3(0.0f), normal), COMPACT).mNormal;
+		OTTER_CHECK(decoded.z <= 1e-4f);
+		maxAngle = std::max(maxAngle, angleTo(normal));
+	}
+	for (const glm::vec3& rim : { glm::vec3(1, 1, 0), glm::vec3(-1, 1, 0), glm::vec3(1, -1, -1e-6f), glm::vec3(-1, -1, -1e-6f) }) {
+		maxAngle = std::max(maxAngle, angleTo(glm::normalize(rim)));
+	}
+	OTTER_CHECK(maxAngle < MAX_ANGLE);
+
+	// Normals are compared as directions, their length is not stored
+	const Vertex vertices[] = { MakeVertex(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -3.0f)), MakeVertex(glm::vec3(0.0f), glm::vec3(0.0f)) };
+	OTTER_CHECK(MeasureQuantizationError(vertices, COMPACT).mNormal == 0.0f);
+	OTTER_CHECK(VertexFormat::Choose(vertices, {}).mNormal == NormalEncoding::Octahedral16);
+
+	// Meshes without any normal store none
+	const Vertex flat[] = { MakeVertex(glm::vec3(0.0f), glm::vec3(0.0f)) };
+	OTTER_CHECK(VertexFormat::Choose(flat, {}).mNormal == NormalEncoding::None);
+	VertexQuantizationSettings tight;
+	tight.mMaxNormalError = 1e-7f;
+	const Vertex tilted[] = { MakeVertex(glm::vec3(0.0f), glm::normalize(glm::vec3(0.3f, -0.2f, -0.7f))) };
+	OTTER_CHECK(VertexFormat::Choose(tilted, tight).mNormal == NormalEncoding::Float32);
+}
+
+OTTER_TEST(VertexFormat, UnormTexCoords) {
+	// The ends of the range are exact, anything between is within half a step
+	for (const glm::vec2& texCoord : { glm::vec2(0.0f), glm::vec2(1.0f), glm::vec2(0.0f, 1.0f) }) {
+		OTTER_CHECK(RoundTrip(MakeVertex(glm::vec3(0.0f), glm::vec3(0.0f), texCoord), COMPACT).mTexCoord == texCoord);
+	}
+	std::vector<Vertex> vertices;
+	OtterTest::Random random(13);
+	for (int i = 0; i < 1000; ++i) {
+		vertices.push_back(MakeVertex(glm::vec3(0.0f), glm::vec3(0.0f), { random.Range(0.0f, 1.0f), random.Range(0.0f, 1.0f) }));
+	}
+	const float error = MeasureQuantizationError(vertices, COMPACT).mTexCoord;
+	OTTER_CHECK(error > 0.0f && error <= 0.5f / 65535.0f + 1e-7f);
+	OTTER_CHECK(VertexFormat::Choose(vertices, {}).mTexCoord == TexCoordEncoding::Unorm16);
+
+	// Tiling or slightly negative UVs cannot be stored as unorms
+	for (const glm::vec2& outside : { glm::vec2(1.0001f, 0.5f), glm::vec2(0.5f, -0.0001f), glm::vec2(4.0f, 2.0f) }) {
+		std::vector<Vertex> tiled = vertices;
+		tiled.push_back(MakeVertex(glm::vec3(0.0f), glm::vec3(0.0f), outside));
+		OTTER_CHECK(VertexFormat::Choose(tiled, {}).mTexCoord == TexCoordEncoding::Float32);
+		OTTER_CHECK(MeasureQuantizationError(tiled, COMPACT).mTexCoord > 0.5f / 65535.0f + 1e-7f);
+	}
+
+	VertexQuantizationSettings tight;
+	tight.mMaxTexCoordError = 1.0f / 262144.0f;
+	OTTER_CHECK(VertexFormat::Choose(vertices, tight).mTexCoord == TexCoordEncoding::Float32);
+}
+
+OTTER_TEST(VertexFormat, UnormColors) {
+	// Multiples of 1/255 are exact, anything else within half a step
+	for (int value = 0; value <= 255; value += 17) {
+		const glm::vec3 color(value / 255.0f, 1.0f - value / 255.0f, 0.0f);
+		const glm::vec3 decoded = RoundTrip(MakeVertex(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec2(0.0f), color), COMPACT).mColor;
+		OTTER_CHECK(std::fabs(decoded.x - color.x) < 1e-6f && std::fabs(decoded.y - color.y) < 1e-6f && decoded.z == 0.0f);
+	}
+
+	std::vector<Vertex> vertices;
+	OtterTest::Random random(17);
+	for (int i = 0; i < 1000; ++i) {
+		vertices.push_back(MakeVertex(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec2(0.0f),
+			{ random.Range(0.0f, 1.0f), random.Range(0.0f, 1.0f), random.Range(0.0f, 1.0f) }));
+	}
+	OTTER_CHECK(MeasureQuantizationError(vertices, COMPACT).mColor <= 0.5f / 255.0f + 1e-6f);
+	OTTER_CHECK(VertexFormat::Choose(vertices, {}).mColor == ColorEncoding::Unorm8);
+
+	// Out of range colors are clamped and the error says so
+	const Vertex bright[] = { MakeVertex(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec2(0.0f), glm::vec3(1.5f, -0.25f, 0.0f)) };
+	OTTER_CHECK(std::fabs(MeasureQuantizationError(bright, COMPACT).mColor - 0.5f) < 1e-6f);
+
+	// All white stores nothing and decodes white
+	const Vertex white[] = { MakeVertex(glm::vec3(0.0f)) };
+	const VertexFormat format = VertexFormat::Choose(white, {});
+	OTTER_CHECK(format.mColor == ColorEncoding::None);
+	OTTER_CHECK(RoundTrip(white[0], format).mColor == glm::vec3(1.0f));
+}
@@ -0,0 +1,171 @@
+#include <map>
+#include <vector>
+#include <algorithm>
+
+#include "Rendering/Vulkan/VulkanAllocator.h"
+
+#include "OtterTest.h"
+#include "TestVulkan.h"
+
+using namespace OtterEngine;
+
+namespace {
+	struct TestBuffer {
+		VkBuffer mBuffer = VK_NULL_HANDLE;
+		VulkanAllocation mAllocation;
+	};
+
+	/// <summary>
+	/// Checks that no two live allocations of a block overlap
+	/// </summary>
+	bool AreDisjoint(const std::vector<TestBuffer>& buffers) {
+		std::map<std::pair<VkDeviceMemory, VkDeviceSize>, VkDeviceSize> ranges;
+		for (const TestBuffer& buffer : buffers) {
+			if (buffer.mAllocation) {
+				ranges[{ buffer.mAllocation.mMemory, buffer.mAllocation.mOffset }] = buffer.mAllocation.mSize;
+			}
+		}
+
+		for (auto it = ranges.begin(); it != ranges.end(); ++it) {
+			auto next = std::next(it);
+			if (next != ranges.end() && next->first.first == it->first.first && it->first.second + it->second > next->first.second) {
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+OTTER_TEST(VulkanAllocator, HundredThousandSmallBuffers) {
+	OtterTest::VulkanTestDevice device;
+	if (!device) return;
+
+	constexpr uint32_t BUFFER_COUNT = 100000;
+	constexpr VkDeviceSize BLOCK_SIZE = 4ull * 1024 * 1024;
+
+	// Small blocks so that the buffers span many of them
+	VulkanAllocator allocator(device.GetDevice(), device.GetPhysicalDevice(), BLOCK_SIZE);
+	OtterTest::Random random(11);
+
+	VkBufferCreateInfo bufferInfo{};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	std::vector<TestBuffer> buffers(BUFFER_COUNT);
+	VkDeviceSize usedBytes = 0;
+	for (TestBuffer& buffer : buffers) {
+		bufferInfo.size = 64 + random.Below(960);
+		OTTER_REQUIRE(allocator.CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer.mBuffer, buffer.mAllocation) == VK_SUCCESS);
+
+		VkMemoryRequirements requirements;
+		vkGetBufferMemoryRequirements(device.GetDevice(), buffer.mBuffer, &requirements);
+		OTTER_CHECK(!buffer.mAllocation.IsDedicated());
+		OTTER_CHECK(buffer.mAllocation.mOffset % requirements.alignment == 0);
+		usedBytes += buffer.mAllocation.mSize;
+	}
+	OTTER_CHECK(AreDisjoint(buffers));
+
+	// Blocks were added as the first ones filled up, each one of the same size
+	const VulkanAllocatorStats full = allocator.GetStats();
+	OTTER_CHECK(full.mAllocationCount == BUFFER_COUNT);
+	OTTER_CHECK(full.mDedicatedCount == 0);
+	OTTER_CHECK(full.mUsedBytes == usedBytes);
+	OTTER_REQUIRE(full.mBlockCount > 1);
+	const VkDeviceSize blockSize = full.mReservedBytes / full.mBlockCount;
+	OTTER_CHECK(full.mReservedBytes == blockSize * full.mBlockCount && blockSize <= BLOCK_SIZE);
+	OTTER_CHECK(full.mReservedBytes >= usedBytes && full.mReservedBytes - usedBytes < blockSize + usedBytes / 4);
+	OTTER_CHECK(full.mPeakReservedBytes == full.mReservedBytes);
+
+	// Freeing every other buffer and creating as many again fills the holes instead of growing
+	for (size_t i = 0; i < buffers.size(); i += 2) {
+		allocator.DestroyBuffer(buffers[i].mBuffer, buffers[i].mAllocation);
+		OTTER_CHECK(buffers[i].mBuffer == VK_NULL_HANDLE && !buffers[i].mAllocation);
+	}
+	OTTER_CHECK(allocator.GetStats().mAllocationCount == BUFFER_COUNT / 2);
+
+	for (size_t i = 0; i < buffers.size(); i += 2) {
+		bufferInfo.size = 64 + random.Below(448);
+		OTTER_REQUIRE(allocator.CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffers[i].mBuffer, buffers[i].mAllocation) == VK_SUCCESS);
+	}
+	OTTER_CHECK(AreDisjoint(buffers));
+	OTTER_CHECK(allocator.GetStats().mBlockCount <= full.mBlockCount);
+
+	// Images never share a block with buffers when the device asks for a granularity between them
+	VkPhysicalDeviceProperties properties{};
+	vkGetPhysicalDeviceProperties(device.GetPhysicalDevice(), &properties);
+
+	VkImageCreateInfo imageInfo{};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+	imageInfo.extent = { 16, 16, 1 };
+	imageInfo.mipLevels = 1;
+	imageInfo.arrayLayers = 1;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	// Room for the images in the blocks of the buffers, were they allowed there
+	for (size_t i = 0; i < 64; ++i) {
+		allocator.DestroyBuffer(buffers[i].mBuffer, buffers[i].mAllocation);
+	}
+
+	std::vector<VkImage> images(16);
+	std::vector<VulkanAllocation> imageAllocations(images.size());
+	for (size_t i = 0; i < images.size(); ++i) {
+		OTTER_REQUIRE(allocator.CreateImage(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, images[i], imageAllocations[i]) == VK_SUCCESS);
+		if (properties.limits.bufferImageGranularity > 1) {
+			const bool sharesBufferBlock = std::any_of(buffers.begin() + 64, buffers.end(), [&](const TestBuffer& buffer) {
+				return buffer.mAllocation.mMemory == imageAllocations[i].mMemory;
+			});
+			OTTER_CHECK(!sharesBufferBlock);
+		}
+	}
+
+	for (size_t i = 0; i < images.size(); ++i) {
+		allocator.DestroyImage(images[i], imageAllocations[i]);
+	}
+
+	// Destroying everything in a shuffled order gives back every block but the one kept per memory type
+	for (size_t i = buffers.size() - 1; i > 0; --i) {
+		std::swap(buffers[i], buffers[random.Below(uint32_t(i + 1))]);
+	}
+	for (TestBuffer& buffer : buffers) {
+		allocator.DestroyBuffer(buffer.mBuffer, buffer.mAllocation);
+	}
+
+	const VulkanAllocatorStats empty = allocator.GetStats();
+	OTTER_CHECK(empty.mAllocationCount == 0);
+	OTTER_CHECK(empty.mUsedBytes == 0);
+	OTTER_CHECK(empty.mDedicatedCount == 0);
+	OTTER_CHECK(empty.mBlockCount >= 1 && empty.mBlockCount <= 2);
+	OTTER_CHECK(empty.mReservedBytes <= 2 * blockSize);
+	OTTER_CHECK(empty.mPeakReservedBytes >= full.mReservedBytes);
+}
+
+OTTER_BENCHMARK(VulkanAllocator, CreateAndDestroySmallBuffers) {
+	OtterTest::VulkanTestDevice device;
+	if (!device) return;
+
+	constexpr uint32_t BUFFER_COUNT = 100000;
+	VulkanAllocator allocator(device.GetDevice(), device.GetPhysicalDevice());
+
+	VkBufferCreateInfo bufferInfo{};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = 256;
+	bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	std::vector<TestBuffer> buffers(BUFFER_COUNT);
+	OtterTest::Measure("Create and destroy 100k buffers of 256 bytes", 3, [&]() {
+		for (TestBuffer& buffer : buffers) {
+			allocator.CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer.mBuffer, buffer.mAllocation);
+		}
+		for (TestBuffer& buffer : buffers) {
+			allocator.DestroyBuffer(buffer.mBuffer, buffer.mAllocation);
+		}
+	});
+}
@@ -0,0 +1,108 @@
+#include <mutex>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "Core/JobSystem.h"
+#include "Rendering/Vulkan/VulkanParallelRecorder.h"
+
+#include "OtterTest.h"
+#include "TestVulkan.h"
+
+using namespace OtterEngine;
+
+OTTER_TEST(VulkanParallelRecorder, SlicesCoverEveryItemOnce) {
+	OtterTest::VulkanTestDevice device;
+	if (!device) return;
+
+	const OtterTest::TestPipelineSet pipelineSet(device.GetDevice(), device.GetPhysicalDevice());
+	VulkanParallelRecorder recorder(device.GetDevice(), device.GetQueueFamily(), 2, 4);
+	OTTER_REQUIRE(recorder.GetSliceCount() == 4);
+
+	for (size_t itemCount : { size_t(1), size_t(63), size_t(200), size_t(1001) }) {
+		std::mutex lock;
+		std::vector<std::pair<size_t, size_t>> ranges;
+		const std::span<const VkCommandBuffer> recorded = recorder.Record(uint32_t(itemCount % 2), pipelineSet.GetRenderPass(), 0, VK_NULL_HANDLE, itemCount,
+			[&](VkCommandBuffer, size_t begin, size_t end) {
+				std::scoped_lock guard(lock);
+				ranges.push_back({ begin, end });
+			});
+
+		// Contiguous non-empty slices in item order, no more than the recorder has nor than the minimum slice size allows
+		const size_t minItems = VulkanParallelRecorder::DEFAULT_MIN_ITEMS_PER_SLICE;
+		OTTER_CHECK(recorded.size() == ranges.size());
+		OTTER_CHECK(ranges.size() >= 1 && ranges.size() <= 4);
+		OTTER_CHECK(ranges.size() <= (itemCount + minItems - 1) / minItems);
+		std::sort(ranges.begin(), ranges.end());
+		size_t next = 0;
+		for (const auto& [begin, end] : ranges) {
+			OTTER_CHECK(begin == next && end > begin);
+			next = end;
+		}
+		OTTER_CHECK(next == itemCount);
+		OTTER_CHECK(std::adjacent_find(recorded.begin(), recorded.end()) == recorded.end());
+	}
+}
+
+OTTER_BENCHMARK(VulkanParallelRecorder, RecordingScalesWithSlices) {
+	OtterTest::VulkanTestDevice device;
+	if (!device) return;
+
+	constexpr size_t DRAW_COUNT = 20000;
+	constexpr size_t DRAWS_PER_PIPELINE = 500;
+	constexpr VkDeviceSize GEOMETRY_SIZE = 1024 * 1024;
+
+	const OtterTest::TestPipelineSet pipelineSet(device.GetDevice(), device.GetPhysicalDevice());
+	std::vector<VkPipeline> pipelines;
+	const auto pipelineStates = pipelineSet.Create(VK_NULL_HANDLE, pipelines);
+	OTTER_REQUIRE(std::none_of(pipelines.begin(), pipelines.end(), [](VkPipeline pipeline) { return pipeline == VK_NULL_HANDLE; }));
+
+	VulkanAllocator allocator(device.GetDevice(), device.GetPhysicalDevice());
+	VkBuffer geometry = VK_NULL_HANDLE;
+	VulkanAllocation geometryAllocation;
+	VulkanUtility::CreateNewBuffer(allocator, GEOMETRY_SIZE, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, geometry, geometryAllocation);
+
+	// What the renderer records per draw: pipeline changes between groups, geometry, material constants and the draw
+	const VkViewport viewport{ 0.0f, 0.0f, 1280.0f, 720.0f, 0.0f, 1.0f };
+	const VkRect2D scissor{ { 0, 0 }, { 1280, 720 } };
+	auto recordSlice = [&](VkCommandBuffer commandBuffer, size_t begin, size_t end) {
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+		size_t boundPipeline = SIZE_MAX;
+		for (size_t draw = begin; draw < end; ++draw) {
+			const size_t pipeline = (draw / DRAWS_PER_PIPELINE) % pipelines.size();
+			if (pipeline != boundPipeline) {
+				vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines[pipeline]);
+				boundPipeline = pipeline;
+			}
+
+			const VkDeviceSize vertexOffset = (draw % 64) * 1024;
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, &geometry, &vertexOffset);
+			vkCmdBindIndexBuffer(commandBuffer, geometry, GEOMETRY_SIZE / 2, VK_INDEX_TYPE_UINT32);
+
+			const uint32_t constants[2] = { uint32_t(draw % 16), uint32_t(draw % 16 + 16) };
+			vkCmdPushConstants(commandBuffer, pipelineSet.GetLayout(), VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(constants), constants);
+			vkCmdDrawIndexed(commandBuffer, 36, 1, 0, 0, uint32_t(draw));
+		}
+	};
+
+	// Nothing is submitted, only the CPU time spent recording is measured
+	// One slice per worker plus the calling thread at most, the recorder's default
+	const uint32_t maxSliceCount = JobSystem::GetWorkerCount() + 1;
+	double singleSliceMs = 0.0;
+	for (uint32_t sliceCount = 1; sliceCount <= maxSliceCount; ++sliceCount) {
+		VulkanParallelRecorder recorder(device.GetDevice(), device.GetQueueFamily(), 1, sliceCount);
+
+		const std::string label = "Record 20k draws in " + std::to_string(sliceCount) + " slice(s)";
+		const double elapsedMs = OtterTest::Measure(label.c_str(), 20, [&]() {
+			recorder.Record(0, pipelineSet.GetRenderPass(), 0, VK_NULL_HANDLE, DRAW_COUNT, recordSlice);
+		});
+
+		singleSliceMs = sliceCount == 1 ? elapsedMs : singleSliceMs;
+		std::printf("    %-48s %10.2f\n", "  speedup over a single slice", singleSliceMs / elapsedMs);
+	}
+
+	allocator.DestroyBuffer(geometry, geometryAllocation);
+}
@@ -0,0 +1,91 @@
+#include <cstring>
+
+#include "Rendering/Vulkan/VulkanStagingRing.h"
+
+#include "OtterTest.h"
+#include "TestVulkan.h"
+
+using namespace OtterEngine;
+
+OTTER_TEST(VulkanStagingRing, WrapsAndFallsBackUntilReclaimed) {
+	OtterTest::VulkanTestDevice device;
+	if (!device) return;
+
+	constexpr VkDeviceSize CAPACITY = 4096;
+
+	VulkanAllocator allocator(device.GetDevice(), device.GetPhysicalDevice());
+	VkFence fences[3] = { device.CreateFence(), device.CreateFence(), device.CreateFence() };
+	{
+		VulkanStagingRing ring(allocator, CAPACITY);
+		OTTER_REQUIRE(ring.GetCapacity() == CAPACITY && ring.GetUsedBytes() == 0);
+		OTTER_CHECK(allocator.GetStats().mAllocationCount == 1);
+
+		// Two uploads in the first segment, the second one aligned past the first
+		const StagingAllocation first = ring.Allocate(1500);
+		const StagingAllocation second = ring.Allocate(1500);
+		OTTER_REQUIRE(first && second);
+		OTTER_CHECK(first.mOffset == 0 && second.mOffset == 1504);
+		OTTER_CHECK(second.mBuffer == first.mBuffer && second.pMapped == first.pMapped + 1504);
+		OTTER_CHECK(ring.GetUsedBytes() == 3004);
+		std::memset(first.pMapped, 0xAB, first.mSize);
+		std::memset(second.pMapped, 0xCD, second.mSize);
+
+		// Nothing comes back while the fence of its segment is unsignaled
+		ring.Commit(fences[0]);
+		ring.Reclaim();
+		OTTER_CHECK(ring.GetUsedBytes() == 3004);
+
+		const StagingAllocation third = ring.Allocate(1000);
+		OTTER_REQUIRE(third);
+		OTTER_CHECK(third.mOffset == 3008 && third.mBuffer == first.mBuffer);
+		OTTER_CHECK(ring.GetUsedBytes() == 4008);
+		ring.Commit(fences[1]);
+
+		device.SignalFence(fences[0]);
+		vkWaitForFences(device.GetDevice(), 1, &fences[0], VK_TRUE, UINT64_MAX);
+		ring.Reclaim();
+		OTTER_CHECK(ring.GetUsedBytes() == 1004);
+
+		// Past the end of the buffer the upload wraps to the start, the 88 bytes skipped at the end count as used
+		const StagingAllocation wrapped = ring.Allocate(1000);
+		OTTER_REQUIRE(wrapped);
+		OTTER_CHECK(wrapped.mOffset == 0 && wrapped.mBuffer == first.mBuffer && wrapped.pMapped == first.pMapped);
+		OTTER_CHECK(ring.GetUsedBytes() == 1004 + (CAPACITY - 4008) + 1000);
+
+		// More than the ring holds goes to a dedicated buffer, outside of the ring's accounting
+		const StagingAllocation large = ring.Allocate(5000);
+		OTTER_REQUIRE(large);
+		OTTER_CHECK(large.mBuffer != first.mBuffer && large.mOffset == 0 && large.mSize == 5000);
+		std::memset(large.pMapped, 0xEF, large.mSize);
+		OTTER_CHECK(ring.GetUsedBytes() == 2092);
+		OTTER_CHECK(allocator.GetStats().mAllocationCount == 2);
+		ring.Commit(fences[2]);
+
+		device.SignalFence(fences[1]);
+		device.SignalFence(fences[2]);
+		vkWaitForFences(device.GetDevice(), 2, &fences[1], VK_TRUE, UINT64_MAX);
+		ring.Reclaim();
+		OTTER_CHECK(ring.GetUsedBytes() == 0);
+		OTTER_CHECK(allocator.GetStats().mAllocationCount == 1);
+
+		// A ring full of uncommitted uploads has nothing to wait for and falls back to a dedicated buffer too
+		const StagingAllocation pending = ring.Allocate(3000);
+		OTTER_REQUIRE(pending);
+		OTTER_CHECK(pending.mOffset == 0 && pending.mBuffer == first.mBuffer);
+		const StagingAllocation overflow = ring.Allocate(3000);
+		OTTER_REQUIRE(overflow);
+		OTTER_CHECK(overflow.mBuffer != first.mBuffer);
+		OTTER_CHECK(ring.GetUsedBytes() == 3000);
+		OTTER_CHECK(allocator.GetStats().mAllocationCount == 2);
+
+		// Work already known to be complete is released on commit
+		ring.Commit(VK_NULL_HANDLE);
+		OTTER_CHECK(ring.GetUsedBytes() == 0);
+		OTTER_CHECK(allocator.GetStats().mAllocationCount == 1);
+	}
+	OTTER_CHECK(allocator.GetStats().mAllocationCount == 0);
+
+	for (VkFence fence : fences) {
+		vkDestroyFence(device.GetDevice(), fence, nullptr);
+	}
+}
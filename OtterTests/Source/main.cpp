@@ -0,0 +1,91 @@
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+
+#include "Core/EngineCore.h"
+
+#include "OtterTest.h"
+
+namespace fs = std::filesystem;
+
+namespace OtterTest {
+	namespace {
+		// Checks can fail on worker threads, the report lines are kept whole
+		std::atomic<int> sFailures{ 0 };
+		std::mutex sReportLock;
+		const TestCase* sCurrentTest = nullptr;
+		fs::path sTempDirectory;
+	}
+
+	std::vector<TestCase>& GetRegistry() {
+		static std::vector<TestCase> sRegistry;
+		return sRegistry;
+	}
+
+	void ReportFailure(const char* expression, const char* file, int line) {
+		std::scoped_lock lock(sReportLock);
+		++sFailures;
+		std::printf("    FAILED: %s (%s:%d)\n", expression, file, line);
+	}
+
+	const fs::path& GetTempDirectory() {
+		if (sTempDirectory.empty()) {
+			// Named after the test, so that suites run in parallel by CTest never share one
+			sTempDirectory = fs::temp_directory_path() /
+				(std::string("OtterTests_") + sCurrentTest->mSuite + "_" + sCurrentTest->mName);
+			std::error_code error;
+			fs::remove_all(sTempDirectory, error);
+			fs::create_directories(sTempDirectory, error);
+		}
+		return sTempDirectory;
+	}
+}
+
+// Usage: OtterTests [suite] [--benchmarks]
+// Runs the tests of every suite, or of the given one. Benchmarks replace the tests with --benchmarks.
+int main(int argc, char** argv) {
+	OtterEngine::EngineCore::Start();
+
+	const char* suite = nullptr;
+	bool runBenchmarks = false;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--benchmarks") == 0) runBenchmarks = true;
+		else suite = argv[i];
+	}
+
+	int testCount = 0;
+	int failedTests = 0;
+	for (const OtterTest::TestCase& test : OtterTest::GetRegistry()) {
+		if (test.mIsBenchmark != runBenchmarks || (suite && std::strcmp(suite, test.mSuite) != 0)) {
+			continue;
+		}
+
+		std::printf("[ RUN  ] %s.%s\n", test.mSuite, test.mName);
+		const int failuresBefore = OtterTest::sFailures;
+		OtterTest::sCurrentTest = &test;
+		test.mBody();
+
+		if (!OtterTest::sTempDirectory.empty()) {
+			std::error_code error;
+			fs::remove_all(OtterTest::sTempDirectory, error);
+			OtterTest::sTempDirectory.clear();
+		}
+
+		const bool hasFailed = OtterTest::sFailures != failuresBefore;
+		std::printf("[ %s ] %s.%s\n", hasFailed ? "FAIL" : " OK ", test.mSuite, test.mName);
+		failedTests += hasFailed ? 1 : 0;
+		++testCount;
+	}
+
+	if (testCount == 0) {
+		std::printf("No %s found%s%s\n", runBenchmarks ? "benchmarks" : "tests", suite ? " in suite " : "", suite ? suite : "");
+		return EXIT_FAILURE;
+	}
+
+	std::printf("%d of %d passed\n", testCount - failedTests, testCount);
+	return failedTests == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}